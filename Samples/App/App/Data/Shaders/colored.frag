@@ -1,6 +1,7 @@
 #version 460
 
 layout(location = 0) in float fragPosZ;
+layout(location = 1) in vec4 fragInstanceColor;
 layout(set = 1, binding = 0) uniform sampler2D textureSampler;
 
 layout(location = 0) out vec4 outColour;	//Final output colour (must also have location)	
@@ -27,5 +28,5 @@ void main()
 	vec3 from = colorRamp[int(key)];
 	vec3 to = colorRamp[int(key) + 1];
 	vec3 color = mix(from, to, t);
-	outColour = vec4(color, 1.0);
+	outColour = vec4(color, 1.0) * fragInstanceColor;
 }
\ No newline at end of file
@@ -4,6 +4,9 @@ layout(location = 0) in vec3 pos;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec3 tangent;
 layout(location = 3) in vec2 tex;
+//Per-instance data
+layout(location = 4) in mat4 instanceTransform;
+layout(location = 8) in vec4 instanceColor;
 
 layout(set = 0, binding = 0) uniform UboViewProjection {
 	mat4 projection;
@@ -20,10 +23,15 @@ layout(push_constant) uniform PushModel {
 } pushModel;
 
 layout(location = 0) out float fragPosZ;
+layout(location = 1) out vec4 fragInstanceColor;
+
+//Depth pre-pass and main pass must produce bit-identical depth
+invariant gl_Position;
 
 void main()
 {
-	vec4 worldPos = pushModel.model * vec4(vec3(pos.x, pos.y, pos.z * 5.0), 1.0);
+	vec4 worldPos = pushModel.model * instanceTransform * vec4(vec3(pos.x, pos.y, pos.z * 5.0), 1.0);
 	gl_Position = uboViewProjection.projection * uboViewProjection.view * worldPos;
 	fragPosZ = pos.z;
+	fragInstanceColor = instanceColor;
 }
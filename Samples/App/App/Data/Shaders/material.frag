@@ -0,0 +1,170 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : require
+
+//Feature toggles. Ids match EShaderFeature bits
+layout(constant_id = 0) const bool TEXTURED = false;
+layout(constant_id = 1) const bool NORMAL_MAP = false;
+layout(constant_id = 2) const bool PBR = false;
+
+layout(location = 0) in vec3 fragPos;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec3 fragTangent;
+layout(location = 3) in vec2 fragTex;
+
+//All textures of scene, slots of material textures are in table indexed by material id
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+layout(set = 1, binding = 1) readonly buffer MaterialTextures {
+	//Base color (diffuse for non PBR variants), normals, metallic roughness
+	uvec4 slots[];
+} materialTextures;
+
+const uint INVALID_SLOT = 0xFFFFFFFFu;
+const uint BASE_COLOR_TEXTURE = 0;
+const uint NORMALS_TEXTURE = 1;
+const uint METALLIC_ROUGHNESS_TEXTURE = 2;
+
+layout(set = 0, binding = 0) uniform FrameUniforms {
+	mat4 projection;
+	mat4 view;
+	vec4 cameraEye;
+	vec4 lightPos;
+	vec4 lightColor;
+	vec4 lightSpecularColor;
+	//First entry of material table region of frame being drawn
+	uint materialTableBase;
+} frame;
+
+layout(push_constant) uniform Lighting {
+	layout(offset = 64) mat4 normalMatrix;
+	layout(offset = 64 + 64) uint materialId;
+	//x is shininess
+	layout(offset = 64 + 64 + 16) vec4 materialParams;
+} lighting;
+
+layout(location = 0) out vec4 outColor;
+
+const float PI = 3.14159265359;
+
+//Texture which is not loaded yet samples as fallback
+vec4 sampleMaterialTexture(uint kind, vec4 fallback)
+{
+	uint entry = frame.materialTableBase + lighting.materialId;
+	if(entry >= materialTextures.slots.length())
+	{
+		return fallback;
+	}
+	uint slot = materialTextures.slots[entry][kind];
+	if(slot == INVALID_SLOT)
+	{
+		return fallback;
+	}
+	return texture(textures[nonuniformEXT(slot)], fragTex);
+}
+
+vec4 materialColor()
+{
+	if(TEXTURED)
+	{
+		return sampleMaterialTexture(BASE_COLOR_TEXTURE, vec4(1.0));
+	}
+	return vec4(1.0);
+}
+
+vec3 getNormal()
+{
+	vec3 n = normalize(fragNormal);
+	if(NORMAL_MAP)
+	{
+		vec3 t = normalize(fragTangent);
+		vec3 b = normalize(cross(n, t));
+		mat3 tbn = mat3(t, b, n);
+		n = normalize(tbn * normalize(sampleMaterialTexture(NORMALS_TEXTURE, vec4(0.5, 0.5, 1.0, 1.0)).xyz * 2.0 - 1.0));
+	}
+	return n;
+}
+
+// Normal Distribution function --------------------------------------
+float D_GGX(float dotNH, float roughness)
+{
+	float alpha = roughness * roughness;
+	float alpha2 = alpha * alpha;
+	float denom = dotNH * dotNH * (alpha2 - 1.0) + 1.0;
+	return (alpha2)/(PI * denom*denom);
+}
+
+// Geometric Shadowing function --------------------------------------
+float G_SchlicksmithGGX(float dotNL, float dotNV, float roughness)
+{
+	float r = (roughness + 1.0);
+	float k = (r*r) / 8.0;
+	float GL = dotNL / (dotNL * (1.0 - k) + k);
+	float GV = dotNV / (dotNV * (1.0 - k) + k);
+	return GL * GV;
+}
+
+// Fresnel function ----------------------------------------------------
+vec3 F_Schlick(float cosTheta, vec3 baseColor, float metallic)
+{
+	vec3 F0 = mix(vec3(0.04), baseColor, metallic);
+	return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
+}
+
+vec3 shadePBR(vec3 N, vec3 baseColor)
+{
+	vec3 V = normalize(frame.cameraEye.xyz - fragPos);
+	vec3 L = normalize(frame.lightPos.xyz - fragPos);
+	vec3 H = normalize(V + L);
+	float dotNV = clamp(dot(N, V), 0.0, 1.0);
+	float dotNL = clamp(dot(N, L), 0.0, 1.0);
+	float dotNH = clamp(dot(N, H), 0.0, 1.0);
+
+	vec2 metallicRoughness = sampleMaterialTexture(METALLIC_ROUGHNESS_TEXTURE, vec4(0.0, 1.0, 0.0, 1.0)).rg;
+	float metallic = metallicRoughness.r;
+	float roughness = metallicRoughness.g;
+
+	vec3 color = baseColor * 0.02;
+	if(dotNL > 0.0)
+	{
+		float D = D_GGX(dotNH, roughness);
+		float G = G_SchlicksmithGGX(dotNL, dotNV, max(0.05, roughness));
+		vec3 F = F_Schlick(dotNV, baseColor, metallic);
+		vec3 spec = D * F * G / (4.0 * dotNL * dotNV);
+		color += spec * dotNL * frame.lightColor.rgb;
+	}
+
+	//Gamma correct
+	return pow(color, vec3(0.4545));
+}
+
+vec3 shadePhong(vec3 N, vec3 baseColor)
+{
+	vec3 L = normalize(frame.lightPos.xyz - fragPos);
+	float diffuseFactor = max(0.0, dot(N, L));
+
+	vec3 R = reflect(-L, N);
+	vec3 V = normalize(frame.cameraEye.xyz - fragPos);
+	float shininess = lighting.materialParams.x;
+	float specularFactor = pow(max(0.0, dot(V, R)), shininess);
+
+	return
+		baseColor * diffuseFactor * frame.lightColor.rgb +
+		specularFactor * frame.lightColor.rgb;
+}
+
+void main()
+{
+	vec4 baseColor = materialColor();
+	if(PBR)
+	{
+		outColor = vec4(shadePBR(getNormal(), baseColor.rgb), 1.0);
+	}
+	else if(NORMAL_MAP)
+	{
+		outColor = vec4(shadePhong(getNormal(), baseColor.rgb), baseColor.a);
+	}
+	else
+	{
+		//Plain textured variant is unlit
+		outColor = baseColor;
+	}
+}
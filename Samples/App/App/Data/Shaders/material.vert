@@ -0,0 +1,49 @@
+#version 460
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec3 tangent;
+layout(location = 3) in vec2 tex;
+//Per-instance data
+layout(location = 4) in mat4 instanceTransform;
+layout(location = 8) in vec4 instanceColor;
+layout(location = 9) in mat3 instanceNormalMatrix;
+
+layout(set = 0, binding = 0) uniform FrameUniforms {
+	mat4 projection;
+	mat4 view;
+	vec4 cameraEye;
+	vec4 lightPos;
+	vec4 lightColor;
+	vec4 lightSpecularColor;
+	//First entry of material table region of frame being drawn
+	uint materialTableBase;
+} frame;
+
+//Normal matrix of pushed model matrix is in lighting constants
+layout(push_constant) uniform PushModel {
+	mat4 modelMatrix;
+	layout(offset = 64) mat4 normalMatrix;
+} pushModel;
+
+layout(location = 0) out vec3 fragPos;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec3 fragTangent;
+layout(location = 3) out vec2 fragTex;
+
+//Depth pre-pass and main pass must produce bit-identical depth
+invariant gl_Position;
+
+void main()
+{
+	mat4 modelMatrix = pushModel.modelMatrix * instanceTransform;
+	vec4 worldPos = modelMatrix * vec4(pos, 1.0);
+	gl_Position = frame.projection * frame.view * worldPos;
+	fragPos = worldPos.xyz;
+	//Normal matrices are computed on CPU, inverse per vertex is too expensive
+	mat3 normalMatrix = mat3(pushModel.normalMatrix) * instanceNormalMatrix;
+	fragNormal = normalMatrix * normal;
+	//Tangent lies in surface and is transformed as position
+	fragTangent = mat3(modelMatrix) * tangent;
+	fragTex = tex;
+}
@@ -1,9 +1,17 @@
 #version 460
 
-layout(set = 0, input_attachment_index = 0, binding = 0) uniform subpassInput inputColor;
+layout(location = 0) in vec2 fragUV;
+
+layout(set = 0, binding = 0) uniform sampler2D inputColor;
 layout(location = 0) out vec4 color;	//Final output colour (must also have location)	
 
+//xy - part of scene color covered by dynamic resolution render area, zw - max uv not bleeding outside of it
+layout(push_constant) uniform PushRenderScale {
+	vec4 renderScale;
+};
+
 void main()
 {
-	color = vec4(subpassLoad(inputColor).rgb, 1.0);
-}
\ No newline at end of file
+	vec2 uv = min(fragUV * renderScale.xy, renderScale.zw);
+	color = vec4(texture(inputColor, uv).rgb, 1.0);
+}
@@ -1,5 +1,7 @@
 #version 460
 
+layout(location = 0) out vec2 fragUV;
+
 vec2 positions[3] = vec2[](
 	vec2(3.0, -1.0),
 	vec2(-1.0, -1.0),
@@ -8,5 +10,6 @@ vec2 positions[3] = vec2[](
 
 void main()
 {
+	fragUV = positions[gl_VertexIndex] * 0.5 + 0.5;
 	gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
 }
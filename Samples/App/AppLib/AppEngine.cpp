@@ -15,6 +15,8 @@
 
 #include "resource.h"
 
+#include <cmath>
+#include <cstring>
 #include <filesystem>
 
 #include <tchar.h>
@@ -24,6 +26,13 @@ using namespace glm;
 
 namespace app
 {
+    //Instances of instancing benchmark scenes, each count is drawn instanced, then by per-instance loop
+    const uint32_t INSTANCING_BENCHMARK_COUNTS[] = { 1000, 10000, 100000 };
+    const uint32_t INSTANCING_BENCHMARK_SCENES = 2 * sizeof(INSTANCING_BENCHMARK_COUNTS) / sizeof(INSTANCING_BENCHMARK_COUNTS[0]);
+    //Frames skipped after scene change while buffers grow and pipelines are created, then frames averaged
+    const uint32_t INSTANCING_BENCHMARK_WARMUP_FRAMES = 10;
+    const uint32_t INSTANCING_BENCHMARK_FRAMES = 30;
+
     //Creates all features like height map, grid, dissection
     AppEngine::AppEngine()
         : Engine()
@@ -40,6 +49,7 @@ namespace app
         mRenderer.reset(new AppRenderer(mThreadPool));
 
         mRenderer->setShaderMetaDataProvider(this);
+        mRenderer->setPipelineCache(fs.getDocumentsDir() + "/pipeline_cache.bin");
 
         mCamera.setEye(vec3(0, 0, -100.0f));
 
@@ -108,6 +118,14 @@ namespace app
 
     bool AppEngine::createMeshGPUResources()
     {
+        for(int i = 1; i < mArgC; i++)
+        {
+            if(strcmp(mArgV[i], "--instancing-benchmark") == 0)
+            {
+                createInstancingBenchmark();
+            }
+        }
+
 		bool result = Engine::createMeshGPUResources();
         return result;
     }
@@ -165,6 +183,12 @@ namespace app
     {
         STAT_CPU("Main thread");
 
+        if(mInstancingBenchmark)
+        {
+            //Every frame is recorded, not only changed ones
+            mRenderer->requestRedraw();
+        }
+
         /*auto bgColor = ImGui::GetStyleColorVec4(ImGuiCol_WindowBg);
         mRenderer->setClearColor(vec4(bgColor.x, bgColor.y, bgColor.z, 0.0f));*/
         mRenderer->setClearColor(vec4(0.0f, 0.0f, 0.0f, 0.0f));
@@ -190,6 +214,79 @@ namespace app
     void AppEngine::onFrameEnd(VulkanRenderer* renderer)
     {
         Engine::onFrameEnd(renderer);
+
+        if(mInstancingBenchmark)
+        {
+            updateInstancingBenchmark(renderer);
+        }
+    }
+
+    void AppEngine::createInstancingBenchmark()
+    {
+        Material material;
+        material.mShaderFileName = "colored";
+        mRenderer->addMaterial(material);
+        auto& meshModel = mRenderer->createMeshModel("Models/unitCube/unitCube.obj", {});
+        mInstancingMesh = meshModel->getMesh(0);
+        mInstancingMesh->setMaterialId(material.mId);
+        //Secondary command buffer of static scene would skip recording
+        mRenderer->setSceneCommandsReuse(false);
+        mInstancingBenchmark = true;
+        mInstancingScene = 0;
+        setInstancingBenchmarkScene();
+    }
+
+    void AppEngine::setInstancingBenchmarkScene()
+    {
+        const uint32_t count = INSTANCING_BENCHMARK_COUNTS[mInstancingScene / 2];
+        if(mInstancingScene % 2 == 0)
+        {
+            //Square grid of colored cubes
+            const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+            Mesh::Instances instances(count);
+            for(uint32_t i = 0; i < count; i++)
+            {
+                const vec2 cell(static_cast<float>(i % side), static_cast<float>(i / side));
+                instances[i].transform = translate(mat4(1.0f), vec3((cell - vec2(side * 0.5f)) * 3.0f, 0.0f));
+                instances[i].color = vec4(cell / static_cast<float>(side), 0.5f, 1.0f);
+            }
+            mInstancingMesh->setInstances(instances);
+        }
+        else
+        {
+            //Old path: mesh commands are recorded for every instance, all of them get mesh transform
+            mInstancingMesh->setInstances({});
+            mInstancingMesh->setInstanceCount(count);
+        }
+        mInstancingFrame = 0;
+        mInstancingRecordTime = 0.0;
+    }
+
+    void AppEngine::updateInstancingBenchmark(VulkanRenderer* renderer)
+    {
+        mInstancingFrame++;
+        if(mInstancingFrame <= INSTANCING_BENCHMARK_WARMUP_FRAMES)
+        {
+            return;
+        }
+
+        const auto& statistics = renderer->getRenderStatistics();
+        mInstancingRecordTime += statistics.mRecordTime;
+        if(mInstancingFrame < INSTANCING_BENCHMARK_WARMUP_FRAMES + INSTANCING_BENCHMARK_FRAMES)
+        {
+            return;
+        }
+
+        LOG_INFO("Instancing benchmark, {} instances {}: draw calls {}, instances drawn {}, record time {:.3f} ms",
+            INSTANCING_BENCHMARK_COUNTS[mInstancingScene / 2], mInstancingScene % 2 == 0 ? "instanced" : "per-instance loop",
+            statistics.mDrawCalls, statistics.mInstances, mInstancingRecordTime / INSTANCING_BENCHMARK_FRAMES);
+        mInstancingScene++;
+        if(mInstancingScene == INSTANCING_BENCHMARK_SCENES)
+        {
+            exit();
+            return;
+        }
+        setInstancingBenchmarkScene();
     }
 
     void AppEngine::onButtonEvent(int button, int action, int mods)
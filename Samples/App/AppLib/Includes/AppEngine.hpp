@@ -61,6 +61,12 @@ namespace app
         void toggleCameraProjection();
 
     private:
+        //--instancing-benchmark: unit cube drawn with 1k, 10k and 100k instances, by one instanced draw call and by
+        //per-instance record loop. Draw calls and CPU record time of each scene are logged, then app exits
+        void createInstancingBenchmark();
+        void updateInstancingBenchmark(fre::VulkanRenderer* renderer);
+        void setInstancingBenchmarkScene();
+
         void loadFonts();
         int getMainMenuHeight() const;
         fre::BoundingBox2D getMainViewport();
@@ -73,5 +79,12 @@ namespace app
         fre::Camera mLastCamera;
 		uint64_t mFrameNumber = 0;
         int mMainMenuHeight = 24;
+
+        bool mInstancingBenchmark = false;
+        fre::MeshPtr mInstancingMesh;
+        uint32_t mInstancingScene = 0;
+        uint32_t mInstancingFrame = 0;
+        //Sum of record times of measured frames, ms
+        double mInstancingRecordTime = 0.0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "FileSystem/MappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fre
+{
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+#ifdef _WIN32
+	bool MappedFile::open(const std::string& fileName)
+	{
+		close();
+
+		//Cache files may be deleted by other process while mapped
+		HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if(file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		mFile = file;
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			close();
+			return false;
+		}
+
+		mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mMapping == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+		if(mData == nullptr)
+		{
+			close();
+			return false;
+		}
+		mSize = static_cast<size_t>(size.QuadPart);
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if(mData != nullptr)
+		{
+			UnmapViewOfFile(mData);
+		}
+		if(mMapping != nullptr)
+		{
+			CloseHandle(mMapping);
+		}
+		if(mFile != nullptr)
+		{
+			CloseHandle(mFile);
+		}
+		mData = nullptr;
+		mSize = 0;
+		mMapping = nullptr;
+		mFile = nullptr;
+	}
+#else
+	bool MappedFile::open(const std::string& fileName)
+	{
+		close();
+
+		const int file = ::open(fileName.c_str(), O_RDONLY);
+		if(file < 0)
+		{
+			return false;
+		}
+
+		struct stat status;
+		if(fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			::close(file);
+			return false;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+		//Mapping stays valid after descriptor is closed
+		::close(file);
+		if(data == MAP_FAILED)
+		{
+			return false;
+		}
+		mData = static_cast<const uint8_t*>(data);
+		mSize = static_cast<size_t>(status.st_size);
+
+		return true;
+	}
+
+	void MappedFile::close()
+	{
+		if(mData != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(mData), mSize);
+		}
+		mData = nullptr;
+		mSize = 0;
+	}
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fre
+{
+	//Read only mapping of whole file, pages are read by OS on first access
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		~MappedFile();
+
+		//False if file can't be opened or is empty
+		bool open(const std::string& fileName);
+		void close();
+
+		const uint8_t* getData() const { return mData; }
+		size_t getSize() const { return mSize; }
+
+	private:
+		const uint8_t* mData = nullptr;
+		size_t mSize = 0;
+#ifdef _WIN32
+		void* mFile = nullptr;
+		void* mMapping = nullptr;
+#endif
+	};
+}
@@ -3,20 +3,44 @@
 #include <volk.h>
 #include <GLFW/glfw3.h>
 
+#include "Renderer/Mipmaps.hpp"
+
 #include "stb_image.h"
 
 #include <glm/glm.hpp>
 
 #include <string>
 #include <limits>
+#include <memory>
+#include <vector>
 
 namespace fre
 {
+    class MappedFile;
+    struct TextureLevels;
+
+    //Header of image file, read without decoding pixels
+    struct ImageHeader
+    {
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        //Channels decoder gives, palette and transparency color of PNG count as they are expanded
+        uint32_t mChannels = 0;
+        //Bits per channel
+        uint32_t mBitDepth = 0;
+        //Images in file, TIFF may have several pages
+        uint32_t mPagesCount = 0;
+        //Format image is loaded in, undefined if loader doesn't support it
+        VkFormat mFormat = VK_FORMAT_UNDEFINED;
+    };
+
     struct Image
     {
         void create(const glm::ivec2& dimension, const VkFormat format);
+        //Copies prebuilt levels of texture
+        void create(const TextureLevels& texture);
         void calculateStrideAndDataSize();
-        //Loads image. Supported formats - the same as stb_image does.
+        //Loads image. Supported formats - the same as stb_image does, TIFF, KTX2 and DDS
         void load();
         void loadPng(const std::string& fileName);
         void loadTIFF(const std::string& fileName);
@@ -25,6 +49,12 @@ namespace fre
         void destroy();
         //Chack file name for validity
         bool isFileNameValid() const;
+        //Reads header of PNG, JPG or classic TIFF file, the first page describes TIFF. Pixels aren't read.
+        //Returns false for other files and broken headers
+        static bool probe(const std::string& fileName, ImageHeader& header);
+        //Dimension, format and channels image gets once loaded, from header of its file, so texture can be
+        //created before data is loaded. Returns false if file can't be probed
+        bool probeFile();
 
         glm::ivec2 mDimension;
         //Data size stored in mData, bytes
@@ -33,10 +63,16 @@ namespace fre
         VkFormat mFormat = VK_FORMAT_UNDEFINED;
         std::string mFileName;
         bool mIsExternal = false;
-        //Pixel size, bytes
+        //Color is sRGB encoded in UNORM format, mips are averaged in linear space
+        bool mSRGB = false;
+        //Pixel size, bytes. Block size for block compressed formats
         uint32_t mStride = 0;
+        //Prebuilt levels in mData, empty if mData holds level 0 only
+        std::vector<MipLevel> mLevels;
         //Does this image own the data
         bool mIsOwner = false;
+        //Mapping mData points into, shared by copies of image
+        std::shared_ptr<MappedFile> mMappedFile;
         bool mIsTIFF = false;
         bool mIsPNG = false;
         int mNumChannels = 0;
@@ -50,6 +86,7 @@ namespace fre
                 mDataSize == other.mDataSize &&
                 mFormat == other.mFormat &&
                 mIsExternal == other.mIsExternal &&
+                mSRGB == other.mSRGB &&
                 mStride == other.mStride &&
                 mIsOwner == other.mIsOwner &&
                 mIsTIFF == other.mIsTIFF &&
@@ -59,4 +96,4 @@ namespace fre
                 mData == other.mData;
         }
     };
-}
\ No newline at end of file
+}
@@ -4,14 +4,14 @@
 
 namespace fre
 {
-	//Lighting data for shader
+	//Lighting data of object for shader, camera and light are in frame uniforms
 	struct Lighting
 	{
-		glm::vec4 cameraEye = glm::vec4(0.0f);
-		glm::vec4 lightPos = glm::vec4(0.0f);
-		glm::vec4 lightDiffuseColor = glm::vec4(0.0f);
-		glm::vec4 lightSpecularColor = glm::vec4(0.0f);
 		glm::mat4 normalMatrix = glm::mat4(1.0f);
+		//x is material index into bindless material texture table
+		glm::uvec4 material = glm::uvec4(0u);
+		//x is material shininess
+		glm::vec4 materialParams = glm::vec4(0.0f);
 	};
 
 	//Light
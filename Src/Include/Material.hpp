@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Renderer/ShaderVariant.hpp"
+
 #include <assimp/scene.h>
 
 #include <map>
@@ -18,5 +20,7 @@ namespace fre
         uint32_t mId = std::numeric_limits<uint32_t>::max();
         uint32_t mShaderId = std::numeric_limits<uint32_t>::max();
         std::string mShaderFileName;
+        //Features enabled in shader for this material
+        ShaderVariantKey mShaderVariant;
     };
 }
\ No newline at end of file
@@ -24,17 +24,21 @@ namespace fre
 		//Vertices are raw data
 		using Vertices = std::vector<uint8_t>;
 		using Indices = std::vector<uint32_t>;
+		using Instances = std::vector<MeshInstance>;
+		using Descriptors = std::vector<std::vector<VulkanDescriptorPtr>>;
 		Mesh();
 		Mesh(uint32_t materialId);
 		~Mesh();
 
 		uint32_t getId() const;
 
+		//Setters of state draws are gathered from change scene version, see getSceneVersion.
 		//Vertex array represented by raw bytes for flexibility
 		void setVertices(const Vertices& vertices, uint32_t vertexSize);
 		void setIndices(const Indices& indices);
 
-		GETTER_SETTER(uint32_t, MaterialId);
+		uint32_t getMaterialId() const { return mMaterialId; }
+		void setMaterialId(uint32_t materialId);
 
 		//Returns size of vertex in bytes
 		uint32_t getVertexSize() const;
@@ -48,27 +52,60 @@ namespace fre
 		//Index array raw data
 		const void* getIndexData() const;
 
-		GETTER_SETTER(BoundingBox3D, BoundingBox);
-		GETTER_SETTER(uint32_t, ComputeShaderId);
+		BoundingBox3D getBoundingBox() const { return mBoundingBox; }
+		void setBoundingBox(const BoundingBox3D& boundingBox);
+		uint32_t getComputeShaderId() const { return mComputeShaderId; }
+		void setComputeShaderId(uint32_t computeShaderId);
 		GETTER_SETTER(glm::vec3, ComputeSpace);
 
 		//Visit callbacks
-		GETTER_SETTER(RecordCallback, BeforeVisitCallback);
-		GETTER_SETTER(RecordCallback, AfterVisitCallback);
+		const RecordCallback& getBeforeVisitCallback() const { return mBeforeVisitCallback; }
+		void setBeforeVisitCallback(const RecordCallback& callback);
+		const RecordCallback& getAfterVisitCallback() const { return mAfterVisitCallback; }
+		void setAfterVisitCallback(const RecordCallback& callback);
 
 		//Record callbacks
-		GETTER_SETTER(RecordCallback, BeforeRecordCallback); 
-		GETTER_SETTER(RecordCallback, AfterRecordCallback); 
-
-		GETTER_SETTER(bool, Visible);
-
-		GETTER_SETTER(uint32_t, InstanceCount);
+		const RecordCallback& getBeforeRecordCallback() const { return mBeforeRecordCallback; }
+		void setBeforeRecordCallback(const RecordCallback& callback);
+		const RecordCallback& getAfterRecordCallback() const { return mAfterRecordCallback; }
+		void setAfterRecordCallback(const RecordCallback& callback);
+
+		//Checked without copying callbacks
+		bool hasVisitCallbacks() const { return mBeforeVisitCallback != nullptr || mAfterVisitCallback != nullptr; }
+		bool hasRecordCallbacks() const
+		{
+			return mBeforeRecordCallback != nullptr || mAfterRecordCallback != nullptr || mPushConstantsCallback != nullptr;
+		}
+
+		bool getVisible() const { return mVisible; }
+		void setVisible(bool visible);
+		//Mesh is rasterized into CPU occlusion depth, position is read from the start of each vertex
+		GETTER_SETTER(bool, Occluder);
+
+		uint32_t getInstanceCount() const { return mInstanceCount; }
+		void setInstanceCount(uint32_t instanceCount);
+
+		//Mesh with instances is drawn by single instanced draw call, instance count is set to instances count.
+		//Normal matrices of instances are computed from their transforms
+		void setInstances(const Instances& instances);
+		//Bulk update of instances range, range must be within instances set before
+		void updateInstances(uint32_t firstInstance, const MeshInstance* instances, uint32_t count);
+		const Instances& getInstances() const;
+		bool hasInstances() const;
+		//Changes on every instances update, renderer uploads instances when version differs
+		uint32_t getInstancesVersion() const;
 
 		FIELD_NS(std::vector<uint32_t>, DescriptorSets, private, public, public);
 
-        FIELD_NS(std::vector<std::vector<VulkanDescriptorPtr>>, Descriptors, private, public, public);
+		//Descriptors of each set of mesh shader
+		const Descriptors& getDescriptors() const { return mDescriptors; }
+		void setDescriptors(const Descriptors& descriptors);
+		//Descriptors changed every frame by mesh of pass recorded every frame, like input attachment
+		//of swapchain image in post-process. Scene version is kept
+		void setFrameDescriptors(const Descriptors& descriptors);
 
 	public:
+		//Callbacks are set before mesh is added to renderer, or changeSceneVersion is called after.
 		//Callback to pass variables to shader
 		PushConstantCallback mPushConstantsCallback = nullptr;
 		//Callback to pass data like textures or buffers to shader
@@ -82,6 +119,9 @@ namespace fre
 		uint32_t mVertexSize = 0;
 		Vertices mVertices;
 		Indices mIndices;
+		Instances mInstances;
+		uint32_t mInstancesVersion = 0;
+		Descriptors mDescriptors;
 
 		BoundingBox3D mBoundingBox = BoundingBox3D(glm::vec3(0.0f), glm::vec3(0.0f));
 
@@ -98,6 +138,7 @@ namespace fre
 		RecordCallback mAfterRecordCallback = nullptr;
 
 		bool mVisible = true;
+		bool mOccluder = false;
 		uint32_t mInstanceCount = 1;
 	};
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "Mesh.hpp"
 #include "Material.hpp"
+#include "SceneGraph.hpp"
 
 #include <glm/glm.hpp>
 #include <assimp/scene.h>
@@ -27,18 +28,37 @@ namespace fre
 		const glm::mat4& getModelMatrix() const;
 		void setModelMatrix(const glm::mat4& newModelMatrix);
 
-		//Creates meshes from assimp node
+		//Node hierarchy meshes are attached to, one node per mesh
+		void setSceneGraph(const SceneGraph& sceneGraph, const std::vector<uint32_t>& meshNodes);
+		SceneGraph& getSceneGraph() { return mSceneGraph; }
+		const SceneGraph& getSceneGraph() const { return mSceneGraph; }
+		//Scene graph node of mesh, NO_PARENT if model has no scene graph
+		uint32_t getMeshNode(size_t index) const { return index < mMeshNodes.size() ? mMeshNodes[index] : SceneGraph::NO_PARENT; }
+		//Recomputes world transforms of changed nodes
+		void updateTransforms(ThreadPool* threadPool = nullptr);
+		//Changes with model matrix and world transforms of nodes
+		uint64_t getTransformsVersion() const { return mTransformsVersion; }
+		//Model matrix combined with world transform of mesh node
+		glm::mat4 getMeshTransform(size_t index) const;
+
+		//Creates meshes from assimp node, adds node and its children to scene graph.
+		//Bounding box is extended by mesh boxes in model space
 		static std::vector<Mesh::Ptr> loadNode(aiNode* node, const aiScene* scene,
-				BoundingBox3D& mn, uint32_t materialOffset);
+				BoundingBox3D& mn, uint32_t materialOffset, SceneGraph& sceneGraph,
+				std::vector<uint32_t>& meshNodes, uint32_t parent = SceneGraph::NO_PARENT);
 		//Creates single mesh from assimp mesh
-		static Mesh::Ptr loadMesh(aiMesh * mesh, BoundingBox3D& mn, uint32_t materialOffset);
+		static Mesh::Ptr loadMesh(aiMesh * mesh, uint32_t materialOffset);
 
-		void setVisible(bool visible) { mVisible = visible; }
+		void setVisible(bool visible);
 		bool isVisible() { return mVisible; }
 
 	private:
 		MeshList meshList;
 		glm::mat4 modelMatrix;
 		bool mVisible = true;
+		SceneGraph mSceneGraph;
+		//Scene graph node of each mesh
+		std::vector<uint32_t> mMeshNodes;
+		uint64_t mTransformsVersion = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <volk.h>
+
+#include "Renderer/Mipmaps.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //Blocks are 4x4 RGBA8 texels row by row. Color endpoints are fitted along principal axis of block
+    //colors and refined by least squares, single channel blocks use 8 interpolated values between min and max
+    void encodeBC1Block(const uint8_t* texels, uint8_t* block);
+    //BC4 alpha block followed by BC1 color block
+    void encodeBC3Block(const uint8_t* texels, uint8_t* block);
+    void encodeBC4Block(const uint8_t* texels, uint32_t channel, uint8_t* block);
+    //BC4 blocks of red and green channels
+    void encodeBC5Block(const uint8_t* texels, uint8_t* block);
+    //BC1, BC3, BC4 and BC5 blocks to RGBA8 texels, channels missing in format are 0, alpha is 255
+    void decodeBlock(VkFormat format, const uint8_t* block, uint8_t* texels);
+
+    //Format encoder uses for 8 bit image: BC4 for 1 channel, BC5 for 2, BC1 for opaque color and BC3 for color with alpha
+    VkFormat chooseBlockCompressedFormat(const uint8_t* data, size_t texelsCount, uint32_t channelsCount);
+
+    //Full chain of 8 bit image in BC1, BC3, BC4 or BC5 format: levels are filtered by generateMipmaps, then split
+    //into blocks, texels of partial blocks are clamped to edge. Block rows are encoded by threadsCount threads,
+    //result doesn't depend on threads count. Levels are tightly packed level 0 first
+    std::vector<MipLevel> compressImage(const uint8_t* data, uint32_t width, uint32_t height, uint32_t channelsCount,
+        bool srgb, VkFormat format, uint32_t threadsCount, std::vector<uint8_t>& levelsData);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    struct CullingSettings
+    {
+        //Merged draws are culled by compute pass on GPU instead of being submitted unconditionally
+        bool mEnabled = false;
+        //Draws hidden behind depth of previous frame are culled too. Scene depth is kept for Hi-Z pyramid
+        bool mOcclusion = false;
+        //Survivors counts read back from GPU are compared with CPU reference. Debug only, costs CPU time
+        bool mValidate = false;
+        //Meshes drawn one by one are tested against frustum on CPU
+        bool mCPUFrustum = false;
+        //Meshes hidden behind occluder meshes rasterized on CPU are culled too, requires mCPUFrustum
+        bool mCPUOcclusion = false;
+        //Size of CPU occlusion depth buffer, rounded down to powers of two
+        uint32_t mOcclusionWidth = 256;
+        uint32_t mOcclusionHeight = 128;
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 mCenter = glm::vec3(0.0f);
+        float mRadius = 0.0f;
+    };
+
+    //Planes point inside: xyz is normalized normal, w is distance
+    struct Frustum
+    {
+        std::array<glm::vec4, 6> mPlanes;
+    };
+
+    //Per-draw input of culling shader, matches std430 layout
+    struct CullingDraw
+    {
+        //Bounding sphere in mesh space: center and radius
+        glm::vec4 mSphere = glm::vec4(0.0f);
+        uint32_t mBatch = 0;
+        //First command of batch in compacted commands
+        uint32_t mBatchFirstDraw = 0;
+        uint32_t mPadding[2] = {};
+    };
+
+    //Parameters of culling shader, matches std140 layout
+    struct CullingData
+    {
+        std::array<glm::vec4, 6> mFrustum;
+        //View projection depth pyramid was rendered with
+        glm::mat4 mOcclusionViewProjection = glm::mat4(1.0f);
+        //Pyramid level 0 width and height, levels count
+        glm::vec4 mHiZ = glm::vec4(0.0f);
+        //Draws count, occlusion flag, compaction flag
+        glm::uvec4 mParams = glm::uvec4(0u);
+    };
+
+    //Conservative max depth pyramid. Level 0 has power of two size not greater than depth,
+    //each texel keeps max depth of all depth texels it covers
+    struct HiZPyramid
+    {
+        void build(const float* depth, uint32_t depthWidth, uint32_t depthHeight, uint32_t width, uint32_t height);
+        uint32_t getLevelsCount() const { return static_cast<uint32_t>(mLevels.size()); }
+        uint32_t getLevelWidth(uint32_t level) const;
+        uint32_t getLevelHeight(uint32_t level) const;
+        float getDepth(uint32_t level, uint32_t x, uint32_t y) const;
+
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        std::vector<std::vector<float>> mLevels;
+    };
+
+    //Vulkan clip space: depth in [0, 1]
+    Frustum getFrustum(const glm::mat4& viewProjection);
+    BoundingSphere getBoundingSphere(const glm::vec3& mn, const glm::vec3& mx);
+    //Radius is scaled by the largest axis scale
+    BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& transform);
+    bool isSphereVisible(const Frustum& frustum, const BoundingSphere& sphere);
+    //World space sphere is tested against pyramid built from depth rendered with viewProjection.
+    //Spheres crossing near plane are never occluded
+    bool isSphereOccluded(const HiZPyramid& pyramid, const glm::mat4& viewProjection, const BoundingSphere& sphere);
+    //Same test for world space axis aligned box given by center and half extents
+    bool isBoxOccluded(const HiZPyramid& pyramid, const glm::mat4& viewProjection, const glm::vec3& center, const glm::vec3& extent);
+    //Hi-Z level 0 size for depth size
+    uint32_t getHiZSize(uint32_t depthSize);
+    uint32_t getHiZLevelsCount(uint32_t width, uint32_t height);
+
+    //Reference of culling shader. Returns survivors count per batch, draws are culled with
+    //transforms of their instances. Pyramid is optional
+    std::vector<uint32_t> cullDraws(
+        const std::vector<CullingDraw>& draws,
+        const std::vector<glm::mat4>& transforms,
+        uint32_t batchesCount,
+        const Frustum& frustum,
+        const HiZPyramid* pyramid,
+        const glm::mat4& occlusionViewProjection);
+}
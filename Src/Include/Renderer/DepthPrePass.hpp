@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace fre
+{
+    enum class EDepthPrePassMode
+    {
+        Off,
+        On,
+        //Enabled while measured overdraw is high
+        Auto
+    };
+
+    struct DepthPrePassSettings
+    {
+        EDepthPrePassMode mMode = EDepthPrePassMode::Off;
+        //Fragment shader invocations per pixel which enable pre-pass in auto mode
+        float mEnableOverdraw = 2.0f;
+        //Pre-pass is disabled again when overdraw drops below
+        float mDisableOverdraw = 1.5f;
+        //Frames in a row overdraw must stay out of band before state changes
+        uint32_t mFramesToChange = 3;
+        //Overdraw can't be measured while pre-pass is on, so every N frames one frame is rendered without it
+        uint32_t mProbeInterval = 120;
+    };
+
+    //Decides per frame whether depth pre-pass is recorded.
+    //Pure CPU logic, it can be driven by synthetic overdraw traces
+    struct DepthPrePass
+    {
+        //Returns true if frame being recorded should use pre-pass
+        bool beginFrame();
+        //Overdraw of main geometry draws of frame recorded with or without pre-pass
+        void update(float overdraw, bool withPrePass);
+        void reset();
+
+        bool isEnabled() const;
+        float getOverdraw() const { return mOverdraw; }
+
+        DepthPrePassSettings mSettings;
+
+    private:
+        bool mAutoEnabled = false;
+        float mOverdraw = 0.0f;
+        uint32_t mOutOfBandFrames = 0;
+        uint32_t mFramesSinceProbe = 0;
+    };
+}
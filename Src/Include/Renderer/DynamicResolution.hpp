@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+namespace fre
+{
+    struct DynamicResolutionSettings
+    {
+        //Frame time budget, ms
+        float mTargetFrameTime = 16.6f;
+        float mMinScale = 0.5f;
+        float mMaxScale = 1.0f;
+        //Scale changes by multiples of step, so it doesn't drift every frame
+        float mScaleStep = 0.05f;
+        //Scale goes down when frame time is above target * mHighThreshold
+        float mHighThreshold = 1.05f;
+        //Scale goes up when frame time is below target * mLowThreshold
+        float mLowThreshold = 0.8f;
+        //Frames in a row frame time must stay out of band before scale changes
+        uint32_t mFramesToDecrease = 5;
+        uint32_t mFramesToIncrease = 60;
+        //Frames ignored after change: frames in flight were rendered with old scale
+        uint32_t mCooldownFrames = 4;
+        //Weight of new frame time in moving average
+        float mSmoothing = 0.2f;
+    };
+
+    //Chooses render scale relative to swapchain extent from measured GPU frame time.
+    //Pure CPU logic, it can be driven by synthetic frame time traces
+    struct DynamicResolution
+    {
+        //Returns true if scale changed
+        bool update(float gpuFrameTime);
+        void reset(float scale);
+
+        float getScale() const { return mScale; }
+        float getAverageFrameTime() const { return mFrameTime; }
+        //Size of swapchain dimension at current scale
+        uint32_t getScaledSize(uint32_t size) const;
+
+        DynamicResolutionSettings mSettings;
+
+    private:
+        float quantize(float scale) const;
+
+        float mScale = 1.0f;
+        float mFrameTime = 0.0f;
+        bool mHasFrameTime = false;
+        uint32_t mOverBudgetFrames = 0;
+        uint32_t mUnderBudgetFrames = 0;
+        uint32_t mCooldown = 0;
+    };
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Renderer/Culling.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //Objects processed by one SIMD test, arrays of bounds are padded to it
+    const uint32_t CULLING_SIMD_WIDTH = 8;
+    //Radius of objects whose bounds are unknown, they are never culled
+    const float UNBOUNDED_RADIUS = 1.0e30f;
+
+    //World space bounds in structure of arrays layout: bounding sphere and half extents of
+    //axis aligned box sharing its center
+    struct CullingBounds
+    {
+        void clear() { mCount = 0; }
+        //Mesh space box is transformed to world space. Returns index of object
+        uint32_t add(const glm::vec3& mn, const glm::vec3& mx, const glm::mat4& transform);
+        //Object which always passes culling
+        uint32_t addUnbounded();
+        uint32_t size() const { return mCount; }
+
+        std::vector<float> mCenterX;
+        std::vector<float> mCenterY;
+        std::vector<float> mCenterZ;
+        std::vector<float> mRadius;
+        std::vector<float> mExtentX;
+        std::vector<float> mExtentY;
+        std::vector<float> mExtentZ;
+        uint32_t mCount = 0;
+
+    private:
+        uint32_t push();
+    };
+
+    //Object is outside if it is behind any plane by both its sphere and its box.
+    //Visibility is written as 0 or 1 per object, returns visible objects count
+    uint32_t cullBoundsScalar(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint8_t>& visibility);
+    //Same test for several objects per instruction: AVX, SSE2 or NEON, whatever target is built for
+    uint32_t cullBoundsSIMD(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint8_t>& visibility);
+    const char* getCullingSIMDName();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //Location of mesh geometry inside arenas, in terms of indexed draw parameters
+    struct GeometryArenaRange
+    {
+        uint32_t mArena = 0;
+        uint32_t mFirstIndex = 0;
+        uint32_t mIndexCount = 0;
+        int32_t mVertexOffset = 0;
+    };
+
+    //Geometry of many meshes packed together. Meshes with the same vertex size share arena,
+    //so one vertex and one index buffer bind serves all of them
+    struct GeometryArena
+    {
+        uint32_t mVertexSize = 0;
+        std::vector<uint8_t> mVertices;
+        std::vector<uint32_t> mIndices;
+        //Buffer manager ids, assigned when arena is uploaded
+        uint32_t mVertexBufferId = ~0u;
+        uint32_t mIndexBufferId = ~0u;
+        //CPU data is released, new meshes go to other arenas
+        bool mSealed = false;
+
+        uint32_t getVertexCount() const { return mVertexSize > 0 ? static_cast<uint32_t>(mVertices.size() / mVertexSize) : 0; }
+    };
+
+    //Packs static meshes on CPU. Arenas are uploaded once and CPU copies are released.
+    //Pure CPU logic, packing can be checked without device
+    struct GeometryArenas
+    {
+        GeometryArenaRange add(uint32_t vertexSize, const void* vertices, uint32_t verticesCount,
+            const uint32_t* indices, uint32_t indicesCount);
+        //Drops CPU copies of arenas geometry and seals arenas, ranges stay valid
+        void releaseCPUData();
+        void clear();
+
+        //Arena is closed when it would exceed this size, next meshes go to a new one
+        size_t mMaxArenaSize = 64 * 1024 * 1024;
+        std::vector<GeometryArena> mArenas;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //Levels of full chain, the last one is 1x1
+    uint32_t getMipLevelsCount(uint32_t width, uint32_t height);
+
+    struct MipLevel
+    {
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        //Range of level in generated data, bytes
+        size_t mOffset = 0;
+        size_t mSize = 0;
+    };
+
+    //Full chain of 8 bit image with interleaved channels, level 0 is copied first and levels follow it
+    //tightly packed. Odd sizes are filtered by 3 taps weighted by coverage, so no texel is dropped.
+    //Color channels of sRGB image are averaged in linear space, alpha (last of 2 or 4 channels) is
+    //linear always. Every level is filtered from unrounded previous one and result is the same on every run
+    std::vector<MipLevel> generateMipmaps(const uint8_t* data, uint32_t width, uint32_t height,
+        uint32_t channelsCount, bool srgb, std::vector<uint8_t>& levelsData);
+}
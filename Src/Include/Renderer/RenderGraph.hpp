@@ -0,0 +1,152 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fre
+{
+    //How pass accesses resource
+    enum class ERenderGraphUsage
+    {
+        ColorAttachment,
+        DepthAttachment,
+        //Depth test without depth writes
+        DepthReadOnly,
+        InputAttachment,
+        Sampled,
+        StorageRead,
+        StorageWrite,
+        TransferSrc,
+        TransferDst,
+        Count
+    };
+
+    //Image resource. All resources have framebuffer extent
+    struct RenderGraphResourceDesc
+    {
+        std::string mName;
+        VkFormat mFormat = VK_FORMAT_UNDEFINED;
+        VkImageAspectFlags mAspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        //External resources (swapchain images) are not owned by graph, never aliased and never lazy
+        bool mExternal = false;
+        VkImageLayout mInitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout mFinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    struct RenderGraphAccess
+    {
+        uint32_t mResource = 0;
+        ERenderGraphUsage mUsage = ERenderGraphUsage::Count;
+    };
+
+    struct RenderGraphPass
+    {
+        std::string mName;
+        std::vector<RenderGraphAccess> mAccesses;
+        //Pass renders into area scaled by dynamic resolution
+        bool mDynamicResolution = false;
+        //Render pass and subpass in it, assigned on compilation
+        uint32_t mRenderPass = 0;
+        uint32_t mSubpass = 0;
+    };
+
+    //Synchronisation between previous access of resource and access in pass
+    struct RenderGraphBarrier
+    {
+        static const uint32_t EXTERNAL = ~0u;
+
+        uint32_t mResource = 0;
+        //Pass of previous access or EXTERNAL if it happened outside of frame graph.
+        //Barrier after several reads waits for all of them and names the last one
+        uint32_t mSrcPass = EXTERNAL;
+        uint32_t mDstPass = EXTERNAL;
+        VkImageLayout mOldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout mNewLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags mSrcStage = 0;
+        VkPipelineStageFlags mDstStage = 0;
+        VkAccessFlags mSrcAccess = 0;
+        VkAccessFlags mDstAccess = 0;
+    };
+
+    //Result of graph compilation for resource
+    struct RenderGraphResource
+    {
+        static const int32_t NO_MEMORY_SLOT = -1;
+
+        RenderGraphResourceDesc mDesc;
+        uint32_t mFirstPass = RenderGraphBarrier::EXTERNAL;
+        uint32_t mLastPass = RenderGraphBarrier::EXTERNAL;
+        VkImageUsageFlags mUsage = 0;
+        //Layout per pass, UNDEFINED in passes that don't access resource
+        std::vector<VkImageLayout> mLayouts;
+        VkImageLayout mFinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        //Only used as attachment, content never leaves tile memory
+        bool mLazy = false;
+        //Transient resources sharing slot share memory
+        int32_t mMemorySlot = NO_MEMORY_SLOT;
+        //Resource which used slot memory before this one (may be from previous frame)
+        uint32_t mAliasPredecessor = RenderGraphBarrier::EXTERNAL;
+
+        bool isUsed() const { return mFirstPass != RenderGraphBarrier::EXTERNAL; }
+        bool isAttachment() const;
+    };
+
+    //Passes declare reads and writes of named resources. Compilation derives layouts, barriers,
+    //memory aliasing and lazy allocation without touching device, so it can be checked on CPU.
+    //Consecutive passes are merged into subpasses of one render pass until a pass reads
+    //an attachment of current render pass other than as input attachment.
+    //Layouts are changed only by render passes resource is attached to.
+    struct RenderGraph
+    {
+        uint32_t addResource(const RenderGraphResourceDesc& desc);
+        uint32_t addPass(const std::string& name, bool dynamicResolution = false);
+        void read(uint32_t pass, uint32_t resource, ERenderGraphUsage usage);
+        void write(uint32_t pass, uint32_t resource, ERenderGraphUsage usage);
+        void clear();
+
+        void compile();
+
+        uint32_t getResourceId(const std::string& name) const;
+        uint32_t getResourcesCount() const { return static_cast<uint32_t>(mResources.size()); }
+        uint32_t getPassesCount() const { return static_cast<uint32_t>(mPasses.size()); }
+        uint32_t getRenderPassesCount() const { return mRenderPassesCount; }
+        uint32_t getMemorySlotsCount() const { return mMemorySlotsCount; }
+        const RenderGraphResource& getResource(uint32_t id) const;
+        const RenderGraphPass& getPass(uint32_t id) const;
+        //Resources used as attachments of render pass, in framebuffer order
+        std::vector<uint32_t> getAttachments(uint32_t renderPass) const;
+        //Layout of resource right before pass starts
+        VkImageLayout getLayoutBefore(uint32_t resource, uint32_t pass) const;
+        //Barriers to execute before pass
+        const std::vector<RenderGraphBarrier>& getBarriers(uint32_t pass) const;
+        //Barriers to execute after last pass (external resources to final layout)
+        const std::vector<RenderGraphBarrier>& getFinalBarriers() const { return mFinalBarriers; }
+        bool isCompiled() const { return mCompiled; }
+
+    private:
+        void addAccess(uint32_t pass, uint32_t resource, ERenderGraphUsage usage);
+        void computeRenderPasses();
+        void computeLifetimes();
+        void assignMemorySlots();
+        void computeBarriers();
+
+        std::vector<RenderGraphResource> mResources;
+        std::vector<RenderGraphPass> mPasses;
+        std::vector<std::vector<RenderGraphBarrier>> mBarriers;
+        std::vector<RenderGraphBarrier> mFinalBarriers;
+        uint32_t mMemorySlotsCount = 0;
+        uint32_t mRenderPassesCount = 0;
+        bool mCompiled = false;
+    };
+
+    bool isWriteUsage(ERenderGraphUsage usage);
+    bool isAttachmentUsage(ERenderGraphUsage usage);
+    VkImageLayout getUsageLayout(ERenderGraphUsage usage, VkImageAspectFlags aspect);
+    VkPipelineStageFlags getUsageStage(ERenderGraphUsage usage);
+    VkAccessFlags getUsageAccess(ERenderGraphUsage usage);
+    VkImageUsageFlags getUsageImageFlags(ERenderGraphUsage usage);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "MeshModel.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //State of render object which decides how scene loop treats it
+    enum ERenderObjectFlag : uint8_t
+    {
+        RO_VISIBLE = 1u << 0,
+        //Mesh has before or after visit callbacks
+        RO_VISIT_CALLBACKS = 1u << 1,
+        //Mesh has before or after record or push constants callbacks
+        RO_RECORD_CALLBACKS = 1u << 2,
+        RO_COMPUTE = 1u << 3,
+        //Drawn by merged indirect draws instead of own draw call
+        RO_MERGED = 1u << 4,
+        //Rejected by CPU culling this frame
+        RO_CULLED = 1u << 5
+    };
+
+    //Meshes of all models flattened into structure of arrays, rebuilt when scene changes. Object index
+    //follows models and their meshes order. Scene loop reads flags and transforms from here and
+    //touches meshes only for objects it records
+    struct RenderObjectTable
+    {
+        void clear();
+        //Adds objects of all model meshes and transforms of its nodes, returns index of first object
+        uint32_t addModel(uint32_t modelId, const MeshModel::Ptr& model);
+        //Recomputes normal matrices of transforms changed since previous update, returns their count
+        uint32_t updateNormalMatrices();
+
+        //Models are numbered in order they were added
+        uint32_t getModelsCount() const { return static_cast<uint32_t>(mModelFirstObjects.size()); }
+        //Objects of model are [getModelFirstObject(model), getModelFirstObject(model + 1))
+        uint32_t getModelFirstObject(uint32_t model) const
+        {
+            return model < mModelFirstObjects.size() ? mModelFirstObjects[model] : size();
+        }
+        //Writes transforms of moved model again, its nodes count must be the one it was added with.
+        //Returns count of normal matrices recomputed
+        uint32_t updateModelTransforms(uint32_t model, const MeshModel::Ptr& meshModel);
+
+        uint32_t size() const { return static_cast<uint32_t>(mFlags.size()); }
+        const glm::mat4& getTransform(uint32_t object) const { return mTransforms[mTransformIds[object]]; }
+        const glm::mat4& getNormalMatrix(uint32_t object) const { return mNormalMatrices[mTransformIds[object]]; }
+
+        std::vector<uint32_t> mModelIds;
+        //Mesh index within model
+        std::vector<uint32_t> mMeshIndices;
+        std::vector<uint32_t> mTransformIds;
+        std::vector<uint32_t> mMaterialIds;
+        //Range of mesh indices, offsets are set for meshes packed into geometry arenas
+        std::vector<uint32_t> mFirstIndices;
+        std::vector<uint32_t> mIndexCounts;
+        std::vector<int32_t> mVertexOffsets;
+        //Draw calls of mesh without instances, instanced mesh is drawn once
+        std::vector<uint32_t> mDrawCounts;
+        std::vector<uint8_t> mFlags;
+        //Model matrix combined with world transforms of model nodes, shared by meshes of node
+        std::vector<glm::mat4> mTransforms;
+        //Inverse transposed transforms, kept between frames
+        std::vector<glm::mat4> mNormalMatrices;
+
+    private:
+        uint32_t updateNormalMatrices(size_t first, size_t end);
+
+        std::vector<uint32_t> mModelFirstObjects;
+        std::vector<uint32_t> mModelFirstTransforms;
+        //Transforms normal matrices were computed from
+        std::vector<glm::mat4> mNormalSources;
+    };
+}
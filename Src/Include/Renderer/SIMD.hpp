@@ -0,0 +1,107 @@
+#pragma once
+
+//Instruction set is picked at compile time: AVX builds use SSE for 4-wide code too
+#if defined(__AVX__)
+    #include <immintrin.h>
+    #define FRE_SIMD_AVX
+    #define FRE_SIMD_SSE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define FRE_SIMD_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define FRE_SIMD_NEON
+#endif
+
+namespace fre
+{
+    //Four floats processed together. Masks have all bits of lane set or cleared
+#if defined(FRE_SIMD_SSE)
+    using SimdFloat4 = __m128;
+
+    inline SimdFloat4 simdSet(float value) { return _mm_set1_ps(value); }
+    //Lanes are value, value + 1, value + 2, value + 3
+    inline SimdFloat4 simdRamp(float value) { return _mm_add_ps(_mm_set1_ps(value), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f)); }
+    inline SimdFloat4 simdLoad(const float* data) { return _mm_loadu_ps(data); }
+    inline void simdStore(float* data, SimdFloat4 value) { _mm_storeu_ps(data, value); }
+    inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { return _mm_add_ps(a, b); }
+    inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { return _mm_mul_ps(a, b); }
+    inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { return _mm_min_ps(a, b); }
+    inline SimdFloat4 simdGreaterEqual(SimdFloat4 a, SimdFloat4 b) { return _mm_cmpge_ps(a, b); }
+    inline SimdFloat4 simdAnd(SimdFloat4 a, SimdFloat4 b) { return _mm_and_ps(a, b); }
+    inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    inline bool simdAny(SimdFloat4 mask) { return _mm_movemask_ps(mask) != 0; }
+#elif defined(FRE_SIMD_NEON)
+    using SimdFloat4 = float32x4_t;
+
+    inline SimdFloat4 simdSet(float value) { return vdupq_n_f32(value); }
+    inline SimdFloat4 simdRamp(float value)
+    {
+        const float ramp[4] = { value, value + 1.0f, value + 2.0f, value + 3.0f };
+        return vld1q_f32(ramp);
+    }
+    inline SimdFloat4 simdLoad(const float* data) { return vld1q_f32(data); }
+    inline void simdStore(float* data, SimdFloat4 value) { vst1q_f32(data, value); }
+    inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { return vaddq_f32(a, b); }
+    inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { return vmulq_f32(a, b); }
+    inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { return vminq_f32(a, b); }
+    inline SimdFloat4 simdGreaterEqual(SimdFloat4 a, SimdFloat4 b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+    inline SimdFloat4 simdAnd(SimdFloat4 a, SimdFloat4 b)
+    {
+        return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+    }
+    inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+    inline bool simdAny(SimdFloat4 mask)
+    {
+        const uint32x4_t bits = vreinterpretq_u32_f32(mask);
+        const uint32x2_t half = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+        return vget_lane_u32(vpmax_u32(half, half), 0) != 0;
+    }
+#else
+    //Scalar fallback, masks are 0 or 1
+    struct SimdFloat4
+    {
+        float mValues[4];
+    };
+
+    template<class Operation>
+    inline SimdFloat4 simdLanewise(SimdFloat4 a, SimdFloat4 b, Operation operation)
+    {
+        SimdFloat4 result;
+        for(int i = 0; i < 4; i++)
+        {
+            result.mValues[i] = operation(a.mValues[i], b.mValues[i]);
+        }
+        return result;
+    }
+
+    inline SimdFloat4 simdSet(float value) { return { { value, value, value, value } }; }
+    inline SimdFloat4 simdRamp(float value) { return { { value, value + 1.0f, value + 2.0f, value + 3.0f } }; }
+    inline SimdFloat4 simdLoad(const float* data) { return { { data[0], data[1], data[2], data[3] } }; }
+    inline void simdStore(float* data, SimdFloat4 value)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            data[i] = value.mValues[i];
+        }
+    }
+    inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { return simdLanewise(a, b, [](float x, float y) { return x + y; }); }
+    inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { return simdLanewise(a, b, [](float x, float y) { return x * y; }); }
+    inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { return simdLanewise(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    inline SimdFloat4 simdGreaterEqual(SimdFloat4 a, SimdFloat4 b) { return simdLanewise(a, b, [](float x, float y) { return x >= y ? 1.0f : 0.0f; }); }
+    inline SimdFloat4 simdAnd(SimdFloat4 a, SimdFloat4 b) { return simdLanewise(a, b, [](float x, float y) { return x * y; }); }
+    inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b)
+    {
+        SimdFloat4 result;
+        for(int i = 0; i < 4; i++)
+        {
+            result.mValues[i] = mask.mValues[i] != 0.0f ? a.mValues[i] : b.mValues[i];
+        }
+        return result;
+    }
+    inline bool simdAny(SimdFloat4 mask)
+    {
+        return mask.mValues[0] != 0.0f || mask.mValues[1] != 0.0f || mask.mValues[2] != 0.0f || mask.mValues[3] != 0.0f;
+    }
+#endif
+}
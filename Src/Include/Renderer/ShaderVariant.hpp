@@ -0,0 +1,65 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace fre
+{
+    //Feature toggles of uber shader. Bit index is specialization constant id in shader
+    enum EShaderFeature : uint32_t
+    {
+        SF_TEXTURED = 1u << 0,
+        SF_NORMAL_MAP = 1u << 1,
+        SF_PBR = 1u << 2,
+        SF_COUNT = 3
+    };
+
+    //Identifies pipeline variant created from the same shader modules
+    struct ShaderVariantKey
+    {
+        uint32_t mFeatures = 0u;
+
+        bool hasFeature(EShaderFeature feature) const
+        {
+            return (mFeatures & feature) != 0u;
+        }
+
+        bool operator==(const ShaderVariantKey& other) const
+        {
+            return mFeatures == other.mFeatures;
+        }
+    };
+
+    //Specialization constants for variant. Must outlive pipeline creation
+    struct ShaderSpecialization
+    {
+        explicit ShaderSpecialization(const ShaderVariantKey& key);
+
+        ShaderSpecialization(const ShaderSpecialization&) = delete;
+        ShaderSpecialization& operator=(const ShaderSpecialization&) = delete;
+
+        std::vector<VkSpecializationMapEntry> mMapEntries;
+        std::vector<VkBool32> mData;
+        VkSpecializationInfo mInfo = {};
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<fre::ShaderVariantKey>
+    {
+        std::size_t operator()(const fre::ShaderVariantKey& key) const
+        {
+            std::size_t seed = 0;
+            std::hash<uint32_t> hasher;
+            seed ^= hasher(key.mFeatures) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+            return seed;
+        }
+    };
+}
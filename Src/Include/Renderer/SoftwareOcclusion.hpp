@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Renderer/Culling.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //Low resolution depth buffer occluders are rasterized into on CPU. Depth is in [0, 1] with
+    //nearer being smaller and rows go from top of screen, as in Vulkan. Pure CPU, no device needed
+    struct OcclusionRasterizer
+    {
+        //Sizes are rounded down to powers of two, so pyramid levels halve exactly
+        void resize(uint32_t width, uint32_t height);
+        void clear();
+        //Triangles are rasterized with both windings and clipped by near plane.
+        //Position is the first vec3 of vertex. Without indices vertices form triangle list
+        void rasterize(const void* vertices, uint32_t vertexSize, uint32_t verticesCount,
+            const uint32_t* indices, uint32_t indicesCount, const glm::mat4& modelViewProjection);
+        //Max depth pyramid of rasterized occluders
+        void buildPyramid(HiZPyramid& pyramid) const;
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+        const std::vector<float>& getDepth() const { return mDepth; }
+        //Triangles whose bounds overlapped depth buffer since last clear
+        uint32_t getTrianglesCount() const { return mTrianglesCount; }
+
+    private:
+        void clipAndRasterize(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+        //Screen space x and y in pixels, z is depth
+        void rasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2);
+
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        std::vector<float> mDepth;
+        std::vector<glm::vec4> mClipPositions;
+        uint32_t mTrianglesCount = 0;
+    };
+}
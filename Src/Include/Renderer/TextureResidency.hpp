@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace fre
+{
+    //Resident chain of texture goes from top level down to the smallest one, level 0 is full size
+    struct TextureResidencyChange
+    {
+        uint32_t mTexture = 0;
+        uint32_t mFromLevel = 0;
+        //Finer than from level for loads, coarser for evictions
+        uint32_t mToLevel = 0;
+    };
+
+    //Mip residency of streamed textures under memory budget, memory is accounted by level sizes only. Levels from
+    //tail level on are always resident, so texture starts with low mips. Levels finer than tail are loaded when
+    //requested. When budget is exceeded levels finer than requested ones are dropped first, then levels of least
+    //recently requested textures, one level at a time. Textures requested in the same frame don't evict each other
+    class TextureResidency
+    {
+    public:
+        void setBudget(uint64_t budget) { mBudget = budget; }
+        uint64_t getBudget() const { return mBudget; }
+        //Bytes of levels loaded by one update, so uploads don't stall a frame. 0 doesn't limit them
+        void setLoadLimit(uint64_t loadLimit) { mLoadLimit = loadLimit; }
+        //Level sizes of chain, level 0 first. Returns top resident level, which is tail level
+        uint32_t addTexture(uint32_t texture, const std::vector<uint64_t>& levelSizes, uint32_t tailLevel);
+        void removeTexture(uint32_t texture);
+        bool hasTexture(uint32_t texture) const { return texture < mTextures.size() && mTextures[texture].mAdded; }
+        //Finest level texture is sampled at in frame. Frames don't go back
+        void request(uint32_t texture, uint32_t level, uint64_t frame);
+        //Changes of resident levels made for requests up to frame, they are applied by caller
+        std::vector<TextureResidencyChange> update(uint64_t frame);
+        //Change caller couldn't apply, like data that failed to load
+        void revert(const TextureResidencyChange& change);
+
+        uint32_t getResidentLevel(uint32_t texture) const { return mTextures[texture].mResidentLevel; }
+        uint64_t getResidentSize() const { return mResidentSize; }
+        //Tails of all textures, resident whatever budget is
+        uint64_t getMinimumSize() const { return mMinimumSize; }
+        uint32_t getTexturesCount() const { return mTexturesCount; }
+
+    private:
+        struct Texture
+        {
+            std::vector<uint64_t> mLevelSizes;
+            uint32_t mTailLevel = 0;
+            uint32_t mResidentLevel = 0;
+            uint32_t mRequestedLevel = 0;
+            uint64_t mRequestFrame = 0;
+            bool mAdded = false;
+        };
+
+        //Levels are dropped until needed bytes fit budget. Only textures requested before frame give up requested levels
+        bool freeMemory(uint64_t neededSize, uint64_t frame, std::vector<TextureResidencyChange>& changes);
+        void setResidentLevel(uint32_t texture, uint32_t level, std::vector<TextureResidencyChange>& changes);
+
+        std::vector<Texture> mTextures;
+        uint32_t mTexturesCount = 0;
+        uint64_t mBudget = UINT64_MAX;
+        uint64_t mLoadLimit = 0;
+        uint64_t mResidentSize = 0;
+        uint64_t mMinimumSize = 0;
+        //Textures that lost levels in current update aren't loaded again in it
+        std::vector<uint8_t> mEvicted;
+        //Textures of current update from least recently requested one
+        std::vector<uint32_t> mVictims;
+    };
+}
@@ -8,6 +8,7 @@
 namespace fre
 {
     struct MainDevice;
+    struct RenderGraphResource;
 
     enum class EAttachmentKind
     {
@@ -23,10 +24,18 @@ namespace fre
     struct VulkanAttachment
     {
         void create(const MainDevice& mainDevice, EAttachmentKind attachmentKind, VkExtent2D swapChainExtent);
+        //Render graph resources are created in steps, so transient resources can share memory
+        void createImage(const MainDevice& mainDevice, const RenderGraphResource& resource, VkExtent2D extent);
+        //Own memory. Lazily allocated if resource never leaves tile memory and device supports it
+        void allocateMemory(const MainDevice& mainDevice, bool lazy);
+        void bindMemory(VkDevice logicalDevice, VkDeviceMemory memory);
+        void createImageView(VkDevice logicalDevice);
         void destroy(VkDevice logicalDevice);
 
         VkImageView mImageView = VK_NULL_HANDLE;
         VkImage mImage = VK_NULL_HANDLE;
+        VkFormat mFormat = VK_FORMAT_UNDEFINED;
+        VkImageAspectFlags mAspect = VK_IMAGE_ASPECT_COLOR_BIT;
     private:
         VkDeviceMemory mImageMemory = VK_NULL_HANDLE;
     };
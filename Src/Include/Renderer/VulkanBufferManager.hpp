@@ -8,6 +8,7 @@
 namespace fre
 {
     struct MainDevice;
+    class VulkanOneTimeCommandPool;
     
     struct VulkanBuffer
     {
@@ -28,9 +29,9 @@ namespace fre
         void destroyBuffer(VkDevice logicalDevice, VulkanBuffer& buffer);
 
         VulkanBuffer createStagingBuffer(const MainDevice& mainDevice, VkQueue transferQueue,
-		    VkCommandPool transferCommandPool, const void* data, size_t size);
+		    VulkanOneTimeCommandPool& transferCommandPool, const void* data, size_t size);
         const VulkanBuffer& createBuffer(const MainDevice& mainDevice, VkQueue transferQueue,
-            VkCommandPool transferCommandPool, VkBufferUsageFlags bufferUsage,
+            VulkanOneTimeCommandPool& transferCommandPool, VkBufferUsageFlags bufferUsage,
             VkMemoryPropertyFlags memoryFlags, const void* data, size_t size);
         const VulkanBuffer& createExternalBuffer(const MainDevice& mainDevice, VkBufferUsageFlags bufferUsage,
             VkMemoryPropertyFlags memoryFlags, VkExternalMemoryHandleTypeFlagsKHR extMemHandleType, VkDeviceSize size);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include "Renderer/Culling.hpp"
+#include "Renderer/VulkanDeletionQueue.hpp"
+#include "Renderer/VulkanDescriptorPool.hpp"
+#include "Renderer/VulkanDescriptorSetLayout.hpp"
+#include "Renderer/VulkanPipeline.hpp"
+#include "Renderer/VulkanStreamBuffer.hpp"
+
+#include <vector>
+
+namespace fre
+{
+    struct MainDevice;
+
+    //Compute pass culling indirect draws by bounding spheres against frustum and optionally
+    //against Hi-Z pyramid built from depth of previous frame. Survivors of each batch are
+    //compacted into culled commands and counted, so draws can be issued with GPU draw count.
+    //Inputs and outputs have a region per command buffer
+    struct VulkanCullingPass
+    {
+        //Returns false if culling shaders are not available
+        bool create(const MainDevice& mainDevice, uint32_t regionsCount, VkSampler sampler,
+            VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+        void destroy(VkDevice logicalDevice);
+        bool isCreated() const { return mCullPipeline.mPipeline != VK_NULL_HANDLE; }
+
+        //Pyramid for depth of given extent. Without depth views pyramid is never built
+        void createHiZ(const MainDevice& mainDevice, VkExtent2D extent, const std::vector<VkImageView>& depthViews);
+        void destroyHiZ(VkDevice logicalDevice);
+        //Pyramid holds depth of previously recorded frame
+        bool isHiZValid() const { return mHiZValid; }
+
+        //Grows per-draw buffers. Waits for device and returns true if they are recreated
+        bool reserve(const MainDevice& mainDevice, VulkanDeletionQueue& deletionQueue, uint32_t drawsCount, uint32_t batchesCount);
+        //Copies draws to region unless it already holds given version
+        void updateDraws(uint32_t region, const std::vector<CullingDraw>& draws, uint32_t version);
+        CullingData* getData(uint32_t region);
+        //Survivors per batch written by last execution of region
+        const uint32_t* getCounts(uint32_t region);
+
+        //Culls draws whose commands and instances are in given buffer ranges. Must be recorded outside of render pass
+        void recordCulling(VkCommandBuffer commandBuffer, uint32_t region, uint32_t drawsCount, uint32_t batchesCount,
+            VkDescriptorBufferInfo commands, VkDescriptorBufferInfo instances);
+        //Builds pyramid from depth attachment in depth read-only layout
+        void recordHiZ(VkCommandBuffer commandBuffer, uint32_t region, VkExtent2D depthExtent, const glm::mat4& viewProjection);
+
+        VkBuffer getCulledCommandsBuffer() const { return mCulledCommandsBuffer; }
+        VkDeviceSize getCulledCommandsOffset(uint32_t region) const { return region * mCulledCommandsRegionSize; }
+        VkBuffer getCountsBuffer() const { return mCountsBuffer.mBuffer; }
+        VkDeviceSize getCountsOffset(uint32_t region) const { return mCountsBuffer.getOffset(region); }
+        uint32_t getHiZWidth() const { return mHiZWidth; }
+        uint32_t getHiZHeight() const { return mHiZHeight; }
+        uint32_t getHiZLevelsCount() const { return static_cast<uint32_t>(mHiZLevelViews.size()); }
+        //View projection of frame pyramid was built from
+        const glm::mat4& getHiZViewProjection() const { return mHiZViewProjection; }
+
+    private:
+        void transitionHiZ(VkCommandBuffer commandBuffer);
+
+        VkDevice mLogicalDevice = VK_NULL_HANDLE;
+        VkSampler mSampler = VK_NULL_HANDLE;
+
+        VulkanDescriptorSetLayout mCullLayout;
+        VulkanDescriptorSetLayout mHiZLayout;
+        VulkanPipeline mCullPipeline;
+        VulkanPipeline mHiZPipeline;
+        VulkanDescriptorPool mCullDescriptorPool;
+        //One per region, updated when region is recorded
+        std::vector<VkDescriptorSet> mCullDescriptorSets;
+
+        VulkanStreamBuffer mDrawsBuffer;
+        VulkanStreamBuffer mDataBuffer;
+        //Host visible, so survivors can be read back for statistics and validation
+        VulkanStreamBuffer mCountsBuffer;
+        VkBuffer mCulledCommandsBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory mCulledCommandsMemory = VK_NULL_HANDLE;
+        VkDeviceSize mCulledCommandsRegionSize = 0;
+
+        //Max depth pyramid, kept in general layout
+        VkImage mHiZImage = VK_NULL_HANDLE;
+        VkDeviceMemory mHiZMemory = VK_NULL_HANDLE;
+        VkImageView mHiZView = VK_NULL_HANDLE;
+        std::vector<VkImageView> mHiZLevelViews;
+        uint32_t mHiZWidth = 0;
+        uint32_t mHiZHeight = 0;
+        bool mHiZTransitioned = false;
+        bool mHiZValid = false;
+        glm::mat4 mHiZViewProjection = glm::mat4(1.0f);
+        VulkanDescriptorPool mHiZDescriptorPool;
+        //Level 0 reads depth attachment of region, other levels read previous level
+        std::vector<VkDescriptorSet> mHiZDepthDescriptorSets;
+        std::vector<VkDescriptorSet> mHiZLevelDescriptorSets;
+    };
+}
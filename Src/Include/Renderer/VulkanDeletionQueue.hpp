@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace fre
+{
+    //Destroys GPU objects released while recording a frame once fence of that frame slot is
+    //signaled again, so replacing a resource in use doesn't wait for device idle. Deleters own
+    //handles they destroy and queue knows nothing about device, retirement runs without it
+    class VulkanDeletionQueue
+    {
+    public:
+        using Deleter = std::function<void()>;
+
+        void create(uint32_t framesCount);
+        //Runs all queued deleters, device must be idle
+        void destroy();
+
+        //Fence of frame slot is signaled: deleters queued in slot run, releases go to slot from now on
+        void beginFrame(uint32_t frame);
+        //Deleter runs when GPU is done with frames recorded so far
+        void push(Deleter&& deleter);
+
+        uint32_t getPendingCount() const { return mPendingCount; }
+
+    private:
+        void retire(uint32_t frame);
+
+        std::vector<std::vector<Deleter>> mFrames;
+        uint32_t mCurrentFrame = 0;
+        uint32_t mPendingCount = 0;
+    };
+}
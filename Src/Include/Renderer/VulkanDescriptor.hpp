@@ -14,11 +14,26 @@ namespace fre
     {
         VulkanDescriptor(VkDescriptorType type)
             : mType(type)
+            , mVersion(getNextVersion())
         {
         }
         VkDescriptorType mType = VK_DESCRIPTOR_TYPE_MAX_ENUM;
         virtual ~VulkanDescriptor() = default;
         virtual VkWriteDescriptorSet getWriter(VkDescriptorSet ds, uint32_t binding) = 0;
+        //Appends type, version and everything written to set: handles, ranges, layouts.
+        //Sets of equal layouts and keys hold equal descriptors
+        virtual void getResourceKey(std::vector<uint64_t>& key) const = 0;
+        //Must be called once written resource is replaced. Driver may give handle of destroyed
+        //resource to a new one, version keeps sets written before from being found again.
+        //Changes scene version, sets of meshes are picked again
+        void invalidate();
+        uint64_t getVersion() const { return mVersion; }
+
+    private:
+        //Versions are unique among all descriptors and never reused
+        static uint64_t getNextVersion();
+
+        uint64_t mVersion = 0;
     };
 
     struct DescriptorBuffer : public VulkanDescriptor
@@ -29,6 +44,7 @@ namespace fre
         }
         VulkanBufferPtr mBuffer;
         virtual VkWriteDescriptorSet getWriter(VkDescriptorSet ds, uint32_t binding) override;
+        virtual void getResourceKey(std::vector<uint64_t>& key) const override;
     private:
         VkDescriptorBufferInfo mBufferInfo = {};
         VkWriteDescriptorSet mWriteDescriptorSet = {};
@@ -47,6 +63,7 @@ namespace fre
         VkImageView mImageView = VK_NULL_HANDLE;
         VkSampler mSampler = VK_NULL_HANDLE;
         virtual VkWriteDescriptorSet getWriter(VkDescriptorSet ds, uint32_t binding) override;
+        virtual void getResourceKey(std::vector<uint64_t>& key) const override;
 
     private:
         VkDescriptorImageInfo mImageInfo = {};
@@ -62,6 +79,7 @@ namespace fre
         }
         VkAccelerationStructureKHR mAccelerationStructure = VK_NULL_HANDLE;
         virtual VkWriteDescriptorSet getWriter(VkDescriptorSet ds, uint32_t binding) override;
+        virtual void getResourceKey(std::vector<uint64_t>& key) const override;
 
     private:
         VkWriteDescriptorSetAccelerationStructureKHR mWriteExt = {};
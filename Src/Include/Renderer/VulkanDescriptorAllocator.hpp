@@ -0,0 +1,93 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+namespace fre
+{
+    struct VulkanDescriptorSetLayout;
+
+    //Descriptors of type per set. Pool of N sets gets ratio * N descriptors of type
+    struct VulkanDescriptorPoolRatio
+    {
+        VkDescriptorType mType = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+        float mRatio = 0.0f;
+    };
+
+    struct VulkanDescriptorAllocatorStatistics
+    {
+        uint32_t mPools = 0;
+        //Descriptors all pools are created for, driver memory of pools grows with it
+        uint32_t mPoolDescriptors = 0;
+        //Pools which ran out of memory and wait for their sets to be released or reset
+        uint32_t mFullPools = 0;
+        uint32_t mAllocatedSets = 0;
+        //Allocated sets which weren't released or reset yet
+        uint32_t mLiveSets = 0;
+        //Allocations retried in another pool after out of pool memory or fragmented pool
+        uint32_t mPoolOverflows = 0;
+        //Full pools returned to use after all their sets were released
+        uint32_t mRecycledPools = 0;
+        uint32_t mResets = 0;
+    };
+
+    //Allocates descriptor sets from list of pools and adds a pool when current one is exhausted.
+    //Sets aren't freed one by one: pool is reset when all its sets are released, or all pools
+    //are reset at once when allocator holds transient sets of a frame.
+    //Pool sizes follow descriptors per set seen in allocated layouts, new pools hold more sets
+    class VulkanDescriptorAllocator
+    {
+    public:
+        void create(
+            VkDevice logicalDevice,
+            uint32_t setsPerPool,
+            //Expected descriptors per set, may be empty
+            const std::vector<VulkanDescriptorPoolRatio>& ratios,
+            VkDescriptorPoolCreateFlags flags = 0);
+        void destroy(VkDevice logicalDevice);
+        //Used for pools created from now on
+        void setRatios(const std::vector<VulkanDescriptorPoolRatio>& ratios);
+
+        //Returns set and pool it was allocated from, pool is needed to release set
+        VkDescriptorSet allocate(VkDevice logicalDevice, const VulkanDescriptorSetLayout& layout, VkDescriptorPool& pool);
+        //Owner of set is gone. Set stays valid until pool has no live sets and is recycled
+        void release(VkDevice logicalDevice, VkDescriptorPool pool);
+        //All sets allocated since previous reset become invalid
+        void reset(VkDevice logicalDevice);
+
+        bool isCreated() const { return mSetsPerPool > 0; }
+        const VulkanDescriptorAllocatorStatistics& getStatistics() const { return mStatistics; }
+
+    private:
+        struct Pool
+        {
+            VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+            uint32_t mLiveSets = 0;
+            bool mFull = false;
+        };
+
+        uint32_t createPool(VkDevice logicalDevice);
+        //Pool which is not full, created if there is none
+        uint32_t getPool(VkDevice logicalDevice);
+        void resetPool(VkDevice logicalDevice, Pool& pool);
+        //Index of type in ratios, added with zero ratio if missing
+        size_t getTypeIndex(VkDescriptorType type);
+        //Descriptors per set: the larger of given and seen in allocated layouts
+        float getRatio(size_t typeIndex) const;
+
+        VkDescriptorPoolCreateFlags mFlags = 0;
+        uint32_t mSetsPerPool = 0;
+        std::vector<VulkanDescriptorPoolRatio> mRatios;
+        //Descriptors of each type in all allocated sets, indexed as mRatios
+        std::vector<uint64_t> mAllocatedDescriptors;
+        //Descriptors of each type in the largest allocated set
+        std::vector<uint32_t> mMaxDescriptors;
+        uint64_t mAllocatedSets = 0;
+
+        std::vector<Pool> mPools;
+        uint32_t mCurrentPool = 0;
+        VulkanDescriptorAllocatorStatistics mStatistics;
+    };
+}
@@ -31,7 +31,8 @@ namespace fre
             uint32_t count,
             //it's possible to create pool of multiple inputs.
             //e. g. color and depth attachments in one pool.
-            const std::vector<VkDescriptorPoolSize>& poolSizes);
+            const std::vector<VkDescriptorPoolSize>& poolSizes,
+            VkDescriptorPoolCreateFlags flags = 0);
         void destroy(VkDevice logicalDevice);
 
         VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
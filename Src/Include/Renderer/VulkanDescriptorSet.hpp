@@ -14,21 +14,19 @@ namespace fre
     struct MainDevice;
 
     //We need a descriptor set per inputs combination.
-    //Thus key is hash of descriptors handles.
+    //Thus key is hash of descriptors versions and handles.
+    //Meshes binding the same resources share a set.
     struct VulkanDescriptorSetKey
     {
-        uint32_t mShaderId = std::numeric_limits<uint32_t>::max();
-        uint32_t mDPId = std::numeric_limits<uint32_t>::max();
         uint32_t mDSLId = std::numeric_limits<uint32_t>::max();
-        uint32_t mMeshId = std::numeric_limits<uint32_t>::max();
+        //Resource keys of descriptors in binding order, empty for set which is never written
+        std::vector<uint64_t> mResources;
 
         bool operator==(const VulkanDescriptorSetKey& other) const
         {
             return
-                mShaderId == other.mShaderId &&
-                mDPId == other.mDPId &&
                 mDSLId == other.mDSLId &&
-                mMeshId == other.mMeshId;
+                mResources == other.mResources;
         }
     };
 
@@ -43,6 +41,9 @@ namespace fre
         VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
         VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
         VkDescriptorSet mDescriptorSet = VK_NULL_HANDLE;
+        //Meshes using set, set is released some frames after nobody uses it
+        uint32_t mReferences = 0;
+        uint32_t mUnusedSinceFrame = 0;
 
         bool operator==(const VulkanDescriptorSet& other) const
         {
@@ -14,6 +14,8 @@ namespace fre
         std::vector<uint32_t> mBindings;
         std::vector<uint32_t> mDescriptorCount;
         std::vector<VkShaderStageFlags> mStageFlags;
+        //Descriptor indexing flags per binding, empty if none are used
+        std::vector<VkDescriptorBindingFlags> mBindingFlags;
 
         bool operator==(const VulkanDescriptorSetLayoutInfo& other) const
         {
@@ -21,7 +23,8 @@ namespace fre
                 mDescriptorTypes == other.mDescriptorTypes &&
                 mBindings == other.mBindings &&
                 mDescriptorCount == other.mDescriptorCount &&
-                mStageFlags == other.mStageFlags;
+                mStageFlags == other.mStageFlags &&
+                mBindingFlags == other.mBindingFlags;
         }
     };
 
@@ -33,6 +36,8 @@ namespace fre
         void destroy(VkDevice logicalDevice);
 
         VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
+        //Descriptors of each type in one set of layout
+        std::vector<VkDescriptorPoolSize> mPoolSizes;
     };
 }
 
@@ -10,17 +10,25 @@
 namespace fre
 {
     struct MainDevice;
+    struct RenderGraph;
 
     struct VulkanFrameBuffer
     {
         void create(const MainDevice& mainDevice, std::vector<VkImageView> attachmentsViews,
             VkExtent2D swapChainExtent, VkRenderPass renderPass);
-        void addColorAttachment(const VulkanAttachment& colorAttachment);
-        void setDepthAttachment(const VulkanAttachment& depthAttachment);
+        //Creates images of transient render graph resources and framebuffer per render pass of graph.
+        //externalViews are indexed by resource id, only external resources are taken from it
+        void create(const MainDevice& mainDevice, const RenderGraph& renderGraph,
+            const std::vector<VkImageView>& externalViews,
+            VkExtent2D swapChainExtent, const std::vector<VkRenderPass>& renderPasses);
+        const VulkanAttachment& getAttachment(uint32_t resource) const;
         void destroy(VkDevice logicalDevice);
 
-        std::vector<VulkanAttachment> mColorAttachments;
-        VulkanAttachment mDepthAttachment;
-        VkFramebuffer mFrameBuffer = VK_NULL_HANDLE;
+        //Per render graph resource, empty for external resources
+        std::vector<VulkanAttachment> mAttachments;
+        //Memory shared by aliased transient attachments, one per memory slot
+        std::vector<VkDeviceMemory> mAliasedMemory;
+        //One per render pass
+        std::vector<VkFramebuffer> mFrameBuffers;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include <mutex>
+#include <vector>
+
+namespace fre
+{
+    struct VulkanFrameCommandPoolsStatistics
+    {
+        //Command buffers allocated, none once every slot has as many as a frame needs
+        uint64_t mAllocations = 0;
+        //Command buffers handed out again after pool reset, each one was allocated and freed before
+        uint64_t mRecycled = 0;
+        uint64_t mResets = 0;
+    };
+
+    //Transient command pools per frame slot and recording thread. Command buffers aren't reset or
+    //freed one by one: pools of slot are reset at once when slot fence is signaled and their
+    //buffers are handed out again
+    class VulkanFrameCommandPools
+    {
+    public:
+        void create(VkDevice logicalDevice, uint32_t queueFamilyId, uint32_t framesCount, uint32_t threadsCount);
+        void destroy(VkDevice logicalDevice);
+
+        //Fence of frame slot is signaled: pools of slot are reset, buffers are acquired from them until next call
+        void beginFrame(VkDevice logicalDevice, uint32_t frame);
+        //Primary command buffer in initial state, valid until slot is reset again. Thread records with own pool
+        VkCommandBuffer acquire(VkDevice logicalDevice, uint32_t thread = 0);
+
+        bool isCreated() const { return !mPools.empty(); }
+        const VulkanFrameCommandPoolsStatistics& getStatistics() const { return mStatistics; }
+
+    private:
+        struct Pool
+        {
+            VkCommandPool mCommandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> mCommandBuffers;
+            //Buffers handed out since reset
+            uint32_t mUsed = 0;
+        };
+
+        //Pools of frame slot follow each other, one per thread
+        std::vector<Pool> mPools;
+        uint32_t mThreadsCount = 0;
+        uint32_t mCurrentFrame = 0;
+        VulkanFrameCommandPoolsStatistics mStatistics;
+    };
+
+    struct VulkanOneTimeCommandPoolStatistics
+    {
+        //Command buffers allocated, one per submission in flight at once
+        uint64_t mAllocations = 0;
+        //Submissions made with command buffer and fence of finished one instead of allocating and freeing them
+        uint64_t mRecycled = 0;
+    };
+
+    //Command pool of one-time submissions such as uploads and layout transitions. Submission waits for
+    //its own fence instead of queue idle, so frames submitted to the same queue keep running. Command
+    //buffers and fences of finished submissions are kept for next ones and destroyed with pool
+    class VulkanOneTimeCommandPool
+    {
+    public:
+        void create(VkDevice logicalDevice, uint32_t queueFamilyId);
+        void destroy(VkDevice logicalDevice);
+
+        //Primary command buffer in recording state
+        VkCommandBuffer begin(VkDevice logicalDevice);
+        //Ends and submits command buffer returned by begin, returns when submission is finished
+        void endAndSubmit(VkDevice logicalDevice, VkQueue queue, VkCommandBuffer commandBuffer);
+
+        //Pool of other command buffers allocated by renderer, they are freed with it
+        VkCommandPool getCommandPool() const { return mCommandPool; }
+        VulkanOneTimeCommandPoolStatistics getStatistics() const;
+
+    private:
+        VkCommandPool mCommandPool = VK_NULL_HANDLE;
+        //Free lists are shared by threads submitting uploads
+        mutable std::mutex mMutex;
+        std::vector<VkCommandBuffer> mFreeCommandBuffers;
+        std::vector<VkFence> mFreeFences;
+        VulkanOneTimeCommandPoolStatistics mStatistics;
+    };
+}
@@ -4,12 +4,14 @@
 #include <GLFW/glfw3.h>
 
 #include "Image.hpp"
+#include "Renderer/Mipmaps.hpp"
 
 #include <vector>
 
 namespace fre
 {
 	struct MainDevice;
+	class VulkanOneTimeCommandPool;
 
 	VkFormat chooseSupportedImageFormat(VkPhysicalDevice physicalDevice, const std::vector<VkFormat>& formats, VkImageTiling tiling, VkFormatFeatureFlags featureFlags);
 
@@ -22,15 +24,30 @@ namespace fre
 	VkImage createImage(const MainDevice& mainDevice,
 		uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
 		VkImageUsageFlags useFlags, VkMemoryPropertyFlags propFlags,
-		VkDeviceMemory *imageMemory, uint32_t& actualSize);
+		VkDeviceMemory *imageMemory, uint32_t& actualSize, uint32_t mipLevels = 1);
 
-	VkImageView createImageView(VkDevice logicalDevice, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+	VkImageView createImageView(VkDevice logicalDevice, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+		uint32_t mipLevels = 1);
 
+	//Levels are tightly packed in buffer one after another, level 0 only if none are passed
 	void copyImageBuffer(VkDevice device, int8_t transferQueueFamilyId, int8_t graphicsQueueFamilyId, VkQueue queue,
-		VkCommandPool transferCommandPool, VkBuffer srcBuffer,
-		VkImage image, uint32_t width, uint32_t height);
+		VulkanOneTimeCommandPool& transferCommandPool, VkBuffer srcBuffer,
+		VkImage image, uint32_t width, uint32_t height, const std::vector<MipLevel>& levels = {});
 
 	void transitionImageLayout(VkDevice device, VkQueue queue,
-		VkCommandPool commandPool, VkImage image, VkImageAspectFlags aspectMask,
-		VkImageLayout oldLayout, VkImageLayout newLayout);
+		VulkanOneTimeCommandPool& commandPool, VkImage image, VkImageAspectFlags aspectMask,
+		VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels = 1);
+
+	//Blit of linear filter needs format support, shaders sample such format filtered too
+	bool isLinearBlitSupported(VkPhysicalDevice physicalDevice, VkFormat format);
+
+	//Every level is blitted from previous one with linear filter on graphics queue. All levels are in
+	//transfer destination layout with level 0 written, they end up in final layout
+	void blitMipmaps(VkDevice device, VkQueue queue, VulkanOneTimeCommandPool& commandPool, VkImage image,
+		uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout finalLayout);
+
+	//Levels from source level on are copied to levels of destination from level 0, destination is width x height.
+	//Source stays in layout, destination ends up in it
+	void copyImageLevels(VkDevice device, VkQueue queue, VulkanOneTimeCommandPool& commandPool, VkImage srcImage, uint32_t srcLevel,
+		VkImage dstImage, uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout layout);
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include "Renderer/VulkanStreamBuffer.hpp"
+
+#include <vector>
+
+namespace fre
+{
+    struct MainDevice;
+
+    //Device local buffer kept between frames. Changed ranges are written to staging region of
+    //command buffer and copied when it executes, so unchanged data is never uploaded again.
+    //All command buffers read the same buffer at offset zero
+    struct VulkanPersistentBuffer
+    {
+        void create(const MainDevice& mainDevice, VkDeviceSize size, uint32_t regionsCount, VkBufferUsageFlags usage);
+        void destroy(VkDevice logicalDevice);
+
+        //Staging memory for size bytes at offset of buffer, valid until upload of region is recorded.
+        //Updates of region must fit into buffer size in total
+        void* update(uint32_t region, VkDeviceSize offset, VkDeviceSize size);
+        //Copies ranges updated for region. Copies wait for reads of given stages recorded before and
+        //these reads wait for copies. Must be recorded outside of render pass
+        void recordUpload(VkCommandBuffer commandBuffer, uint32_t region, VkPipelineStageFlags stages, VkAccessFlags access);
+
+        bool isCreated() const { return mBuffer != VK_NULL_HANDLE; }
+        VkDeviceSize getSize() const { return mSize; }
+        uint32_t getRegionsCount() const { return static_cast<uint32_t>(mCopies.size()); }
+        //Bytes copied by last recorded upload
+        VkDeviceSize getUploadedSize() const { return mUploadedSize; }
+
+        VkBuffer mBuffer = VK_NULL_HANDLE;
+
+    private:
+        VkDeviceMemory mMemory = VK_NULL_HANDLE;
+        VkDeviceSize mSize = 0;
+        VulkanStreamBuffer mStaging;
+        //Pending copies of each region, adjacent ranges are merged
+        std::vector<std::vector<VkBufferCopy>> mCopies;
+        //Staging bytes used by pending copies of each region
+        std::vector<VkDeviceSize> mStagingSizes;
+        VkDeviceSize mUploadedSize = 0;
+    };
+}
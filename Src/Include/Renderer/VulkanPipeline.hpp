@@ -4,13 +4,98 @@
 #include <GLFW/glfw3.h>
 
 #include "Renderer/VulkanBufferManager.hpp"
+#include "Renderer/VulkanResourceCache.hpp"
+#include "Renderer/ShaderVariant.hpp"
 
+#include <array>
+#include <limits>
+#include <memory>
 #include <vector>
 
 namespace fre
 {
     struct VulkanShader;
     struct VulkanVertexAttribute;
+    struct VulkanPipelineLibrary;
+
+    //Depth handling of geometry pipeline. With depth pre-pass depth is filled first by
+    //cheap draws, then expensive fragment shaders run only for visible fragments
+    enum class EDepthPass
+    {
+        //Depth test and writes as requested by shader metadata
+        Default,
+        //Vertex stage only, vertex attributes are read from position-only stream
+        PrePass,
+        //Main pass after pre-pass: depth equal test, no depth writes
+        Equal,
+        Count
+    };
+
+    //Depth pre-pass reads tightly packed positions
+    const uint32_t POSITION_STREAM_STRIDE = 3 * sizeof(float);
+    //Vertex input bindings of geometry pipelines
+    const uint32_t VERTEX_BINDING = 0;
+    const uint32_t INSTANCE_BINDING = 1;
+
+    //Stable identity of objects geometry pipeline is created from. Library parts are keyed by it
+    //instead of handles, which driver may give to new objects once old ones are destroyed
+    struct GeometryPipelineIdentity
+    {
+        //Shader and index of its metadata fix shader modules and pipeline layout
+        uint32_t mShaderId = std::numeric_limits<uint32_t>::max();
+        uint32_t mMetaDataIndex = 0u;
+        //Render pass index in render graph
+        uint32_t mRenderPassId = 0u;
+
+        bool isValid() const { return mShaderId != std::numeric_limits<uint32_t>::max(); }
+    };
+
+    //Everything needed to rebuild geometry pipeline with different specialization constants
+    struct GeometryPipelineState
+    {
+        GeometryPipelineIdentity mIdentity;
+        std::vector<VkShaderStageFlagBits> mStages;
+        std::vector<VkShaderModule> mModules;
+        VkPrimitiveTopology mTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        uint32_t mStride = 0u;
+        //Stride of instance-rate binding 1, 0 if shader has no per-instance attributes
+        uint32_t mInstanceStride = 0u;
+        std::vector<VkVertexInputAttributeDescription> mAttributeDescriptions;
+        VkBool32 mDepthTestEnable = VK_FALSE;
+        VkBool32 mDepthWriteEnable = VK_FALSE;
+        VkCompareOp mDepthCompareOp = VK_COMPARE_OP_LESS;
+        VkColorComponentFlags mColorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        VkRenderPass mRenderPass = VK_NULL_HANDLE;
+        uint32_t mSubpassIndex = 0u;
+        uint32_t mAttachmentsCount = 1u;
+        float mLineWidth = 0.0f;
+        VkCullModeFlags mCullMode = VK_CULL_MODE_BACK_BIT;
+        //Layout is created per pipeline. Its definition is kept to match compatible library parts
+        std::vector<VkDescriptorSetLayout> mDescriptorSetLayouts;
+        std::vector<VkPushConstantRange> mPushConstantRanges;
+    };
+
+    //Fixed function state create infos filled from GeometryPipelineState.
+    //Shared by monolithic pipelines and graphics pipeline library parts.
+    struct GeometryPipelineCreateInfos
+    {
+        GeometryPipelineCreateInfos(const GeometryPipelineState& state, bool extendedDynamicState);
+        GeometryPipelineCreateInfos(const GeometryPipelineCreateInfos&) = delete;
+        GeometryPipelineCreateInfos& operator=(const GeometryPipelineCreateInfos&) = delete;
+
+        std::vector<VkVertexInputBindingDescription> mBindingDescriptions;
+        VkPipelineVertexInputStateCreateInfo mVertexInput = {};
+        VkPipelineInputAssemblyStateCreateInfo mInputAssembly = {};
+        VkPipelineViewportStateCreateInfo mViewport = {};
+        std::vector<VkDynamicState> mDynamicStates;
+        VkPipelineDynamicStateCreateInfo mDynamicState = {};
+        VkPipelineRasterizationStateCreateInfo mRasterization = {};
+        VkPipelineMultisampleStateCreateInfo mMultisample = {};
+        std::vector<VkPipelineColorBlendAttachmentState> mColorBlendAttachments;
+        VkPipelineColorBlendStateCreateInfo mColorBlend = {};
+        VkPipelineDepthStencilStateCreateInfo mDepthStencil = {};
+    };
 
     struct VulkanPipeline
     {
@@ -20,6 +105,8 @@ namespace fre
             VkPrimitiveTopology topology,
             uint32_t stride,
             const std::vector<VulkanVertexAttribute>& vertexAttributes,
+            uint32_t instanceStride,
+            const std::vector<VulkanVertexAttribute>& instanceAttributes,
             VkBool32 depthWriteEnable,
             VkRenderPass renderPass,
             uint32_t subpassIndex,
@@ -27,26 +114,43 @@ namespace fre
             std::vector<VkPushConstantRange> pushConstantRanges,
             uint32_t attachmentsCount,
             float lineWidth,
-            VkCullModeFlags cullMode);
+            VkCullModeFlags cullMode,
+            bool hasVariants = false,
+            VulkanPipelineLibrary* library = nullptr,
+            const GeometryPipelineIdentity& identity = GeometryPipelineIdentity(),
+            VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 
         void createComputePipeline(
             VkDevice logicalDevice,
             VulkanShader& shader,
             std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-		    std::vector<VkPushConstantRange> pushConstantRanges);
+		    std::vector<VkPushConstantRange> pushConstantRanges,
+            VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 
-        void createShaderBindingTables(MainDevice& mainDevice, VkQueue transferQueue, VkCommandPool transferCommandPool,
+        void createShaderBindingTables(MainDevice& mainDevice, VkQueue transferQueue, VulkanOneTimeCommandPool& transferCommandPool,
             const VkPhysicalDeviceRayTracingPipelinePropertiesKHR& mRayTracingPipelineProperties, VulkanBufferManager& bufferManager);
 
         void createRTPipeline(VkDevice logicalDevice,
             std::vector<VulkanShader*> shaders,
             std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-            std::vector<VkPushConstantRange> pushConstantRanges);
+            std::vector<VkPushConstantRange> pushConstantRanges,
+            VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 
         void destroy(VkDevice logicalDevice);
 
         bool isCompute() const;
 
+        //Returns pipeline specialized for given variant key and depth pass. Variants are created on first request and cached.
+        //Shader modules must stay alive while new variants may be requested.
+        VkPipeline getVariant(VkDevice logicalDevice, const ShaderVariantKey& key, EDepthPass depthPass = EDepthPass::Default);
+        bool hasVariants() const { return mHasVariants; }
+        //Called once per frame after its slot fence is waited. Variants not requested for a while are evicted and
+        //destroyed when frames in flight complete. Returns true if any was evicted, so command buffers reused
+        //across frames have to be recorded again
+        bool update(uint64_t frame);
+        //Sets state which is dynamic when extended dynamic state is supported
+        void applyDynamicState(VkCommandBuffer commandBuffer, EDepthPass depthPass = EDepthPass::Default) const;
+
         VkPipeline mPipeline = VK_NULL_HANDLE;
         VkPipelineBindPoint mBindPoint = VK_PIPELINE_BIND_POINT_MAX_ENUM;
         VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
@@ -54,5 +158,20 @@ namespace fre
         VulkanBuffer mRaygenShaderBindingTable;
         VulkanBuffer mMissShaderBindingTable;
         VulkanBuffer mHhitShaderBindingTable;
+
+    private:
+        VkPipeline createGeometryVariant(VkDevice logicalDevice, const ShaderVariantKey& key,
+            const GeometryPipelineState& state) const;
+        GeometryPipelineState getDepthPassState(EDepthPass depthPass) const;
+        bool hasExtendedDynamicState() const;
+
+        GeometryPipelineState mGeometryState;
+        VulkanPipelineLibrary* mLibrary = nullptr;
+        //Variants created later go to the same cache
+        VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+        bool mHasVariants = false;
+        //Per depth pass. Default variant of default depth pass is mPipeline and isn't kept here
+        using VariantCache = VulkanResourceCache<ShaderVariantKey, VkPipeline>;
+        std::array<std::unique_ptr<VariantCache>, static_cast<size_t>(EDepthPass::Count)> mVariants;
     };
 }
\ No newline at end of file
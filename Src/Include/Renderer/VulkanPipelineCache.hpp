@@ -0,0 +1,27 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+namespace fre
+{
+    struct MainDevice;
+
+    //VkPipelineCache shared by all pipeline creation and kept in file between launches, so pipelines
+    //compiled once are only looked up later. Data of other driver or device is dropped on load
+    struct VulkanPipelineCache
+    {
+        //Empty file name keeps cache in memory only
+        void create(const MainDevice& mainDevice, const std::string& fileName);
+        //Writes cache to file, no-op without file name
+        void save(VkDevice logicalDevice) const;
+        void destroy(VkDevice logicalDevice);
+
+        VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+
+    private:
+        std::string mFileName;
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include "Renderer/ShaderVariant.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace fre
+{
+    struct GeometryPipelineState;
+
+    //Optional pipeline features detected at device creation
+    struct PipelineFeatureSupport
+    {
+        //VK_EXT_extended_dynamic_state: cull mode, depth test/write and topology are set at record time
+        bool mExtendedDynamicState = false;
+        //VK_EXT_graphics_pipeline_library: pipelines are linked from separately compiled parts
+        bool mGraphicsPipelineLibrary = false;
+    };
+
+    //Part of graphics pipeline library. Values are flattened state the part depends on
+    struct PipelinePartKey
+    {
+        VkGraphicsPipelineLibraryFlagsEXT mPart = 0;
+        std::vector<uint64_t> mValues;
+
+        bool operator==(const PipelinePartKey& other) const
+        {
+            return mPart == other.mPart && mValues == other.mValues;
+        }
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<fre::PipelinePartKey>
+    {
+        std::size_t operator()(const fre::PipelinePartKey& key) const
+        {
+            std::size_t seed = 0;
+            std::hash<uint64_t> hasher;
+            seed ^= hasher(key.mPart) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            for(const auto value : key.mValues)
+            {
+                seed ^= hasher(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+            }
+
+            return seed;
+        }
+    };
+}
+
+namespace fre
+{
+    //Compiles vertex input, pre-rasterization, fragment shader and fragment output parts separately
+    //and caches them, so new pipelines are created by linking already compiled parts.
+    //Without VK_EXT_graphics_pipeline_library VulkanPipeline falls back to monolithic pipelines.
+    struct VulkanPipelineLibrary
+    {
+        //Parts are keyed by shader ids, which are given again when shaders are reloaded, so parts are
+        //destroyed with pipelines of those shaders
+        void destroy(VkDevice logicalDevice);
+
+        //Links complete pipeline from parts. Parts are created on first use
+        VkPipeline link(
+            VkDevice logicalDevice,
+            const GeometryPipelineState& state,
+            VkPipelineLayout pipelineLayout,
+            const ShaderVariantKey& variantKey,
+            const VkSpecializationInfo* specializationInfo);
+
+        size_t getPartsCount() const { return mParts.size(); }
+
+        PipelineFeatureSupport mSupport;
+        //Parts and linked pipelines are looked up here before compiling
+        VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+
+    private:
+        VkPipeline getPart(
+            VkDevice logicalDevice,
+            VkGraphicsPipelineLibraryFlagsEXT part,
+            const GeometryPipelineState& state,
+            VkPipelineLayout pipelineLayout,
+            const ShaderVariantKey& variantKey,
+            const VkSpecializationInfo* specializationInfo);
+        PipelinePartKey getPartKey(
+            VkGraphicsPipelineLibraryFlagsEXT part,
+            const GeometryPipelineState& state,
+            const ShaderVariantKey& variantKey) const;
+
+        std::unordered_map<PipelinePartKey, VkPipeline> mParts;
+    };
+}
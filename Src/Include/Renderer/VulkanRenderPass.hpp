@@ -5,21 +5,30 @@
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 namespace fre
 {
     struct MainDevice;
+    struct RenderGraph;
 
+    //Render pass derived from compiled render graph: one subpass per graph pass assigned to it,
+    //attachment layouts and subpass dependencies come from graph barriers
     struct VulkanRenderPass
     {
-        void create(const MainDevice& mainDevice, VkFormat swapChainImageFormat);
+        void create(const MainDevice& mainDevice, const RenderGraph& renderGraph, uint32_t renderPass);
+        //Render area may be smaller than framebuffer when rendering at dynamic resolution
         void begin(
             VkFramebuffer swapChainFrameBuffer,
-            VkExtent2D swapChainExtent, VkCommandBuffer commandBuffer,
-            const glm::vec4& clearColor);
+            VkExtent2D renderArea, VkCommandBuffer commandBuffer,
+            const glm::vec4& clearColor,
+            VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void end(VkCommandBuffer commandBuffer);
         void destroy(VkDevice logicalDevice);
 
         VkRenderPass mRenderPass = VK_NULL_HANDLE;
+        //Aspect per attachment, selects clear value
+        std::vector<VkImageAspectFlags> mAttachmentAspects;
     };
     
 }
\ No newline at end of file
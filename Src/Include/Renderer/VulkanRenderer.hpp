@@ -11,13 +11,29 @@
 #include "Shader.hpp"
 #include "Statistics.hpp"
 #include "Utilities.hpp"
+#include "Renderer/RenderGraph.hpp"
+#include "Renderer/RenderObjectTable.hpp"
+#include "Renderer/SoftwareOcclusion.hpp"
+#include "Renderer/Culling.hpp"
+#include "Renderer/DepthPrePass.hpp"
+#include "Renderer/GeometryArena.hpp"
+#include "Renderer/DynamicResolution.hpp"
+#include "Renderer/FrustumCulling.hpp"
 #include "Renderer/VulkanBufferManager.hpp"
 #include "Renderer/VulkanResourceCache.hpp"
 #include "Renderer/VulkanCommandBuffer.hpp"
+#include "Renderer/VulkanCullingPass.hpp"
+#include "Renderer/VulkanDeletionQueue.hpp"
+#include "Renderer/VulkanDescriptorAllocator.hpp"
 #include "Renderer/VulkanFrameBuffer.hpp"
+#include "Renderer/VulkanFrameCommandPools.hpp"
 #include "Renderer/VulkanPipeline.hpp"
+#include "Renderer/VulkanPipelineCache.hpp"
+#include "Renderer/VulkanPersistentBuffer.hpp"
+#include "Renderer/VulkanPipelineLibrary.hpp"
 #include "Renderer/VulkanRenderPass.hpp"
 #include "Renderer/VulkanSamplerKeyHasher.hpp"
+#include "Renderer/VulkanStreamBuffer.hpp"
 #include "Renderer/VulkanSwapchain.hpp"
 #include "Renderer/VulkanTextureManager.hpp"
 #include "Pointers.hpp"
@@ -27,6 +43,8 @@
 #include <assimp/postprocess.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <set>
@@ -43,10 +61,60 @@ namespace fre
 	struct VulkanDescriptor;
 	struct VulkanPipeline;
 
+	//Statistics of last measured frame
+	struct RenderStatistics
+	{
+		uint32_t mDrawCalls = 0;
+		uint32_t mDepthPrePassDrawCalls = 0;
+		//Instances drawn by all draw calls
+		uint32_t mInstances = 0;
+		//Indirect draw calls of merged geometry and meshes drawn by them
+		uint32_t mIndirectDrawCalls = 0;
+		uint32_t mMergedMeshes = 0;
+		//Push constant updates recorded and skipped as equal to already pushed ones
+		uint32_t mPushConstants = 0;
+		uint32_t mSkippedPushConstants = 0;
+		//Merged meshes which passed GPU culling
+		uint32_t mVisibleMergedMeshes = 0;
+		//Scene meshes rejected by CPU frustum culling
+		uint32_t mCPUCulledMeshes = 0;
+		//Meshes tested against CPU occlusion depth and rejected by it, cull rate is their ratio
+		uint32_t mCPUOcclusionTested = 0;
+		uint32_t mCPUOccludedMeshes = 0;
+		uint32_t mCPUOccluderTriangles = 0;
+		//CPU time of frustum and occlusion culling, ms
+		float mCPUCullingTime = 0.0f;
+		//CPU time of command buffer recording, ms
+		float mRecordTime = 0.0f;
+		//Descriptor pools and live sets of persistent and frame allocators, allocations moved to new pool
+		uint32_t mDescriptorPools = 0;
+		uint32_t mDescriptorSets = 0;
+		uint32_t mDescriptorPoolOverflows = 0;
+		//Descriptors pools are sized for
+		uint32_t mDescriptorPoolDescriptors = 0;
+		//Mesh references to shared descriptor sets, each one was a separate set before sharing
+		uint32_t mDescriptorSetReferences = 0;
+		//Geometry pass was executed from secondary command buffer recorded in earlier frame
+		bool mSceneCommandsReused = false;
+		//Bytes of draw data, indirect commands and per-draw data copied to device, zero for static scene
+		uint64_t mUploadedSceneBytes = 0;
+		//Command buffers allocated since previous frame and reused instead of allocation and free,
+		//by frame command pools and one-time submissions
+		uint32_t mCommandBufferAllocations = 0;
+		uint32_t mRecycledCommandBuffers = 0;
+		//Fragment shader invocations of geometry pass, without depth pre-pass draws
+		uint64_t mFragmentInvocations = 0;
+		//Fragment shader invocations per pixel of render area
+		float mOverdraw = 0.0f;
+		bool mDepthPrePass = false;
+	};
+
 	class VulkanRenderer
 	{
 	public:
 		using UIRenderCallback = std::function<void()>;
+		//Called once per frame after render objects are gathered, may change their flags and transforms
+		using RenderObjectsCallback = std::function<void(RenderObjectTable& renderObjects)>;
 		VulkanRenderer(ThreadPool& threadPool);
 		virtual ~VulkanRenderer();
 		
@@ -65,8 +133,14 @@ namespace fre
 		uint32_t createDescriptorSetLayout(const VulkanDescriptorSetLayoutInfo& key);
         VulkanDescriptorSetLayoutPtr& getDescriptorSetLayout(const uint32_t index);
 
-		uint32_t createDescriptorSet(const VulkanDescriptorSetKey& key);
+		//Set is written with descriptors once it is created, keys with equal resources give the same set
+		uint32_t createDescriptorSet(const VulkanDescriptorSetKey& key, const std::vector<VulkanDescriptorPtr>& descriptors);
+		void acquireDescriptorSet(const uint32_t index);
+		//Set is destroyed once it wasn't used for some frames
+		void releaseDescriptorSet(const uint32_t index);
         VulkanDescriptorSetPtr& getDescriptorSet(const uint32_t index);
+		//Transient set valid until frame slot being recorded is drawn again
+		VkDescriptorSet allocateFrameDescriptorSet(const uint32_t dslId);
 
 		void bindDescriptorSets(const std::vector<uint32_t>& setIds, VkPipelineLayout pipelineLayout, VkPipelineBindPoint pipelineBindPoint);
 
@@ -92,7 +166,7 @@ namespace fre
 		const VulkanBuffer& createBuffer(VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags, void* data, size_t dataSize);
 		const VulkanBuffer& createExternalBuffer(VkBufferUsageFlags bufferUsage, VkMemoryPropertyFlags memoryFlags,
 			VkExternalMemoryHandleTypeFlagsKHR extMemHandleType, VkDeviceSize size);
-		void copyBuffer(VkBuffer src, VkBuffer dst, size_t dataSize, VkPipelineBindPoint pipelineBindPoint) const;
+		void copyBuffer(VkBuffer src, VkBuffer dst, size_t dataSize, VkPipelineBindPoint pipelineBindPoint);
 
 		AccelerationStructure& createBLAS(VulkanBuffer& vbo, const uint32_t verticesCount, VulkanBuffer& ibo, const uint32_t indicesCount, VulkanBuffer& transform);
 		AccelerationStructure& createTLAS(const uint64_t refBlasAddress, const VkTransformMatrixKHR& transform);
@@ -128,6 +202,8 @@ namespace fre
 		void createBarrier(VkBuffer buffer, VkPipelineBindPoint pipelineBindPoint);
 		const VulkanBuffer* getVertexBuffer(const uint32_t meshId) const;
 		const VulkanBuffer* getIndexBuffer(const uint32_t meshId) const;
+		//Range of mesh in geometry arenas, nullptr if mesh has own buffers
+		const GeometryArenaRange* getGeometryRange(const uint32_t meshId) const;
 		//External shader meta data provider
 		void setShaderMetaDataProvider(ShaderMetaDataProvider* provider);
 		//Shader used if no shader was selected for material
@@ -154,9 +230,8 @@ namespace fre
 		VkPushConstantRange getModelMatrixPCR() const { return mModelMatrixPCR; }
 		//Returns common push constant range for lighting
 		VkPushConstantRange getLightingPCR() const { return mLightingPCR; }
-		//Fills lighting push constants
-		void fillLightingPushConstant(const Mesh::Ptr& mesh, const glm::mat4& modelMatrix,
-			const Camera& camera, const Light& light, Lighting& lighting);
+		//Fills lighting push constants, camera and light are in frame uniforms
+		void fillLightingPushConstant(const Mesh::Ptr& mesh, const glm::mat4& modelMatrix, Lighting& lighting);
 
 		Material& getMaterial(uint32_t id);
 
@@ -165,6 +240,12 @@ namespace fre
 		bool needRedraw();
 
 		void addUIRenderCallback(const UIRenderCallback& callback) { mUIRenderCallbacks.push_back(callback); }
+		//Objects are gathered again every frame while callback is set
+		void setRenderObjectsCallback(const RenderObjectsCallback& callback)
+		{
+			mRenderObjectsCallback = callback;
+			changeSceneVersion();
+		}
 		
 		// - Dynamic data update functions
 		void setViewport(const BoundingBox2D& viewport);
@@ -177,9 +258,62 @@ namespace fre
 
 		void setHasExternalResources(bool hasExternalResources) { mHasExternalResources = hasExternalResources; }
 
+		//Dynamic resolution. Attachments keep full size, only render area of scene passes is scaled
+		void setDynamicResolutionEnabled(bool enabled);
+		bool isDynamicResolutionEnabled() const { return mDynamicResolutionEnabled; }
+		DynamicResolution& getDynamicResolution() { return mDynamicResolution; }
+		float getRenderScale() const;
+		//Last measured GPU time of frame in milliseconds
+		float getGPUFrameTime() const { return mDynamicResolution.getAverageFrameTime(); }
+
+		//Depth pre-pass for shaders with mDepthPrePass metadata flag. Set when scene is loaded
+		void setDepthPrePassMode(EDepthPrePassMode mode);
+		DepthPrePass& getDepthPrePass() { return mDepthPrePass; }
+		//Geometry pass is recorded into secondary command buffer per swapchain image and executed again while
+		//objects, materials and render extent stay the same. Camera and light are read from frame uniforms,
+		//so moving them doesn't record commands again. Overdraw isn't measured then. Not used for scenes
+		//with mesh callbacks, since they may record anything. Shader callbacks must not bind sets of
+		//allocateFrameDescriptorSet or push constants read from camera or light while it's enabled
+		void setSceneCommandsReuse(bool enabled);
+		bool isSceneCommandsReuse() const { return mSceneCommandsReuse; }
+		//Scene commands are recorded again, needed when push constants callbacks depend on other state
+		void invalidateSceneCommands() { mSceneCommandsVersion++; }
+		const RenderStatistics& getRenderStatistics() const { return mRenderStatistics; }
+
+		//Static meshes are packed into shared vertex and index arenas and drawn with indirect draws
+		//grouped by pipeline. Must be set before meshes are loaded
+		void setMergedGeometryEnabled(bool enabled) { mMergedGeometryEnabled = enabled; }
+		bool isMergedGeometryEnabled() const { return mMergedGeometryEnabled; }
+
+		//Loaded textures are compressed to BC formats, see VulkanTextureManager. Must be set before images are loaded
+		void setTextureCompression(bool enabled) { mTextureManager.setTextureCompression(enabled); }
+		bool isTextureCompression() const { return mTextureManager.isTextureCompression(); }
+		//Processed textures are cached in directory and mapped by later launches, see TextureCache.
+		//Must be set before images are loaded
+		void setTextureCache(const std::string& directory, uint64_t sizeLimit = TextureCache::DEFAULT_SIZE_LIMIT)
+			{ mTextureManager.setTextureCache(directory, sizeLimit); }
+		//Bindless textures keep coarse levels resident and get finer ones by screen size of visible meshes within
+		//budget of level data, bytes, see VulkanTextureManager. Must be set before images are loaded
+		void setTextureStreaming(bool enabled, uint64_t budget) { mTextureManager.setTextureStreaming(enabled, budget); }
+		//Explicit request on top of screen size ones, for textures not drawn by meshes. Level 0 is full size
+		void requestTextureLevel(uint32_t textureInfoId, uint32_t level) { mTextureManager.requestTextureLevel(textureInfoId, level); }
+		TextureStreamingStatistics getTextureStreamingStatistics() { return mTextureManager.getStreamingStatistics(); }
+
+		//Merged draws are culled by compute pass. Must be set before GPU resources are created
+		void setCullingSettings(const CullingSettings& settings) { mCullingSettings = settings; }
+		const CullingSettings& getCullingSettings() const { return mCullingSettings; }
+
+		//Compiled pipelines are kept in file and reused by later launches, see VulkanPipelineCache.
+		//Must be set before GPU resources are created
+		void setPipelineCache(const std::string& fileName) { mPipelineCacheFileName = fileName; }
+
 	protected:
 		BoundingBox2D getViewport() const;
+		//Extent scene is rendered at: swapchain extent scaled by dynamic resolution
+		VkExtent2D getRenderExtent() const;
 		virtual void createPipelines();
+		//Creates variants loaded materials are drawn with, so first frames don't compile them
+		void prewarmPipelineVariants();
 		virtual void cleanupPipelines(VkDevice logicalDevice);
 		virtual void createFullscreenTriangle();
 		//Returns shader metadata associated with shader by its file name
@@ -197,25 +331,50 @@ namespace fre
 
 		inline void addDeviceExtension(const char* extension)
 		{
+			//Base renderer may enable optional extensions requested by derived one as well
+			for(const char* requested : mRequestedDeviceExtensions)
+			{
+				if(strcmp(requested, extension) == 0)
+				{
+					return;
+				}
+			}
 			mRequestedDeviceExtensions.push_back(extension);
 		}
 
 		//Extensions
 		virtual void requestExtensions();
 		virtual void requestDeviceFeatures();
+		//Optional features are queried through feature chain, but device is suitable without them
+		template<typename T>
+		T* queryDeviceFeature(VkStructureType structureType);
+		void removeDeviceFeature(void* feature);
+		void enableOptionalDeviceFeatures();
+		bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
 
 		// - Render
-		void bindPipeline(const VulkanPipeline& pipeline);
+		void bindPipeline(VulkanPipeline& pipeline, const ShaderVariantKey& variantKey, EDepthPass depthPass = EDepthPass::Default);
 		void bindVertexBuffers(const VkBuffer* buffers, uint32_t count, VkDeviceSize* offsets, VkPipelineBindPoint pipelineBindPoint);
 		void bindIndexBuffer(const VkBuffer buffer, VkPipelineBindPoint pipelineBindPoint);
 		virtual void recordMeshCommands(
-			const MeshModel::Ptr& model, const Mesh::Ptr& mesh, const Camera& camera,
-			const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass, uint32_t instanceId);
-		void recordSceneCommands(const Camera& camera, const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass);
+			const MeshModel::Ptr& model, const Mesh::Ptr& mesh, uint32_t renderObject, const Camera& camera,
+			const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass, uint32_t instanceId,
+			EDepthPass depthPass = EDepthPass::Default);
+		void recordSceneCommands(const Camera& camera, const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass,
+			EDepthPass depthPass = EDepthPass::Default);
+		//Mesh is drawn to pre-pass and then with depth equal test
+		bool isDepthPrePassCandidate(const ShaderMetaData& shaderMetaData, const Mesh::Ptr& mesh) const;
 
 		void renderFullscreenTriangle(VkPipelineLayout pipelineLayout);
-		virtual void renderSubPass(uint32_t subPassIndex, const Camera& camera,
+		//Records render graph pass. Passes are numbered in recording order, so pass id is also
+		//the subpass index shaders are declared with
+		virtual void renderSubPass(uint32_t passId, const Camera& camera,
 			const Light& light);
+		//Executes geometry pass from secondary command buffer, recorded again when scene version changes
+		void executeSceneCommands(uint32_t passId, uint64_t version, const Camera& camera, const Light& light);
+		//Bumps scene commands version when frame settings geometry pass depends on differ from previous frame,
+		//scene changes bump it when objects are gathered. Returns the version, 0 when commands can't be reused
+		uint64_t updateSceneCommandsVersion();
 
 		virtual bool isRayTracingSupported() { return false; }
 
@@ -231,24 +390,83 @@ namespace fre
 		void loadImages();
 		//Creates GPU resources of loaded meshes
 		virtual void loadMeshes();
+		//Creates position-only vertex buffers of depth pre-pass candidates
+		void createDepthPrePassStreams();
+		//Propagates changed node transforms of models to world transforms, returns false if nothing moved
+		bool updateTransforms();
+		//Gathers meshes of all models into render object table when scene version changes,
+		//otherwise writes transforms of moved models only
+		void prepareRenderObjects(bool transformsChanged);
+		//Uploads model matrices of all render objects when they are gathered, of moved models otherwise
+		void prepareDrawData();
+		//Writes draw data of objects [first, end) to staging of current command buffer
+		void writeDrawData(uint32_t first, uint32_t end);
+		//Draw data replaces pushed model matrix, so shader has to read instance transform
+		bool useDrawData(const ShaderMetaData& shaderMetaData, const Mesh::Ptr& mesh, uint32_t renderObject) const;
+		//Next push constants are recorded even if equal to pushed ones
+		void resetPushedConstants();
+		//Returns shared sets unused for a few frames to allocator, all unused ones if device is idle
+		void destroyUnusedDescriptorSets(bool all = false);
+		//Attachment descriptors sample images of current swapchain framebuffers
+		void updateAttachmentDescriptors();
+		//Scene-wide descriptor set of all textures and material texture table
+		void createBindlessTextures();
+		//Uploads changed mesh instances to regions of current command buffer
+		void updateInstanceBuffers();
+		//Instance buffer bound to meshes without instances: single instance with default data
+		void createDefaultInstanceBuffer();
+		//Creates buffers of packed arenas and releases their CPU copies
+		void uploadGeometryArenas();
+		//Mesh is drawn by indirect draws of merged geometry instead of own draw calls
+		bool isMergedDrawCandidate(const Mesh::Ptr& mesh) const;
+		//Groups merged meshes into batches and uploads their indirect commands and per-draw data when
+		//render objects are gathered, uploads per-draw data of moved models otherwise
+		void prepareMergedDraws();
+		//Sorts draws of merged render objects by state and splits them into batches
+		void groupMergedDraws();
+		void recordMergedDraws(const Camera& camera, const Light& light, uint32_t subPass, EDepthPass depthPass);
+		//Writes culling parameters for current frame, draws are copied only to regions which miss them
+		void prepareCulling(const Camera& camera);
+		//Copies changed draw data, commands and per-draw data. Must be recorded before they are read
+		void recordSceneUploads(VkCommandBuffer commandBuffer);
+		void createCullingPass();
+		//Tests meshes drawn one by one against frustum, visibility follows order of scene traversal
+		void prepareCPUCulling(const Camera& camera);
+		//Rasterizes occluders and hides meshes behind them, runs after frustum test
+		void prepareCPUOcclusion(const glm::mat4& viewProjection);
+		//Streamed textures of visible meshes are requested at levels of their screen size
+		void requestStreamedTextures(const Camera& camera);
+		//Hi-Z pyramid reads depth attachments of swapchain framebuffers
+		void createHiZPyramid();
+		//Creates mesh descriptor sets on first use and updates them with mesh descriptors
+		void updateMeshDescriptorSets(const Mesh::Ptr& mesh, const Shader& shader);
 		//Vulkan functions
 		// -create functions
 		void createInstance();
 
 		void createLogicalDevice();
 		virtual void createSwapChain();
+		void createRenderGraph();
 		void createSwapChainFrameBuffers();
 		void createSurface();
 		void createUIDescriptorPool();
 		void createCommandPools();
 		void createCommandBuffers();
+		void createFrameQueries();
 		void createUI();
 
-		void updateUniformBuffers(const Camera& camera);
+		//Writes camera and light to frame uniforms region of current command buffer
+		void updateUniformBuffers(const Camera& camera, const Light& light);
+		//Uniform block at set 0 binding 0 of shaders, see FrameUniforms
+		void createFrameUniforms();
+		void cleanupFrameUniforms();
 
 		// - Record functions
 		void recordCommands(const Camera& camera,
 			const Light& light);
+		//Reads queries of previous frame recorded into current command buffer,
+		//updates render scale, depth pre-pass state and statistics
+		void readFrameQueries();
 			
 		// - Get functions
 		void getPhysicalDevice();
@@ -267,7 +485,14 @@ namespace fre
 		virtual void cleanupComputeFences();
 		virtual void cleanupTransferSynchronisation();
 		virtual void cleanupSemaphores();
+		virtual void cleanupCommandPools();
 		virtual void cleanupUI();
+		virtual void cleanupFrameQueries();
+		virtual void cleanupInstanceBuffers();
+		//Old buffer is destroyed once frames in flight are finished, buffer is left empty
+		void releaseStreamBuffer(VulkanStreamBuffer& buffer);
+		void releasePersistentBuffer(VulkanPersistentBuffer& buffer);
+		virtual void cleanupCullingPass();
 		virtual void cleanupRayTracing();
         virtual void cleanupSwapChain();
 		// - Recreate methods
@@ -301,23 +526,111 @@ namespace fre
 
 		int32_t mSubPassesCount = 0;
 
-		VulkanRenderPass mRenderPass;
-
+		//Passes and attachments of frame. Render passes and framebuffers are derived from it
+		RenderGraph mRenderGraph;
+		uint32_t mSwapChainResource = 0;
+		uint32_t mSceneColorResource = 0;
+		uint32_t mSceneDepthResource = 0;
+		uint32_t mGeometryPass = 0;
+		//One per render graph render pass
+		std::vector<VulkanRenderPass> mRenderPasses;
+
+		//Scales render area of dynamic resolution passes by measured GPU frame time
+		DynamicResolution mDynamicResolution;
+		bool mDynamicResolutionEnabled = false;
+		//Two timestamps (frame begin and end) per command buffer
+		VkQueryPool mTimestampQueryPool = VK_NULL_HANDLE;
+		//Nanoseconds per timestamp tick, 0 if timestamps are not supported
+		float mTimestampPeriod = 0.0f;
+		//Fragment shader invocations of geometry pass, one query per command buffer
+		VkQueryPool mPipelineStatisticsQueryPool = VK_NULL_HANDLE;
+		//Queries written into command buffer, results are read before it is recorded again
+		struct FrameQueries
+		{
+			bool mTimestamps = false;
+			bool mPipelineStatistics = false;
+			bool mDepthPrePass = false;
+			uint32_t mPixelsCount = 0;
+			//Batches culled on GPU and CPU reference survivors of them if validation is on
+			uint32_t mCullingBatches = 0;
+			std::vector<uint32_t> mCullingReference;
+			//Reference can't test occlusion, GPU may only cull more
+			bool mCullingOcclusion = false;
+		};
+		std::vector<FrameQueries> mFrameQueries;
+
+		DepthPrePass mDepthPrePass;
+		//Pre-pass state of frame being recorded
+		bool mFrameDepthPrePass = false;
+		//Draw calls of frame being recorded
+		RenderStatistics mRecordingStatistics;
+		//Geometry pass commands of swapchain image, valid for version they were recorded with. They reference
+		//framebuffer and frame uniforms region of the image
+		struct SceneCommands
+		{
+			VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+			//Frame slot whose fence signals when last submission of commands is done, -1 if never submitted
+			int mFrame = -1;
+			uint64_t mVersion = 0;
+			//Statistics of geometry pass, restored when commands are reused
+			RenderStatistics mStatistics;
+		};
+		std::vector<SceneCommands> mSceneCommands;
+		bool mSceneCommandsReuse = false;
+		//Geometry pass of frame is executed from scene commands
+		bool mFrameSceneCommands = false;
+		//Changes when buffers, pipelines or swapchain which scene commands reference are recreated,
+		//when render objects change and when frame settings differ from previous frame
+		uint64_t mSceneCommandsVersion = 1;
+		//Render extent, pre-pass and culling of previous frame
+		std::array<uint64_t, 5> mSceneCommandsState = {};
+		RenderStatistics mRenderStatistics;
+
+		//Graphics and compute command buffers are acquired from frame pools when frame is recorded
 		std::vector<VulkanCommandBuffer> mGraphicsCommandBuffers;
 		std::vector<VulkanCommandBuffer> mTransferCommandBuffers;
 		std::vector<VulkanCommandBuffer> mComputeCommandBuffers;
+		//Allocations and reuses of command buffers counted until previous frame
+		uint64_t mCommandBufferAllocations = 0;
+		uint64_t mRecycledCommandBuffers = 0;
 
 		// - Push constants
 		VkPushConstantRange mModelMatrixPCR;
 		VkPushConstantRange mLightingPCR;
 		VkPushConstantRange mNearFarPCR;
+		VkPushConstantRange mRenderScalePCR;
 
 		Lighting mLighting;
+		//Constants pushed to graphics command buffer with pipeline layout, bytes are valid where mask is set
+		VkPipelineLayout mPushedLayout = VK_NULL_HANDLE;
+		std::vector<uint8_t> mPushedConstants;
+		std::vector<uint8_t> mPushedConstantsMask;
+		//Cached normal matrix of draw being recorded, lighting computes it if not set
+		const glm::mat4* mRecordingNormalMatrix = nullptr;
 
 		// - Descriptors
 		VulkanDescriptorPoolPtr mUIDescriptorPool;
 
-		uint32_t mSharedDescriptorPoolId = MAX(uint32_t);
+		//Persistent sets of meshes, pools are added on demand and sized by allocated layouts
+		VulkanDescriptorAllocator mDescriptorAllocator;
+		//Transient sets, reset once frame fence is signaled
+		std::array<VulkanDescriptorAllocator, MAX_FRAME_DRAWS> mFrameDescriptorAllocators;
+		//GPU objects released while frames which may use them are in flight
+		VulkanDeletionQueue mDeletionQueue;
+		//Shared sets nobody references, they come back to allocator after a few frames
+		std::vector<uint32_t> mUnusedDescriptorSets;
+		uint32_t mDescriptorSetReferences = 0;
+		//Reused to build keys of mesh sets without allocations
+		VulkanDescriptorSetKey mDescriptorSetKey;
+		//Shaders declaring runtime sized texture array use this layout, all meshes share its set
+		uint32_t mBindlessDSLId = MAX(uint32_t);
+		uint32_t mBindlessSetId = MAX(uint32_t);
+		//Shaders declaring uniform block at set 0 binding 0 use this layout, all meshes share its set.
+		//Set holds dynamic uniform buffer, region of current command buffer is selected when set is bound
+		uint32_t mFrameUniformsDSLId = MAX(uint32_t);
+		uint32_t mFrameUniformsSetId = MAX(uint32_t);
+		VkDescriptorPool mFrameUniformsPool = VK_NULL_HANDLE;
+		VulkanStreamBuffer mFrameUniformsBuffer;
 
 		VulkanResourceCache<VulkanSamplerKey, VkSampler> mSamplerCache;
 		VulkanResourceCache<VulkanDescriptorPoolKey, VulkanDescriptorPoolPtr> mDescriptorPoolCache;
@@ -344,20 +657,112 @@ namespace fre
 		std::map<uint32_t, uint32_t> mMeshToVertexBufferMap;
 		//Mesh Id to index buffer map
 		std::map<uint32_t, uint32_t> mMeshToIndexBufferMap;
+		//Mesh Id to position-only vertex buffer map, used by depth pre-pass
+		std::map<uint32_t, uint32_t> mMeshToPositionBufferMap;
+		//Mesh Id to instances buffer map
+		std::map<uint32_t, VulkanStreamBuffer> mMeshToInstanceBufferMap;
+		VulkanStreamBuffer mDefaultInstanceBuffer;
+
+		bool mMergedGeometryEnabled = false;
+		GeometryArenas mGeometryArenas;
+		//Mesh Id to range in geometry arenas map
+		std::map<uint32_t, GeometryArenaRange> mMeshToGeometryRangeMap;
+		//Draw of merged mesh with one of its pipelines
+		struct MergedDraw
+		{
+			uint32_t mSubPass = 0;
+			uint32_t mPipelineId = 0;
+			//Index of pipeline in shader, also index of its metadata
+			uint32_t mPipelineIndex = 0;
+			uint32_t mMaterialId = 0;
+			uint32_t mArena = 0;
+			//Orders draws by descriptors of mesh, equal hashes are confirmed by comparing descriptors
+			size_t mDescriptorsHash = 0;
+			Mesh::Ptr mMesh;
+			//Render object transform is read from
+			uint32_t mObject = 0;
+			VkDrawIndexedIndirectCommand mCommand = {};
+		};
+		//Consecutive draws sharing pipeline, material, arena and descriptors
+		struct MergedDrawBatch
+		{
+			uint32_t mSubPass = 0;
+			uint32_t mPipelineId = 0;
+			uint32_t mPipelineIndex = 0;
+			uint32_t mArena = 0;
+			//Mesh which material and descriptor sets are used by batch
+			Mesh::Ptr mMesh;
+			uint32_t mFirstDraw = 0;
+			uint32_t mDrawsCount = 0;
+		};
+		std::vector<MergedDraw> mMergedDraws;
+		std::vector<MergedDrawBatch> mMergedDrawBatches;
+		//Render objects version draws were grouped for
+		uint64_t mMergedDrawsVersion = 0;
+		//Merged draws of each render object are [mObjectFirstDraws[object], mObjectFirstDraws[object + 1])
+		//in mObjectDraws, so moved objects update only their per-draw data
+		std::vector<uint32_t> mObjectFirstDraws;
+		std::vector<uint32_t> mObjectDraws;
+		//Mesh space bounding spheres of merged draws
+		std::vector<CullingDraw> mCullingDraws;
+		//Indirect commands and per-draw instance data, draw index is used as first instance
+		VulkanPersistentBuffer mIndirectCommandsBuffer;
+		VulkanPersistentBuffer mMergedInstanceBuffer;
+		//Model matrix of every render object at its index, drawn as first instance instead of pushed
+		VulkanPersistentBuffer mDrawDataBuffer;
+		//Render objects version draw data was uploaded for
+		uint64_t mDrawDataVersion = 0;
+
+		CullingSettings mCullingSettings;
+		VulkanCullingPass mCullingPass;
+		//Merged draws of frame being recorded are culled on GPU
+		bool mFrameCulling = false;
+		//Culled draws are compacted and drawn with GPU draw count
+		bool mDrawIndirectCount = false;
+		//Meshes of frame being recorded, culling below follows its order
+		RenderObjectTable mRenderObjects;
+		//Scene and transforms versions objects were gathered and updated with, see getSceneVersion
+		uint64_t mSceneVersion = 0;
+		uint64_t mTransformsVersion = 0;
+		//Transforms version of each model its objects hold
+		std::vector<uint64_t> mModelTransformsVersions;
+		//Models whose transforms were written this frame while objects were kept
+		std::vector<uint32_t> mMovedModels;
+		//Changes when objects are gathered again
+		uint64_t mRenderObjectsVersion = 0;
+		//Changes when objects are gathered again or any of their transforms changes
+		uint64_t mRenderTransformsVersion = 0;
+		//Some objects have visit or record callbacks
+		bool mRenderObjectsCallbacks = false;
+		//World bounds and visibility of all scene meshes, meshes without bounds are never culled
+		CullingBounds mMeshBounds;
+		//Render transforms version bounds were computed for
+		uint64_t mMeshBoundsVersion = 0;
+		std::vector<uint8_t> mMeshVisibility;
+		OcclusionRasterizer mOcclusionRasterizer;
+		HiZPyramid mOcclusionPyramid;
+		bool mFrameCPUCulling = false;
 
 		uint32_t mImageIndex = std::numeric_limits<uint32_t>::max();
 		VkQueue mGraphicsQueue = VK_NULL_HANDLE;
-		VkCommandPool mGraphicsCommandPool = VK_NULL_HANDLE;
+		VulkanOneTimeCommandPool mGraphicsCommandPool;
 
 		GLFWwindow* mWindow;
 
 		int mCurrentFrame = 0;
 
-		//Scene settings
-		struct UboViewProjection
+		//Scene settings. Per frame data of shaders, uniform block at set 0 binding 0. Geometry pass commands
+		//don't depend on camera and light, so they are reused while camera moves
+		struct FrameUniforms
 		{
 			glm::mat4 mProjection;
 			glm::mat4 mView;
+			glm::vec4 mCameraEye;
+			glm::vec4 mLightPos;
+			glm::vec4 mLightDiffuseColor;
+			glm::vec4 mLightSpecularColor;
+			//x is first entry of material texture table region of frame
+			glm::uvec4 mMaterialTable;
 		};
 
 		//Vulkan components
@@ -390,6 +795,15 @@ namespace fre
 		ShaderMetaDataProvider* mShaderMetaDataProvider = nullptr;
 
 		std::vector<VulkanPipeline> mPipelines;
+		//Pipeline parts and optional pipeline features
+		VulkanPipelineLibrary mPipelineLibrary;
+		VulkanPipelineCache mPipelineCache;
+		std::string mPipelineCacheFileName;
+		VkPhysicalDeviceExtendedDynamicStateFeaturesEXT* mExtendedDynamicStateFeatures = nullptr;
+		VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT* mGraphicsPipelineLibraryFeatures = nullptr;
+		VkPhysicalDeviceDescriptorIndexingFeatures* mDescriptorIndexingFeatures = nullptr;
+		//Flags of bindless texture array, 0 if descriptor indexing is not supported
+		VkDescriptorBindingFlags mBindlessTextureFlags = 0;
 
 		//std::vector<VkBuffer> mUniformBuffers;
 		//std::vector<VkDeviceMemory> mVPUniformBufferMemory;
@@ -405,8 +819,11 @@ namespace fre
 		std::vector<VulkanFrameBuffer> mFrameBuffers;
 
 		// - Pools -
-		VkCommandPool mTransferCommandPool = VK_NULL_HANDLE;
-		VkCommandPool mComputeCommandPool = VK_NULL_HANDLE;
+		VulkanOneTimeCommandPool mTransferCommandPool;
+		VulkanOneTimeCommandPool mComputeCommandPool;
+		//Transient pools of frame command buffers, reset when fence of frame slot is signaled
+		VulkanFrameCommandPools mGraphicsFrameCommandPools;
+		VulkanFrameCommandPools mComputeFrameCommandPools;
 
 		// - Ray tracing
 		VkPhysicalDeviceRayTracingPipelinePropertiesKHR  mRayTracingPipelineProperties{};
@@ -440,6 +857,7 @@ namespace fre
         int32_t mNeedRedraw = 5;
 
 		std::vector<UIRenderCallback> mUIRenderCallbacks;
+		RenderObjectsCallback mRenderObjectsCallback = nullptr;
 
 		uint8_t mDeviceUUID[VK_UUID_SIZE];
 		
@@ -1,45 +1,399 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace fre
 {
-    template <typename Key, typename Resource>
+    enum class ECacheEviction
+    {
+        None,
+        //Keeps at most limit resources, least recently found ones are evicted
+        LRU,
+        //Evicts resources which weren't found for limit frames
+        FrameAge
+    };
+
+    struct VulkanResourceCacheStatistics
+    {
+        uint64_t mHits = 0;
+        uint64_t mMisses = 0;
+        uint64_t mEvictions = 0;
+        uint32_t mSize = 0;
+        //Evicted resources waiting for GPU to finish with them
+        uint32_t mPendingDestructions = 0;
+    };
+
+    //Resources are looked up by key and then addressed by index, which stays valid until the
+    //resource is erased or evicted. Lookups are thread-safe: keys are spread over shards with
+    //own locks, hits take shared lock only. Key type is copied only on miss, any type hashed by
+    //Hasher and comparable with Key can be used for lookup. Creator runs under shard lock and
+    //must not use the same cache.
+    //Bounded cache evicts in update(), evicted resources are destroyed framesInFlight frames later
+    template <typename Key, typename Resource, typename Hasher = std::hash<Key>>
     class VulkanResourceCache
     {
     public:
         using Index = uint32_t;
+        using Destroyer = std::function<void(Resource& resource)>;
+
+        static constexpr Index INVALID_INDEX = std::numeric_limits<Index>::max();
+
+        VulkanResourceCache() = default;
+        VulkanResourceCache(const VulkanResourceCache&) = delete;
+        VulkanResourceCache& operator=(const VulkanResourceCache&) = delete;
+
+        ~VulkanResourceCache()
+        {
+            for(auto& chunk : mChunks)
+            {
+                delete[] chunk.load(std::memory_order_relaxed);
+            }
+        }
+
+        void setEviction(ECacheEviction eviction, uint32_t limit, uint32_t framesInFlight, Destroyer destroyer)
+        {
+            std::unique_lock<std::mutex> lock(mAllocationMutex);
+            mEviction = eviction;
+            mLimit = limit;
+            mFramesInFlight = framesInFlight;
+            mDestroyer = std::move(destroyer);
+        }
 
         // Add or retrieve resource by key
-        Index findOrCreate(const Key& key, std::function<Resource(const Key& key)> createFunc)
+        template <typename LookupKey, typename Creator>
+        Index findOrCreate(const LookupKey& key, Creator&& createFunc)
         {
-            auto it = keyToIndex.find(key);
-            if(it != keyToIndex.end())
+            const std::size_t hash = Hasher{}(key);
+            Shard& shard = mShards[getShardIndex(hash)];
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mMutex);
+                const Index index = findInShard(shard, hash, key);
+                if(index != INVALID_INDEX)
+                {
+                    touch(index);
+                    mHits.fetch_add(1, std::memory_order_relaxed);
+                    return index;
+                }
+            }
+
+            std::unique_lock<std::shared_mutex> lock(shard.mMutex);
+            //Other thread may have created it while lock was released
+            Index index = findInShard(shard, hash, key);
+            if(index != INVALID_INDEX)
             {
-                return it->second;
+                touch(index);
+                mHits.fetch_add(1, std::memory_order_relaxed);
+                return index;
             }
 
-            Index newIndex = static_cast<Index>(resources.size());
-            resources.push_back(createFunc(key));
-            keyToIndex[key] = newIndex;
-            return newIndex;
+            index = allocateIndex();
+            Entry& entry = getEntry(index);
+            try
+            {
+                entry.mKey = Key(key);
+                entry.mResource = createFunc(static_cast<const Key&>(entry.mKey));
+            }
+            catch(...)
+            {
+                entry.mKey = Key();
+                freeIndex(index);
+                throw;
+            }
+            entry.mHash = hash;
+            entry.mLastUsedFrame.store(mFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            shard.mIndices.emplace(hash, index);
+            mMisses.fetch_add(1, std::memory_order_relaxed);
+            mSize.fetch_add(1, std::memory_order_relaxed);
+
+            return index;
+        }
+
+        // Retrieve resource index without creating it
+        template <typename LookupKey>
+        Index find(const LookupKey& key)
+        {
+            const std::size_t hash = Hasher{}(key);
+            Shard& shard = mShards[getShardIndex(hash)];
+            std::shared_lock<std::shared_mutex> lock(shard.mMutex);
+            const Index index = findInShard(shard, hash, key);
+            if(index != INVALID_INDEX)
+            {
+                touch(index);
+            }
+            (index != INVALID_INDEX ? mHits : mMisses).fetch_add(1, std::memory_order_relaxed);
+
+            return index;
+        }
+
+        // Forget resource right away, caller destroys it before. Index is reused later
+        void erase(Index index)
+        {
+            assert(index < size());
+            Entry& entry = getEntry(index);
+            {
+                Shard& shard = mShards[getShardIndex(entry.mHash)];
+                std::unique_lock<std::shared_mutex> lock(shard.mMutex);
+                removeFromShard(shard, entry.mHash, index);
+                entry.mResource = Resource();
+                entry.mKey = Key();
+            }
+            mSize.fetch_sub(1, std::memory_order_relaxed);
+            freeIndex(index);
+        }
+
+        // Keeps resource used with index from being evicted as least recently used or old
+        void touch(Index index)
+        {
+            getEntry(index).mLastUsedFrame.store(mFrame.load(std::memory_order_relaxed), std::memory_order_relaxed);
         }
 
         // Access by index
         Resource& getByIndex(Index index)
         {
-            assert(index < resources.size());
-            return resources[index];
+            assert(index < size());
+            return getEntry(index).mResource;
         }
 
         const Resource& getByIndex(Index index) const
         {
-            assert(index < resources.size());
-            return resources[index];
+            assert(index < size());
+            return getEntry(index).mResource;
+        }
+
+        // Called once per frame: evicts by policy and destroys resources GPU is done with
+        void update(uint64_t frame)
+        {
+            mFrame.store(frame, std::memory_order_relaxed);
+            destroyEvicted(false);
+            if(mEviction == ECacheEviction::None)
+            {
+                return;
+            }
+
+            //Candidates are gathered shard by shard, lookups of other shards go on meanwhile
+            std::vector<std::pair<uint64_t, Index>> candidates;
+            for(auto& shard : mShards)
+            {
+                std::shared_lock<std::shared_mutex> lock(shard.mMutex);
+                for(const auto& [hash, index] : shard.mIndices)
+                {
+                    const uint64_t lastUsedFrame = getEntry(index).mLastUsedFrame.load(std::memory_order_relaxed);
+                    if(mEviction == ECacheEviction::LRU || lastUsedFrame + mLimit < frame)
+                    {
+                        candidates.push_back({ lastUsedFrame, index });
+                    }
+                }
+            }
+            if(mEviction == ECacheEviction::LRU)
+            {
+                if(candidates.size() <= mLimit)
+                {
+                    return;
+                }
+                const size_t evictedCount = candidates.size() - mLimit;
+                if(evictedCount < candidates.size())
+                {
+                    std::nth_element(candidates.begin(), candidates.begin() + evictedCount, candidates.end());
+                    candidates.resize(evictedCount);
+                }
+            }
+
+            for(const auto& [lastUsedFrame, index] : candidates)
+            {
+                Entry& entry = getEntry(index);
+                Shard& shard = mShards[getShardIndex(entry.mHash)];
+                std::unique_lock<std::shared_mutex> lock(shard.mMutex);
+                //Found again since candidates were gathered, resource is in use by now
+                if(mEviction == ECacheEviction::FrameAge &&
+                    entry.mLastUsedFrame.load(std::memory_order_relaxed) + mLimit >= frame)
+                {
+                    continue;
+                }
+                if(removeFromShard(shard, entry.mHash, index))
+                {
+                    std::unique_lock<std::mutex> allocationLock(mAllocationMutex);
+                    mEvicted.push_back({ index, frame });
+                    mEvictions.fetch_add(1, std::memory_order_relaxed);
+                    mSize.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Destroys evicted resources, all of them if GPU is idle
+        void destroyEvicted(bool all = true)
+        {
+            std::vector<Index> destroyed;
+            {
+                std::unique_lock<std::mutex> lock(mAllocationMutex);
+                const uint64_t frame = mFrame.load(std::memory_order_relaxed);
+                auto pendingIt = std::partition(mEvicted.begin(), mEvicted.end(),
+                    [this, all, frame](const Eviction& eviction) { return !all && eviction.mFrame + mFramesInFlight > frame; });
+                for(auto it = pendingIt; it != mEvicted.end(); ++it)
+                {
+                    destroyed.push_back(it->mIndex);
+                }
+                mEvicted.erase(pendingIt, mEvicted.end());
+            }
+
+            for(const Index index : destroyed)
+            {
+                Entry& entry = getEntry(index);
+                if(mDestroyer != nullptr)
+                {
+                    mDestroyer(entry.mResource);
+                }
+                entry.mResource = Resource();
+                entry.mKey = Key();
+                freeIndex(index);
+            }
         }
 
-        size_t size() const { return resources.size(); }
+        // Slots ever used, erased and evicted ones hold default resource
+        size_t size() const { return mSlotsCount.load(std::memory_order_acquire); }
+
+        VulkanResourceCacheStatistics getStatistics() const
+        {
+            VulkanResourceCacheStatistics result;
+            result.mHits = mHits.load(std::memory_order_relaxed);
+            result.mMisses = mMisses.load(std::memory_order_relaxed);
+            result.mEvictions = mEvictions.load(std::memory_order_relaxed);
+            result.mSize = mSize.load(std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(mAllocationMutex);
+            result.mPendingDestructions = static_cast<uint32_t>(mEvicted.size());
+            return result;
+        }
 
     private:
-        std::vector<Resource> resources;
-        std::unordered_map<Key, Index> keyToIndex;
+        static constexpr uint32_t SHARDS_COUNT = 16;
+        //Entries live in chunks which never move, so indices can be read without locks
+        static constexpr uint32_t CHUNK_BITS = 10;
+        static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+        static constexpr uint32_t MAX_CHUNKS = 4096;
+
+        struct Entry
+        {
+            Key mKey = Key();
+            Resource mResource = Resource();
+            std::size_t mHash = 0;
+            std::atomic<uint64_t> mLastUsedFrame{ 0 };
+        };
+
+        struct Shard
+        {
+            std::shared_mutex mMutex;
+            //Hash to indices of entries with it
+            std::unordered_multimap<std::size_t, Index> mIndices;
+        };
+
+        struct Eviction
+        {
+            Index mIndex = INVALID_INDEX;
+            uint64_t mFrame = 0;
+        };
+
+        static uint32_t getShardIndex(std::size_t hash)
+        {
+            //Low bits select bucket inside of shard map, second and fourth quarters of hash are folded
+            //whatever size_t width is
+            constexpr uint32_t QUARTER_BITS = sizeof(std::size_t) * 2;
+            return static_cast<uint32_t>((hash >> QUARTER_BITS) ^ (hash >> (3 * QUARTER_BITS))) % SHARDS_COUNT;
+        }
+
+        Entry& getEntry(Index index) const
+        {
+            Entry* chunk = mChunks[index >> CHUNK_BITS].load(std::memory_order_acquire);
+            return chunk[index & (CHUNK_SIZE - 1)];
+        }
+
+        template <typename LookupKey>
+        Index findInShard(const Shard& shard, std::size_t hash, const LookupKey& key) const
+        {
+            const auto range = shard.mIndices.equal_range(hash);
+            for(auto it = range.first; it != range.second; ++it)
+            {
+                if(getEntry(it->second).mKey == key)
+                {
+                    return it->second;
+                }
+            }
+            return INVALID_INDEX;
+        }
+
+        bool removeFromShard(Shard& shard, std::size_t hash, Index index)
+        {
+            const auto range = shard.mIndices.equal_range(hash);
+            for(auto it = range.first; it != range.second; ++it)
+            {
+                if(it->second == index)
+                {
+                    shard.mIndices.erase(it);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        Index allocateIndex()
+        {
+            std::unique_lock<std::mutex> lock(mAllocationMutex);
+            if(!mFreeIndices.empty())
+            {
+                const Index index = mFreeIndices.back();
+                mFreeIndices.pop_back();
+                return index;
+            }
+
+            const Index index = static_cast<Index>(mSlotsCount.load(std::memory_order_relaxed));
+            const uint32_t chunk = index >> CHUNK_BITS;
+            if(chunk >= MAX_CHUNKS)
+            {
+                throw std::length_error("Resource cache is full");
+            }
+            if(mChunks[chunk].load(std::memory_order_relaxed) == nullptr)
+            {
+                mChunks[chunk].store(new Entry[CHUNK_SIZE], std::memory_order_release);
+            }
+            mSlotsCount.store(index + 1, std::memory_order_release);
+            return index;
+        }
+
+        void freeIndex(Index index)
+        {
+            std::unique_lock<std::mutex> lock(mAllocationMutex);
+            mFreeIndices.push_back(index);
+        }
+
+        std::array<Shard, SHARDS_COUNT> mShards;
+        std::array<std::atomic<Entry*>, MAX_CHUNKS> mChunks{};
+        std::atomic<size_t> mSlotsCount{ 0 };
+
+        //Guards free indices, chunks allocation and eviction queue
+        mutable std::mutex mAllocationMutex;
+        std::vector<Index> mFreeIndices;
+        std::vector<Eviction> mEvicted;
+
+        ECacheEviction mEviction = ECacheEviction::None;
+        uint32_t mLimit = 0;
+        uint32_t mFramesInFlight = 0;
+        Destroyer mDestroyer;
+        std::atomic<uint64_t> mFrame{ 0 };
+
+        std::atomic<uint64_t> mHits{ 0 };
+        std::atomic<uint64_t> mMisses{ 0 };
+        std::atomic<uint64_t> mEvictions{ 0 };
+        std::atomic<uint32_t> mSize{ 0 };
     };
-}
\ No newline at end of file
+}
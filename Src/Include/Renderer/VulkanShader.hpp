@@ -42,6 +42,11 @@ namespace fre
         std::vector<VkPushConstantRange> mPushConstantRanges;
         //Vertex size
         uint32_t mVertexSize = 0u;
+        //Per-instance attributes, read at instance rate from mesh instances buffer.
+        //Locations follow vertex attributes
+        std::vector<VulkanVertexAttribute> mInstanceAttributes;
+        //Per-instance data size
+        uint32_t mInstanceSize = 0u;
         //Subpass index
         uint32_t mSubPassIndex = 0u;
         //Geomery topology
@@ -54,6 +59,11 @@ namespace fre
         bool mDepthTestEnabled = false;
         //Cull mode
         VkCullModeFlags mCullMode = VK_CULL_MODE_BACK_BIT;
+        //Shader features are toggled by specialization constants, pipeline variants are created on demand
+        bool mHasVariants = false;
+        //Expensive fragment shader, meshes can be drawn to depth pre-pass first.
+        //First vertex attribute must be position
+        bool mDepthPrePass = false;
         //Metadata considered valid if it has descriptor set layouts
         bool isValid() const;
     };
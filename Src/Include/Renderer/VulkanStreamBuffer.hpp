@@ -0,0 +1,42 @@
+#pragma once
+
+#include <volk.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+namespace fre
+{
+    struct MainDevice;
+
+    //Regions start at offsets valid for binding them as uniform or storage buffers on any device
+    const uint32_t STREAM_BUFFER_ALIGNMENT = 256;
+
+    //Persistently mapped buffer with a region per command buffer, so CPU can write
+    //data of current frame while previous frames still read their regions
+    struct VulkanStreamBuffer
+    {
+        void create(const MainDevice& mainDevice, VkDeviceSize regionSize, uint32_t regionsCount,
+            VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        void destroy(VkDevice logicalDevice);
+
+        //Copies data to region unless it already holds given version
+        void update(uint32_t region, const void* data, VkDeviceSize size, uint32_t version);
+        //Region memory for data rewritten every frame
+        void* getRegionData(uint32_t region);
+
+        bool isCreated() const { return mBuffer != VK_NULL_HANDLE; }
+        VkDeviceSize getRegionSize() const { return mRegionSize; }
+        uint32_t getRegionsCount() const { return static_cast<uint32_t>(mVersions.size()); }
+        VkDeviceSize getOffset(uint32_t region) const { return region * mRegionSize; }
+
+        VkBuffer mBuffer = VK_NULL_HANDLE;
+
+    private:
+        VkDeviceMemory mMemory = VK_NULL_HANDLE;
+        void* mMappedData = nullptr;
+        VkDeviceSize mRegionSize = 0;
+        //Version of data uploaded to each region
+        std::vector<uint32_t> mVersions;
+    };
+}
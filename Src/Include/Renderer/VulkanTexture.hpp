@@ -39,5 +39,9 @@ namespace fre
 		VkImageView mImageView = VK_NULL_HANDLE;
 		//Actual size in GPU memory, bytes
 		uint32_t mActualSize = 0;
+		//Full chain for sampled textures created with data, 1 otherwise
+		uint32_t mMipLevels = 1;
+		//Level of full chain image starts at, streamed textures drop finer levels
+		uint32_t mFirstLevel = 0;
 	};
 }
\ No newline at end of file
@@ -4,12 +4,20 @@
 #include <GLFW/glfw3.h>
 
 #include "Pointers.hpp"
+#include "Renderer/VulkanDeletionQueue.hpp"
 #include "Renderer/VulkanDescriptorPool.hpp"
 #include "Renderer/VulkanDescriptorSet.hpp"
 #include "Renderer/VulkanDescriptorSetLayout.hpp"
+#include "Renderer/VulkanStreamBuffer.hpp"
+#include "Renderer/TextureResidency.hpp"
 #include "Image.hpp"
+#include "TextureCache.hpp"
 
+#include <array>
+#include <atomic>
+#include <limits>
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 
@@ -19,10 +27,43 @@ namespace fre
 {
 	struct MainDevice;
 	class ThreadPool;
+	class VulkanOneTimeCommandPool;
+
+	//Textures of material, index of texture slot in material entry of bindless table
+	enum EMaterialTexture : uint32_t
+	{
+		MT_BASE_COLOR = 0,
+		MT_NORMALS,
+		MT_METALLIC_ROUGHNESS,
+		MT_COUNT
+	};
+
+	struct TextureStreamingStatistics
+	{
+		//Level data of streamed textures, bytes
+		uint64_t mResidentSize = 0;
+		uint64_t mBudget = 0;
+		uint32_t mTexturesCount = 0;
+		//Textures recreated with finer or coarser levels since streaming was enabled
+		uint64_t mLoads = 0;
+		uint64_t mEvictions = 0;
+	};
 
 	struct VulkanTextureManager
 	{
 		using LoadImageCallback = std::function<void(const int imageIndex, const int imagesCount)>;
+		using SamplerCallback = std::function<VkSampler(const VulkanTextureInfo& info)>;
+		//Material entry is uvec4 in shader, unused slots are invalid
+		using MaterialTextures = std::array<uint32_t, 4>;
+		static_assert(MT_COUNT <= 4, "Material textures don't fit material entry");
+
+		static const uint32_t INVALID_BINDLESS_SLOT = std::numeric_limits<uint32_t>::max();
+		//Streamed texture keeps levels up to this size resident always
+		static const uint32_t STREAMING_TAIL_SIZE = 128;
+
+		//Binding 0 is partially bound array of sampled textures updated after bind,
+		//binding 1 is table of material texture slots indexed by material id
+		static VulkanDescriptorSetLayoutInfo getBindlessLayoutInfo(uint32_t texturesCount, VkDescriptorBindingFlags texturesFlags);
 
 		void create(VkDevice logicalDevice);
 		void destroy(VkDevice logicalDevice);
@@ -38,37 +79,224 @@ namespace fre
 			const bool isExternal,
 			Image& image);
 		VulkanTextureInfoPtr getTextureInfo(const uint32_t id);
+		//Texture of image still being loaded gets size and format from header of its file, and data once
+		//image is loaded, see uploadLoadedImages
 		uint32_t createTexture(
 			const MainDevice& mainDevice,
 			int8_t transferQueueFamilyId,
 			int8_t graphicsQueueFamilyId,
 			const VkQueue queue,
-			const VkCommandPool commandPool,
+			VulkanOneTimeCommandPool& commandPool,
 			const VulkanTextureInfoPtr& info);
 		VulkanTexturePtr getTexture(uint32_t id);
+		//Headers of image files are read first, so textures can be created while images are decoded in parallel
         void loadImages(const LoadImageCallback& callback, ThreadPool& threadPool);
+		//Textures created before their images were loaded get data of images loaded since previous call. Texture
+		//is recreated if loaded image differs from header, like compressed one. Called once per frame
+		void uploadLoadedImages(const MainDevice& mainDevice,
+			int8_t transferFamilyId,
+			int8_t graphicsFamilyId,
+			VkQueue queue,
+			VulkanOneTimeCommandPool& commandPool,
+			VulkanDeletionQueue& deletionQueue);
 		void uploadData(const MainDevice& mainDevice,
 			int8_t transferQueueFamilyId,
 			int8_t graphicsQueueFamilyId,
 			const VkQueue queue,
-			const VkCommandPool commandPool,
+			VulkanOneTimeCommandPool& commandPool,
 			VulkanTexturePtr& texture,
 			const VulkanTextureInfoPtr& info);
+		//Replaces image and view of texture, old ones are retired through deletion queue
 		void updateTextureImage(
 			const MainDevice& mainDevice,
 			int8_t transferFamilyId,
 			int8_t graphicsFamilyId,
 			VkQueue queue,
-			VkCommandPool commandPool,
+			VulkanOneTimeCommandPool& commandPool,
+			VulkanDeletionQueue& deletionQueue,
 			const VulkanTextureInfoPtr& info);
 		VkDeviceMemory getTextureMemory(uint32_t index);
 		bool isTextureInfoCreated(uint32_t index);
 		void destroyTexture(VkDevice logicalDevice, uint32_t id);
+
+		//Allocates the only descriptor set of all sampled textures. Every image of texture takes a free slot,
+		//slot of replaced image is reused once frames in flight are finished. Material table has region
+		//per frame in flight. Textures created before are written too
+		void createBindless(const MainDevice& mainDevice, VkDescriptorSetLayout layout, uint32_t texturesCount,
+			uint32_t materialsCount, uint32_t framesCount, const SamplerCallback& samplerCallback);
+		void destroyBindless(VkDevice logicalDevice);
+		bool isBindless() const { return mBindlessSet != VK_NULL_HANDLE; }
+		VkDescriptorSet getBindlessSet() const { return mBindlessSet; }
+		//Texture info ids of material textures by EMaterialTexture. Shader sees texture in material
+		//entry once texture is created, invalid slot before that
+		void setMaterialTextures(uint32_t materialId, const MaterialTextures& textureInfoIds);
+		//Region of frame gets entries changed since it was used last time, called once fence of frame is signaled
+		void updateMaterialTable(uint32_t frame);
+		//Index of first entry of frame region, shaders add material id to it
+		uint32_t getMaterialTableBase(uint32_t frame) const
+			{ return static_cast<uint32_t>(mMaterialTable.getOffset(frame) / sizeof(MaterialTextures)); }
+
+		//Color textures and textures of 1 or 2 channels are compressed to BC1, BC3, BC4 or BC5 with levels
+		//once loaded, see TextureProcessing. Must be set before images are loaded
+		void setTextureCompression(bool enabled) { mTextureCompression = enabled; }
+		bool isTextureCompression() const { return mTextureCompression; }
+		//Loaded images are stored GPU ready in directory with full chains of sampled textures, later loads map
+		//them instead of decoding. Must be set before images are loaded
+		void setTextureCache(const std::string& directory, uint64_t sizeLimit = TextureCache::DEFAULT_SIZE_LIMIT)
+			{ mTextureCache.create(directory, sizeLimit); }
+		TextureCacheStatistics getTextureCacheStatistics() const { return mTextureCache.getStatistics(); }
+		//Device samples BC formats, nothing is compressed otherwise
+		void setBlockCompressionSupported(bool supported) { mBlockCompressionSupported = supported; }
+
+		//Sampled textures get full chains and start with levels up to STREAMING_TAIL_SIZE, finer levels are loaded
+		//when requested and levels of least recently requested textures are dropped over budget, see TextureResidency.
+		//Budget counts level data, bytes. Must be enabled before images are loaded, only textures sampled through
+		//bindless slots are streamed. Finer levels are loaded again from image files, so texture cache makes loads cheap
+		void setTextureStreaming(bool enabled, uint64_t budget);
+		bool isTextureStreaming() const { return mStreaming; }
+		//Finest level texture is sampled at in current frame, level 0 is full size
+		void requestTextureLevel(uint32_t textureInfoId, uint32_t level);
+		//Material is drawn in current frame at screen size, pixels. Its textures are requested at matching levels
+		void requestMaterialLevels(uint32_t materialId, float screenSize);
+		//Textures are recreated with levels loaded by thread pool and next residency update is started there.
+		//Called once per frame, old images are released through deletion queue
+		void updateStreaming(const MainDevice& mainDevice,
+			int8_t transferFamilyId,
+			int8_t graphicsFamilyId,
+			VkQueue queue,
+			VulkanOneTimeCommandPool& commandPool,
+			VulkanDeletionQueue& deletionQueue,
+			ThreadPool& threadPool);
+		TextureStreamingStatistics getStreamingStatistics();
 		
 	private:
+		//Where mips of texture come from: blit chain needs linear filtering of format, CPU filter
+		//handles 8 bit formats and sRGB color stored in UNORM one
+		enum class EMipmapsSource
+		{
+			None,
+			CPU,
+			Blit
+		};
+		static EMipmapsSource getMipmapsSource(VkPhysicalDevice physicalDevice, const VulkanTextureInfo& info);
+		//Source of mips image of info gets once it is loaded
+		static EMipmapsSource getLoadedMipmapsSource(VkPhysicalDevice physicalDevice, const VulkanTextureInfo& info);
+
+		//Loads and processes image of texture info or reads it from texture cache
+		void loadImage(VulkanTextureInfo& info);
+		//Creates texture of info with id, streamed one starts with its tail levels
+		VulkanTexturePtr makeTexture(const MainDevice& mainDevice,
+			int8_t transferQueueFamilyId,
+			int8_t graphicsQueueFamilyId,
+			const VkQueue queue,
+			VulkanOneTimeCommandPool& commandPool,
+			uint32_t id,
+			const VulkanTextureInfoPtr& info);
+		//Creates image of texture for size, levels and data of info. Image reserved for data not loaded yet
+		//gets levels loaded image is expected to have
+		void createTextureImage(const MainDevice& mainDevice,
+			int8_t transferQueueFamilyId,
+			int8_t graphicsQueueFamilyId,
+			const VkQueue queue,
+			VulkanOneTimeCommandPool& commandPool,
+			VulkanTexturePtr& texture,
+			const VulkanTextureInfoPtr& info,
+			bool reserve = false);
+
+		//Texture created from header of image file, waiting for image to be loaded
+		struct ReservedTexture
+		{
+			uint32_t mTextureInfoId = 0;
+			VkFormat mFormat = VK_FORMAT_UNDEFINED;
+			glm::ivec2 mDimension = glm::ivec2(0);
+		};
+
+		struct StreamedTexture
+		{
+			uint32_t mTextureId = 0;
+			uint32_t mWidth = 0;
+			uint32_t mHeight = 0;
+			uint32_t mLevelsCount = 0;
+		};
+		struct StreamingRequest
+		{
+			uint32_t mTextureInfoId = 0;
+			uint32_t mLevel = 0;
+			uint64_t mFrame = 0;
+		};
+		//Residency change with levels loaded for it, data is empty for evictions
+		struct StreamedLevels
+		{
+			TextureResidencyChange mChange;
+			Image mImage;
+			std::vector<uint8_t> mData;
+		};
+		bool isStreamed(const VulkanTextureInfo& info) const;
+		//Image of levels from first one on packed into data, image doesn't own data
+		static Image getLevelsImage(const Image& image, uint32_t firstLevel, std::vector<uint8_t>& data);
+		//Runs on thread pool: residency update for requests and loads of finer levels
+		void updateResidency(uint64_t frame);
+		void applyStreamedLevels(const MainDevice& mainDevice,
+			int8_t transferFamilyId,
+			int8_t graphicsFamilyId,
+			VkQueue queue,
+			VulkanOneTimeCommandPool& commandPool,
+			VulkanDeletionQueue& deletionQueue,
+			StreamedLevels& levels);
+
+		//Texture image goes to a free slot, slot of its previous image must be retired before
+		void writeBindlessTexture(VkDevice logicalDevice, const VulkanTextureInfo& info, const VulkanTexture& texture);
+		//Materials stop using slot of texture info. Without deletion queue slot is free at once, device must be idle
+		void retireBindlessSlot(uint32_t textureInfoId, VulkanDeletionQueue* deletionQueue);
+		void writeMaterialEntry(uint32_t materialId);
+		//Rewrites entries of materials using texture info
+		void writeMaterialEntries(uint32_t textureInfoId);
+		//Like destroyTexture, but handles and bindless slot are reused once frames in flight are finished
+		void releaseTexture(VkDevice logicalDevice, uint32_t id, VulkanDeletionQueue& deletionQueue);
+
 		std::map<uint32_t, VulkanTextureInfoPtr> mTextureInfos;
 		std::map<uint32_t, VulkanTexturePtr> mTextures;
 		uint32_t mDefaultTextureId = 0;
 		std::mutex mMutex;
+		//Texture infos of images being loaded by thread pool and of ones loaded since last upload, guarded by mMutex
+		std::set<uint32_t> mLoadingImages;
+		std::vector<uint32_t> mLoadedImages;
+		//Reserved textures by texture id, render thread only
+		std::map<uint32_t, ReservedTexture> mReservedTextures;
+
+		VkDescriptorPool mBindlessPool = VK_NULL_HANDLE;
+		VkDescriptorSet mBindlessSet = VK_NULL_HANDLE;
+		uint32_t mBindlessTexturesCount = 0;
+		SamplerCallback mBindlessSamplerCallback;
+		//Slots of current images by texture info id. Free slots are reused first, slots never used come after them
+		std::map<uint32_t, uint32_t> mBindlessSlots;
+		std::vector<uint32_t> mFreeBindlessSlots;
+		uint32_t mUsedBindlessSlotsCount = 0;
+		std::vector<MaterialTextures> mMaterialTextures;
+		//Host visible table of material entries, read by shaders directly. Entries are written to mMaterialEntries
+		//and copied to region of frame in flight once it isn't read anymore
+		VulkanStreamBuffer mMaterialTable;
+		uint32_t mMaterialTableCount = 0;
+		std::vector<MaterialTextures> mMaterialEntries;
+		uint32_t mMaterialEntriesVersion = 0;
+
+		bool mTextureCompression = false;
+		bool mBlockCompressionSupported = false;
+		TextureCache mTextureCache;
+
+		bool mStreaming = false;
+		//Streamed textures by texture info id and requests of current frame, render thread only
+		std::map<uint32_t, StreamedTexture> mStreamedTextures;
+		std::vector<StreamingRequest> mFrameRequests;
+		uint64_t mStreamingFrame = 1;
+		//Guards residency, requests passed to thread pool and levels coming back
+		std::mutex mStreamingMutex;
+		TextureResidency mResidency;
+		std::vector<StreamingRequest> mStreamingRequests;
+		std::vector<StreamedLevels> mStreamedLevels;
+		//Residency update runs on thread pool, the next one starts once it is finished
+		std::atomic<bool> mResidencyUpdating{ false };
+		uint64_t mStreamingLoads = 0;
+		uint64_t mStreamingEvictions = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace fre
+{
+	class ThreadPool;
+
+	//Hierarchy of transforms in structure of arrays layout. Nodes are stored in depth-first order:
+	//parent precedes its children and subtree of node is a contiguous range starting at the node.
+	//World transforms are recomputed only for dirty nodes and their descendants
+	class SceneGraph
+	{
+	public:
+		static const uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+		//Parent must be the last added node or one of its ancestors, so order stays depth-first.
+		//World transform is valid right away if parent is not dirty
+		uint32_t addNode(uint32_t parent, const glm::mat4& localTransform);
+		void clear();
+
+		uint32_t getNodesCount() const { return static_cast<uint32_t>(mParents.size()); }
+		uint32_t getParent(uint32_t node) const { return mParents[node]; }
+		//Subtree of node is [node, getSubtreeEnd(node))
+		uint32_t getSubtreeEnd(uint32_t node) const { return mSubtreeEnds[node]; }
+
+		const glm::mat4& getLocalTransform(uint32_t node) const { return mLocalTransforms[node]; }
+		void setLocalTransform(uint32_t node, const glm::mat4& transform);
+		//World transforms of dirty subtrees are stale until update
+		const glm::mat4& getWorldTransform(uint32_t node) const { return mWorldTransforms[node]; }
+		bool isDirty() const { return mDirty; }
+
+		//Recomputes world transforms of dirty subtrees in one linear pass, returns recomputed nodes count.
+		//With thread pool large hierarchies are split into independent subtrees updated in parallel,
+		//calling thread takes part and never waits for tasks which haven't started
+		uint32_t update(ThreadPool* threadPool = nullptr);
+
+	private:
+		struct Range
+		{
+			uint32_t mFirst = 0;
+			uint32_t mEnd = 0;
+		};
+
+		uint32_t updateRange(uint32_t first, uint32_t end);
+		//Splits nodes into ranges of whole subtrees not larger than chunk. Roots of larger subtrees
+		//are kept apart and updated before ranges
+		void partition(uint32_t first, uint32_t end, uint32_t chunkSize);
+
+		std::vector<uint32_t> mParents;
+		std::vector<uint32_t> mSubtreeEnds;
+		std::vector<glm::mat4> mLocalTransforms;
+		std::vector<glm::mat4> mWorldTransforms;
+		//Node needs world transform, its descendants are updated with it
+		std::vector<uint8_t> mDirtyNodes;
+		bool mDirty = false;
+
+		//Partition for parallel update, rebuilt when nodes are added
+		std::vector<Range> mRanges;
+		std::vector<uint32_t> mSplitNodes;
+		uint32_t mPartitionNodesCount = 0;
+	};
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Serialization/BaseTypesSerialization.hpp"
+#include "Renderer/ShaderVariant.hpp"
+
+#include <rapidjson/document.h>
+
+namespace fre
+{
+    inline void serialize(rapidjson::Value& v, const char* n, const ShaderVariantKey& m, rapidjson::Document& d)
+    {
+        rapidjson::Value tmp(rapidjson::kObjectType);
+        SERIALIZE_MEMBER(tmp, m, mFeatures);
+        v.AddMember(rapidjson::StringRef(n), tmp, d.GetAllocator());
+    }
+
+    inline void deserialize(const rapidjson::Value& v, const char* n, ShaderVariantKey& result)
+    {
+        if(v.HasMember(n))
+        {
+            const rapidjson::Value& tmp = v[n];
+
+            DESERIALIZE_MEMBER(tmp, result, mFeatures);
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace fre
+{
+    struct Image;
+
+    //What is done to decoded image before upload. Only 8 bit images are processed, others keep level 0
+    struct TextureProcessing
+    {
+        //Full chain is filtered on CPU
+        bool mMipmaps = false;
+        //Color images and images of 1 or 2 channels are compressed to BC1, BC3, BC4 or BC5 with full chain.
+        //Linear color like normal maps stays uncompressed, BC1 loses too much of its channels
+        bool mCompression = false;
+    };
+
+    struct TextureCacheStatistics
+    {
+        uint64_t mHits = 0;
+        uint64_t mMisses = 0;
+        uint64_t mEvictions = 0;
+        //Bytes of cache files after last store
+        uint64_t mSize = 0;
+    };
+
+    //Content addressed cache of GPU ready images: format, extent and levels exactly as they are uploaded,
+    //stored as KTX2 files named by hash of source file bytes and processing. Hits are mapped and image data
+    //points into mapping, so nothing is decoded or copied before upload. Files above size limit are evicted
+    //least recently used first, hits renew write time of their files. Thread safe
+    class TextureCache
+    {
+    public:
+        static const uint64_t DEFAULT_SIZE_LIMIT = 2ull << 30;
+
+        //Directory is created on first store
+        void create(const std::string& directory, uint64_t sizeLimit = DEFAULT_SIZE_LIMIT);
+        bool isCreated() const { return !mDirectory.empty(); }
+        //Image with file name is read from cache or loaded, processed and stored, result is the same.
+        //Without cache it is loaded and processed only
+        void loadImage(Image& image, const TextureProcessing& processing);
+        TextureCacheStatistics getStatistics() const;
+
+        //Loaded image is replaced by processed one
+        static void processImage(Image& image, const TextureProcessing& processing);
+
+    private:
+        //0 if source file can't be read
+        static uint64_t getKey(const std::string& fileName, const Image& image, const TextureProcessing& processing);
+        std::string getPath(uint64_t key) const;
+        //False if there is no valid file
+        bool loadFile(const std::string& path, Image& image);
+        void storeFile(const std::string& path, const Image& image);
+        void evict();
+
+        std::string mDirectory;
+        uint64_t mSizeLimit = DEFAULT_SIZE_LIMIT;
+        mutable std::mutex mMutex;
+        TextureCacheStatistics mStatistics;
+    };
+}
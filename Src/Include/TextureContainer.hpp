@@ -0,0 +1,42 @@
+#pragma once
+
+#include <volk.h>
+
+#include "Renderer/Mipmaps.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fre
+{
+    //Bytes of 4x4 block of BC format or of texel of uncompressed one, 0 if format can't be stored in containers
+    uint32_t getFormatBlockBytes(VkFormat format);
+    bool isBlockCompressedFormat(VkFormat format);
+    //Bytes of level, partial blocks at right and bottom edges are whole ones
+    size_t getLevelSize(VkFormat format, uint32_t width, uint32_t height);
+
+    //Single 2D texture with prebuilt levels, level 0 first and levels tightly packed
+    struct TextureLevels
+    {
+        VkFormat mFormat = VK_FORMAT_UNDEFINED;
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        std::vector<MipLevel> mLevels;
+        std::vector<uint8_t> mData;
+    };
+
+    //KTX2 without supercompression. Arrays, cubemaps and volumes aren't supported. Name is used in errors only
+    TextureLevels parseKTX2(const std::vector<uint8_t>& file, const std::string& name);
+    //Levels of KTX2 file in place: data is empty and level offsets are offsets in file, smallest level comes first
+    TextureLevels parseKTX2Header(const uint8_t* file, size_t size, const std::string& name);
+    //Level data is written smallest level first as KTX2 requires, with data format descriptor of format
+    std::vector<uint8_t> serializeKTX2(const TextureLevels& texture);
+    //DDS with DXT1, DXT5, ATI1, ATI2 four character codes, RGBA8 pixel format or DX10 header of BC1-5, BC7, RGBA8
+    TextureLevels parseDDS(const std::vector<uint8_t>& file, const std::string& name);
+
+    TextureLevels loadKTX2(const std::string& fileName);
+    void saveKTX2(const std::string& fileName, const TextureLevels& texture);
+    TextureLevels loadDDS(const std::string& fileName);
+}
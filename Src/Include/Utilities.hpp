@@ -28,11 +28,15 @@ namespace fre
 {
 	const int MAX_FRAME_DRAWS = 3;
 	const int MAX_OBJECTS = 40;
+	//Capacity of bindless texture array and material texture table
+	const uint32_t MAX_BINDLESS_TEXTURES = 4096;
+	const uint32_t MAX_BINDLESS_MATERIALS = 4096;
 	const EAttachmentKind COLOR_ATTACHMENT = EAttachmentKind::Color;
 	const EAttachmentKind POSITION_ATTACHMENT = EAttachmentKind::Color16;
 	const EAttachmentKind DEPTH_ATTACHMENT = EAttachmentKind::DepthStencil;
 
 	struct ShaderMetaData;
+	class VulkanOneTimeCommandPool;
 
 	struct MainDevice
 	{
@@ -49,6 +53,15 @@ namespace fre
 		glm::vec2 tex = glm::vec2(0.0f);
 	};
 
+	//Default per-instance data, read by vertex shader at instance rate
+	struct MeshInstance
+	{
+		glm::mat4 transform = glm::mat4(1.0f);
+		glm::vec4 color = glm::vec4(1.0f);
+		//Transforms normals, see getNormalMatrix. Columns are padded to vec4
+		glm::mat4 normalMatrix = glm::mat4(1.0f);
+	};
+
 	template<class T>
 	struct BoundingBox
 	{
@@ -118,12 +131,7 @@ namespace fre
 		VkMemoryPropertyFlags bufferProperties, VkMemoryAllocateFlags allocFlags,
 		VkBuffer* buffer, uint64_t* deviceAddress, VkDeviceMemory* bufferMemory);
 
-	VkCommandBuffer beginCommandBuffer(VkDevice device, VkCommandPool commandPool);
-
-	void endAndSubmitCommitBuffer(VkDevice device, VkCommandPool commandPool,
-		VkQueue queue, VkCommandBuffer commandBuffer);
-
-	void copyBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool,
+	void copyBuffer(VkDevice device, VkQueue transferQueue, VulkanOneTimeCommandPool& transferCommandPool,
 		VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize);
 
 	std::vector<VulkanQueueFamily> getQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
@@ -153,6 +161,17 @@ namespace fre
 
 	glm::vec2 toScreenSpace(const glm::vec3 worldSpace, const glm::vec2& viewSize, const glm::mat4& m, const glm::mat4& v, const glm::mat4& p);
 
+	//Inverse transposed upper 3x3 of transform, keeps normals perpendicular under non-uniform scale
+	glm::mat4 getNormalMatrix(const glm::mat4& transform);
+
+	//Changed by setters of meshes, models, materials and descriptors. Renderer gathers draws again
+	//only when it differs from version they were gathered with
+	uint64_t getSceneVersion();
+	void changeSceneVersion();
+	//Changed by model matrices and scene graph nodes, moved objects keep their draws
+	uint64_t getTransformsVersion();
+	void changeTransformsVersion();
+
 	ImVec2 operator + (const ImVec2& lhs, const ImVec2& rhs);
 	ImVec2 operator - (const ImVec2& lhs, const ImVec2& rhs);
 	ImVec2 operator * (const ImVec2& lhs, const float rhs);
@@ -2,9 +2,31 @@
 #include "VulkanBufferManager.hpp"
 #include "VulkanTexture.hpp"
 #include "VulkanAccelerationStructure.hpp"
+#include "Utilities.hpp"
+
+#include <atomic>
 
 namespace fre
 {
+    //Non-dispatchable handles are pointers or 64 bit integers depending on platform
+    template <typename Handle>
+    static uint64_t getHandleKey(Handle handle)
+    {
+        return (uint64_t)(handle);
+    }
+
+    uint64_t VulkanDescriptor::getNextVersion()
+    {
+        static std::atomic<uint64_t> version{ 0 };
+        return ++version;
+    }
+
+    void VulkanDescriptor::invalidate()
+    {
+        mVersion = getNextVersion();
+        changeSceneVersion();
+    }
+
     VkWriteDescriptorSet DescriptorBuffer::getWriter(VkDescriptorSet ds, uint32_t binding)
     {
         mBufferInfo.buffer = mBuffer->mBuffer;
@@ -21,6 +43,16 @@ namespace fre
         return mWriteDescriptorSet;
     }
 
+    void DescriptorBuffer::getResourceKey(std::vector<uint64_t>& key) const
+    {
+        //Whole buffer is written, see getWriter
+        key.push_back(mType);
+        key.push_back(getVersion());
+        key.push_back(getHandleKey(mBuffer != nullptr ? mBuffer->mBuffer : VK_NULL_HANDLE));
+        key.push_back(0);
+        key.push_back(VK_WHOLE_SIZE);
+    }
+
     VkWriteDescriptorSet DescriptorImage::getWriter(VkDescriptorSet ds, uint32_t binding)
     {
         mImageInfo.imageLayout = mLayout;
@@ -37,6 +69,15 @@ namespace fre
         return mWriteDescriptorSet;
     };
 
+    void DescriptorImage::getResourceKey(std::vector<uint64_t>& key) const
+    {
+        key.push_back(mType);
+        key.push_back(getVersion());
+        key.push_back(mLayout);
+        key.push_back(getHandleKey(mImageView));
+        key.push_back(getHandleKey(mSampler));
+    }
+
     VkWriteDescriptorSet DescriptorAccelerationStructure::getWriter(VkDescriptorSet ds, uint32_t binding)
     {
         mWriteExt.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
@@ -52,4 +93,11 @@ namespace fre
 
         return mWrite;
     }
+
+    void DescriptorAccelerationStructure::getResourceKey(std::vector<uint64_t>& key) const
+    {
+        key.push_back(mType);
+        key.push_back(getVersion());
+        key.push_back(getHandleKey(mAccelerationStructure));
+    }
 }
\ No newline at end of file
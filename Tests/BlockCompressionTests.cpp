@@ -0,0 +1,287 @@
+#include "Renderer/BlockCompression.hpp"
+#include "TextureContainer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+using namespace fre;
+
+namespace
+{
+	const uint32_t BLOCK_TEXELS = 16;
+
+	//Smooth RGBA image with noise, alpha is a horizontal ramp
+	std::vector<uint8_t> createImage(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_int_distribution<int32_t> noise(-6, 6);
+		std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4);
+		for(uint32_t y = 0; y < height; y++)
+		{
+			for(uint32_t x = 0; x < width; x++)
+			{
+				const float values[4] =
+				{
+					127.5f + 127.5f * std::sin(x * 0.013f + y * 0.007f),
+					255.0f * y / std::max(height - 1, 1u),
+					127.5f + 127.5f * std::cos(x * 0.021f - y * 0.017f),
+					255.0f * x / std::max(width - 1, 1u)
+				};
+				for(uint32_t c = 0; c < 4; c++)
+				{
+					const int32_t value = static_cast<int32_t>(values[c]) + noise(generator);
+					result[(static_cast<size_t>(y) * width + x) * 4 + c] = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+				}
+			}
+		}
+
+		return result;
+	}
+
+	//Channels of format as bits of mask
+	uint32_t getChannelsMask(VkFormat format)
+	{
+		switch(format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			return 0x7;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+			return 0xF;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			return 0x1;
+		default:
+			return 0x3;
+		}
+	}
+
+	void encodeBlock(VkFormat format, const uint8_t* texels, uint8_t* block)
+	{
+		switch(format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			encodeBC1Block(texels, block);
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+			encodeBC3Block(texels, block);
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			encodeBC4Block(texels, 0, block);
+			break;
+		default:
+			encodeBC5Block(texels, block);
+			break;
+		}
+	}
+
+	//Root mean square error of decoded level 0 against source for channels of format
+	float getLevelError(VkFormat format, const uint8_t* source, uint32_t width, uint32_t height, const uint8_t* levelData)
+	{
+		const uint32_t channelsMask = getChannelsMask(format);
+		const uint32_t blocksCount = (width + 3) / 4;
+		const uint32_t blockBytes = getFormatBlockBytes(format);
+		double sum = 0.0;
+		uint32_t count = 0;
+		uint8_t texels[BLOCK_TEXELS * 4];
+		for(uint32_t blockY = 0; blockY < (height + 3) / 4; blockY++)
+		{
+			for(uint32_t blockX = 0; blockX < blocksCount; blockX++)
+			{
+				decodeBlock(format, &levelData[(static_cast<size_t>(blockY) * blocksCount + blockX) * blockBytes], texels);
+				for(uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++)
+				{
+					for(uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++)
+					{
+						const size_t texel = static_cast<size_t>(blockY * 4 + y) * width + blockX * 4 + x;
+						for(uint32_t c = 0; c < 4; c++)
+						{
+							if((channelsMask & (1 << c)) != 0)
+							{
+								const double difference = static_cast<double>(source[texel * 4 + c]) - texels[(y * 4 + x) * 4 + c];
+								sum += difference * difference;
+								count++;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		return count > 0 ? static_cast<float>(std::sqrt(sum / count)) : 0.0f;
+	}
+
+	void expectTexturesEqual(const TextureLevels& expected, const TextureLevels& actual)
+	{
+		EXPECT_EQ(expected.mFormat, actual.mFormat);
+		EXPECT_EQ(expected.mWidth, actual.mWidth);
+		EXPECT_EQ(expected.mHeight, actual.mHeight);
+		EXPECT_TRUE(expected.mData == actual.mData);
+		ASSERT_EQ(expected.mLevels.size(), actual.mLevels.size());
+		for(size_t level = 0; level < expected.mLevels.size(); level++)
+		{
+			const auto& a = expected.mLevels[level];
+			const auto& b = actual.mLevels[level];
+			EXPECT_EQ(a.mWidth, b.mWidth) << "level " << level;
+			EXPECT_EQ(a.mHeight, b.mHeight) << "level " << level;
+			EXPECT_EQ(a.mOffset, b.mOffset) << "level " << level;
+			EXPECT_EQ(a.mSize, b.mSize) << "level " << level;
+		}
+	}
+
+	//DDS file of texture with four character code or with DX10 header of DXGI format if code is DX10
+	std::vector<uint8_t> makeDDS(const TextureLevels& texture, const char* fourCC, uint32_t dxgiFormat)
+	{
+		const bool dx10 = strcmp(fourCC, "DX10") == 0;
+		std::vector<uint8_t> result(128 + (dx10 ? 20 : 0), 0);
+		const uint32_t header[] =
+		{
+			124, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000, texture.mHeight, texture.mWidth, 0, 0,
+			static_cast<uint32_t>(texture.mLevels.size())
+		};
+		memcpy(result.data(), "DDS ", 4);
+		memcpy(&result[4], header, sizeof(header));
+		const uint32_t pixelFormat[] = { 32, 0x4 };
+		memcpy(&result[76], pixelFormat, sizeof(pixelFormat));
+		memcpy(&result[84], fourCC, 4);
+		if(dx10)
+		{
+			const uint32_t dx10Header[] = { dxgiFormat, 3, 0, 1, 0 };
+			memcpy(&result[128], dx10Header, sizeof(dx10Header));
+		}
+		result.insert(result.end(), texture.mData.begin(), texture.mData.end());
+
+		return result;
+	}
+}
+
+//Solid blocks of 565 colors and of any single channel values are exact
+TEST(BlockCompression, SolidBlocks)
+{
+	std::mt19937 generator(1);
+	std::uniform_int_distribution<uint32_t> values(0, 0xFFFF);
+	for(uint32_t i = 0; i < 256; i++)
+	{
+		const uint32_t random = values(generator);
+		const uint32_t r = (random >> 11) & 31;
+		const uint32_t g = (random >> 5) & 63;
+		const uint32_t b = random & 31;
+		uint8_t texels[BLOCK_TEXELS * 4];
+		for(uint32_t texel = 0; texel < BLOCK_TEXELS; texel++)
+		{
+			texels[texel * 4 + 0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+			texels[texel * 4 + 1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+			texels[texel * 4 + 2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+			texels[texel * 4 + 3] = static_cast<uint8_t>(random >> 8);
+		}
+		for(const VkFormat format : { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK,
+			VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK })
+		{
+			const uint32_t channelsMask = getChannelsMask(format);
+			uint8_t block[16];
+			uint8_t decoded[BLOCK_TEXELS * 4];
+			encodeBlock(format, texels, block);
+			decodeBlock(format, block, decoded);
+			uint32_t errors = 0;
+			for(uint32_t texel = 0; texel < BLOCK_TEXELS * 4; texel++)
+			{
+				errors += (channelsMask & (1 << (texel % 4))) != 0 && decoded[texel] != texels[texel] ? 1 : 0;
+			}
+			EXPECT_EQ(errors, 0u) << "format " << format << ", color " << random;
+		}
+	}
+}
+
+TEST(BlockCompression, ChooseFormat)
+{
+	std::vector<uint8_t> opaque(64, 255);
+	EXPECT_EQ(chooseBlockCompressedFormat(opaque.data(), 64, 1), VK_FORMAT_BC4_UNORM_BLOCK);
+	EXPECT_EQ(chooseBlockCompressedFormat(opaque.data(), 32, 2), VK_FORMAT_BC5_UNORM_BLOCK);
+	EXPECT_EQ(chooseBlockCompressedFormat(opaque.data(), 16, 3), VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+	EXPECT_EQ(chooseBlockCompressedFormat(opaque.data(), 16, 4), VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+	opaque[63] = 254;
+	EXPECT_EQ(chooseBlockCompressedFormat(opaque.data(), 16, 4), VK_FORMAT_BC3_UNORM_BLOCK);
+}
+
+//Level 0 of every format stays close to source, error is in 8 bit units
+TEST(BlockCompression, Error)
+{
+	for(const auto& [width, height] : { std::pair<uint32_t, uint32_t>{ 512, 256 }, { 1023, 517 } })
+	{
+		const auto image = createImage(width, height, 1);
+		for(const auto& [format, maxError] : { std::pair<VkFormat, float>{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4.5f },
+			{ VK_FORMAT_BC3_UNORM_BLOCK, 4.0f }, { VK_FORMAT_BC4_UNORM_BLOCK, 1.5f }, { VK_FORMAT_BC5_UNORM_BLOCK, 1.5f } })
+		{
+			std::vector<uint8_t> levelsData;
+			const bool srgb = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK || format == VK_FORMAT_BC3_UNORM_BLOCK;
+			const auto levels = compressImage(image.data(), width, height, 4, srgb, format, 2, levelsData);
+			ASSERT_EQ(levels.size(), getMipLevelsCount(width, height));
+			size_t offset = 0;
+			for(const auto& level : levels)
+			{
+				EXPECT_EQ(level.mOffset, offset);
+				EXPECT_EQ(level.mSize, getLevelSize(format, level.mWidth, level.mHeight));
+				offset += level.mSize;
+			}
+			EXPECT_EQ(offset, levelsData.size());
+			EXPECT_LT(getLevelError(format, image.data(), width, height, levelsData.data()), maxError)
+				<< width << "x" << height << ", format " << format;
+		}
+	}
+}
+
+//Result doesn't depend on threads count
+TEST(BlockCompression, Deterministic)
+{
+	const uint32_t width = 1023;
+	const uint32_t height = 517;
+	const auto image = createImage(width, height, 2);
+	std::vector<uint8_t> single;
+	std::vector<uint8_t> parallel;
+	compressImage(image.data(), width, height, 4, true, VK_FORMAT_BC3_UNORM_BLOCK, 1, single);
+	compressImage(image.data(), width, height, 4, true, VK_FORMAT_BC3_UNORM_BLOCK, 4, parallel);
+	EXPECT_TRUE(single == parallel);
+}
+
+TEST(BlockCompression, UnsupportedFormat)
+{
+	const auto image = createImage(8, 8, 1);
+	std::vector<uint8_t> levelsData;
+	EXPECT_THROW(compressImage(image.data(), 8, 8, 4, false, VK_FORMAT_BC7_UNORM_BLOCK, 1, levelsData), std::runtime_error);
+}
+
+//Odd sized chains read back from KTX2 and DDS as written
+TEST(BlockCompression, Containers)
+{
+	const auto image = createImage(37, 19, 1);
+	TextureLevels texture;
+	texture.mWidth = 37;
+	texture.mHeight = 19;
+	for(const VkFormat format : { VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK })
+	{
+		texture.mFormat = format;
+		texture.mLevels = compressImage(image.data(), texture.mWidth, texture.mHeight, 4, true, format, 1, texture.mData);
+		const auto ktx2 = serializeKTX2(texture);
+		expectTexturesEqual(texture, parseKTX2(ktx2, "test.ktx2"));
+
+		const uint32_t dxgiFormat = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK ? 71 : format == VK_FORMAT_BC3_UNORM_BLOCK ? 77 : 83;
+		const char* fourCC = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK ? "DXT1" : format == VK_FORMAT_BC3_UNORM_BLOCK ? "DXT5" : "ATI2";
+		for(const char* code : { "DX10", fourCC })
+		{
+			//DDS has no BC1 format without alpha
+			auto expected = texture;
+			expected.mFormat = format == VK_FORMAT_BC1_RGB_UNORM_BLOCK ? VK_FORMAT_BC1_RGBA_UNORM_BLOCK : format;
+			expectTexturesEqual(expected, parseDDS(makeDDS(texture, code, dxgiFormat), "test.dds"));
+		}
+
+		//Truncated file is rejected
+		EXPECT_THROW(parseKTX2(std::vector<uint8_t>(ktx2.begin(), ktx2.end() - 1), "test.ktx2"), std::runtime_error);
+	}
+
+	texture.mFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	texture.mLevels = generateMipmaps(image.data(), texture.mWidth, texture.mHeight, 4, false, texture.mData);
+	expectTexturesEqual(texture, parseKTX2(serializeKTX2(texture), "test.ktx2"));
+}
@@ -0,0 +1,160 @@
+#include "Renderer/Culling.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace fre;
+
+namespace
+{
+	const float CAMERA_NEAR = 1.0f;
+	const float CAMERA_FAR = 100.0f;
+	const uint32_t DEPTH_SIZE = 64;
+
+	//Camera at origin looking along -z with 90 degrees field of view. Built by hand, so depth is
+	//in Vulkan [0, 1] range whatever glm is configured with
+	glm::mat4 getViewProjection()
+	{
+		glm::mat4 result(0.0f);
+		result[0][0] = 1.0f;
+		result[1][1] = 1.0f;
+		result[2][2] = CAMERA_FAR / (CAMERA_NEAR - CAMERA_FAR);
+		result[2][3] = -1.0f;
+		result[3][2] = CAMERA_FAR * CAMERA_NEAR / (CAMERA_NEAR - CAMERA_FAR);
+
+		return result;
+	}
+
+	float getDepth(float z)
+	{
+		const glm::vec4 clip = getViewProjection() * glm::vec4(0.0f, 0.0f, z, 1.0f);
+
+		return clip.z / clip.w;
+	}
+
+	glm::mat4 getTransform(float x, float y, float z, float scale = 1.0f)
+	{
+		glm::mat4 result(1.0f);
+		result[0][0] = scale;
+		result[1][1] = scale;
+		result[2][2] = scale;
+		result[3] = glm::vec4(x, y, z, 1.0f);
+
+		return result;
+	}
+
+	//Wall at distance 10 covers left half of screen, right half is empty
+	HiZPyramid getWallPyramid()
+	{
+		std::vector<float> depth(DEPTH_SIZE * DEPTH_SIZE, 1.0f);
+		for(uint32_t y = 0; y < DEPTH_SIZE; y++)
+		{
+			std::fill_n(depth.begin() + y * DEPTH_SIZE, DEPTH_SIZE / 2, getDepth(-10.0f));
+		}
+		HiZPyramid result;
+		result.build(depth.data(), DEPTH_SIZE, DEPTH_SIZE, DEPTH_SIZE, DEPTH_SIZE);
+
+		return result;
+	}
+
+	BoundingSphere getSphere(float x, float y, float z, float radius)
+	{
+		BoundingSphere result;
+		result.mCenter = glm::vec3(x, y, z);
+		result.mRadius = radius;
+
+		return result;
+	}
+
+	CullingDraw getDraw(const glm::vec4& sphere, uint32_t batch)
+	{
+		CullingDraw result;
+		result.mSphere = sphere;
+		result.mBatch = batch;
+
+		return result;
+	}
+}
+
+//Every pyramid texel keeps max depth of texels it covers, non power of two depth is reduced conservatively
+TEST(Culling, HiZPyramidBuild)
+{
+	const uint32_t depthSize = 6;
+	std::vector<float> depth(depthSize * depthSize);
+	for(uint32_t i = 0; i < depth.size(); i++)
+	{
+		depth[i] = i / 100.0f;
+	}
+
+	HiZPyramid pyramid;
+	const uint32_t size = getHiZSize(depthSize);
+	pyramid.build(depth.data(), depthSize, depthSize, size, size);
+	EXPECT_EQ(size, 4u);
+	ASSERT_EQ(pyramid.getLevelsCount(), 3u);
+	EXPECT_EQ(pyramid.getLevelWidth(1), 2u);
+	EXPECT_EQ(pyramid.getLevelHeight(2), 1u);
+
+	for(uint32_t y = 0; y < depthSize; y++)
+	{
+		for(uint32_t x = 0; x < depthSize; x++)
+		{
+			EXPECT_GE(pyramid.getDepth(0, x * size / depthSize, y * size / depthSize), depth[y * depthSize + x]);
+		}
+	}
+	EXPECT_FLOAT_EQ(pyramid.getDepth(0, 0, 0), depth[1 * depthSize + 1]);
+	EXPECT_FLOAT_EQ(pyramid.getDepth(1, 1, 0), depth[2 * depthSize + 5]);
+	EXPECT_FLOAT_EQ(pyramid.getDepth(2, 0, 0), depth.back());
+}
+
+//Spheres behind wall are occluded, ones in front of it, beside it or crossing near plane are not
+TEST(Culling, SphereOcclusion)
+{
+	const HiZPyramid pyramid = getWallPyramid();
+	const glm::mat4 viewProjection = getViewProjection();
+
+	EXPECT_TRUE(isSphereOccluded(pyramid, viewProjection, getSphere(-20.0f, 0.0f, -40.0f, 1.0f)));
+	EXPECT_TRUE(isSphereOccluded(pyramid, viewProjection, getSphere(-5.0f, 3.0f, -12.0f, 0.5f)));
+	EXPECT_FALSE(isSphereOccluded(pyramid, viewProjection, getSphere(-2.0f, 0.0f, -5.0f, 0.5f)));
+	EXPECT_FALSE(isSphereOccluded(pyramid, viewProjection, getSphere(20.0f, 0.0f, -40.0f, 1.0f)));
+	//Wall covers only part of sphere rectangle
+	EXPECT_FALSE(isSphereOccluded(pyramid, viewProjection, getSphere(0.0f, 0.0f, -40.0f, 5.0f)));
+	EXPECT_FALSE(isSphereOccluded(pyramid, viewProjection, getSphere(0.0f, 0.0f, -1.0f, 2.0f)));
+}
+
+//Survivors are counted per batch, spheres are moved and scaled by transforms of their draws
+TEST(Culling, CullDraws)
+{
+	const glm::mat4 viewProjection = getViewProjection();
+	const Frustum frustum = getFrustum(viewProjection);
+	const HiZPyramid pyramid = getWallPyramid();
+	const glm::vec4 unitSphere(0.0f, 0.0f, 0.0f, 1.0f);
+	const std::vector<CullingDraw> draws = {
+		//Beside wall
+		getDraw(unitSphere, 0),
+		//Behind camera
+		getDraw(unitSphere, 0),
+		//Crosses far plane only when scaled
+		getDraw(unitSphere, 0),
+		//Behind wall
+		getDraw(unitSphere, 1),
+		//In front of wall, sphere center is offset in mesh space
+		getDraw(glm::vec4(0.0f, 0.0f, -5.0f, 0.5f), 1) };
+	const std::vector<glm::mat4> transforms = {
+		getTransform(10.0f, 0.0f, -40.0f),
+		getTransform(0.0f, 0.0f, 20.0f),
+		getTransform(0.0f, 0.0f, -103.0f, 5.0f),
+		getTransform(-20.0f, 0.0f, -40.0f),
+		getTransform(-2.0f, 0.0f, 0.0f) };
+
+	const auto frustumCounts = cullDraws(draws, transforms, 2, frustum, nullptr, viewProjection);
+	EXPECT_EQ(frustumCounts, std::vector<uint32_t>({ 2u, 2u }));
+
+	const auto occlusionCounts = cullDraws(draws, transforms, 2, frustum, &pyramid, viewProjection);
+	EXPECT_EQ(occlusionCounts, std::vector<uint32_t>({ 2u, 1u }));
+
+	//Unscaled sphere is beyond far plane
+	auto unscaled = transforms;
+	unscaled[2] = getTransform(0.0f, 0.0f, -103.0f);
+	EXPECT_EQ(cullDraws(draws, unscaled, 2, frustum, nullptr, viewProjection), std::vector<uint32_t>({ 1u, 2u }));
+}
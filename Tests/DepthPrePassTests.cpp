@@ -0,0 +1,111 @@
+#include "Renderer/DepthPrePass.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace fre;
+
+namespace
+{
+	DepthPrePass getAutoPrePass(uint32_t probeInterval = 120)
+	{
+		DepthPrePass result;
+		result.mSettings.mMode = EDepthPrePassMode::Auto;
+		result.mSettings.mProbeInterval = probeInterval;
+
+		return result;
+	}
+
+	//Records frames of synthetic overdraw trace the way renderer does, returns frames recorded with pre-pass.
+	//Overdraw is reported for every frame, frames with pre-pass must not change decision
+	std::vector<bool> runTrace(DepthPrePass& prePass, const std::vector<float>& overdraws)
+	{
+		std::vector<bool> result;
+		for(const float overdraw : overdraws)
+		{
+			const bool withPrePass = prePass.beginFrame();
+			prePass.update(overdraw, withPrePass);
+			result.push_back(withPrePass);
+		}
+
+		return result;
+	}
+
+	std::vector<float> getTrace(uint32_t framesCount, float overdraw)
+	{
+		return std::vector<float>(framesCount, overdraw);
+	}
+}
+
+//Pre-pass is enabled by overdraw above band for several frames in a row, overdraw inside band keeps it off
+TEST(DepthPrePass, Hysteresis)
+{
+	DepthPrePass prePass = getAutoPrePass();
+	EXPECT_EQ(runTrace(prePass, getTrace(10, 1.8f)), std::vector<bool>(10, false));
+	EXPECT_FALSE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 1.8f);
+
+	//Spikes shorter than frames to change, frame inside band starts counting again
+	EXPECT_EQ(runTrace(prePass, { 2.5f, 2.5f, 1.8f, 2.5f, 2.5f }), std::vector<bool>(5, false));
+	EXPECT_FALSE(prePass.isEnabled());
+	EXPECT_EQ(runTrace(prePass, { 2.5f }), std::vector<bool>(1, false));
+	EXPECT_TRUE(prePass.isEnabled());
+
+	//Low overdraw measured with pre-pass is its own effect and is ignored
+	EXPECT_EQ(runTrace(prePass, getTrace(20, 1.0f)), std::vector<bool>(20, true));
+	EXPECT_TRUE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 2.5f);
+
+	prePass.reset();
+	EXPECT_FALSE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 0.0f);
+	EXPECT_FALSE(prePass.beginFrame());
+}
+
+//While enabled every probe interval one frame is recorded without pre-pass, single probe below band disables it
+TEST(DepthPrePass, ProbeFrames)
+{
+	const uint32_t probeInterval = 10;
+	DepthPrePass prePass = getAutoPrePass(probeInterval);
+	runTrace(prePass, getTrace(3, 3.0f));
+	ASSERT_TRUE(prePass.isEnabled());
+
+	//Probes inside band keep pre-pass, interval is counted from switch
+	std::vector<bool> expected(3 * probeInterval, true);
+	for(uint32_t i = probeInterval - 1; i < expected.size(); i += probeInterval)
+	{
+		expected[i] = false;
+	}
+	EXPECT_EQ(runTrace(prePass, getTrace(3 * probeInterval, 1.8f)), expected);
+	EXPECT_TRUE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 1.8f);
+
+	//Only probe measures low overdraw, it disables pre-pass at once
+	expected.assign(probeInterval, true);
+	expected.back() = false;
+	EXPECT_EQ(runTrace(prePass, getTrace(probeInterval, 1.2f)), expected);
+	EXPECT_FALSE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 1.2f);
+
+	//Without pre-pass every frame measures overdraw, enabling again needs frames to change in a row
+	EXPECT_EQ(runTrace(prePass, { 1.2f, 3.0f, 3.0f }), std::vector<bool>(3, false));
+	EXPECT_FALSE(prePass.isEnabled());
+	EXPECT_EQ(runTrace(prePass, { 3.0f, 3.0f }), std::vector<bool>({ false, true }));
+	EXPECT_TRUE(prePass.isEnabled());
+}
+
+//Fixed modes ignore overdraw, off mode still reports it
+TEST(DepthPrePass, FixedModes)
+{
+	DepthPrePass prePass;
+	EXPECT_EQ(runTrace(prePass, getTrace(5, 3.0f)), std::vector<bool>(5, false));
+	EXPECT_FALSE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 3.0f);
+
+	prePass.mSettings.mMode = EDepthPrePassMode::On;
+	prePass.mSettings.mProbeInterval = 2;
+	EXPECT_EQ(runTrace(prePass, getTrace(5, 1.0f)), std::vector<bool>(5, true));
+	EXPECT_TRUE(prePass.isEnabled());
+	EXPECT_FLOAT_EQ(prePass.getOverdraw(), 3.0f);
+}
@@ -0,0 +1,140 @@
+#include "Renderer/DynamicResolution.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace fre;
+
+namespace
+{
+	//Synthetic GPU: frame time is proportional to pixels count, with a few percent of noise
+	struct FrameTimeTrace
+	{
+		float mFullScaleTime = 0.0f;
+		float mNoise = 0.03f;
+		std::mt19937 mGenerator{ 1 };
+
+		float getFrameTime(float scale)
+		{
+			std::uniform_real_distribution<float> noise(1.0f - mNoise, 1.0f + mNoise);
+			return mFullScaleTime * scale * scale * noise(mGenerator);
+		}
+	};
+
+	struct TraceResult
+	{
+		uint32_t mChanges = 0;
+		//Frame of last scale change
+		uint32_t mLastChange = 0;
+		float mMinScale = 1.0f;
+		float mMaxScale = 0.0f;
+	};
+
+	TraceResult run(DynamicResolution& resolution, FrameTimeTrace& trace, uint32_t framesCount)
+	{
+		TraceResult result;
+		for(uint32_t frame = 0; frame < framesCount; frame++)
+		{
+			if(resolution.update(trace.getFrameTime(resolution.getScale())))
+			{
+				result.mChanges++;
+				result.mLastChange = frame;
+			}
+			result.mMinScale = std::min(result.mMinScale, resolution.getScale());
+			result.mMaxScale = std::max(result.mMaxScale, resolution.getScale());
+		}
+
+		return result;
+	}
+}
+
+//Scale settles on the largest step which fits budget, from above and from below, and stays there
+TEST(DynamicResolution, Convergence)
+{
+	DynamicResolution resolution;
+	const float target = resolution.mSettings.mTargetFrameTime;
+	FrameTimeTrace heavy;
+	heavy.mFullScaleTime = 25.0f;
+	auto result = run(resolution, heavy, 2000);
+	EXPECT_FLOAT_EQ(resolution.getScale(), 0.8f);
+	EXPECT_LT(result.mLastChange, 100u);
+	EXPECT_LE(heavy.mFullScaleTime * 0.8f * 0.8f, target * resolution.mSettings.mHighThreshold);
+
+	resolution.reset(0.5f);
+	FrameTimeTrace light;
+	light.mFullScaleTime = 20.0f;
+	result = run(resolution, light, 2000);
+	//0.8 would be under low threshold, 0.9 over high one
+	EXPECT_FLOAT_EQ(resolution.getScale(), 0.85f);
+	EXPECT_EQ(result.mChanges, 7u);
+	EXPECT_LT(result.mLastChange, 1000u);
+	EXPECT_LE(result.mMaxScale, 0.85f);
+}
+
+TEST(DynamicResolution, HysteresisBand)
+{
+	DynamicResolution resolution;
+	const auto& settings = resolution.mSettings;
+
+	//Noisy frame times inside band never change scale
+	FrameTimeTrace inBand;
+	inBand.mFullScaleTime = settings.mTargetFrameTime * 0.92f;
+	inBand.mNoise = 0.1f;
+	EXPECT_EQ(run(resolution, inBand, 5000).mChanges, 0u);
+	EXPECT_FLOAT_EQ(resolution.getScale(), 1.0f);
+
+	//Over budget frames lower scale only when there are enough of them in a row
+	resolution.reset(1.0f);
+	const float overBudget = settings.mTargetFrameTime * 1.2f;
+	for(uint32_t frame = 1; frame < settings.mFramesToDecrease; frame++)
+	{
+		EXPECT_FALSE(resolution.update(overBudget)) << "frame " << frame;
+	}
+	EXPECT_TRUE(resolution.update(overBudget));
+	const float lowered = resolution.getScale();
+	EXPECT_LT(lowered, 1.0f);
+
+	//Frames in flight were rendered at old scale and are ignored
+	for(uint32_t frame = 0; frame < settings.mCooldownFrames; frame++)
+	{
+		EXPECT_FALSE(resolution.update(settings.mTargetFrameTime * 10.0f)) << "frame " << frame;
+	}
+	EXPECT_FLOAT_EQ(resolution.getScale(), lowered);
+
+	//Going up waits much longer than going down
+	const float underBudget = settings.mTargetFrameTime * 0.5f;
+	for(uint32_t frame = 1; frame < settings.mFramesToIncrease; frame++)
+	{
+		EXPECT_FALSE(resolution.update(underBudget)) << "frame " << frame;
+	}
+	EXPECT_TRUE(resolution.update(underBudget));
+	EXPECT_FLOAT_EQ(resolution.getScale(), lowered + settings.mScaleStep);
+}
+
+TEST(DynamicResolution, Clamping)
+{
+	DynamicResolution resolution;
+	const auto& settings = resolution.mSettings;
+
+	FrameTimeTrace overloaded;
+	overloaded.mFullScaleTime = settings.mTargetFrameTime * 20.0f;
+	auto result = run(resolution, overloaded, 1000);
+	EXPECT_FLOAT_EQ(resolution.getScale(), settings.mMinScale);
+	EXPECT_GE(result.mMinScale, settings.mMinScale);
+	EXPECT_EQ(resolution.getScaledSize(1920), 960u);
+
+	FrameTimeTrace idle;
+	idle.mFullScaleTime = settings.mTargetFrameTime * 0.1f;
+	result = run(resolution, idle, 2000);
+	EXPECT_FLOAT_EQ(resolution.getScale(), settings.mMaxScale);
+	EXPECT_LE(result.mMaxScale, settings.mMaxScale);
+	EXPECT_EQ(resolution.getScaledSize(1920), 1920u);
+
+	resolution.reset(2.0f);
+	EXPECT_FLOAT_EQ(resolution.getScale(), settings.mMaxScale);
+	resolution.reset(0.0f);
+	EXPECT_FLOAT_EQ(resolution.getScale(), settings.mMinScale);
+	EXPECT_EQ(resolution.getScaledSize(1), 1u);
+}
@@ -0,0 +1,96 @@
+#include "Renderer/FrustumCulling.hpp"
+
+#include <gtest/gtest.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+
+using namespace fre;
+
+namespace
+{
+	//Camera at origin looking along x and -z
+	Frustum getTestFrustum()
+	{
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		return getFrustum(projection * view);
+	}
+}
+
+TEST(FrustumCulling, KnownObjects)
+{
+	const Frustum frustum = getTestFrustum();
+	CullingBounds bounds;
+	const uint32_t front = bounds.add(glm::vec3(9.0f, -1.0f, -11.0f), glm::vec3(11.0f, 1.0f, -9.0f), glm::mat4(1.0f));
+	const uint32_t behind = bounds.add(glm::vec3(-11.0f, -1.0f, 9.0f), glm::vec3(-9.0f, 1.0f, 11.0f), glm::mat4(1.0f));
+	const uint32_t far = bounds.add(glm::vec3(999.0f, -1.0f, -1001.0f), glm::vec3(1001.0f, 1.0f, -999.0f), glm::mat4(1.0f));
+	//Box behind camera moved in front of it by transform
+	const uint32_t moved = bounds.add(glm::vec3(-11.0f, -1.0f, 9.0f), glm::vec3(-9.0f, 1.0f, 11.0f),
+		glm::translate(glm::mat4(1.0f), glm::vec3(20.0f, 0.0f, -20.0f)));
+	const uint32_t unbounded = bounds.addUnbounded();
+
+	for(auto cull : { cullBoundsScalar, cullBoundsSIMD })
+	{
+		std::vector<uint8_t> visibility;
+		EXPECT_EQ(cull(frustum, bounds, visibility), 3u);
+		ASSERT_GE(visibility.size(), bounds.size());
+		EXPECT_EQ(visibility[front], 1);
+		EXPECT_EQ(visibility[behind], 0);
+		EXPECT_EQ(visibility[far], 0);
+		EXPECT_EQ(visibility[moved], 1);
+		EXPECT_EQ(visibility[unbounded], 1);
+	}
+}
+
+//SIMD implementation matches scalar one on random boxes scattered around camera, count not divisible by SIMD width
+TEST(FrustumCulling, SIMDMatchesScalar)
+{
+	const uint32_t objectsCount = 100003;
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<float> size(0.1f, 10.0f);
+	CullingBounds bounds;
+	for(uint32_t i = 0; i < objectsCount; i++)
+	{
+		const glm::vec3 mn(position(generator), position(generator), position(generator));
+		const glm::vec3 mx = mn + glm::vec3(size(generator), size(generator), size(generator));
+		bounds.add(mn, mx, glm::mat4(1.0f));
+	}
+
+	const Frustum frustum = getTestFrustum();
+	std::vector<uint8_t> scalarVisibility;
+	std::vector<uint8_t> simdVisibility;
+	const uint32_t scalarVisible = cullBoundsScalar(frustum, bounds, scalarVisibility);
+	const uint32_t simdVisible = cullBoundsSIMD(frustum, bounds, simdVisibility);
+	EXPECT_EQ(scalarVisible, simdVisible) << getCullingSIMDName();
+	EXPECT_GT(simdVisible, 0u);
+	EXPECT_LT(simdVisible, objectsCount);
+
+	uint32_t mismatches = 0;
+	for(uint32_t i = 0; i < objectsCount; i++)
+	{
+		mismatches += scalarVisibility[i] != simdVisibility[i] ? 1 : 0;
+	}
+	EXPECT_EQ(mismatches, 0u) << getCullingSIMDName();
+}
+
+TEST(FrustumCulling, ClearKeepsCapacity)
+{
+	CullingBounds bounds;
+	for(uint32_t i = 0; i < CULLING_SIMD_WIDTH + 1; i++)
+	{
+		bounds.addUnbounded();
+	}
+	const size_t capacity = bounds.mCenterX.size();
+	EXPECT_EQ(capacity % CULLING_SIMD_WIDTH, 0u);
+	bounds.clear();
+	EXPECT_EQ(bounds.size(), 0u);
+	bounds.addUnbounded();
+	EXPECT_EQ(bounds.mCenterX.size(), capacity);
+
+	std::vector<uint8_t> visibility;
+	EXPECT_EQ(cullBoundsSIMD(getTestFrustum(), bounds, visibility), 1u);
+}
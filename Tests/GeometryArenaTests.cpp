@@ -0,0 +1,116 @@
+#include "Renderer/GeometryArena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace fre;
+
+namespace
+{
+	//Vertices of given size filled with their index in mesh
+	std::vector<uint8_t> getVertices(uint32_t vertexSize, uint32_t verticesCount)
+	{
+		std::vector<uint8_t> result(vertexSize * verticesCount);
+		for(uint32_t i = 0; i < verticesCount; i++)
+		{
+			memset(result.data() + i * vertexSize, static_cast<int>(i), vertexSize);
+		}
+
+		return result;
+	}
+
+	GeometryArenaRange addMesh(GeometryArenas& arenas, uint32_t vertexSize, uint32_t verticesCount, const std::vector<uint32_t>& indices)
+	{
+		const auto vertices = getVertices(vertexSize, verticesCount);
+
+		return arenas.add(vertexSize, vertices.data(), verticesCount, indices.data(), static_cast<uint32_t>(indices.size()));
+	}
+}
+
+//Meshes with the same vertex size are packed one after another, indices stay mesh local
+TEST(GeometryArenas, Packing)
+{
+	GeometryArenas arenas;
+	const auto first = addMesh(arenas, 12, 3, { 0, 1, 2 });
+	const auto second = addMesh(arenas, 12, 4, { 0, 1, 2, 2, 3, 0 });
+	ASSERT_EQ(arenas.mArenas.size(), 1u);
+	EXPECT_EQ(first.mArena, 0u);
+	EXPECT_EQ(first.mFirstIndex, 0u);
+	EXPECT_EQ(first.mIndexCount, 3u);
+	EXPECT_EQ(first.mVertexOffset, 0);
+	EXPECT_EQ(second.mArena, 0u);
+	EXPECT_EQ(second.mFirstIndex, 3u);
+	EXPECT_EQ(second.mIndexCount, 6u);
+	EXPECT_EQ(second.mVertexOffset, 3);
+
+	const auto& arena = arenas.mArenas[0];
+	EXPECT_EQ(arena.getVertexCount(), 7u);
+	EXPECT_EQ(arena.mIndices, std::vector<uint32_t>({ 0, 1, 2, 0, 1, 2, 2, 3, 0 }));
+	//Vertex of draw is index plus vertex offset
+	for(uint32_t i = 0; i < second.mIndexCount; i++)
+	{
+		const uint32_t vertex = arena.mIndices[second.mFirstIndex + i] + second.mVertexOffset;
+		EXPECT_EQ(arena.mVertices[vertex * arena.mVertexSize], arena.mIndices[second.mFirstIndex + i]);
+	}
+}
+
+//Different vertex sizes never share arena, meshes are added to the last arena of their size
+TEST(GeometryArenas, VertexSizes)
+{
+	GeometryArenas arenas;
+	const auto first = addMesh(arenas, 12, 3, { 0, 1, 2 });
+	const auto other = addMesh(arenas, 32, 3, { 0, 1, 2 });
+	const auto second = addMesh(arenas, 12, 3, { 2, 1, 0 });
+	ASSERT_EQ(arenas.mArenas.size(), 2u);
+	EXPECT_EQ(first.mArena, 0u);
+	EXPECT_EQ(other.mArena, 1u);
+	EXPECT_EQ(other.mVertexOffset, 0);
+	EXPECT_EQ(other.mFirstIndex, 0u);
+	EXPECT_EQ(second.mArena, 0u);
+	EXPECT_EQ(second.mVertexOffset, 3);
+	EXPECT_EQ(second.mFirstIndex, 3u);
+	EXPECT_EQ(arenas.mArenas[1].mVertexSize, 32u);
+}
+
+//Full arena is closed and new one is started, mesh bigger than limit gets arena of its own
+TEST(GeometryArenas, Growth)
+{
+	GeometryArenas arenas;
+	//Mesh of 4 vertices of 12 bytes and 6 indices takes 72 bytes
+	arenas.mMaxArenaSize = 150;
+	const std::vector<uint32_t> quad = { 0, 1, 2, 2, 3, 0 };
+	const auto first = addMesh(arenas, 12, 4, quad);
+	const auto second = addMesh(arenas, 12, 4, quad);
+	const auto third = addMesh(arenas, 12, 4, quad);
+	ASSERT_EQ(arenas.mArenas.size(), 2u);
+	EXPECT_EQ(first.mArena, 0u);
+	EXPECT_EQ(second.mArena, 0u);
+	EXPECT_EQ(second.mVertexOffset, 4);
+	EXPECT_EQ(third.mArena, 1u);
+	EXPECT_EQ(third.mVertexOffset, 0);
+	EXPECT_EQ(third.mFirstIndex, 0u);
+
+	const auto big = addMesh(arenas, 12, 20, quad);
+	EXPECT_EQ(big.mArena, 2u);
+	EXPECT_EQ(arenas.mArenas[2].getVertexCount(), 20u);
+	//Arena of big mesh is over limit, next mesh starts a new one
+	EXPECT_EQ(addMesh(arenas, 12, 4, quad).mArena, 3u);
+}
+
+//Released arenas keep ranges valid and don't accept new meshes
+TEST(GeometryArenas, ReleaseCPUData)
+{
+	GeometryArenas arenas;
+	const auto first = addMesh(arenas, 12, 3, { 0, 1, 2 });
+	arenas.releaseCPUData();
+	EXPECT_TRUE(arenas.mArenas[0].mSealed);
+	EXPECT_TRUE(arenas.mArenas[0].mVertices.empty());
+	EXPECT_TRUE(arenas.mArenas[0].mIndices.empty());
+
+	const auto second = addMesh(arenas, 12, 3, { 0, 1, 2 });
+	EXPECT_EQ(first.mArena, 0u);
+	EXPECT_EQ(second.mArena, 1u);
+	EXPECT_EQ(second.mVertexOffset, 0);
+	EXPECT_EQ(second.mFirstIndex, 0u);
+}
@@ -0,0 +1,199 @@
+#include "Image.hpp"
+
+#include <gtest/gtest.h>
+
+#include "stb_image_write.h"
+#include "tiffio.h"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+using namespace fre;
+
+namespace
+{
+	//Files are cut inside header of every format
+	const uint32_t CUT_SIZE = 24;
+
+	void writeEndian(std::vector<uint8_t>& data, uint32_t value, uint32_t bytes, bool bigEndian)
+	{
+		for(uint32_t i = 0; i < bytes; i++)
+		{
+			const uint32_t shift = bigEndian ? (bytes - 1 - i) * 8 : i * 8;
+			data.push_back(static_cast<uint8_t>(value >> shift));
+		}
+	}
+
+	//Uncompressed 16 bit grayscale pages, each one followed by its directory
+	bool writeTIFFPages(const std::string& fileName, const std::vector<uint16_t>& pixels, uint32_t size,
+		uint32_t pagesCount, bool bigEndian)
+	{
+		const uint32_t pageSize = size * size * 2;
+		std::vector<uint8_t> data;
+		data.push_back(bigEndian ? 'M' : 'I');
+		data.push_back(bigEndian ? 'M' : 'I');
+		writeEndian(data, 42, 2, bigEndian);
+		writeEndian(data, 8 + pageSize, 4, bigEndian);
+		for(uint32_t page = 0; page < pagesCount; page++)
+		{
+			const uint32_t dataOffset = static_cast<uint32_t>(data.size());
+			for(uint16_t pixel : pixels)
+			{
+				writeEndian(data, pixel, 2, bigEndian);
+			}
+			const uint32_t tags[][3] = {
+				{ TIFFTAG_IMAGEWIDTH, TIFF_LONG, size },
+				{ TIFFTAG_IMAGELENGTH, TIFF_LONG, size },
+				{ TIFFTAG_BITSPERSAMPLE, TIFF_SHORT, 16 },
+				{ TIFFTAG_COMPRESSION, TIFF_SHORT, COMPRESSION_NONE },
+				{ TIFFTAG_PHOTOMETRIC, TIFF_SHORT, PHOTOMETRIC_MINISBLACK },
+				{ TIFFTAG_STRIPOFFSETS, TIFF_LONG, dataOffset },
+				{ TIFFTAG_SAMPLESPERPIXEL, TIFF_SHORT, 1 },
+				{ TIFFTAG_ROWSPERSTRIP, TIFF_LONG, size },
+				{ TIFFTAG_STRIPBYTECOUNTS, TIFF_LONG, pageSize },
+				{ TIFFTAG_SAMPLEFORMAT, TIFF_SHORT, SAMPLEFORMAT_UINT } };
+			const uint32_t tagsCount = sizeof(tags) / sizeof(tags[0]);
+			writeEndian(data, tagsCount, 2, bigEndian);
+			for(const auto& tag : tags)
+			{
+				writeEndian(data, tag[0], 2, bigEndian);
+				writeEndian(data, tag[1], 2, bigEndian);
+				writeEndian(data, 1, 4, bigEndian);
+				//Short values are left justified in value field
+				writeEndian(data, tag[2], tag[1] == TIFF_SHORT ? 2 : 4, bigEndian);
+				writeEndian(data, 0, tag[1] == TIFF_SHORT ? 2 : 0, bigEndian);
+			}
+			const bool last = page + 1 == pagesCount;
+			writeEndian(data, last ? 0 : static_cast<uint32_t>(data.size()) + 4 + pageSize, 4, bigEndian);
+		}
+
+		std::ofstream file(fileName, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+		return file.good();
+	}
+
+	//PNG of 1 to 4 channels, grayscale and color JPG, TIFF of 1 to 3 pages in both byte orders
+	class ImageProbeTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			mDirectory = std::filesystem::temp_directory_path() / "fre_image_probe_tests";
+			std::filesystem::remove_all(mDirectory);
+			std::filesystem::create_directories(mDirectory);
+
+			std::mt19937 generator(1);
+			std::uniform_int_distribution<uint32_t> noise(0, 65535);
+			std::vector<uint8_t> pixels(static_cast<size_t>(SIZE) * SIZE * 4);
+			std::vector<uint16_t> pixels16(static_cast<size_t>(SIZE) * SIZE);
+			for(uint32_t i = 0; i < FILES_COUNT; i++)
+			{
+				for(auto& pixel : pixels16)
+				{
+					pixel = static_cast<uint16_t>(noise(generator));
+				}
+				for(size_t j = 0; j < pixels.size(); j++)
+				{
+					pixels[j] = static_cast<uint8_t>(pixels16[j / 4] >> (j % 2 * 8));
+				}
+
+				ImageHeader header;
+				header.mWidth = SIZE;
+				header.mHeight = SIZE;
+				header.mBitDepth = 8;
+				header.mPagesCount = 1;
+				std::string fileName = (mDirectory / ("image" + std::to_string(i))).string();
+				bool written = false;
+				switch(i % 3)
+				{
+				case 0:
+					header.mChannels = i / 3 % 4 + 1;
+					fileName += ".png";
+					written = stbi_write_png(fileName.c_str(), SIZE, SIZE, header.mChannels, pixels.data(),
+						SIZE * header.mChannels) != 0;
+					break;
+				case 1:
+					header.mChannels = i / 3 % 2 == 0 ? 1 : 3;
+					fileName += ".jpg";
+					written = stbi_write_jpg(fileName.c_str(), SIZE, SIZE, header.mChannels, pixels.data(), 90) != 0;
+					break;
+				case 2:
+					header.mChannels = 1;
+					header.mBitDepth = 16;
+					header.mPagesCount = i / 3 % 3 + 1;
+					fileName += ".tiff";
+					written = writeTIFFPages(fileName, pixels16, SIZE, header.mPagesCount, i / 3 % 2 == 1);
+					break;
+				}
+				ASSERT_TRUE(written) << fileName;
+				mFileNames.push_back(fileName);
+				mExpected.push_back(header);
+			}
+		}
+
+		void TearDown() override
+		{
+			std::error_code error;
+			std::filesystem::remove_all(mDirectory, error);
+		}
+
+		static const uint32_t SIZE = 64;
+		//Every combination of channels, byte order and pages
+		static const uint32_t FILES_COUNT = 36;
+		std::filesystem::path mDirectory;
+		std::vector<std::string> mFileNames;
+		std::vector<ImageHeader> mExpected;
+	};
+}
+
+TEST_F(ImageProbeTest, HeadersMatchWritten)
+{
+	for(uint32_t i = 0; i < mFileNames.size(); i++)
+	{
+		ImageHeader header;
+		ASSERT_TRUE(Image::probe(mFileNames[i], header)) << mFileNames[i];
+		EXPECT_EQ(header.mWidth, mExpected[i].mWidth) << mFileNames[i];
+		EXPECT_EQ(header.mHeight, mExpected[i].mHeight) << mFileNames[i];
+		EXPECT_EQ(header.mChannels, mExpected[i].mChannels) << mFileNames[i];
+		EXPECT_EQ(header.mBitDepth, mExpected[i].mBitDepth) << mFileNames[i];
+		EXPECT_EQ(header.mPagesCount, mExpected[i].mPagesCount) << mFileNames[i];
+	}
+}
+
+//Texture created from header has to fit data loaded later
+TEST_F(ImageProbeTest, HeadersMatchLoaded)
+{
+	for(const auto& fileName : mFileNames)
+	{
+		Image loaded;
+		loaded.mFileName = fileName;
+		loaded.load();
+		Image probed;
+		probed.mFileName = fileName;
+		EXPECT_TRUE(probed.probeFile()) << fileName;
+		EXPECT_EQ(probed.mDimension, loaded.mDimension) << fileName;
+		EXPECT_EQ(probed.mFormat, loaded.mFormat) << fileName;
+		EXPECT_EQ(probed.mNumChannels, loaded.mNumChannels) << fileName;
+		loaded.destroy();
+	}
+}
+
+TEST_F(ImageProbeTest, CutFilesRejected)
+{
+	std::vector<char> data(CUT_SIZE);
+	for(uint32_t i = 0; i < mFileNames.size(); i++)
+	{
+		const std::string extension = std::filesystem::path(mFileNames[i]).extension().string();
+		const std::string cutFileName = (mDirectory / ("cut" + std::to_string(i) + extension)).string();
+		{
+			std::ifstream source(mFileNames[i], std::ios::binary);
+			source.read(data.data(), static_cast<std::streamsize>(data.size()));
+			std::ofstream cut(cutFileName, std::ios::binary);
+			cut.write(data.data(), source.gcount());
+		}
+		ImageHeader header;
+		EXPECT_FALSE(Image::probe(cutFileName, header)) << cutFileName;
+	}
+}
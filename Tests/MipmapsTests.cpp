@@ -0,0 +1,119 @@
+#include "Renderer/Mipmaps.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace fre;
+
+namespace
+{
+	std::vector<uint8_t> createRandomImage(uint32_t width, uint32_t height, uint32_t seed)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_int_distribution<uint32_t> bytes(0, 255);
+		std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4);
+		for(auto& value : result)
+		{
+			value = static_cast<uint8_t>(bytes(generator));
+		}
+
+		return result;
+	}
+}
+
+TEST(Mipmaps, LevelsCount)
+{
+	EXPECT_EQ(getMipLevelsCount(1, 1), 1u);
+	EXPECT_EQ(getMipLevelsCount(2048, 2048), 12u);
+	EXPECT_EQ(getMipLevelsCount(1023, 517), 10u);
+	EXPECT_EQ(getMipLevelsCount(1, 300), 9u);
+}
+
+//Every level halves previous one and levels are packed tightly up to 1x1
+TEST(Mipmaps, Layout)
+{
+	for(const auto& [width, height] : { std::pair<uint32_t, uint32_t>{ 2048, 2048 }, { 1023, 517 }, { 37, 1 } })
+	{
+		const auto image = createRandomImage(width, height, 1);
+		std::vector<uint8_t> data;
+		const auto levels = generateMipmaps(image.data(), width, height, 4, true, data);
+		ASSERT_EQ(levels.size(), getMipLevelsCount(width, height));
+
+		size_t offset = 0;
+		for(uint32_t level = 0; level < levels.size(); level++)
+		{
+			const auto& mip = levels[level];
+			const uint32_t expectedWidth = level == 0 ? width : std::max(levels[level - 1].mWidth / 2, 1u);
+			const uint32_t expectedHeight = level == 0 ? height : std::max(levels[level - 1].mHeight / 2, 1u);
+			EXPECT_EQ(mip.mWidth, expectedWidth) << width << "x" << height << ", level " << level;
+			EXPECT_EQ(mip.mHeight, expectedHeight) << width << "x" << height << ", level " << level;
+			EXPECT_EQ(mip.mOffset, offset) << width << "x" << height << ", level " << level;
+			EXPECT_EQ(mip.mSize, static_cast<size_t>(mip.mWidth) * mip.mHeight * 4) << width << "x" << height << ", level " << level;
+			offset += mip.mSize;
+		}
+		EXPECT_EQ(levels.back().mWidth, 1u);
+		EXPECT_EQ(levels.back().mHeight, 1u);
+		EXPECT_EQ(offset, data.size());
+		EXPECT_TRUE(std::equal(image.begin(), image.end(), data.begin()));
+	}
+}
+
+TEST(Mipmaps, Deterministic)
+{
+	for(const auto& [width, height] : { std::pair<uint32_t, uint32_t>{ 2048, 2048 }, { 1023, 517 } })
+	{
+		const auto image = createRandomImage(width, height, 1);
+		std::vector<uint8_t> first;
+		std::vector<uint8_t> second;
+		generateMipmaps(image.data(), width, height, 4, true, first);
+		generateMipmaps(image.data(), width, height, 4, true, second);
+		EXPECT_EQ(first, second) << width << "x" << height;
+	}
+}
+
+//Odd sizes must keep constant color exactly in both spaces
+TEST(Mipmaps, ConstantColorOddSize)
+{
+	std::vector<uint8_t> constant(static_cast<size_t>(37) * 19 * 4);
+	for(size_t i = 0; i < constant.size(); i++)
+	{
+		constant[i] = static_cast<uint8_t>(i % 4 == 3 ? 200 : 77 + 50 * (i % 4));
+	}
+	for(const bool srgb : { true, false })
+	{
+		std::vector<uint8_t> mips;
+		generateMipmaps(constant.data(), 37, 19, 4, srgb, mips);
+		uint32_t errors = 0;
+		for(size_t i = constant.size(); i < mips.size(); i++)
+		{
+			errors += mips[i] != constant[i % 4] ? 1 : 0;
+		}
+		EXPECT_EQ(errors, 0u) << (srgb ? "sRGB" : "linear");
+	}
+}
+
+//Average of black and white is linear 0.5: 188 in sRGB space, 128 in linear one. Alpha is never converted
+TEST(Mipmaps, CheckerAverage)
+{
+	std::vector<uint8_t> checker(16);
+	for(uint32_t texel = 0; texel < 4; texel++)
+	{
+		const uint8_t value = (texel == 0 || texel == 3) ? 255 : 0;
+		checker[texel * 4 + 0] = value;
+		checker[texel * 4 + 1] = value;
+		checker[texel * 4 + 2] = value;
+		checker[texel * 4 + 3] = value;
+	}
+	std::vector<uint8_t> mips;
+	generateMipmaps(checker.data(), 2, 2, 4, true, mips);
+	ASSERT_EQ(mips.size(), 20u);
+	EXPECT_EQ(mips[16], 188);
+	EXPECT_EQ(mips[17], 188);
+	EXPECT_EQ(mips[18], 188);
+	EXPECT_EQ(mips[19], 128);
+	generateMipmaps(checker.data(), 2, 2, 4, false, mips);
+	EXPECT_EQ(mips[16], 128);
+	EXPECT_EQ(mips[19], 128);
+}
@@ -0,0 +1,225 @@
+#include "Renderer/RenderGraph.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace fre;
+
+namespace
+{
+	uint32_t addColor(RenderGraph& graph, const std::string& name)
+	{
+		RenderGraphResourceDesc desc;
+		desc.mName = name;
+		desc.mFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+		return graph.addResource(desc);
+	}
+
+	uint32_t addSwapchain(RenderGraph& graph)
+	{
+		RenderGraphResourceDesc desc;
+		desc.mName = "Swapchain";
+		desc.mFormat = VK_FORMAT_B8G8R8A8_UNORM;
+		desc.mExternal = true;
+		desc.mFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		return graph.addResource(desc);
+	}
+
+	std::vector<RenderGraphBarrier> getBarriers(const RenderGraph& graph, uint32_t pass, uint32_t resource)
+	{
+		std::vector<RenderGraphBarrier> result;
+		for(const auto& barrier : graph.getBarriers(pass))
+		{
+			if(barrier.mResource == resource)
+			{
+				result.push_back(barrier);
+			}
+		}
+
+		return result;
+	}
+}
+
+//Sampled read waits for writer's pass in the next render pass, later write waits for the read
+TEST(RenderGraph, ReadAfterWrite)
+{
+	RenderGraph graph;
+	const uint32_t color = addColor(graph, "Color");
+	const uint32_t swapchain = addSwapchain(graph);
+	const uint32_t scene = graph.addPass("Scene");
+	graph.write(scene, color, ERenderGraphUsage::ColorAttachment);
+	const uint32_t post = graph.addPass("Post");
+	graph.read(post, color, ERenderGraphUsage::Sampled);
+	graph.write(post, swapchain, ERenderGraphUsage::ColorAttachment);
+	const uint32_t blur = graph.addPass("Blur");
+	graph.write(blur, color, ERenderGraphUsage::StorageWrite);
+	graph.compile();
+
+	ASSERT_TRUE(graph.isCompiled());
+	EXPECT_NE(graph.getPass(scene).mRenderPass, graph.getPass(post).mRenderPass);
+	const auto& resource = graph.getResource(color);
+	EXPECT_EQ(resource.mFirstPass, scene);
+	EXPECT_EQ(resource.mLastPass, blur);
+	EXPECT_FALSE(resource.mLazy);
+	EXPECT_EQ(resource.mUsage, static_cast<VkImageUsageFlags>(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT));
+	EXPECT_EQ(graph.getLayoutBefore(color, post), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	auto barriers = getBarriers(graph, post, color);
+	ASSERT_EQ(barriers.size(), 1u);
+	EXPECT_EQ(barriers[0].mSrcPass, scene);
+	EXPECT_EQ(barriers[0].mDstPass, post);
+	EXPECT_EQ(barriers[0].mOldLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	EXPECT_EQ(barriers[0].mNewLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	EXPECT_EQ(barriers[0].mSrcStage, static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT));
+	EXPECT_NE(barriers[0].mSrcAccess & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0u);
+	EXPECT_NE(barriers[0].mDstStage & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0u);
+	EXPECT_EQ(barriers[0].mDstAccess, static_cast<VkAccessFlags>(VK_ACCESS_SHADER_READ_BIT));
+
+	//Write after read only waits for execution of the read
+	barriers = getBarriers(graph, blur, color);
+	ASSERT_EQ(barriers.size(), 1u);
+	EXPECT_EQ(barriers[0].mSrcPass, post);
+	EXPECT_EQ(barriers[0].mSrcAccess, 0u);
+	EXPECT_EQ(barriers[0].mOldLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	EXPECT_EQ(barriers[0].mNewLayout, VK_IMAGE_LAYOUT_GENERAL);
+
+	//External resource goes to its final layout after last pass
+	ASSERT_EQ(graph.getFinalBarriers().size(), 1u);
+	EXPECT_EQ(graph.getFinalBarriers()[0].mResource, swapchain);
+	EXPECT_EQ(graph.getFinalBarriers()[0].mNewLayout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+//Reads of depth at different stages wait for its write, the next write waits for all of them with one barrier
+TEST(RenderGraph, MultipleReaders)
+{
+	RenderGraph graph;
+	RenderGraphResourceDesc depthDesc;
+	depthDesc.mName = "Depth";
+	depthDesc.mFormat = VK_FORMAT_D32_SFLOAT;
+	depthDesc.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	const uint32_t depth = graph.addResource(depthDesc);
+	const uint32_t geometry = graph.addPass("Geometry");
+	graph.write(geometry, depth, ERenderGraphUsage::DepthAttachment);
+	const uint32_t decals = graph.addPass("Decals");
+	graph.read(decals, depth, ERenderGraphUsage::DepthReadOnly);
+	const uint32_t fog = graph.addPass("Fog");
+	graph.read(fog, depth, ERenderGraphUsage::Sampled);
+	const uint32_t ambientOcclusion = graph.addPass("AmbientOcclusion");
+	graph.read(ambientOcclusion, depth, ERenderGraphUsage::Sampled);
+	const uint32_t transparent = graph.addPass("Transparent");
+	graph.write(transparent, depth, ERenderGraphUsage::DepthAttachment);
+	graph.compile();
+
+	const VkImageLayout readLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	auto barriers = getBarriers(graph, decals, depth);
+	ASSERT_EQ(barriers.size(), 1u);
+	EXPECT_EQ(barriers[0].mSrcPass, geometry);
+	EXPECT_EQ(barriers[0].mNewLayout, readLayout);
+
+	//Shader read in the same layout is a new stage, it waits for the write without layout change
+	barriers = getBarriers(graph, fog, depth);
+	ASSERT_EQ(barriers.size(), 1u);
+	EXPECT_EQ(barriers[0].mSrcPass, geometry);
+	EXPECT_EQ(barriers[0].mOldLayout, readLayout);
+	EXPECT_EQ(barriers[0].mNewLayout, readLayout);
+	EXPECT_NE(barriers[0].mSrcAccess & VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, 0u);
+	EXPECT_NE(barriers[0].mDstStage & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0u);
+	EXPECT_EQ(barriers[0].mDstAccess, static_cast<VkAccessFlags>(VK_ACCESS_SHADER_READ_BIT));
+
+	//The same read at already synchronised stages
+	EXPECT_TRUE(getBarriers(graph, ambientOcclusion, depth).empty());
+
+	barriers = getBarriers(graph, transparent, depth);
+	ASSERT_EQ(barriers.size(), 1u);
+	EXPECT_EQ(barriers[0].mSrcPass, ambientOcclusion);
+	EXPECT_EQ(barriers[0].mSrcStage, static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT));
+	EXPECT_EQ(barriers[0].mSrcAccess, 0u);
+	EXPECT_EQ(barriers[0].mOldLayout, readLayout);
+	EXPECT_EQ(barriers[0].mNewLayout, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+}
+
+//Chain of passes each reading previous target: first and third targets never live together and share memory
+TEST(RenderGraph, DisjointLifetimesShareSlot)
+{
+	RenderGraph graph;
+	const uint32_t first = addColor(graph, "First");
+	const uint32_t second = addColor(graph, "Second");
+	const uint32_t third = addColor(graph, "Third");
+	const uint32_t swapchain = addSwapchain(graph);
+	const uint32_t passes[] = { graph.addPass("First"), graph.addPass("Second"), graph.addPass("Third"), graph.addPass("Present") };
+	graph.write(passes[0], first, ERenderGraphUsage::ColorAttachment);
+	graph.read(passes[1], first, ERenderGraphUsage::Sampled);
+	graph.write(passes[1], second, ERenderGraphUsage::ColorAttachment);
+	graph.read(passes[2], second, ERenderGraphUsage::Sampled);
+	graph.write(passes[2], third, ERenderGraphUsage::ColorAttachment);
+	graph.read(passes[3], third, ERenderGraphUsage::Sampled);
+	graph.write(passes[3], swapchain, ERenderGraphUsage::ColorAttachment);
+	graph.compile();
+
+	EXPECT_EQ(graph.getMemorySlotsCount(), 2u);
+	EXPECT_EQ(graph.getResource(first).mMemorySlot, graph.getResource(third).mMemorySlot);
+	EXPECT_NE(graph.getResource(first).mMemorySlot, graph.getResource(second).mMemorySlot);
+	EXPECT_EQ(graph.getResource(swapchain).mMemorySlot, static_cast<int32_t>(RenderGraphResource::NO_MEMORY_SLOT));
+	EXPECT_EQ(graph.getResource(third).mAliasPredecessor, first);
+	//Slot goes back to first target in the next frame
+	EXPECT_EQ(graph.getResource(first).mAliasPredecessor, third);
+
+	//Third target waits for last read of the first one and discards its content
+	const auto barriers = getBarriers(graph, passes[2], third);
+	ASSERT_EQ(barriers.size(), 1u);
+	EXPECT_EQ(barriers[0].mSrcPass, passes[1]);
+	EXPECT_EQ(barriers[0].mOldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+	EXPECT_EQ(barriers[0].mNewLayout, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	EXPECT_NE(barriers[0].mSrcStage & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0u);
+	EXPECT_EQ(barriers[0].mSrcAccess, 0u);
+}
+
+//Depth and G-buffer consumed by subpasses of the same render pass never leave tile memory
+TEST(RenderGraph, TransientAttachmentIsLazy)
+{
+	RenderGraph graph;
+	RenderGraphResourceDesc depthDesc;
+	depthDesc.mName = "Depth";
+	depthDesc.mFormat = VK_FORMAT_D32_SFLOAT;
+	depthDesc.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	const uint32_t depth = graph.addResource(depthDesc);
+	const uint32_t albedo = addColor(graph, "Albedo");
+	const uint32_t swapchain = addSwapchain(graph);
+	const uint32_t geometry = graph.addPass("Geometry");
+	graph.write(geometry, depth, ERenderGraphUsage::DepthAttachment);
+	graph.write(geometry, albedo, ERenderGraphUsage::ColorAttachment);
+	const uint32_t lighting = graph.addPass("Lighting");
+	graph.read(lighting, depth, ERenderGraphUsage::DepthReadOnly);
+	graph.read(lighting, albedo, ERenderGraphUsage::InputAttachment);
+	graph.write(lighting, swapchain, ERenderGraphUsage::ColorAttachment);
+	graph.compile();
+
+	EXPECT_EQ(graph.getRenderPassesCount(), 1u);
+	EXPECT_EQ(graph.getPass(lighting).mRenderPass, graph.getPass(geometry).mRenderPass);
+	EXPECT_EQ(graph.getPass(lighting).mSubpass, 1u);
+	EXPECT_EQ(graph.getAttachments(0), (std::vector<uint32_t>{ depth, albedo, swapchain }));
+	for(const uint32_t resource : { depth, albedo })
+	{
+		const auto& transient = graph.getResource(resource);
+		EXPECT_TRUE(transient.mLazy) << transient.mDesc.mName;
+		EXPECT_NE(transient.mUsage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 0u) << transient.mDesc.mName;
+		EXPECT_EQ(transient.mMemorySlot, static_cast<int32_t>(RenderGraphResource::NO_MEMORY_SLOT)) << transient.mDesc.mName;
+	}
+	EXPECT_FALSE(graph.getResource(swapchain).mLazy);
+	EXPECT_EQ(graph.getMemorySlotsCount(), 0u);
+
+	//The same G-buffer sampled by a later render pass has to be stored
+	graph.clear();
+	const uint32_t stored = addColor(graph, "Albedo");
+	const uint32_t write = graph.addPass("Geometry");
+	graph.write(write, stored, ERenderGraphUsage::ColorAttachment);
+	const uint32_t read = graph.addPass("Lighting");
+	graph.read(read, stored, ERenderGraphUsage::Sampled);
+	graph.compile();
+	EXPECT_FALSE(graph.getResource(stored).mLazy);
+	EXPECT_EQ(graph.getResource(stored).mUsage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, 0u);
+	EXPECT_EQ(graph.getResource(stored).mMemorySlot, 0);
+}
@@ -0,0 +1,162 @@
+#include "Renderer/RenderObjectTable.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace fre;
+
+namespace
+{
+	glm::mat4 getTranslation(float x, float y, float z)
+	{
+		glm::mat4 result(1.0f);
+		result[3] = glm::vec4(x, y, z, 1.0f);
+
+		return result;
+	}
+
+	//Model of meshes attached to children of root node, mesh i is at x = i
+	MeshModel::Ptr createModel(uint32_t meshesCount)
+	{
+		MeshModel::MeshList meshes;
+		SceneGraph sceneGraph;
+		std::vector<uint32_t> meshNodes;
+		const uint32_t root = sceneGraph.addNode(SceneGraph::NO_PARENT, glm::mat4(1.0f));
+		for(uint32_t i = 0; i < meshesCount; i++)
+		{
+			meshes.push_back(Mesh::Ptr(new Mesh(i % 4)));
+			meshNodes.push_back(sceneGraph.addNode(root, getTranslation(static_cast<float>(i), 0.0f, 0.0f)));
+		}
+		MeshModel::Ptr result(new MeshModel(meshes));
+		result->setSceneGraph(sceneGraph, meshNodes);
+
+		return result;
+	}
+}
+
+TEST(RenderObjectTable, AddModel)
+{
+	const Mesh::RecordCallback callback = [](VulkanRenderer*, uint32_t, VkPipelineBindPoint) {};
+	auto first = createModel(3);
+	first->getMesh(1)->setVisible(false);
+	first->getMesh(2)->setBeforeVisitCallback(callback);
+	auto second = createModel(2);
+	second->setModelMatrix(getTranslation(0.0f, 10.0f, 0.0f));
+	second->getMesh(0)->setAfterRecordCallback(callback);
+	second->setVisible(false);
+
+	RenderObjectTable table;
+	EXPECT_EQ(table.addModel(5, first), 0u);
+	EXPECT_EQ(table.addModel(7, second), 3u);
+	ASSERT_EQ(table.size(), 5u);
+
+	EXPECT_EQ(table.mModelIds, (std::vector<uint32_t>{ 5, 5, 5, 7, 7 }));
+	EXPECT_EQ(table.mMeshIndices, (std::vector<uint32_t>{ 0, 1, 2, 0, 1 }));
+	EXPECT_EQ(table.mMaterialIds, (std::vector<uint32_t>{ 0, 1, 2, 0, 1 }));
+	EXPECT_EQ(table.mFlags[0], RO_VISIBLE);
+	EXPECT_EQ(table.mFlags[1], 0);
+	EXPECT_EQ(table.mFlags[2], RO_VISIBLE | RO_VISIT_CALLBACKS);
+	EXPECT_EQ(table.mFlags[3], RO_RECORD_CALLBACKS);
+	EXPECT_EQ(table.mFlags[4], 0);
+	for(uint32_t object = 0; object < table.size(); object++)
+	{
+		EXPECT_EQ(table.mDrawCounts[object], 1u) << "object " << object;
+	}
+
+	//Transforms combine model matrix with node transforms
+	EXPECT_EQ(table.getTransform(2)[3], glm::vec4(2.0f, 0.0f, 0.0f, 1.0f));
+	EXPECT_EQ(table.getTransform(4)[3], glm::vec4(1.0f, 10.0f, 0.0f, 1.0f));
+
+	table.clear();
+	EXPECT_EQ(table.size(), 0u);
+	EXPECT_TRUE(table.mTransforms.empty());
+}
+
+//Normal matrices are recomputed only for changed transforms and survive table rebuild
+TEST(RenderObjectTable, NormalMatrices)
+{
+	auto model = createModel(4);
+	RenderObjectTable table;
+	table.addModel(0, model);
+	const uint32_t transformsCount = static_cast<uint32_t>(table.mTransforms.size());
+	EXPECT_EQ(table.updateNormalMatrices(), transformsCount);
+	EXPECT_EQ(table.updateNormalMatrices(), 0u);
+
+	table.clear();
+	table.addModel(0, model);
+	EXPECT_EQ(table.updateNormalMatrices(), 0u);
+
+	//Non uniform scale of the whole model changes every transform
+	glm::mat4 scale(1.0f);
+	scale[0][0] = 2.0f;
+	scale[1][1] = 4.0f;
+	model->setModelMatrix(scale);
+	table.clear();
+	table.addModel(0, model);
+	EXPECT_EQ(table.updateNormalMatrices(), transformsCount);
+	const auto& normalMatrix = table.getNormalMatrix(3);
+	EXPECT_FLOAT_EQ(normalMatrix[0][0], 0.5f);
+	EXPECT_FLOAT_EQ(normalMatrix[1][1], 0.25f);
+	EXPECT_FLOAT_EQ(normalMatrix[2][2], 1.0f);
+	EXPECT_FLOAT_EQ(normalMatrix[3][0], 0.0f);
+	EXPECT_FLOAT_EQ(normalMatrix[3][3], 1.0f);
+}
+
+//Moved model gets its transforms written again without gathering objects
+TEST(RenderObjectTable, ModelTransforms)
+{
+	auto first = createModel(2);
+	auto second = createModel(3);
+	RenderObjectTable table;
+	table.addModel(0, first);
+	table.addModel(1, second);
+	table.updateNormalMatrices();
+	ASSERT_EQ(table.getModelsCount(), 2u);
+	EXPECT_EQ(table.getModelFirstObject(0), 0u);
+	EXPECT_EQ(table.getModelFirstObject(1), 2u);
+	EXPECT_EQ(table.getModelFirstObject(2), table.size());
+
+	const uint64_t transformsVersion = second->getTransformsVersion();
+	second->getSceneGraph().setLocalTransform(2, getTranslation(5.0f, 0.0f, 0.0f));
+	second->updateTransforms();
+	EXPECT_NE(second->getTransformsVersion(), transformsVersion);
+
+	//Only moved node has new transform, pure translation keeps its normal matrix
+	EXPECT_EQ(table.updateModelTransforms(1, second), 1u);
+	EXPECT_EQ(table.getTransform(3)[3], glm::vec4(5.0f, 0.0f, 0.0f, 1.0f));
+	EXPECT_EQ(table.getTransform(1)[3], glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+	EXPECT_EQ(table.updateModelTransforms(0, first), 0u);
+}
+
+//Setters bump scene version only when drawn state changes
+TEST(RenderObjectTable, SceneVersion)
+{
+	auto model = createModel(1);
+	const auto& mesh = model->getMesh(0);
+
+	uint64_t version = getSceneVersion();
+	mesh->setVisible(true);
+	model->setVisible(true);
+	mesh->setMaterialId(mesh->getMaterialId());
+	EXPECT_EQ(getSceneVersion(), version);
+
+	mesh->setVisible(false);
+	EXPECT_NE(getSceneVersion(), version);
+	version = getSceneVersion();
+	model->setVisible(false);
+	EXPECT_NE(getSceneVersion(), version);
+
+	//Descriptors of pass recorded every frame keep version
+	version = getSceneVersion();
+	const Mesh::Descriptors descriptors(1);
+	mesh->setFrameDescriptors(descriptors);
+	EXPECT_EQ(getSceneVersion(), version);
+	mesh->setDescriptors(Mesh::Descriptors(2));
+	EXPECT_NE(getSceneVersion(), version);
+
+	//Moving model changes transforms only
+	version = getSceneVersion();
+	const uint64_t transformsVersion = getTransformsVersion();
+	model->setModelMatrix(getTranslation(1.0f, 0.0f, 0.0f));
+	EXPECT_EQ(getSceneVersion(), version);
+	EXPECT_NE(getTransformsVersion(), transformsVersion);
+}
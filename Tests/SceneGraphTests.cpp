@@ -0,0 +1,141 @@
+#include "SceneGraph.hpp"
+#include "ThreadPool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+using namespace fre;
+
+namespace
+{
+	glm::mat4 getTranslation(float x, float y, float z)
+	{
+		glm::mat4 result(1.0f);
+		result[3] = glm::vec4(x, y, z, 1.0f);
+
+		return result;
+	}
+
+	//Random depth-first hierarchy: each node is attached to some node of current path
+	SceneGraph createRandomSceneGraph(uint32_t nodesCount, std::mt19937& generator)
+	{
+		std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+		SceneGraph result;
+		std::vector<uint32_t> path;
+		for(uint32_t i = 0; i < nodesCount; i++)
+		{
+			const uint32_t pops = std::uniform_int_distribution<uint32_t>(0, 2)(generator);
+			for(uint32_t p = 0; p < pops && !path.empty(); p++)
+			{
+				path.pop_back();
+			}
+			//Keep hierarchy shallow enough to have many subtrees
+			if(path.size() > 16)
+			{
+				path.clear();
+			}
+			const auto transform = getTranslation(offset(generator), offset(generator), offset(generator));
+			path.push_back(result.addNode(path.empty() ? SceneGraph::NO_PARENT : path.back(), transform));
+		}
+
+		return result;
+	}
+
+	//World transforms recomputed from scratch which don't match the graph
+	uint32_t getWorldMismatches(const SceneGraph& sceneGraph)
+	{
+		std::vector<glm::mat4> world(sceneGraph.getNodesCount());
+		uint32_t result = 0;
+		for(uint32_t node = 0; node < sceneGraph.getNodesCount(); node++)
+		{
+			const uint32_t parent = sceneGraph.getParent(node);
+			world[node] = parent != SceneGraph::NO_PARENT ? world[parent] * sceneGraph.getLocalTransform(node) :
+				sceneGraph.getLocalTransform(node);
+			result += world[node] != sceneGraph.getWorldTransform(node) ? 1 : 0;
+		}
+
+		return result;
+	}
+}
+
+TEST(SceneGraph, SubtreeRanges)
+{
+	SceneGraph sceneGraph;
+	const uint32_t root = sceneGraph.addNode(SceneGraph::NO_PARENT, glm::mat4(1.0f));
+	const uint32_t child = sceneGraph.addNode(root, getTranslation(1.0f, 0.0f, 0.0f));
+	const uint32_t grandChild = sceneGraph.addNode(child, getTranslation(0.0f, 1.0f, 0.0f));
+	const uint32_t sibling = sceneGraph.addNode(root, getTranslation(0.0f, 0.0f, 1.0f));
+
+	EXPECT_EQ(sceneGraph.getSubtreeEnd(root), 4u);
+	EXPECT_EQ(sceneGraph.getSubtreeEnd(child), 3u);
+	EXPECT_EQ(sceneGraph.getSubtreeEnd(grandChild), 3u);
+	EXPECT_EQ(sceneGraph.getSubtreeEnd(sibling), 4u);
+	EXPECT_EQ(sceneGraph.getParent(sibling), root);
+	EXPECT_EQ(sceneGraph.getWorldTransform(grandChild)[3], glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
+	EXPECT_FALSE(sceneGraph.isDirty());
+
+	//Grand child's subtree is already closed by sibling
+	EXPECT_THROW(sceneGraph.addNode(grandChild, glm::mat4(1.0f)), std::runtime_error);
+	EXPECT_THROW(sceneGraph.addNode(10, glm::mat4(1.0f)), std::runtime_error);
+}
+
+TEST(SceneGraph, UpdateOnlyDirtySubtrees)
+{
+	SceneGraph sceneGraph;
+	const uint32_t root = sceneGraph.addNode(SceneGraph::NO_PARENT, glm::mat4(1.0f));
+	const uint32_t child = sceneGraph.addNode(root, getTranslation(1.0f, 0.0f, 0.0f));
+	const uint32_t grandChild = sceneGraph.addNode(child, getTranslation(0.0f, 1.0f, 0.0f));
+	sceneGraph.addNode(root, getTranslation(0.0f, 0.0f, 1.0f));
+
+	EXPECT_EQ(sceneGraph.update(), 0u);
+	sceneGraph.setLocalTransform(child, getTranslation(2.0f, 0.0f, 0.0f));
+	EXPECT_TRUE(sceneGraph.isDirty());
+	EXPECT_EQ(sceneGraph.update(), 2u);
+	EXPECT_FALSE(sceneGraph.isDirty());
+	EXPECT_EQ(sceneGraph.getWorldTransform(grandChild)[3], glm::vec4(2.0f, 1.0f, 0.0f, 1.0f));
+
+	//Root changes everything
+	sceneGraph.setLocalTransform(root, getTranslation(0.0f, 0.0f, -1.0f));
+	sceneGraph.setLocalTransform(grandChild, getTranslation(0.0f, 3.0f, 0.0f));
+	EXPECT_EQ(sceneGraph.update(), 4u);
+	EXPECT_EQ(sceneGraph.getWorldTransform(grandChild)[3], glm::vec4(2.0f, 3.0f, -1.0f, 1.0f));
+	EXPECT_EQ(getWorldMismatches(sceneGraph), 0u);
+}
+
+//Sequential and parallel updates of large hierarchy give the same transforms as recomputation from scratch
+TEST(SceneGraph, ParallelUpdateMatchesSequential)
+{
+	const uint32_t nodesCount = 200000;
+	std::mt19937 generator(1);
+	SceneGraph sceneGraph = createRandomSceneGraph(nodesCount, generator);
+	SceneGraph parallelSceneGraph = sceneGraph;
+	ThreadPool threadPool(std::max(std::thread::hardware_concurrency(), 2u));
+
+	std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+	for(uint32_t frame = 0; frame < 3; frame++)
+	{
+		for(uint32_t i = 0; i < nodesCount / 100; i++)
+		{
+			const uint32_t node = std::uniform_int_distribution<uint32_t>(0, nodesCount - 1)(generator);
+			const auto transform = getTranslation(offset(generator), offset(generator), offset(generator));
+			sceneGraph.setLocalTransform(node, transform);
+			parallelSceneGraph.setLocalTransform(node, transform);
+		}
+		const uint32_t updated = sceneGraph.update();
+		EXPECT_GT(updated, 0u);
+		EXPECT_LE(updated, nodesCount);
+		parallelSceneGraph.update(&threadPool);
+
+		uint32_t mismatches = 0;
+		for(uint32_t i = 0; i < nodesCount; i++)
+		{
+			mismatches += sceneGraph.getWorldTransform(i) != parallelSceneGraph.getWorldTransform(i) ? 1 : 0;
+		}
+		EXPECT_EQ(mismatches, 0u) << "frame " << frame;
+		EXPECT_EQ(getWorldMismatches(sceneGraph), 0u) << "frame " << frame;
+	}
+	threadPool.destroy();
+}
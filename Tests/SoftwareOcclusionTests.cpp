@@ -0,0 +1,160 @@
+#include "Renderer/SoftwareOcclusion.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace fre;
+
+namespace
+{
+	const float CAMERA_NEAR = 1.0f;
+	const float CAMERA_FAR = 100.0f;
+	const uint32_t DEPTH_SIZE = 64;
+	const float DEPTH_EPSILON = 1e-4f;
+
+	//Camera at origin looking along -z with 90 degrees field of view. Built by hand, so depth is
+	//in Vulkan [0, 1] range whatever glm is configured with
+	glm::mat4 getViewProjection()
+	{
+		glm::mat4 result(0.0f);
+		result[0][0] = 1.0f;
+		result[1][1] = 1.0f;
+		result[2][2] = CAMERA_FAR / (CAMERA_NEAR - CAMERA_FAR);
+		result[2][3] = -1.0f;
+		result[3][2] = CAMERA_FAR * CAMERA_NEAR / (CAMERA_NEAR - CAMERA_FAR);
+
+		return result;
+	}
+
+	float getDepth(float z)
+	{
+		const glm::vec4 clip = getViewProjection() * glm::vec4(0.0f, 0.0f, z, 1.0f);
+
+		return clip.z / clip.w;
+	}
+
+	//Normalized device coordinate of pixel center
+	float getNDC(uint32_t pixel)
+	{
+		return (pixel + 0.5f) / DEPTH_SIZE * 2.0f - 1.0f;
+	}
+
+	float getPixel(const OcclusionRasterizer& rasterizer, uint32_t x, uint32_t y)
+	{
+		return rasterizer.getDepth()[y * rasterizer.getWidth() + x];
+	}
+
+	OcclusionRasterizer getRasterizer()
+	{
+		OcclusionRasterizer result;
+		result.resize(DEPTH_SIZE, DEPTH_SIZE);
+
+		return result;
+	}
+
+	void rasterize(OcclusionRasterizer& rasterizer, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices)
+	{
+		rasterizer.rasterize(vertices.data(), sizeof(glm::vec3), static_cast<uint32_t>(vertices.size()),
+			indices.data(), static_cast<uint32_t>(indices.size()), getViewProjection());
+	}
+}
+
+//Depth of pixel centers is depth of triangle plane seen through them, pixels outside keep far depth
+TEST(SoftwareOcclusion, TriangleDepth)
+{
+	OcclusionRasterizer rasterizer;
+	rasterizer.resize(100, 50);
+	EXPECT_EQ(rasterizer.getWidth(), 64u);
+	EXPECT_EQ(rasterizer.getHeight(), 32u);
+
+	//Facing camera at distance 10, covers center of screen
+	rasterizer = getRasterizer();
+	rasterize(rasterizer, { { -5.0f, -5.0f, -10.0f }, { 5.0f, -5.0f, -10.0f }, { 0.0f, 5.0f, -10.0f } }, { 0, 1, 2 });
+	EXPECT_EQ(rasterizer.getTrianglesCount(), 1u);
+	EXPECT_NEAR(getPixel(rasterizer, 32, 32), getDepth(-10.0f), DEPTH_EPSILON);
+	EXPECT_NEAR(getPixel(rasterizer, 30, 30), getDepth(-10.0f), DEPTH_EPSILON);
+	EXPECT_EQ(getPixel(rasterizer, 2, 2), 1.0f);
+	EXPECT_EQ(getPixel(rasterizer, 61, 61), 1.0f);
+	//Apex is at row 48, pixels beside it are outside
+	EXPECT_NEAR(getPixel(rasterizer, 32, 46), getDepth(-10.0f), DEPTH_EPSILON);
+	EXPECT_EQ(getPixel(rasterizer, 29, 46), 1.0f);
+	EXPECT_EQ(getPixel(rasterizer, 35, 46), 1.0f);
+	EXPECT_EQ(getPixel(rasterizer, 32, 49), 1.0f);
+
+	//Tilted plane z = -10 - x, point seen through pixel center with x_ndc = x / -z is at x = 10 * x_ndc / (1 - x_ndc)
+	rasterizer.clear();
+	EXPECT_EQ(getPixel(rasterizer, 32, 32), 1.0f);
+	rasterize(rasterizer, { { -5.0f, -20.0f, -5.0f }, { 5.0f, -20.0f, -15.0f }, { 0.0f, 20.0f, -10.0f } }, { 0, 1, 2 });
+	for(const uint32_t x : { 24u, 28u, 32u, 36u })
+	{
+		const float ndc = getNDC(x);
+		const float planeX = 10.0f * ndc / (1.0f - ndc);
+		EXPECT_NEAR(getPixel(rasterizer, x, 40), getDepth(-10.0f - planeX), DEPTH_EPSILON) << x;
+	}
+}
+
+//Rasterized depth doesn't depend on order of triangle vertices
+TEST(SoftwareOcclusion, BothWindings)
+{
+	const std::vector<glm::vec3> vertices = { { -8.0f, -6.0f, -12.0f }, { 7.0f, -4.0f, -20.0f }, { 1.0f, 9.0f, -9.0f } };
+	OcclusionRasterizer counterClockwise = getRasterizer();
+	rasterize(counterClockwise, vertices, { 0, 1, 2 });
+	OcclusionRasterizer clockwise = getRasterizer();
+	rasterize(clockwise, vertices, { 0, 2, 1 });
+
+	EXPECT_EQ(counterClockwise.getTrianglesCount(), 1u);
+	EXPECT_EQ(clockwise.getTrianglesCount(), 1u);
+	EXPECT_EQ(counterClockwise.getDepth(), clockwise.getDepth());
+	EXPECT_LT(*std::min_element(clockwise.getDepth().begin(), clockwise.getDepth().end()), 1.0f);
+}
+
+//Floor crossing camera plane is clipped by near plane instead of being dropped or wrapped around
+TEST(SoftwareOcclusion, NearPlaneClipping)
+{
+	OcclusionRasterizer rasterizer = getRasterizer();
+	rasterize(rasterizer, { { -50.0f, -1.0f, 10.0f }, { 50.0f, -1.0f, 10.0f }, { 0.0f, -1.0f, -50.0f } }, { 0, 1, 2 });
+	EXPECT_GE(rasterizer.getTrianglesCount(), 1u);
+
+	//Floor y = -1 is seen through pixel centers with y_ndc = -1 / -z below horizon only
+	for(uint32_t y = 0; y < DEPTH_SIZE; y++)
+	{
+		const float ndc = getNDC(y);
+		const float depth = getPixel(rasterizer, DEPTH_SIZE / 2, y);
+		if(ndc < -0.05f)
+		{
+			EXPECT_NEAR(depth, getDepth(1.0f / ndc), DEPTH_EPSILON) << y;
+		}
+		else if(ndc > 0.0f)
+		{
+			EXPECT_EQ(depth, 1.0f) << y;
+		}
+		EXPECT_GE(depth, 0.0f) << y;
+		EXPECT_LE(depth, 1.0f) << y;
+	}
+
+	//Triangle entirely behind near plane covers nothing
+	rasterizer.clear();
+	rasterize(rasterizer, { { -5.0f, -5.0f, -0.5f }, { 5.0f, -5.0f, -0.5f }, { 0.0f, 5.0f, 3.0f } }, { 0, 1, 2 });
+	EXPECT_EQ(*std::min_element(rasterizer.getDepth().begin(), rasterizer.getDepth().end()), 1.0f);
+}
+
+//Boxes behind rasterized wall are occluded, ones in front of it or beside it are not
+TEST(SoftwareOcclusion, BoxOcclusion)
+{
+	//Wall at distance 10 covers left half of screen
+	OcclusionRasterizer rasterizer = getRasterizer();
+	rasterize(rasterizer, { { -100.0f, -100.0f, -10.0f }, { 0.0f, -100.0f, -10.0f }, { 0.0f, 100.0f, -10.0f },
+		{ -100.0f, 100.0f, -10.0f } }, { 0, 1, 2, 0, 2, 3 });
+	EXPECT_EQ(rasterizer.getTrianglesCount(), 2u);
+	HiZPyramid pyramid;
+	rasterizer.buildPyramid(pyramid);
+	const glm::mat4 viewProjection = getViewProjection();
+
+	EXPECT_TRUE(isBoxOccluded(pyramid, viewProjection, glm::vec3(-20.0f, 0.0f, -40.0f), glm::vec3(1.0f)));
+	EXPECT_TRUE(isBoxOccluded(pyramid, viewProjection, glm::vec3(-5.0f, 3.0f, -12.0f), glm::vec3(0.5f)));
+	EXPECT_FALSE(isBoxOccluded(pyramid, viewProjection, glm::vec3(-2.0f, 0.0f, -5.0f), glm::vec3(0.5f)));
+	EXPECT_FALSE(isBoxOccluded(pyramid, viewProjection, glm::vec3(20.0f, 0.0f, -40.0f), glm::vec3(1.0f)));
+	//Box crossing edge of wall
+	EXPECT_FALSE(isBoxOccluded(pyramid, viewProjection, glm::vec3(0.0f, 0.0f, -40.0f), glm::vec3(5.0f)));
+}
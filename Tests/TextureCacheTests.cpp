@@ -0,0 +1,210 @@
+#include "Image.hpp"
+#include "TextureCache.hpp"
+
+#include <gtest/gtest.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+
+using namespace fre;
+
+namespace
+{
+	class TextureCacheTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			mDirectory = std::filesystem::temp_directory_path() / "fre_texture_cache_tests";
+			std::filesystem::remove_all(mDirectory);
+			std::filesystem::create_directories(mDirectory / "sources");
+
+			//Color maps with alpha and without, the same mix material textures have
+			std::mt19937 generator(1);
+			std::uniform_real_distribution<float> frequencies(0.02f, 0.2f);
+			std::uniform_int_distribution<int32_t> noise(-4, 4);
+			std::vector<uint8_t> pixels(static_cast<size_t>(SIZE) * SIZE * 4);
+			for(uint32_t i = 0; i < 4; i++)
+			{
+				const uint32_t channelsCount = i % 3 == 0 ? 4 : 3;
+				const float frequencyX = frequencies(generator);
+				const float frequencyY = frequencies(generator);
+				for(uint32_t y = 0; y < SIZE; y++)
+				{
+					for(uint32_t x = 0; x < SIZE; x++)
+					{
+						for(uint32_t c = 0; c < channelsCount; c++)
+						{
+							const float value = 127.5f + 127.5f * std::sin(x * frequencyX * (c + 1) + y * frequencyY);
+							const int32_t texel = static_cast<int32_t>(value) + noise(generator);
+							pixels[(static_cast<size_t>(y) * SIZE + x) * channelsCount + c] =
+								static_cast<uint8_t>(std::min(std::max(texel, 0), 255));
+						}
+					}
+				}
+				const std::string fileName = (mDirectory / "sources" / ("texture" + std::to_string(i) + ".png")).string();
+				ASSERT_NE(stbi_write_png(fileName.c_str(), SIZE, SIZE, channelsCount, pixels.data(), SIZE * channelsCount), 0);
+				mFileNames.push_back(fileName);
+			}
+		}
+
+		void TearDown() override
+		{
+			std::error_code error;
+			std::filesystem::remove_all(mDirectory, error);
+		}
+
+		//Format, extent and every level as upload reads them
+		std::vector<uint8_t> load(TextureCache& cache, uint32_t index, const TextureProcessing& processing)
+		{
+			Image image;
+			image.mFileName = mFileNames[index];
+			image.mSRGB = true;
+			cache.loadImage(image, processing);
+
+			const auto* data = static_cast<const uint8_t*>(image.mData);
+			const uint32_t values[] = { static_cast<uint32_t>(image.mFormat), static_cast<uint32_t>(image.mDimension.x),
+				static_cast<uint32_t>(image.mDimension.y), static_cast<uint32_t>(image.mLevels.size()) };
+			std::vector<uint8_t> result(reinterpret_cast<const uint8_t*>(values), reinterpret_cast<const uint8_t*>(values) + sizeof(values));
+			if(image.mLevels.empty())
+			{
+				result.insert(result.end(), data, data + image.mDataSize);
+			}
+			for(const auto& level : image.mLevels)
+			{
+				result.insert(result.end(), data + level.mOffset, data + level.mOffset + level.mSize);
+			}
+			image.destroy();
+
+			return result;
+		}
+
+		static const uint32_t SIZE = 128;
+		std::filesystem::path mDirectory;
+		std::vector<std::string> mFileNames;
+	};
+}
+
+//Images read from cache are exactly the processed ones, next launch reads them without processing
+TEST_F(TextureCacheTest, CachedMatchesProcessed)
+{
+	for(const bool compression : { false, true })
+	{
+		TextureProcessing processing;
+		processing.mMipmaps = true;
+		processing.mCompression = compression;
+		const std::string cacheDirectory = (mDirectory / (compression ? "compressed" : "mipmaps")).string();
+
+		TextureCache uncached;
+		TextureCache cold;
+		cold.create(cacheDirectory);
+		std::vector<std::vector<uint8_t>> expected;
+		for(uint32_t i = 0; i < mFileNames.size(); i++)
+		{
+			expected.push_back(load(uncached, i, processing));
+			EXPECT_EQ(load(cold, i, processing), expected.back()) << mFileNames[i];
+		}
+		auto statistics = cold.getStatistics();
+		EXPECT_EQ(statistics.mHits, 0u);
+		EXPECT_EQ(statistics.mMisses, mFileNames.size());
+		EXPECT_GT(statistics.mSize, 0u);
+
+		TextureCache warm;
+		warm.create(cacheDirectory);
+		for(uint32_t i = 0; i < mFileNames.size(); i++)
+		{
+			EXPECT_EQ(load(warm, i, processing), expected[i]) << mFileNames[i];
+		}
+		statistics = warm.getStatistics();
+		EXPECT_EQ(statistics.mHits, mFileNames.size());
+		EXPECT_EQ(statistics.mMisses, 0u);
+	}
+}
+
+//The same file processed differently is another entry
+TEST_F(TextureCacheTest, ProcessingChangesKey)
+{
+	TextureCache cache;
+	cache.create((mDirectory / "cache").string());
+	TextureProcessing processing;
+	processing.mMipmaps = true;
+	load(cache, 0, processing);
+	processing.mCompression = true;
+	load(cache, 0, processing);
+	load(cache, 0, processing);
+	const auto statistics = cache.getStatistics();
+	EXPECT_EQ(statistics.mHits, 1u);
+	EXPECT_EQ(statistics.mMisses, 2u);
+}
+
+//Broken cache files are ignored and written again
+TEST_F(TextureCacheTest, BrokenFile)
+{
+	const auto cacheDirectory = mDirectory / "cache";
+	TextureProcessing processing;
+	processing.mMipmaps = true;
+	TextureCache uncached;
+	const auto expected = load(uncached, 1, processing);
+	{
+		TextureCache cache;
+		cache.create(cacheDirectory.string());
+		load(cache, 1, processing);
+	}
+	uint32_t filesCount = 0;
+	for(const auto& entry : std::filesystem::directory_iterator(cacheDirectory))
+	{
+		std::ofstream(entry.path(), std::ios::binary | std::ios::trunc) << "broken";
+		filesCount++;
+	}
+	EXPECT_EQ(filesCount, 1u);
+
+	TextureCache cache;
+	cache.create(cacheDirectory.string());
+	EXPECT_EQ(load(cache, 1, processing), expected);
+	EXPECT_EQ(load(cache, 1, processing), expected);
+	const auto statistics = cache.getStatistics();
+	EXPECT_EQ(statistics.mHits, 1u);
+	EXPECT_EQ(statistics.mMisses, 1u);
+}
+
+//Cache fitting two and a half files: the first one is used again before the third one is stored, so the second
+//one is evicted, then the third one is evicted by the second one
+TEST_F(TextureCacheTest, LeastRecentlyUsedEviction)
+{
+	const std::string cacheDirectory = (mDirectory / "cache").string();
+	TextureProcessing processing;
+	processing.mMipmaps = true;
+	TextureCache cache;
+	cache.create(cacheDirectory, std::numeric_limits<uint64_t>::max());
+	//Uncompressed chains of images of the same size are files of the same size
+	load(cache, 0, processing);
+	load(cache, 1, processing);
+	const uint64_t fileSize = cache.getStatistics().mSize / 2;
+	ASSERT_GT(fileSize, 0u);
+
+	cache.create(cacheDirectory, fileSize * 5 / 2);
+	std::error_code error;
+	const auto now = std::filesystem::file_time_type::clock::now();
+	for(const auto& entry : std::filesystem::directory_iterator(cacheDirectory))
+	{
+		std::filesystem::last_write_time(entry.path(), now - std::chrono::hours(1), error);
+	}
+	load(cache, 0, processing);
+	load(cache, 2, processing);
+	load(cache, 0, processing);
+	load(cache, 1, processing);
+
+	const auto statistics = cache.getStatistics();
+	EXPECT_EQ(statistics.mHits, 2u);
+	EXPECT_EQ(statistics.mMisses, 2u);
+	EXPECT_EQ(statistics.mEvictions, 2u);
+	EXPECT_LE(statistics.mSize, fileSize * 5 / 2);
+}
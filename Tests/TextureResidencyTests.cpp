@@ -0,0 +1,254 @@
+#include "Renderer/TextureResidency.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace fre;
+
+namespace
+{
+	//Levels of simulated textures up to this size are tails
+	const uint32_t TAIL_SIZE = 128;
+	//Textures this far from camera are requested
+	const uint32_t VIEW_RANGE = 12;
+	//Frames of one camera sweep along row
+	const uint32_t SWEEP_FRAMES = 240;
+
+	//Chain of square texture with 1 byte per texel
+	std::vector<uint64_t> getLevelSizes(uint32_t size, uint32_t& tailLevel)
+	{
+		std::vector<uint64_t> levelSizes;
+		tailLevel = 0;
+		for(uint32_t levelSize = size; ; levelSize /= 2)
+		{
+			if(levelSize > TAIL_SIZE)
+			{
+				tailLevel++;
+			}
+			levelSizes.push_back(static_cast<uint64_t>(levelSize) * levelSize);
+			if(levelSize == 1)
+			{
+				break;
+			}
+		}
+
+		return levelSizes;
+	}
+
+	//Resident levels as GPU would see them, built from changes only
+	struct SimulatedTextureMemory
+	{
+		std::vector<std::vector<uint64_t>> mLevelSizes;
+		std::vector<uint32_t> mLevels;
+		uint64_t mSize = 0;
+		uint64_t mLoadedSize = 0;
+		uint64_t mEvictedSize = 0;
+
+		void add(uint32_t texture, const std::vector<uint64_t>& levelSizes, uint32_t level)
+		{
+			remove(texture);
+			mLevelSizes[texture] = levelSizes;
+			mLevels[texture] = level;
+			for(uint32_t i = level; i < levelSizes.size(); i++)
+			{
+				mSize += levelSizes[i];
+			}
+		}
+
+		void remove(uint32_t texture)
+		{
+			for(uint32_t i = mLevels[texture]; i < mLevelSizes[texture].size(); i++)
+			{
+				mSize -= mLevelSizes[texture][i];
+			}
+			mLevelSizes[texture].clear();
+			mLevels[texture] = 0;
+		}
+
+		//Returns false if change doesn't start from resident level
+		bool apply(const TextureResidencyChange& change)
+		{
+			if(change.mTexture >= mLevels.size() || mLevels[change.mTexture] != change.mFromLevel ||
+				change.mToLevel >= mLevelSizes[change.mTexture].size())
+			{
+				return false;
+			}
+
+			const auto& levelSizes = mLevelSizes[change.mTexture];
+			for(uint32_t i = std::min(change.mFromLevel, change.mToLevel); i < std::max(change.mFromLevel, change.mToLevel); i++)
+			{
+				if(change.mToLevel < change.mFromLevel)
+				{
+					mSize += levelSizes[i];
+					mLoadedSize += levelSizes[i];
+				}
+				else
+				{
+					mSize -= levelSizes[i];
+					mEvictedSize += levelSizes[i];
+				}
+			}
+			mLevels[change.mTexture] = change.mToLevel;
+
+			return true;
+		}
+	};
+}
+
+TEST(TextureResidency, LeastRecentlyRequestedEviction)
+{
+	TextureResidency residency;
+	uint32_t tailLevel = 0;
+	const auto levelSizes = getLevelSizes(1024, tailLevel);
+	uint64_t streamedSize = 0;
+	for(uint32_t level = 0; level < tailLevel; level++)
+	{
+		streamedSize += levelSizes[level];
+	}
+	const uint32_t a = 0;
+	const uint32_t b = 1;
+	const uint32_t c = 2;
+	for(const uint32_t texture : { a, b, c })
+	{
+		EXPECT_EQ(residency.addTexture(texture, levelSizes, tailLevel), tailLevel);
+	}
+	//Two full textures fit
+	residency.setBudget(residency.getMinimumSize() + 2 * streamedSize);
+
+	residency.request(a, 0, 1);
+	residency.request(b, 0, 1);
+	residency.update(1);
+	residency.request(a, 0, 2);
+	residency.update(2);
+	//B is least recently requested
+	residency.request(c, 0, 3);
+	residency.update(3);
+	EXPECT_EQ(residency.getResidentLevel(a), 0u);
+	EXPECT_EQ(residency.getResidentLevel(b), tailLevel);
+	EXPECT_EQ(residency.getResidentLevel(c), 0u);
+
+	//Textures requested together don't evict each other, B waits
+	for(const uint32_t texture : { a, b, c })
+	{
+		residency.request(texture, 0, 4);
+	}
+	residency.update(4);
+	EXPECT_EQ(residency.getResidentLevel(a), 0u);
+	EXPECT_EQ(residency.getResidentLevel(b), tailLevel);
+	EXPECT_EQ(residency.getResidentLevel(c), 0u);
+
+	//Levels finer than requested one go first: A gives level 0 to levels 2 and 1 of B, level 0 of B doesn't fit
+	//even with level 1 of A, so A keeps it
+	residency.request(a, 2, 5);
+	residency.request(b, 0, 5);
+	residency.request(c, 0, 5);
+	residency.update(5);
+	EXPECT_EQ(residency.getResidentLevel(a), 1u);
+	EXPECT_EQ(residency.getResidentLevel(b), 1u);
+	EXPECT_EQ(residency.getResidentLevel(c), 0u);
+	EXPECT_LE(residency.getResidentSize(), residency.getBudget());
+}
+
+//Camera moves along row of textures of 256 to 4096 texels, visible textures request levels by distance. Budget
+//shrinks halfway and textures are added again from time to time. Changes are applied to simulated memory that
+//checks them
+TEST(TextureResidency, CameraSweep)
+{
+	const uint32_t texturesCount = 1000;
+	const uint32_t framesCount = 2000;
+	const uint64_t budget = 64ull << 20;
+
+	std::mt19937 generator(1);
+	std::uniform_int_distribution<uint32_t> sizes(0, 4);
+	std::vector<std::vector<uint64_t>> levelSizes(texturesCount);
+	std::vector<uint32_t> tailLevels(texturesCount);
+	TextureResidency residency;
+	SimulatedTextureMemory memory;
+	memory.mLevelSizes.resize(texturesCount);
+	memory.mLevels.resize(texturesCount);
+	for(uint32_t texture = 0; texture < texturesCount; texture++)
+	{
+		levelSizes[texture] = getLevelSizes(256u << sizes(generator), tailLevels[texture]);
+		const uint32_t level = residency.addTexture(texture, levelSizes[texture], tailLevels[texture]);
+		memory.add(texture, levelSizes[texture], level);
+	}
+	residency.setBudget(budget);
+	ASSERT_LE(residency.getMinimumSize(), budget * 3 / 4);
+
+	uint32_t accountingErrors = 0;
+	uint32_t budgetViolations = 0;
+	//Requests left unloaded though free or evictable memory had room for next level
+	uint32_t unsatisfiedRequests = 0;
+	uint64_t requestsCount = 0;
+	uint64_t hitsCount = 0;
+	std::vector<uint32_t> requests(texturesCount, UINT32_MAX);
+	for(uint64_t frame = 1; frame <= framesCount; frame++)
+	{
+		if(frame == framesCount / 2)
+		{
+			residency.setBudget(budget * 3 / 4);
+		}
+		if(frame % 100 == 0)
+		{
+			const uint32_t texture = static_cast<uint32_t>(frame / 100 % texturesCount);
+			const uint32_t level = residency.addTexture(texture, levelSizes[texture], tailLevels[texture]);
+			memory.add(texture, levelSizes[texture], level);
+		}
+
+		//Camera sweeps along row, levels get finer close to it
+		const float phase = static_cast<float>(frame % SWEEP_FRAMES) / SWEEP_FRAMES;
+		const float camera = (1.0f - std::cos(phase * 6.2831853f)) * 0.5f * static_cast<float>(texturesCount - 1);
+		std::fill(requests.begin(), requests.end(), UINT32_MAX);
+		for(uint32_t texture = 0; texture < texturesCount; texture++)
+		{
+			const float distance = std::abs(static_cast<float>(texture) - camera);
+			if(distance <= VIEW_RANGE)
+			{
+				requests[texture] = static_cast<uint32_t>(std::log2(1.0f + distance));
+				residency.request(texture, requests[texture], frame);
+			}
+		}
+
+		for(const auto& change : residency.update(frame))
+		{
+			accountingErrors += memory.apply(change) ? 0 : 1;
+		}
+		accountingErrors += memory.mSize == residency.getResidentSize() ? 0 : 1;
+		budgetViolations += memory.mSize > residency.getBudget() ? 1 : 0;
+
+		//Memory that this frame's requests could take: free one, levels nobody samples and levels of older requests
+		uint64_t available = residency.getBudget() > memory.mSize ? residency.getBudget() - memory.mSize : 0;
+		for(uint32_t texture = 0; texture < texturesCount; texture++)
+		{
+			accountingErrors += memory.mLevels[texture] == residency.getResidentLevel(texture) ? 0 : 1;
+			const uint32_t lowest = requests[texture] == UINT32_MAX ? tailLevels[texture] : std::min(requests[texture], tailLevels[texture]);
+			for(uint32_t level = memory.mLevels[texture]; level < lowest; level++)
+			{
+				available += levelSizes[texture][level];
+			}
+		}
+		for(uint32_t texture = 0; texture < texturesCount; texture++)
+		{
+			if(requests[texture] == UINT32_MAX)
+			{
+				continue;
+			}
+			const uint32_t level = memory.mLevels[texture];
+			const bool hit = level <= requests[texture];
+			requestsCount++;
+			hitsCount += hit ? 1 : 0;
+			unsatisfiedRequests += !hit && levelSizes[texture][level - 1] <= available ? 1 : 0;
+		}
+	}
+
+	EXPECT_EQ(accountingErrors, 0u);
+	EXPECT_EQ(budgetViolations, 0u);
+	EXPECT_EQ(unsatisfiedRequests, 0u);
+	EXPECT_GT(memory.mLoadedSize, 0u);
+	EXPECT_GT(memory.mEvictedSize, 0u);
+	ASSERT_GT(requestsCount, 0u);
+	EXPECT_GT(static_cast<double>(hitsCount) / requestsCount, 0.9);
+}
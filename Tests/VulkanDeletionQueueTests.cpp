@@ -0,0 +1,107 @@
+#include "Renderer/VulkanDeletionQueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+
+using namespace fre;
+
+TEST(VulkanDeletionQueue, RetiresWhenSlotComesBack)
+{
+	VulkanDeletionQueue queue;
+	queue.create(2);
+	std::vector<uint32_t> destroyed;
+
+	queue.beginFrame(0);
+	queue.push([&destroyed]() { destroyed.push_back(0); });
+	queue.beginFrame(1);
+	queue.push([&destroyed]() { destroyed.push_back(1); });
+	EXPECT_EQ(queue.getPendingCount(), 2u);
+	EXPECT_TRUE(destroyed.empty());
+
+	queue.beginFrame(0);
+	EXPECT_EQ(destroyed, std::vector<uint32_t>{ 0 });
+	EXPECT_EQ(queue.getPendingCount(), 1u);
+	queue.beginFrame(1);
+	EXPECT_EQ(destroyed, (std::vector<uint32_t>{ 0, 1 }));
+	EXPECT_EQ(queue.getPendingCount(), 0u);
+}
+
+//Releases made by deleters wait for the next round of current slot
+TEST(VulkanDeletionQueue, NestedRelease)
+{
+	VulkanDeletionQueue queue;
+	queue.create(2);
+	uint32_t destroyed = 0;
+
+	queue.beginFrame(0);
+	queue.push([&queue, &destroyed]()
+		{
+			destroyed++;
+			queue.push([&destroyed]() { destroyed++; });
+		});
+	queue.beginFrame(1);
+	queue.beginFrame(0);
+	EXPECT_EQ(destroyed, 1u);
+	EXPECT_EQ(queue.getPendingCount(), 1u);
+	queue.destroy();
+	EXPECT_EQ(destroyed, 2u);
+	EXPECT_EQ(queue.getPendingCount(), 0u);
+}
+
+TEST(VulkanDeletionQueue, NotCreatedDestroysRightAway)
+{
+	VulkanDeletionQueue queue;
+	uint32_t destroyed = 0;
+	queue.push([&destroyed]() { destroyed++; });
+	EXPECT_EQ(destroyed, 1u);
+	EXPECT_EQ(queue.getPendingCount(), 0u);
+}
+
+//Frame loop with random releases per frame, GPU finishes frame when its slot is waited
+TEST(VulkanDeletionQueue, FrameLoop)
+{
+	const uint32_t framesInFlight = 3;
+	const int64_t framesCount = 100000;
+	VulkanDeletionQueue queue;
+	queue.create(framesInFlight);
+
+	std::mt19937 generator(1);
+	std::uniform_int_distribution<uint32_t> releases(0, 8);
+	//Frames before this one are finished by GPU
+	int64_t finishedFrames = 0;
+	int64_t frameNumber = 0;
+	uint32_t released = 0;
+	uint32_t destroyed = 0;
+	uint32_t premature = 0;
+	int64_t maxLatency = 0;
+	for(; frameNumber < framesCount; frameNumber++)
+	{
+		//Waiting fence of slot means frame which used it before is finished
+		finishedFrames = std::max<int64_t>(finishedFrames, frameNumber - framesInFlight + 1);
+		queue.beginFrame(static_cast<uint32_t>(frameNumber % framesInFlight));
+
+		const uint32_t count = releases(generator);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			const int64_t releasedFrame = frameNumber;
+			queue.push([&, releasedFrame]()
+				{
+					premature += releasedFrame >= finishedFrames ? 1 : 0;
+					maxLatency = std::max(maxLatency, frameNumber - releasedFrame);
+					destroyed++;
+				});
+		}
+		released += count;
+	}
+	//Device is idle at shutdown
+	finishedFrames = frameNumber;
+	queue.destroy();
+
+	EXPECT_GT(released, 0u);
+	EXPECT_EQ(destroyed, released);
+	EXPECT_EQ(premature, 0u);
+	EXPECT_EQ(maxLatency, framesInFlight);
+	EXPECT_EQ(queue.getPendingCount(), 0u);
+}
@@ -0,0 +1,268 @@
+#include "Renderer/VulkanFrameCommandPools.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using namespace fre;
+
+namespace
+{
+	//Vulkan calls made through volk function pointers
+	struct VulkanCalls
+	{
+		uint32_t mAllocateCommandBuffers = 0;
+		uint32_t mFreeCommandBuffers = 0;
+		uint32_t mResetCommandPools = 0;
+		uint32_t mQueueSubmits = 0;
+		uint32_t mQueueWaitIdles = 0;
+		uint32_t mCreateFences = 0;
+		uint32_t mDestroyFences = 0;
+		uint32_t mWaitForFences = 0;
+		VkFence mSubmittedFence = VK_NULL_HANDLE;
+		uint64_t mHandles = 0;
+	};
+
+	VulkanCalls gCalls;
+
+	template<typename T>
+	T makeHandle()
+	{
+		return (T)static_cast<uintptr_t>(++gCalls.mHandles);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL createCommandPool(VkDevice, const VkCommandPoolCreateInfo*,
+		const VkAllocationCallbacks*, VkCommandPool* commandPool)
+	{
+		*commandPool = makeHandle<VkCommandPool>();
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL destroyCommandPool(VkDevice, VkCommandPool, const VkAllocationCallbacks*)
+	{
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL resetCommandPool(VkDevice, VkCommandPool, VkCommandPoolResetFlags)
+	{
+		gCalls.mResetCommandPools++;
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL allocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* allocInfo,
+		VkCommandBuffer* commandBuffers)
+	{
+		gCalls.mAllocateCommandBuffers++;
+		for(uint32_t i = 0; i < allocInfo->commandBufferCount; i++)
+		{
+			commandBuffers[i] = makeHandle<VkCommandBuffer>();
+		}
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL freeCommandBuffers(VkDevice, VkCommandPool, uint32_t, const VkCommandBuffer*)
+	{
+		gCalls.mFreeCommandBuffers++;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL beginCommandBuffer(VkCommandBuffer, const VkCommandBufferBeginInfo*)
+	{
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL endCommandBuffer(VkCommandBuffer)
+	{
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL queueSubmit(VkQueue, uint32_t, const VkSubmitInfo*, VkFence fence)
+	{
+		gCalls.mQueueSubmits++;
+		gCalls.mSubmittedFence = fence;
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL queueWaitIdle(VkQueue)
+	{
+		gCalls.mQueueWaitIdles++;
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL createFence(VkDevice, const VkFenceCreateInfo*, const VkAllocationCallbacks*, VkFence* fence)
+	{
+		gCalls.mCreateFences++;
+		*fence = makeHandle<VkFence>();
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL destroyFence(VkDevice, VkFence, const VkAllocationCallbacks*)
+	{
+		gCalls.mDestroyFences++;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL waitForFences(VkDevice, uint32_t fencesCount, const VkFence* fences, VkBool32, uint64_t)
+	{
+		gCalls.mWaitForFences++;
+		EXPECT_EQ(fencesCount, 1u);
+		EXPECT_EQ(fences[0], gCalls.mSubmittedFence);
+
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL resetFences(VkDevice, uint32_t, const VkFence*)
+	{
+		return VK_SUCCESS;
+	}
+
+	//Replaces volk function pointers with counting ones while alive, no device is needed
+	class FakeDevice
+	{
+	public:
+		FakeDevice()
+		{
+			gCalls = VulkanCalls();
+			mCreateCommandPool = vkCreateCommandPool;
+			mDestroyCommandPool = vkDestroyCommandPool;
+			mResetCommandPool = vkResetCommandPool;
+			mAllocateCommandBuffers = vkAllocateCommandBuffers;
+			mFreeCommandBuffers = vkFreeCommandBuffers;
+			mBeginCommandBuffer = vkBeginCommandBuffer;
+			mEndCommandBuffer = vkEndCommandBuffer;
+			mQueueSubmit = vkQueueSubmit;
+			mQueueWaitIdle = vkQueueWaitIdle;
+			mCreateFence = vkCreateFence;
+			mDestroyFence = vkDestroyFence;
+			mWaitForFences = vkWaitForFences;
+			mResetFences = vkResetFences;
+
+			vkCreateCommandPool = createCommandPool;
+			vkDestroyCommandPool = destroyCommandPool;
+			vkResetCommandPool = resetCommandPool;
+			vkAllocateCommandBuffers = allocateCommandBuffers;
+			vkFreeCommandBuffers = freeCommandBuffers;
+			vkBeginCommandBuffer = beginCommandBuffer;
+			vkEndCommandBuffer = endCommandBuffer;
+			vkQueueSubmit = queueSubmit;
+			vkQueueWaitIdle = queueWaitIdle;
+			vkCreateFence = createFence;
+			vkDestroyFence = destroyFence;
+			vkWaitForFences = waitForFences;
+			vkResetFences = resetFences;
+		}
+
+		~FakeDevice()
+		{
+			vkCreateCommandPool = mCreateCommandPool;
+			vkDestroyCommandPool = mDestroyCommandPool;
+			vkResetCommandPool = mResetCommandPool;
+			vkAllocateCommandBuffers = mAllocateCommandBuffers;
+			vkFreeCommandBuffers = mFreeCommandBuffers;
+			vkBeginCommandBuffer = mBeginCommandBuffer;
+			vkEndCommandBuffer = mEndCommandBuffer;
+			vkQueueSubmit = mQueueSubmit;
+			vkQueueWaitIdle = mQueueWaitIdle;
+			vkCreateFence = mCreateFence;
+			vkDestroyFence = mDestroyFence;
+			vkWaitForFences = mWaitForFences;
+			vkResetFences = mResetFences;
+		}
+
+		VkDevice getDevice() const { return reinterpret_cast<VkDevice>(static_cast<uintptr_t>(1)); }
+		VkQueue getQueue() const { return reinterpret_cast<VkQueue>(static_cast<uintptr_t>(2)); }
+
+	private:
+		PFN_vkCreateCommandPool mCreateCommandPool;
+		PFN_vkDestroyCommandPool mDestroyCommandPool;
+		PFN_vkResetCommandPool mResetCommandPool;
+		PFN_vkAllocateCommandBuffers mAllocateCommandBuffers;
+		PFN_vkFreeCommandBuffers mFreeCommandBuffers;
+		PFN_vkBeginCommandBuffer mBeginCommandBuffer;
+		PFN_vkEndCommandBuffer mEndCommandBuffer;
+		PFN_vkQueueSubmit mQueueSubmit;
+		PFN_vkQueueWaitIdle mQueueWaitIdle;
+		PFN_vkCreateFence mCreateFence;
+		PFN_vkDestroyFence mDestroyFence;
+		PFN_vkWaitForFences mWaitForFences;
+		PFN_vkResetFences mResetFences;
+	};
+}
+
+//Sequential one-time submissions share one command buffer and one fence. Each waits for its fence only,
+//where it used to allocate and free a command buffer and wait for queue idle
+TEST(VulkanOneTimeCommandPool, RecyclesCommandBuffers)
+{
+	FakeDevice device;
+	VulkanOneTimeCommandPool pool;
+	pool.create(device.getDevice(), 0);
+
+	const uint32_t submissionsCount = 100;
+	for(uint32_t i = 0; i < submissionsCount; i++)
+	{
+		VkCommandBuffer commandBuffer = pool.begin(device.getDevice());
+		pool.endAndSubmit(device.getDevice(), device.getQueue(), commandBuffer);
+	}
+	EXPECT_EQ(gCalls.mAllocateCommandBuffers, 1u);
+	EXPECT_EQ(gCalls.mFreeCommandBuffers, 0u);
+	EXPECT_EQ(gCalls.mCreateFences, 1u);
+	EXPECT_EQ(gCalls.mQueueSubmits, submissionsCount);
+	EXPECT_EQ(gCalls.mWaitForFences, submissionsCount);
+	EXPECT_EQ(gCalls.mQueueWaitIdles, 0u);
+	EXPECT_EQ(pool.getStatistics().mAllocations, 1u);
+	EXPECT_EQ(pool.getStatistics().mRecycled, submissionsCount - 1);
+
+	//Buffers are freed with pool
+	pool.destroy(device.getDevice());
+	EXPECT_EQ(gCalls.mFreeCommandBuffers, 0u);
+	EXPECT_EQ(gCalls.mDestroyFences, 1u);
+	EXPECT_TRUE(pool.getCommandPool() == VK_NULL_HANDLE);
+}
+
+//Command buffer recorded while other one is open gets its own, both are reused afterwards
+TEST(VulkanOneTimeCommandPool, NestedRecording)
+{
+	FakeDevice device;
+	VulkanOneTimeCommandPool pool;
+	pool.create(device.getDevice(), 0);
+
+	for(uint32_t i = 0; i < 10; i++)
+	{
+		VkCommandBuffer outer = pool.begin(device.getDevice());
+		VkCommandBuffer inner = pool.begin(device.getDevice());
+		EXPECT_NE(outer, inner);
+		pool.endAndSubmit(device.getDevice(), device.getQueue(), inner);
+		pool.endAndSubmit(device.getDevice(), device.getQueue(), outer);
+	}
+	EXPECT_EQ(gCalls.mAllocateCommandBuffers, 2u);
+	EXPECT_EQ(pool.getStatistics().mRecycled, 18u);
+	EXPECT_EQ(gCalls.mCreateFences, 1u);
+
+	pool.destroy(device.getDevice());
+}
+
+//Buffers of frame slot are allocated once and reset with their pool when slot comes back
+TEST(VulkanFrameCommandPools, ResetsPoolOfSlot)
+{
+	FakeDevice device;
+	VulkanFrameCommandPools pools;
+	const uint32_t framesCount = 3;
+	pools.create(device.getDevice(), 0, framesCount, 1);
+
+	const uint32_t frames = 30;
+	for(uint32_t frame = 0; frame < frames; frame++)
+	{
+		pools.beginFrame(device.getDevice(), frame % framesCount);
+		EXPECT_NE(pools.acquire(device.getDevice()), pools.acquire(device.getDevice()));
+	}
+	EXPECT_EQ(gCalls.mAllocateCommandBuffers, 2 * framesCount);
+	EXPECT_EQ(gCalls.mFreeCommandBuffers, 0u);
+	EXPECT_EQ(gCalls.mResetCommandPools, frames - framesCount);
+	EXPECT_EQ(pools.getStatistics().mRecycled, 2 * (frames - framesCount));
+
+	pools.destroy(device.getDevice());
+	EXPECT_FALSE(pools.isCreated());
+}
@@ -0,0 +1,191 @@
+#include "Renderer/VulkanResourceCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <thread>
+
+using namespace fre;
+
+namespace
+{
+	//Resource is derived from key, so every lookup can check what it got
+	uint64_t getResource(uint32_t key)
+	{
+		return static_cast<uint64_t>(key) * 2654435761u + 1;
+	}
+}
+
+TEST(VulkanResourceCache, FindCreateErase)
+{
+	VulkanResourceCache<std::string, uint32_t> cache;
+	uint32_t creations = 0;
+	auto create = [&creations](const std::string& key) { creations++; return static_cast<uint32_t>(key.size()); };
+
+	const auto first = cache.findOrCreate(std::string("first"), create);
+	const auto second = cache.findOrCreate(std::string("second"), create);
+	EXPECT_NE(first, second);
+	EXPECT_EQ(cache.findOrCreate(std::string("first"), create), first);
+	EXPECT_EQ(cache.find(std::string("second")), second);
+	EXPECT_EQ(cache.find(std::string("third")), cache.INVALID_INDEX);
+	EXPECT_EQ(cache.getByIndex(first), 5u);
+	EXPECT_EQ(cache.getByIndex(second), 6u);
+	EXPECT_EQ(creations, 2u);
+
+	auto statistics = cache.getStatistics();
+	EXPECT_EQ(statistics.mHits, 2u);
+	EXPECT_EQ(statistics.mMisses, 3u);
+	EXPECT_EQ(statistics.mSize, 2u);
+
+	//Erased index is reused
+	cache.erase(first);
+	EXPECT_EQ(cache.find(std::string("first")), cache.INVALID_INDEX);
+	EXPECT_EQ(cache.findOrCreate(std::string("third"), create), first);
+	EXPECT_EQ(cache.getStatistics().mSize, 2u);
+
+	//Failed creation leaves nothing behind
+	EXPECT_THROW(cache.findOrCreate(std::string("fourth"), [](const std::string&) -> uint32_t { throw std::runtime_error("failed"); }),
+		std::runtime_error);
+	EXPECT_EQ(cache.find(std::string("fourth")), cache.INVALID_INDEX);
+	EXPECT_EQ(cache.getStatistics().mSize, 2u);
+}
+
+//Least recently found resources are evicted, but destroyed only when frames in flight are done with them
+TEST(VulkanResourceCache, LRUEviction)
+{
+	const uint32_t framesInFlight = 3;
+	VulkanResourceCache<uint32_t, uint64_t> cache;
+	std::vector<uint64_t> destroyed;
+	cache.setEviction(ECacheEviction::LRU, 2, framesInFlight, [&destroyed](uint64_t& resource) { destroyed.push_back(resource); });
+
+	for(uint32_t key = 0; key < 3; key++)
+	{
+		cache.update(key);
+		cache.findOrCreate(key, getResource);
+	}
+	//Key 0 is used again, so key 1 is the oldest one
+	cache.find(0u);
+	cache.update(3);
+	EXPECT_EQ(cache.find(1u), cache.INVALID_INDEX);
+	EXPECT_NE(cache.find(0u), cache.INVALID_INDEX);
+	EXPECT_NE(cache.find(2u), cache.INVALID_INDEX);
+
+	auto statistics = cache.getStatistics();
+	EXPECT_EQ(statistics.mEvictions, 1u);
+	EXPECT_EQ(statistics.mSize, 2u);
+	EXPECT_EQ(statistics.mPendingDestructions, 1u);
+	for(uint64_t frame = 4; frame < 3 + framesInFlight; frame++)
+	{
+		cache.update(frame);
+		EXPECT_TRUE(destroyed.empty()) << "frame " << frame;
+	}
+	cache.update(3 + framesInFlight);
+	EXPECT_EQ(destroyed, std::vector<uint64_t>{ getResource(1) });
+	EXPECT_EQ(cache.getStatistics().mPendingDestructions, 0u);
+}
+
+TEST(VulkanResourceCache, FrameAgeEviction)
+{
+	VulkanResourceCache<uint32_t, uint64_t> cache;
+	uint32_t destructions = 0;
+	cache.setEviction(ECacheEviction::FrameAge, 2, 1, [&destructions](uint64_t&) { destructions++; });
+
+	cache.update(0);
+	cache.findOrCreate(0u, getResource);
+	cache.findOrCreate(1u, getResource);
+	for(uint64_t frame = 1; frame <= 3; frame++)
+	{
+		cache.update(frame);
+		cache.find(1u);
+	}
+	cache.update(4);
+	EXPECT_EQ(cache.find(0u), cache.INVALID_INDEX);
+	EXPECT_NE(cache.find(1u), cache.INVALID_INDEX);
+
+	cache.destroyEvicted();
+	EXPECT_EQ(destructions, 1u);
+}
+
+//Threads look up random keys of small set for a number of frames. Bounded run evicts least recently used
+//resources between frames, unbounded one must create each key once
+TEST(VulkanResourceCache, ConcurrentLookups)
+{
+	const uint32_t threadsCount = std::max(std::thread::hardware_concurrency(), 4u);
+	const uint32_t framesCount = 20;
+	const uint32_t lookupsPerFrame = 5000;
+	const uint32_t keysCount = 4096;
+
+	for(const uint32_t limit : { 0u, 1024u })
+	{
+		VulkanResourceCache<uint32_t, uint64_t> cache;
+		std::unique_ptr<std::atomic<uint32_t>[]> creations(new std::atomic<uint32_t>[keysCount]);
+		for(uint32_t key = 0; key < keysCount; key++)
+		{
+			creations[key] = 0;
+		}
+		std::atomic<uint32_t> destructions{ 0 };
+		if(limit > 0)
+		{
+			cache.setEviction(ECacheEviction::LRU, limit, 3, [&destructions](uint64_t&) { destructions++; });
+		}
+
+		std::atomic<uint32_t> mismatches{ 0 };
+		auto work = [&](uint32_t thread, uint32_t frame)
+			{
+				std::mt19937 generator(frame * threadsCount + thread);
+				std::uniform_int_distribution<uint32_t> keys(0, keysCount - 1);
+				for(uint32_t i = 0; i < lookupsPerFrame; i++)
+				{
+					const uint32_t key = keys(generator);
+					const auto index = cache.findOrCreate(key, [&creations](const uint32_t& key)
+						{
+							creations[key]++;
+							return getResource(key);
+						});
+					if(cache.getByIndex(index) != getResource(key))
+					{
+						mismatches++;
+					}
+				}
+			};
+
+		//Threads look up during frame, eviction runs between frames as renderer would run it
+		for(uint32_t frame = 0; frame < framesCount; frame++)
+		{
+			std::vector<std::thread> threads;
+			for(uint32_t thread = 1; thread < threadsCount; thread++)
+			{
+				threads.emplace_back(work, thread, frame);
+			}
+			work(0, frame);
+			for(auto& thread : threads)
+			{
+				thread.join();
+			}
+			cache.update(frame);
+		}
+		cache.destroyEvicted();
+
+		const auto statistics = cache.getStatistics();
+		EXPECT_EQ(mismatches, 0u) << "limit " << limit;
+		EXPECT_EQ(statistics.mHits + statistics.mMisses, static_cast<uint64_t>(threadsCount) * framesCount * lookupsPerFrame);
+		EXPECT_EQ(statistics.mEvictions, destructions) << "limit " << limit;
+		EXPECT_EQ(statistics.mPendingDestructions, 0u);
+		if(limit == 0)
+		{
+			uint32_t duplicates = 0;
+			for(uint32_t key = 0; key < keysCount; key++)
+			{
+				duplicates += creations[key] > 1 ? creations[key] - 1 : 0;
+			}
+			EXPECT_EQ(duplicates, 0u);
+			EXPECT_EQ(statistics.mEvictions, 0u);
+		}
+		else
+		{
+			EXPECT_GT(statistics.mEvictions, 0u);
+			EXPECT_LE(statistics.mSize, limit);
+		}
+	}
+}
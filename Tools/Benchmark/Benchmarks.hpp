@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+//Each benchmark prints its results and returns exit code of process, nonzero if results are wrong
+
+//Scalar and SIMD frustum culling of 1M random boxes
+int benchmarkFrustumCulling();
+//Sequential and parallel scene graph update of 1M nodes with 1% of local transforms changed
+int benchmarkSceneGraphUpdate();
+//Header probes of 1000 PNG, JPG and TIFF files of 256x256 against decoding them. Files are written to directory
+int benchmarkImageProbe(const std::string& directory);
+//Scene traversal of draw recording over 50k meshes, through meshes and through render object table
+int benchmarkRenderObjects();
+//Decoding of 16 PNG color maps and 8 TIFF height maps of 1024x1024 with stb and libtiff, then loading them
+//with mips and compression without cache, with empty cache and with filled one. Files are written to directory
+int benchmarkTextureCache(const std::string& directory);
@@ -0,0 +1,63 @@
+#include "Benchmarks.hpp"
+#include "Renderer/FrustumCulling.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <utility>
+
+int benchmarkFrustumCulling()
+{
+    const uint32_t objectsCount = 1000000;
+    const uint32_t runsCount = 10;
+
+    //Random boxes scattered around camera
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.1f, 10.0f);
+    fre::CullingBounds bounds;
+    for(uint32_t i = 0; i < objectsCount; i++)
+    {
+        const glm::vec3 mn(position(generator), position(generator), position(generator));
+        const glm::vec3 mx = mn + glm::vec3(size(generator), size(generator), size(generator));
+        bounds.add(mn, mx, glm::mat4(1.0f));
+    }
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const fre::Frustum frustum = fre::getFrustum(projection * view);
+
+    //Best of runs, ms
+    auto measure = [&](auto cull, std::vector<uint8_t>& visibility)
+        {
+            double best = std::numeric_limits<double>::max();
+            uint32_t visible = 0;
+            for(uint32_t run = 0; run < runsCount; run++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                visible = cull(frustum, bounds, visibility);
+                const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+                best = std::min(best, time.count());
+            }
+            return std::make_pair(best, visible);
+        };
+
+    std::vector<uint8_t> scalarVisibility;
+    std::vector<uint8_t> simdVisibility;
+    const auto scalar = measure(fre::cullBoundsScalar, scalarVisibility);
+    const auto simd = measure(fre::cullBoundsSIMD, simdVisibility);
+    uint32_t mismatches = 0;
+    for(uint32_t i = 0; i < objectsCount; i++)
+    {
+        mismatches += scalarVisibility[i] != simdVisibility[i] ? 1 : 0;
+    }
+
+    printf("Frustum culling of 1M boxes: scalar %.3f ms, %s %.3f ms, visible %u, mismatches %u\n",
+        scalar.first, fre::getCullingSIMDName(), simd.first, simd.second, mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,180 @@
+#include "Benchmarks.hpp"
+#include "Image.hpp"
+
+#include "stb_image_write.h"
+#include "tiffio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    //Uncompressed 16 bit grayscale pages written by libtiff in given byte order
+    void writeTIFFPages(const std::string& fileName, const std::vector<uint16_t>& pixels, uint32_t size,
+        uint32_t pagesCount, bool bigEndian)
+    {
+        TIFF* tiff = TIFFOpen(fileName.c_str(), bigEndian ? "wb" : "wl");
+        if(!tiff)
+        {
+            throw std::runtime_error("Failed to open TIFF file for writing: " + fileName);
+        }
+        for(uint32_t page = 0; page < pagesCount; page++)
+        {
+            TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, size);
+            TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, size);
+            TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+            TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 16);
+            TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, SAMPLEFORMAT_UINT);
+            TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+            TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+            TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+            for(uint32_t row = 0; row < size; row++)
+            {
+                if(TIFFWriteScanline(tiff, const_cast<uint16_t*>(&pixels[static_cast<size_t>(row) * size]), row, 0) < 0 ||
+                    (row + 1 == size && !TIFFWriteDirectory(tiff)))
+                {
+                    TIFFClose(tiff);
+                    throw std::runtime_error("Failed to write TIFF page: " + fileName);
+                }
+            }
+        }
+        TIFFClose(tiff);
+    }
+}
+
+int benchmarkImageProbe(const std::string& directory)
+{
+    const uint32_t filesCount = 1000;
+    const uint32_t size = 256;
+    const uint32_t runsCount = 5;
+
+    //PNG of 1 to 4 channels, grayscale and color JPG, TIFF of 1 to 3 pages in both byte orders
+    const std::filesystem::path root = std::filesystem::path(directory) / "sources";
+    std::vector<std::string> fileNames;
+    std::vector<fre::ImageHeader> expected;
+    try
+    {
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root);
+
+        std::mt19937 generator(1);
+        std::uniform_int_distribution<uint32_t> noise(0, 65535);
+        std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+        std::vector<uint16_t> pixels16(static_cast<size_t>(size) * size);
+        for(uint32_t i = 0; i < filesCount; i++)
+        {
+            for(auto& pixel : pixels16)
+            {
+                pixel = static_cast<uint16_t>(noise(generator));
+            }
+            for(size_t j = 0; j < pixels.size(); j++)
+            {
+                pixels[j] = static_cast<uint8_t>(pixels16[j / 4] >> (j % 2 * 8));
+            }
+
+            fre::ImageHeader header;
+            header.mWidth = size;
+            header.mHeight = size;
+            header.mBitDepth = 8;
+            header.mPagesCount = 1;
+            std::string fileName = (root / ("image" + std::to_string(i))).string();
+            bool written = false;
+            switch(i % 3)
+            {
+            case 0:
+                header.mChannels = i / 3 % 4 + 1;
+                fileName += ".png";
+                written = stbi_write_png(fileName.c_str(), size, size, header.mChannels, pixels.data(),
+                    size * header.mChannels) != 0;
+                break;
+            case 1:
+                header.mChannels = i / 3 % 2 == 0 ? 1 : 3;
+                fileName += ".jpg";
+                written = stbi_write_jpg(fileName.c_str(), size, size, header.mChannels, pixels.data(), 90) != 0;
+                break;
+            case 2:
+                header.mChannels = 1;
+                header.mBitDepth = 16;
+                header.mPagesCount = i / 3 % 3 + 1;
+                fileName += ".tiff";
+                writeTIFFPages(fileName, pixels16, size, header.mPagesCount, i / 3 % 2 == 1);
+                written = true;
+                break;
+            }
+            if(!written)
+            {
+                throw std::runtime_error("Failed to write image " + fileName);
+            }
+            fileNames.push_back(fileName);
+            expected.push_back(header);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        printf("%s\n", e.what());
+        return 1;
+    }
+
+    //Best of runs, ms. Files stay in OS file cache, so both read the same memory and differ by parsing and decoding
+    uint32_t mismatches = 0;
+    double probeTime = std::numeric_limits<double>::max();
+    double decodeTime = std::numeric_limits<double>::max();
+    std::vector<fre::ImageHeader> headers(filesCount);
+    for(uint32_t run = 0; run < runsCount; run++)
+    {
+        std::vector<fre::Image> images(filesCount);
+        auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < filesCount; i++)
+        {
+            fre::Image::probe(fileNames[i], headers[i]);
+        }
+        std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+        probeTime = std::min(probeTime, time.count());
+
+        try
+        {
+            start = std::chrono::steady_clock::now();
+            for(uint32_t i = 0; i < filesCount; i++)
+            {
+                images[i].mFileName = fileNames[i];
+                images[i].load();
+            }
+            time = std::chrono::steady_clock::now() - start;
+            decodeTime = std::min(decodeTime, time.count());
+        }
+        catch(const std::exception& e)
+        {
+            printf("%s\n", e.what());
+            return 1;
+        }
+
+        //Headers match written files and textures created from them fit data loaded later
+        mismatches = 0;
+        for(uint32_t i = 0; i < filesCount; i++)
+        {
+            const fre::ImageHeader& header = headers[i];
+            fre::Image probed;
+            probed.mFileName = fileNames[i];
+            const bool matches = header.mWidth == expected[i].mWidth && header.mHeight == expected[i].mHeight &&
+                header.mChannels == expected[i].mChannels && header.mBitDepth == expected[i].mBitDepth &&
+                header.mPagesCount == expected[i].mPagesCount && probed.probeFile() &&
+                probed.mDimension == images[i].mDimension && probed.mFormat == images[i].mFormat &&
+                probed.mNumChannels == images[i].mNumChannels;
+            mismatches += matches ? 0 : 1;
+            images[i].destroy();
+        }
+    }
+
+    printf("Image probe of %u PNG, JPG and TIFF files of %ux%u: probe %.3f ms (%.2f us per file), decode %.3f ms, mismatches %u\n",
+        filesCount, size, size, probeTime, probeTime * 1000.0 / filesCount, decodeTime, mismatches);
+
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+#include "Benchmarks.hpp"
+#include "Renderer/RenderObjectTable.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <utility>
+
+using namespace fre;
+
+int benchmarkRenderObjects()
+{
+    const uint32_t objectsCount = 50000;
+    const uint32_t runsCount = 10;
+
+    //Models of 50 meshes attached to nodes of small hierarchy, every 10th mesh is hidden and every 100th one has callbacks
+    const uint32_t modelMeshesCount = 50;
+    uint32_t callbackCalls = 0;
+    const Mesh::RecordCallback countCall = [&callbackCalls](VulkanRenderer*, uint32_t, VkPipelineBindPoint) { callbackCalls++; };
+    std::vector<MeshModel::Ptr> models;
+    for(uint32_t first = 0; first < objectsCount; first += modelMeshesCount)
+    {
+        MeshModel::MeshList meshes;
+        SceneGraph sceneGraph;
+        std::vector<uint32_t> meshNodes;
+        const uint32_t root = sceneGraph.addNode(SceneGraph::NO_PARENT, glm::mat4(1.0f));
+        for(uint32_t i = first; i < std::min(first + modelMeshesCount, objectsCount); i++)
+        {
+            Mesh::Ptr mesh(new Mesh(i % 16));
+            mesh->setVisible(i % 10 != 0);
+            if(i % 100 == 0)
+            {
+                mesh->setBeforeVisitCallback(countCall);
+                mesh->setBeforeRecordCallback(countCall);
+            }
+            glm::mat4 transform(1.0f);
+            transform[3] = glm::vec4(static_cast<float>(i), 0.0f, 0.0f, 1.0f);
+            meshNodes.push_back(sceneGraph.addNode(root, transform));
+            meshes.push_back(mesh);
+        }
+        models.push_back(MeshModel::Ptr(new MeshModel(meshes)));
+        models.back()->setSceneGraph(sceneGraph, meshNodes);
+        models.back()->updateTransforms();
+    }
+
+    //Best of runs, ms. Draws sum up something of every recorded draw so traversals can't be optimized away
+    auto measure = [runsCount](auto&& traverse)
+        {
+            double best = std::numeric_limits<double>::max();
+            float checksum = 0.0f;
+            for(uint32_t run = 0; run < runsCount; run++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                checksum = traverse();
+                const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+                best = std::min(best, time.count());
+            }
+            return std::make_pair(best, checksum);
+        };
+
+    //Recording before render object table: every mesh is reached through its model
+    const auto meshTraversal = measure([&]()
+        {
+            float checksum = 0.0f;
+            for(const auto& model : models)
+            {
+                for(uint32_t k = 0; k < model->getMeshCount(); k++)
+                {
+                    const auto& mesh = model->getMesh(k);
+                    if(mesh->getBeforeVisitCallback())
+                    {
+                        mesh->getBeforeVisitCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                    }
+                    if(mesh->getVisible() && model->isVisible())
+                    {
+                        const uint32_t count = mesh->hasInstances() ? 1 : mesh->getInstanceCount();
+                        for(uint32_t i = 0; i < count; i++)
+                        {
+                            if(mesh->getBeforeRecordCallback() != nullptr)
+                            {
+                                mesh->getBeforeRecordCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                            }
+                            const glm::mat4 transform = model->getMeshTransform(k);
+                            checksum += transform[3].x + mesh->getMaterialId();
+                            if(mesh->getAfterRecordCallback() != nullptr)
+                            {
+                                mesh->getAfterRecordCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                            }
+                        }
+                    }
+                    if(mesh->getAfterVisitCallback())
+                    {
+                        mesh->getAfterVisitCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                    }
+                }
+            }
+            return checksum;
+        });
+
+    //Done only when scene version changes
+    RenderObjectTable table;
+    const auto tableBuild = measure([&]()
+        {
+            table.clear();
+            for(uint32_t j = 0; j < models.size(); j++)
+            {
+                table.addModel(j, models[j]);
+            }
+            table.updateNormalMatrices();
+            return static_cast<float>(table.size());
+        });
+
+    //Recording with render object table: meshes are touched only for objects with callbacks
+    const auto tableTraversal = measure([&]()
+        {
+            float checksum = 0.0f;
+            for(uint32_t object = 0; object < table.size(); object++)
+            {
+                const uint8_t flags = table.mFlags[object];
+                const bool callbacks = (flags & (RO_VISIT_CALLBACKS | RO_RECORD_CALLBACKS)) != 0;
+                const Mesh::Ptr* mesh = callbacks ? &models[table.mModelIds[object]]->getMesh(table.mMeshIndices[object]) : nullptr;
+                if((flags & RO_VISIT_CALLBACKS) != 0 && (*mesh)->getBeforeVisitCallback())
+                {
+                    (*mesh)->getBeforeVisitCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                }
+                if((flags & RO_VISIBLE) != 0)
+                {
+                    for(uint32_t i = 0; i < table.mDrawCounts[object]; i++)
+                    {
+                        if((flags & RO_RECORD_CALLBACKS) != 0 && (*mesh)->getBeforeRecordCallback() != nullptr)
+                        {
+                            (*mesh)->getBeforeRecordCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                        }
+                        checksum += table.getTransform(object)[3].x + table.mMaterialIds[object];
+                        if((flags & RO_RECORD_CALLBACKS) != 0 && (*mesh)->getAfterRecordCallback() != nullptr)
+                        {
+                            (*mesh)->getAfterRecordCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                        }
+                    }
+                }
+                if((flags & RO_VISIT_CALLBACKS) != 0 && (*mesh)->getAfterVisitCallback())
+                {
+                    (*mesh)->getAfterVisitCallback()(nullptr, 0, VK_PIPELINE_BIND_POINT_GRAPHICS);
+                }
+            }
+            return checksum;
+        });
+
+    const bool mismatch = meshTraversal.second != tableTraversal.second;
+    printf("Render objects %u: mesh traversal %.3f ms, table build %.3f ms, table traversal %.3f ms, mismatch %d\n",
+        table.size(), meshTraversal.first, tableBuild.first, tableTraversal.first, mismatch ? 1 : 0);
+
+    return mismatch ? 1 : 0;
+}
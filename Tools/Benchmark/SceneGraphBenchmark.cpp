@@ -0,0 +1,85 @@
+#include "Benchmarks.hpp"
+#include "SceneGraph.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+
+int benchmarkSceneGraphUpdate()
+{
+    const uint32_t nodesCount = 1000000;
+    const float dirtyRatio = 0.01f;
+    const uint32_t runsCount = 10;
+
+    //Random depth-first hierarchy: each node is attached to some node of current path
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    auto getRandomTransform = [&]()
+        {
+            glm::mat4 result(1.0f);
+            result[3] = glm::vec4(offset(generator), offset(generator), offset(generator), 1.0f);
+            return result;
+        };
+    fre::SceneGraph sceneGraph;
+    std::vector<uint32_t> path;
+    for(uint32_t i = 0; i < nodesCount; i++)
+    {
+        const uint32_t pops = std::uniform_int_distribution<uint32_t>(0, 2)(generator);
+        for(uint32_t p = 0; p < pops && !path.empty(); p++)
+        {
+            path.pop_back();
+        }
+        //Keep hierarchy shallow enough to have many subtrees
+        if(path.size() > 16)
+        {
+            path.clear();
+        }
+        path.push_back(sceneGraph.addNode(path.empty() ? fre::SceneGraph::NO_PARENT : path.back(), getRandomTransform()));
+    }
+    sceneGraph.update();
+
+    std::vector<uint32_t> dirtyNodes(static_cast<size_t>(nodesCount * dirtyRatio));
+    for(auto& node : dirtyNodes)
+    {
+        node = std::uniform_int_distribution<uint32_t>(0, nodesCount - 1)(generator);
+    }
+
+    //Best of runs, ms. Dirty nodes are marked again before each run
+    uint32_t updatedNodes = 0;
+    auto measure = [&](fre::SceneGraph& graph, fre::ThreadPool* threadPool)
+        {
+            double best = std::numeric_limits<double>::max();
+            for(uint32_t run = 0; run < runsCount; run++)
+            {
+                for(const uint32_t node : dirtyNodes)
+                {
+                    graph.setLocalTransform(node, graph.getLocalTransform(node));
+                }
+                const auto start = std::chrono::steady_clock::now();
+                updatedNodes = graph.update(threadPool);
+                const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+                best = std::min(best, time.count());
+            }
+            return best;
+        };
+
+    const uint32_t threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+    fre::ThreadPool threadPool(threadsCount);
+    fre::SceneGraph parallelSceneGraph = sceneGraph;
+    const double updateTime = measure(sceneGraph, nullptr);
+    const double parallelUpdateTime = measure(parallelSceneGraph, &threadPool);
+    threadPool.destroy();
+    uint32_t mismatches = 0;
+    for(uint32_t i = 0; i < nodesCount; i++)
+    {
+        mismatches += sceneGraph.getWorldTransform(i) != parallelSceneGraph.getWorldTransform(i) ? 1 : 0;
+    }
+
+    printf("Scene graph update of 1M nodes, 1%% dirty: sequential %.3f ms, %u threads %.3f ms, updated %u, mismatches %u\n",
+        updateTime, threadsCount, parallelUpdateTime, updatedNodes, mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
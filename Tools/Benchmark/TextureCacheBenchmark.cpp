@@ -0,0 +1,227 @@
+#include "Benchmarks.hpp"
+#include "Image.hpp"
+#include "TextureCache.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+#include "tiffio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    //FNV-1a of format, extent and every level, reading every byte as upload does
+    uint64_t getImageChecksum(const fre::Image& image)
+    {
+        uint64_t result = 0xCBF29CE484222325ull;
+        auto add = [&result](const uint8_t* data, size_t size)
+            {
+                for(size_t i = 0; i < size; i++)
+                {
+                    result = (result ^ data[i]) * 0x100000001B3ull;
+                }
+            };
+        const uint32_t values[] = { static_cast<uint32_t>(image.mFormat), static_cast<uint32_t>(image.mDimension.x),
+            static_cast<uint32_t>(image.mDimension.y), static_cast<uint32_t>(image.mLevels.size()) };
+        add(reinterpret_cast<const uint8_t*>(values), sizeof(values));
+        const auto* data = static_cast<const uint8_t*>(image.mData);
+        if(image.mLevels.empty())
+        {
+            add(data, image.mDataSize);
+        }
+        for(const auto& level : image.mLevels)
+        {
+            add(data + level.mOffset, level.mSize);
+        }
+
+        return result;
+    }
+
+    //Smooth noisy texels like the ones of photographed materials, so encoders and decoders do real work
+    void fillPixels(std::mt19937& generator, uint32_t size, uint32_t channelsCount, std::vector<uint8_t>& pixels)
+    {
+        std::uniform_real_distribution<float> frequencies(0.005f, 0.05f);
+        std::uniform_int_distribution<int32_t> noise(-4, 4);
+        const float frequencyX = frequencies(generator);
+        const float frequencyY = frequencies(generator);
+        pixels.resize(static_cast<size_t>(size) * size * channelsCount);
+        for(uint32_t y = 0; y < size; y++)
+        {
+            for(uint32_t x = 0; x < size; x++)
+            {
+                for(uint32_t c = 0; c < channelsCount; c++)
+                {
+                    const float value = 127.5f + 127.5f * std::sin(x * frequencyX * (c + 1) + y * frequencyY);
+                    const int32_t texel = static_cast<int32_t>(value) + noise(generator);
+                    pixels[(static_cast<size_t>(y) * size + x) * channelsCount + c] =
+                        static_cast<uint8_t>(std::min(std::max(texel, 0), 255));
+                }
+            }
+        }
+    }
+
+    //8 bit grayscale LZW compressed TIFF, the kind height and roughness maps are exported as
+    void writeTIFF(const std::string& fileName, const std::vector<uint8_t>& pixels, uint32_t size)
+    {
+        TIFF* tiff = TIFFOpen(fileName.c_str(), "w");
+        if(!tiff)
+        {
+            throw std::runtime_error("Failed to open TIFF file for writing: " + fileName);
+        }
+        TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, size);
+        TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, size);
+        TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+        TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+        TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+        TIFFSetField(tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+        TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+        for(uint32_t row = 0; row < size; row++)
+        {
+            if(TIFFWriteScanline(tiff, const_cast<uint8_t*>(&pixels[static_cast<size_t>(row) * size]), row, 0) < 0)
+            {
+                TIFFClose(tiff);
+                throw std::runtime_error("Failed to write TIFF scanline: " + fileName);
+            }
+        }
+        TIFFClose(tiff);
+    }
+}
+
+int benchmarkTextureCache(const std::string& directory)
+{
+    const uint32_t pngsCount = 16;
+    const uint32_t tiffsCount = 8;
+    const uint32_t size = 1024;
+    const uint32_t runsCount = 3;
+
+    const std::filesystem::path root(directory);
+    const std::filesystem::path sourcesDirectory = root / "sources";
+    const std::filesystem::path cacheDirectory = root / "cache";
+    std::vector<std::string> pngs;
+    std::vector<std::string> tiffs;
+    try
+    {
+        std::filesystem::remove_all(sourcesDirectory);
+        std::filesystem::create_directories(sourcesDirectory);
+
+        //Color maps with alpha and without, the same mix material textures have
+        std::mt19937 generator(1);
+        std::vector<uint8_t> pixels;
+        for(uint32_t i = 0; i < pngsCount; i++)
+        {
+            const uint32_t channelsCount = i % 3 == 0 ? 4 : 3;
+            fillPixels(generator, size, channelsCount, pixels);
+            const std::string fileName = (sourcesDirectory / ("texture" + std::to_string(i) + ".png")).string();
+            if(stbi_write_png(fileName.c_str(), size, size, channelsCount, pixels.data(), size * channelsCount) == 0)
+            {
+                throw std::runtime_error("Failed to write image " + fileName);
+            }
+            pngs.push_back(fileName);
+        }
+        for(uint32_t i = 0; i < tiffsCount; i++)
+        {
+            fillPixels(generator, size, 1, pixels);
+            const std::string fileName = (sourcesDirectory / ("height" + std::to_string(i) + ".tif")).string();
+            writeTIFF(fileName, pixels, size);
+            tiffs.push_back(fileName);
+        }
+    }
+    catch(const std::exception& e)
+    {
+        printf("%s\n", e.what());
+        return 1;
+    }
+
+    //Color maps are sRGB, height maps are linear
+    auto loadAll = [](fre::TextureCache& cache, const std::vector<std::string>& fileNames, bool sRGB,
+        const fre::TextureProcessing& processing, std::vector<uint64_t>& checksums)
+        {
+            checksums.clear();
+            const auto start = std::chrono::steady_clock::now();
+            for(const auto& fileName : fileNames)
+            {
+                fre::Image image;
+                image.mFileName = fileName;
+                image.mSRGB = sRGB;
+                cache.loadImage(image, processing);
+                checksums.push_back(getImageChecksum(image));
+                image.destroy();
+            }
+            const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+            return time.count();
+        };
+
+    fre::TextureProcessing processing;
+    processing.mMipmaps = true;
+    processing.mCompression = true;
+    uint32_t mismatches = 0;
+    uint64_t warmMisses = 0;
+    //Best of runs, ms: decoding only, decoding and processing without cache, with empty cache and with filled one
+    //opened by new cache object as next launch does. Filled cache files stay in OS file cache
+    auto measure = [&](const char* name, const std::vector<std::string>& fileNames, bool sRGB)
+        {
+            double decode = std::numeric_limits<double>::max();
+            double uncached = std::numeric_limits<double>::max();
+            double cold = std::numeric_limits<double>::max();
+            double warm = std::numeric_limits<double>::max();
+            std::vector<uint64_t> expected;
+            std::vector<uint64_t> checksums;
+            fre::TextureCacheStatistics warmStatistics;
+            for(uint32_t run = 0; run < runsCount; run++)
+            {
+                fre::TextureCache none;
+                decode = std::min(decode, loadAll(none, fileNames, sRGB, fre::TextureProcessing(), checksums));
+                uncached = std::min(uncached, loadAll(none, fileNames, sRGB, processing, expected));
+
+                std::filesystem::remove_all(cacheDirectory);
+                fre::TextureCache coldCache;
+                coldCache.create(cacheDirectory.string());
+                cold = std::min(cold, loadAll(coldCache, fileNames, sRGB, processing, checksums));
+                for(size_t i = 0; i < fileNames.size(); i++)
+                {
+                    mismatches += checksums[i] != expected[i] ? 1 : 0;
+                }
+
+                fre::TextureCache warmCache;
+                warmCache.create(cacheDirectory.string());
+                warm = std::min(warm, loadAll(warmCache, fileNames, sRGB, processing, checksums));
+                for(size_t i = 0; i < fileNames.size(); i++)
+                {
+                    mismatches += checksums[i] != expected[i] ? 1 : 0;
+                }
+                warmStatistics = warmCache.getStatistics();
+                warmMisses += warmStatistics.mMisses;
+            }
+
+            printf("%u %s %ux%u: decode %.1f ms, uncached %.1f ms, cold %.1f ms, warm %.1f ms, warm hits %llu, misses %llu\n",
+                static_cast<uint32_t>(fileNames.size()), name, size, size, decode, uncached, cold, warm,
+                static_cast<unsigned long long>(warmStatistics.mHits), static_cast<unsigned long long>(warmStatistics.mMisses));
+        };
+
+    try
+    {
+        measure("PNG", pngs, true);
+        measure("TIFF", tiffs, false);
+    }
+    catch(const std::exception& e)
+    {
+        printf("%s\n", e.what());
+        return 1;
+    }
+    printf("Texture cache mismatches %u, warm misses %llu\n", mismatches, static_cast<unsigned long long>(warmMisses));
+
+    std::error_code error;
+    std::filesystem::remove_all(sourcesDirectory, error);
+    std::filesystem::remove_all(cacheDirectory, error);
+
+    return mismatches == 0 && warmMisses == 0 ? 0 : 1;
+}
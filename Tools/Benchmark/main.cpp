@@ -0,0 +1,35 @@
+#include "Benchmarks.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+//CPU benchmarks of engine parts, run without window. Benchmark is chosen by switch
+int main(int argc, char* argv[])
+{
+    if(argc > 1 && strcmp(argv[1], "--culling") == 0)
+    {
+        return benchmarkFrustumCulling();
+    }
+    if(argc > 1 && strcmp(argv[1], "--scene-graph") == 0)
+    {
+        return benchmarkSceneGraphUpdate();
+    }
+    if(argc > 1 && strcmp(argv[1], "--render-objects") == 0)
+    {
+        return benchmarkRenderObjects();
+    }
+    if(argc > 1 && strcmp(argv[1], "--image-probe") == 0)
+    {
+        return benchmarkImageProbe(argc > 2 ? argv[2] :
+            (std::filesystem::temp_directory_path() / "fre_image_probe_benchmark").string());
+    }
+    if(argc > 1 && strcmp(argv[1], "--texture-cache") == 0)
+    {
+        return benchmarkTextureCache(argc > 2 ? argv[2] :
+            (std::filesystem::temp_directory_path() / "fre_texture_cache_benchmark").string());
+    }
+
+    printf("Usage: Benchmark --culling | --scene-graph | --render-objects | --image-probe [directory] |\n    --texture-cache [directory]\n");
+    return 1;
+}
@@ -0,0 +1,45 @@
+#include "Image.hpp"
+#include "Renderer/BlockCompression.hpp"
+#include "TextureContainer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+//Offline compression of PNG or JPG file to KTX2 with all levels. Color is sRGB unless "linear" follows output file
+int main(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        printf("Usage: CompressTexture <input image> <output KTX2> [linear]\n");
+        return 1;
+    }
+
+    try
+    {
+        fre::Image image;
+        image.mFileName = argv[1];
+        image.load();
+        const bool srgb = !(argc > 3 && strcmp(argv[3], "linear") == 0);
+        const auto* data = static_cast<const uint8_t*>(image.mData);
+        fre::TextureLevels texture;
+        texture.mWidth = image.mDimension.x;
+        texture.mHeight = image.mDimension.y;
+        texture.mFormat = fre::chooseBlockCompressedFormat(data, static_cast<size_t>(texture.mWidth) * texture.mHeight, image.mStride);
+        texture.mLevels = fre::compressImage(data, texture.mWidth, texture.mHeight, image.mStride, srgb, texture.mFormat,
+            std::max(std::thread::hardware_concurrency(), 1u), texture.mData);
+        image.destroy();
+        fre::saveKTX2(argv[2], texture);
+        printf("%s: %ux%u, format %u, levels %u, %zu bytes\n", argv[2], texture.mWidth, texture.mHeight, texture.mFormat,
+            static_cast<uint32_t>(texture.mLevels.size()), texture.mData.size());
+    }
+    catch(const std::runtime_error& e)
+    {
+        printf("%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
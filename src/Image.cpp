@@ -1,11 +1,16 @@
 #include "FileSystem/FileSystem.hpp"
+#include "FileSystem/MappedFile.hpp"
 #include "Image.hpp"
 #include "Log.hpp"
+#include "TextureContainer.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "tiffio.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <stdexcept>
 
 using namespace glm;
@@ -13,6 +18,93 @@ using namespace glm;
 namespace fre
 {
 
+	//Header probes read a few bytes of file and seek over the rest
+	const uint32_t MAX_TIFF_PAGES = 65536;
+	const uint8_t PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+	VkFormat getTiffFormat(uint16_t samplesPerPixel, uint16_t bitsPerSample, uint16_t sampleFormat)
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		bool isFloat = (sampleFormat == SAMPLEFORMAT_IEEEFP);
+		bool isSigned = (sampleFormat == SAMPLEFORMAT_INT);
+
+		// Map based on channels
+		if(samplesPerPixel == 1) {
+			if(bitsPerSample == 8)
+				format = isSigned ? VK_FORMAT_R8_SNORM :
+				VK_FORMAT_R8_UNORM;
+			if(bitsPerSample == 16)
+				format = isFloat ? VK_FORMAT_R16_SFLOAT :
+				isSigned ? VK_FORMAT_R16_SINT :
+				VK_FORMAT_R16_UINT;
+			if(bitsPerSample == 32)
+				format = isFloat ? VK_FORMAT_R32_SFLOAT :
+				isSigned ? VK_FORMAT_R32_SINT :
+				VK_FORMAT_R32_UINT;
+		}
+		if(samplesPerPixel == 2) {
+			if(bitsPerSample == 8)
+				format = isSigned ? VK_FORMAT_R8G8_SNORM :
+				VK_FORMAT_R8G8_UNORM;
+			if(bitsPerSample == 16)
+				format = isFloat ? VK_FORMAT_R16G16_SFLOAT :
+				isSigned ? VK_FORMAT_R16G16_SINT :
+				VK_FORMAT_R16G16_UINT;
+			if(bitsPerSample == 32)
+				format = isFloat ? VK_FORMAT_R32G32_SFLOAT :
+				isSigned ? VK_FORMAT_R32G32_SINT :
+				VK_FORMAT_R32G32_UINT;
+		}
+		if(samplesPerPixel == 3) {
+			if(bitsPerSample == 8)
+				format = isSigned ? VK_FORMAT_R8G8B8_SNORM :
+				VK_FORMAT_R8G8B8_UNORM;
+			if(bitsPerSample == 16)
+				format = isFloat ? VK_FORMAT_R16G16B16_SFLOAT :
+				isSigned ? VK_FORMAT_R16G16B16_SINT :
+				VK_FORMAT_R16G16B16_UINT;
+			if(bitsPerSample == 32)
+				format = isFloat ? VK_FORMAT_R32G32B32_SFLOAT :
+				isSigned ? VK_FORMAT_R32G32B32_SINT :
+				VK_FORMAT_R32G32B32_UINT;
+		}
+		if(samplesPerPixel == 4) {
+			if(bitsPerSample == 8)
+				format = isSigned ? VK_FORMAT_R8G8B8A8_SNORM :
+				VK_FORMAT_R8G8B8A8_UNORM;
+			if(bitsPerSample == 16)
+				format = isFloat ? VK_FORMAT_R16G16B16A16_SFLOAT :
+				isSigned ? VK_FORMAT_R16G16B16A16_SINT :
+				VK_FORMAT_R16G16B16A16_UINT;
+			if(bitsPerSample == 32)
+				format = isFloat ? VK_FORMAT_R32G32B32A32_SFLOAT :
+				isSigned ? VK_FORMAT_R32G32B32A32_SINT :
+				VK_FORMAT_R32G32B32A32_UINT;
+		}
+
+		return format;
+	}
+
+	//Channels are changed to ones image is loaded with
+	VkFormat getPngOrJpgFormat(int& numChannels)
+	{
+		switch(numChannels)
+		{
+			case 1:
+				return VK_FORMAT_R8_UNORM;
+			case 2:
+				return VK_FORMAT_R8G8_UNORM;
+			case 3:
+				//RGB formats are rarely sampled by GPUs, image is loaded with opaque alpha
+				numChannels = 4;
+				return VK_FORMAT_R8G8B8A8_UNORM;
+			case 4:
+				return VK_FORMAT_R8G8B8A8_UNORM;
+		}
+
+		return VK_FORMAT_UNDEFINED;
+	}
+
 	void getInfoFromTiff(const std::string& fileName, ivec2& size, VkFormat& format, int& numChannels)
 	{
 		size = ivec2(0);
@@ -39,64 +131,7 @@ namespace fre
 			}
 			else
 			{
-				bool isFloat = (sampleFormat == SAMPLEFORMAT_IEEEFP);
-				bool isSigned = (sampleFormat == SAMPLEFORMAT_INT);
-				bool isUnsigned = (sampleFormat == SAMPLEFORMAT_UINT);
-
-				// Map based on channels
-				if(samplesPerPixel == 1) {
-					if(bitsPerSample == 8)
-						format = isSigned ? VK_FORMAT_R8_SNORM :
-						VK_FORMAT_R8_UNORM;
-					if(bitsPerSample == 16)
-						format = isFloat ? VK_FORMAT_R16_SFLOAT :
-						isSigned ? VK_FORMAT_R16_SINT :
-						VK_FORMAT_R16_UINT;
-					if(bitsPerSample == 32)
-						format = isFloat ? VK_FORMAT_R32_SFLOAT :
-						isSigned ? VK_FORMAT_R32_SINT :
-						VK_FORMAT_R32_UINT;
-				}
-				if(samplesPerPixel == 2) {
-					if(bitsPerSample == 8)
-						format = isSigned ? VK_FORMAT_R8G8_SNORM :
-						VK_FORMAT_R8G8_UNORM;
-					if(bitsPerSample == 16)
-						format = isFloat ? VK_FORMAT_R16G16_SFLOAT :
-						isSigned ? VK_FORMAT_R16G16_SINT :
-						VK_FORMAT_R16G16_UINT;
-					if(bitsPerSample == 32)
-						format = isFloat ? VK_FORMAT_R32G32_SFLOAT :
-						isSigned ? VK_FORMAT_R32G32_SINT :
-						VK_FORMAT_R32G32_UINT;
-				}
-				if(samplesPerPixel == 3) {
-					if(bitsPerSample == 8)
-						format = isSigned ? VK_FORMAT_R8G8B8_SNORM :
-						VK_FORMAT_R8G8B8_UNORM;
-					if(bitsPerSample == 16)
-						format = isFloat ? VK_FORMAT_R16G16B16_SFLOAT :
-						isSigned ? VK_FORMAT_R16G16B16_SINT :
-						VK_FORMAT_R16G16B16_UINT;
-					if(bitsPerSample == 32)
-						format = isFloat ? VK_FORMAT_R32G32B32_SFLOAT :
-						isSigned ? VK_FORMAT_R32G32B32_SINT :
-						VK_FORMAT_R32G32B32_UINT;
-				}
-				if(samplesPerPixel == 4) {
-					if(bitsPerSample == 8)
-						format = isSigned ? VK_FORMAT_R8G8B8A8_SNORM :
-						VK_FORMAT_R8G8B8A8_UNORM;
-					if(bitsPerSample == 16)
-						format = isFloat ? VK_FORMAT_R16G16B16A16_SFLOAT :
-						isSigned ? VK_FORMAT_R16G16B16A16_SINT :
-						VK_FORMAT_R16G16B16A16_UINT;
-					if(bitsPerSample == 32)
-						format = isFloat ? VK_FORMAT_R32G32B32A32_SFLOAT :
-						isSigned ? VK_FORMAT_R32G32B32A32_SINT :
-						VK_FORMAT_R32G32B32A32_UINT;
-				}
-
+				format = getTiffFormat(samplesPerPixel, bitsPerSample, sampleFormat);
 				numChannels = samplesPerPixel;
 
 				if(format == VK_FORMAT_UNDEFINED)
@@ -106,30 +141,232 @@ namespace fre
 			}
 			TIFFClose(tiff);
 		}
-
-		LOG_ERROR("Can't open TIFF file to retrieve the dimensions: {}", fileName);
+		else
+		{
+			LOG_ERROR("Can't open TIFF file to retrieve the dimensions: {}", fileName);
+		}
 	}
 	
     void getInfoFromPngOrJpg(const std::string& fileName, ivec2& size, VkFormat& format, int& numChannels)
     {
 		stbi_info(fileName.c_str(), &size.x, &size.y, &numChannels);
 
-		switch(numChannels)
+		format = getPngOrJpgFormat(numChannels);
+		if(format == VK_FORMAT_UNDEFINED)
 		{
-			case 1:
-				format = VK_FORMAT_R8_UNORM;
-				break;
-			case 2:
-				format = VK_FORMAT_R8G8_UNORM;
-				break;
-			case 3:
-				format = VK_FORMAT_R8G8B8_UNORM;
+			LOG_ERROR("Unsupported channel count for file: {}", fileName);
+		}
+	}
+
+	bool readFileBytes(std::ifstream& file, uint64_t offset, void* data, size_t size)
+	{
+		//Previous read may have hit the end of file
+		file.clear();
+		file.seekg(static_cast<std::streamoff>(offset));
+		file.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+
+		return static_cast<size_t>(file.gcount()) == size;
+	}
+
+	uint32_t readBigEndian(const uint8_t* data, uint32_t bytes)
+	{
+		uint32_t result = 0;
+		for(uint32_t i = 0; i < bytes; i++)
+		{
+			result = (result << 8) | data[i];
+		}
+
+		return result;
+	}
+
+	uint32_t readEndian(const uint8_t* data, uint32_t bytes, bool bigEndian)
+	{
+		if(bigEndian)
+		{
+			return readBigEndian(data, bytes);
+		}
+
+		uint32_t result = 0;
+		for(uint32_t i = bytes; i > 0; i--)
+		{
+			result = (result << 8) | data[i - 1];
+		}
+
+		return result;
+	}
+
+	//Chunks are walked up to image data, transparency chunk adds alpha like decoder does
+	bool probePNG(std::ifstream& file, ImageHeader& header)
+	{
+		uint8_t data[29];
+		if(!readFileBytes(file, 0, data, sizeof(data)) || memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0 ||
+			memcmp(data + 12, "IHDR", 4) != 0)
+		{
+			return false;
+		}
+		header.mWidth = readBigEndian(data + 16, 4);
+		header.mHeight = readBigEndian(data + 20, 4);
+		header.mBitDepth = data[24];
+		const uint8_t colorType = data[25];
+		const bool palette = colorType == 3;
+		header.mChannels = palette ? 3 : (colorType & 2 ? 3 : 1) + (colorType & 4 ? 1 : 0);
+		header.mBitDepth = palette ? 8 : header.mBitDepth;
+		header.mPagesCount = 1;
+
+		uint64_t offset = 8 + 12 + readBigEndian(data + 8, 4);
+		while(true)
+		{
+			uint8_t chunk[8];
+			if(!readFileBytes(file, offset, chunk, sizeof(chunk)))
+			{
+				return false;
+			}
+			if(memcmp(chunk + 4, "IDAT", 4) == 0 || memcmp(chunk + 4, "IEND", 4) == 0)
+			{
 				break;
-			case 4:
-				format = VK_FORMAT_R8G8B8A8_UNORM;
+			}
+			if(memcmp(chunk + 4, "tRNS", 4) == 0)
+			{
+				header.mChannels = palette ? 4 : header.mChannels + 1;
 				break;
-			default: LOG_ERROR("Unsupported channel count for file: {}", fileName);
+			}
+			offset += 12 + static_cast<uint64_t>(readBigEndian(chunk, 4));
+		}
+
+		return header.mWidth > 0 && header.mHeight > 0;
+	}
+
+	//Segments are skipped up to frame header, decoder gives 1 or 3 channels
+	bool probeJPG(std::ifstream& file, ImageHeader& header)
+	{
+		uint8_t data[2];
+		if(!readFileBytes(file, 0, data, sizeof(data)) || data[0] != 0xFF || data[1] != 0xD8)
+		{
+			return false;
+		}
+
+		uint64_t offset = 2;
+		while(readFileBytes(file, offset, data, sizeof(data)))
+		{
+			if(data[0] != 0xFF)
+			{
+				return false;
+			}
+			const uint8_t marker = data[1];
+			//Fill bytes and markers without segment
+			if(marker == 0xFF)
+			{
+				offset++;
+				continue;
+			}
+			if(marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8))
+			{
+				offset += 2;
+				continue;
+			}
+			//Scan or end of image before frame header
+			if(marker == 0xDA || marker == 0xD9)
+			{
+				return false;
+			}
+
+			uint8_t segment[8];
+			const bool frame = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+			if(!readFileBytes(file, offset + 2, segment, frame ? 8 : 2))
+			{
+				return false;
+			}
+			if(frame)
+			{
+				header.mBitDepth = segment[2];
+				header.mHeight = readBigEndian(segment + 3, 2);
+				header.mWidth = readBigEndian(segment + 5, 2);
+				header.mChannels = segment[7] >= 3 ? 3 : 1;
+				header.mPagesCount = 1;
+				return header.mWidth > 0 && header.mHeight > 0 && segment[7] > 0;
+			}
+			offset += 2 + readBigEndian(segment, 2);
+		}
+
+		return false;
+	}
+
+	//Tags of the first directory describe image, the rest of directories are counted as pages
+	bool probeTIFF(std::ifstream& file, ImageHeader& header)
+	{
+		uint8_t data[12];
+		if(!readFileBytes(file, 0, data, 8))
+		{
+			return false;
+		}
+		const bool bigEndian = data[0] == 'M' && data[1] == 'M';
+		if(!(bigEndian || (data[0] == 'I' && data[1] == 'I')) || readEndian(data + 2, 2, bigEndian) != 42)
+		{
+			return false;
+		}
+
+		uint16_t samplesPerPixel = 1;
+		uint16_t bitsPerSample = 1;
+		uint16_t sampleFormat = SAMPLEFORMAT_UINT;
+		uint64_t offset = readEndian(data + 4, 4, bigEndian);
+		header.mPagesCount = 0;
+		while(offset != 0 && header.mPagesCount < MAX_TIFF_PAGES)
+		{
+			if(!readFileBytes(file, offset, data, 2))
+			{
+				return false;
+			}
+			const uint32_t entriesCount = readEndian(data, 2, bigEndian);
+			for(uint32_t i = 0; i < entriesCount && header.mPagesCount == 0; i++)
+			{
+				if(!readFileBytes(file, offset + 2 + i * 12, data, 12))
+				{
+					return false;
+				}
+				//Values of 4 bytes or less are stored in entry, the first of several ones is enough
+				const uint32_t tag = readEndian(data, 2, bigEndian);
+				const uint32_t type = readEndian(data + 2, 2, bigEndian);
+				const uint32_t count = readEndian(data + 4, 4, bigEndian);
+				const uint32_t valueBytes = type == TIFF_BYTE ? 1 : type == TIFF_SHORT ? 2 : 4;
+				uint8_t value[4];
+				memcpy(value, data + 8, 4);
+				if(static_cast<uint64_t>(count) * valueBytes > 4 && !readFileBytes(file, readEndian(data + 8, 4, bigEndian), value, valueBytes))
+				{
+					return false;
+				}
+				const uint32_t first = readEndian(value, valueBytes, bigEndian);
+				switch(tag)
+				{
+				case TIFFTAG_IMAGEWIDTH:
+					header.mWidth = first;
+					break;
+				case TIFFTAG_IMAGELENGTH:
+					header.mHeight = first;
+					break;
+				case TIFFTAG_BITSPERSAMPLE:
+					bitsPerSample = static_cast<uint16_t>(first);
+					break;
+				case TIFFTAG_SAMPLESPERPIXEL:
+					samplesPerPixel = static_cast<uint16_t>(first);
+					break;
+				case TIFFTAG_SAMPLEFORMAT:
+					sampleFormat = static_cast<uint16_t>(first);
+					break;
+				}
+			}
+			if(!readFileBytes(file, offset + 2 + static_cast<uint64_t>(entriesCount) * 12, data, 4))
+			{
+				return false;
+			}
+			offset = readEndian(data, 4, bigEndian);
+			header.mPagesCount++;
 		}
+
+		header.mChannels = samplesPerPixel;
+		header.mBitDepth = bitsPerSample;
+		header.mFormat = getTiffFormat(samplesPerPixel, bitsPerSample, sampleFormat);
+
+		return header.mPagesCount > 0 && header.mWidth > 0 && header.mHeight > 0;
 	}
 
 	void Image::create(const ivec2& dimension, const VkFormat format)
@@ -144,17 +381,57 @@ namespace fre
 		mIsOwner = true;
 	}
 
+	void Image::create(const TextureLevels& texture)
+	{
+		mDimension = ivec2(texture.mWidth, texture.mHeight);
+		mFormat = texture.mFormat;
+		mLevels = texture.mLevels;
+		mNumChannels = 0;
+		mIsTIFF = false;
+		mIsPNG = false;
+
+		calculateStrideAndDataSize();
+
+		mData = new uint8_t[mDataSize];
+		memcpy(mData, texture.mData.data(), mDataSize);
+
+		mIsOwner = true;
+	}
+
 	void Image::calculateStrideAndDataSize()
 	{
+		if(!mLevels.empty())
+		{
+			mStride = getFormatBlockBytes(mFormat);
+			//Levels may be stored smallest first
+			size_t dataSize = 0;
+			for(const auto& level : mLevels)
+			{
+				dataSize = std::max(dataSize, level.mOffset + level.mSize);
+			}
+			mDataSize = static_cast<uint32_t>(dataSize);
+			return;
+		}
+
 		switch(mFormat)
 		{
 		case VK_FORMAT_R8_UNORM:
 			mStride = 1;
 			break;
+		case VK_FORMAT_R8G8_UNORM:
+			mStride = 2;
+			break;
+		case VK_FORMAT_R8G8B8_UNORM:
+			mStride = 3;
+			break;
 		case VK_FORMAT_R16_UNORM:
+		case VK_FORMAT_R16_UINT:
+		case VK_FORMAT_R16_SFLOAT:
 			mStride = 2;
 			break;
 		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R32_UINT:
+		case VK_FORMAT_R32_SFLOAT:
 			mStride = 4;
 			break;
 		}
@@ -179,6 +456,14 @@ namespace fre
 				getInfoFromPngOrJpg(fullFileName, mDimension, mFormat, mNumChannels);
 				loadPng(fullFileName);
 			}
+			else if(mFileName.find(".ktx2") != std::string::npos)
+			{
+				create(loadKTX2(fs.find(mFileName)));
+			}
+			else if(mFileName.find(".dds") != std::string::npos)
+			{
+				create(loadDDS(fs.find(mFileName)));
+			}
 
 			if (mData == nullptr)
 			{
@@ -278,7 +563,11 @@ namespace fre
 
     void Image::destroy()
     {
-		if(mIsOwner)
+		if(mMappedFile)
+		{
+			mMappedFile.reset();
+		}
+		else if(mIsOwner)
 		{
 			if(mIsTIFF)
 			{
@@ -290,7 +579,7 @@ namespace fre
 			}
 			else
 			{
-				delete [] mData;
+				delete [] static_cast<uint8_t*>(mData);
 			}
 		}
     }
@@ -300,6 +589,63 @@ namespace fre
 		return !mFileName.empty() && mFileName.find('#') == std::string::npos;
 	}
 
+	bool Image::probe(const std::string& fileName, ImageHeader& header)
+	{
+		header = ImageHeader();
+		std::ifstream file(fileName, std::ios::binary);
+		if(!file.is_open())
+		{
+			return false;
+		}
+
+		if(fileName.find(".tiff") != std::string::npos || fileName.find(".tif") != std::string::npos)
+		{
+			return probeTIFF(file, header);
+		}
+		if(fileName.find(".png") != std::string::npos || fileName.find(".jpg") != std::string::npos)
+		{
+			//Decoder tells format by content, so does probe
+			bool result = probePNG(file, header);
+			if(!result)
+			{
+				header = ImageHeader();
+				result = probeJPG(file, header);
+			}
+			int numChannels = static_cast<int>(header.mChannels);
+			header.mFormat = getPngOrJpgFormat(numChannels);
+			return result;
+		}
+
+		return false;
+	}
+
+	bool Image::probeFile()
+	{
+		if(!isFileNameValid())
+		{
+			return false;
+		}
+
+		FS;
+		ImageHeader header;
+		if(!probe(fs.find(mFileName), header) || header.mFormat == VK_FORMAT_UNDEFINED)
+		{
+			return false;
+		}
+		mDimension = ivec2(header.mWidth, header.mHeight);
+		mFormat = header.mFormat;
+		mNumChannels = static_cast<int>(header.mChannels);
+		if(mFileName.find(".png") != std::string::npos || mFileName.find(".jpg") != std::string::npos)
+		{
+			getPngOrJpgFormat(mNumChannels);
+		}
+		calculateStrideAndDataSize();
+		//Data isn't loaded yet
+		mDataSize = 0;
+
+		return true;
+	}
+
 	void Image::getInfo(const std::string& fileName, ivec2& size, VkFormat& format, int& numChannels)
 	{
 		if(fileName.find(".tiff") != std::string::npos || fileName.find(".tif") != std::string::npos)
@@ -315,4 +661,4 @@ namespace fre
 			throw std::runtime_error("Failed to get image info from " + fileName);
 		}
     }
-}
\ No newline at end of file
+}
@@ -1,5 +1,8 @@
 #include "Mesh.hpp"
 
+#include <cassert>
+#include <cstring>
+
 namespace fre
 {
 	static uint32_t gMeshId = 0;
@@ -31,11 +34,97 @@ namespace fre
 	{
 		mVertices = vertices;
 		mVertexSize = vertexSize;
+		changeSceneVersion();
 	}
 
 	void Mesh::setIndices(const Indices& index)
 	{
 		mIndices = index;
+		changeSceneVersion();
+	}
+
+	void Mesh::setMaterialId(uint32_t materialId)
+	{
+		if(mMaterialId != materialId)
+		{
+			mMaterialId = materialId;
+			changeSceneVersion();
+		}
+	}
+
+	void Mesh::setBoundingBox(const BoundingBox3D& boundingBox)
+	{
+		if(mBoundingBox.mMin != boundingBox.mMin || mBoundingBox.mMax != boundingBox.mMax)
+		{
+			mBoundingBox = boundingBox;
+			changeSceneVersion();
+		}
+	}
+
+	void Mesh::setComputeShaderId(uint32_t computeShaderId)
+	{
+		if(mComputeShaderId != computeShaderId)
+		{
+			mComputeShaderId = computeShaderId;
+			changeSceneVersion();
+		}
+	}
+
+	//Callbacks can't be compared, every assignment changes scene
+	void Mesh::setBeforeVisitCallback(const RecordCallback& callback)
+	{
+		mBeforeVisitCallback = callback;
+		changeSceneVersion();
+	}
+
+	void Mesh::setAfterVisitCallback(const RecordCallback& callback)
+	{
+		mAfterVisitCallback = callback;
+		changeSceneVersion();
+	}
+
+	void Mesh::setBeforeRecordCallback(const RecordCallback& callback)
+	{
+		mBeforeRecordCallback = callback;
+		changeSceneVersion();
+	}
+
+	void Mesh::setAfterRecordCallback(const RecordCallback& callback)
+	{
+		mAfterRecordCallback = callback;
+		changeSceneVersion();
+	}
+
+	void Mesh::setVisible(bool visible)
+	{
+		if(mVisible != visible)
+		{
+			mVisible = visible;
+			changeSceneVersion();
+		}
+	}
+
+	void Mesh::setInstanceCount(uint32_t instanceCount)
+	{
+		if(mInstanceCount != instanceCount)
+		{
+			mInstanceCount = instanceCount;
+			changeSceneVersion();
+		}
+	}
+
+	void Mesh::setDescriptors(const Descriptors& descriptors)
+	{
+		if(mDescriptors != descriptors)
+		{
+			mDescriptors = descriptors;
+			changeSceneVersion();
+		}
+	}
+
+	void Mesh::setFrameDescriptors(const Descriptors& descriptors)
+	{
+		mDescriptors = descriptors;
 	}
 
 	uint32_t Mesh::getVertexSize() const
@@ -62,4 +151,46 @@ namespace fre
 	{
 		return mIndices.data();
 	}
+
+	void Mesh::setInstances(const Instances& instances)
+	{
+		//Mesh with instances is drawn differently, data of instances is uploaded by their version
+		if(mInstances.empty() != instances.empty())
+		{
+			changeSceneVersion();
+		}
+		mInstances = instances;
+		for(auto& instance : mInstances)
+		{
+			instance.normalMatrix = getNormalMatrix(instance.transform);
+		}
+		setInstanceCount(static_cast<uint32_t>(mInstances.size()));
+		mInstancesVersion++;
+	}
+
+	void Mesh::updateInstances(uint32_t firstInstance, const MeshInstance* instances, uint32_t count)
+	{
+		assert(firstInstance + count <= mInstances.size());
+		memcpy(mInstances.data() + firstInstance, instances, count * sizeof(MeshInstance));
+		for(uint32_t i = firstInstance; i < firstInstance + count; i++)
+		{
+			mInstances[i].normalMatrix = getNormalMatrix(mInstances[i].transform);
+		}
+		mInstancesVersion++;
+	}
+
+	const Mesh::Instances& Mesh::getInstances() const
+	{
+		return mInstances;
+	}
+
+	bool Mesh::hasInstances() const
+	{
+		return !mInstances.empty();
+	}
+
+	uint32_t Mesh::getInstancesVersion() const
+	{
+		return mInstancesVersion;
+	}
 }
\ No newline at end of file
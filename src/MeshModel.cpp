@@ -40,33 +40,103 @@ namespace fre
 
 	void MeshModel::setModelMatrix(const mat4& newModelMatrix)
 	{
-		modelMatrix = newModelMatrix;
+		if(modelMatrix != newModelMatrix)
+		{
+			modelMatrix = newModelMatrix;
+			mTransformsVersion++;
+			changeTransformsVersion();
+		}
+	}
+
+	void MeshModel::setSceneGraph(const SceneGraph& sceneGraph, const std::vector<uint32_t>& meshNodes)
+	{
+		mSceneGraph = sceneGraph;
+		mMeshNodes = meshNodes;
+		changeSceneVersion();
+	}
+
+	void MeshModel::updateTransforms(ThreadPool* threadPool)
+	{
+		if(mSceneGraph.update(threadPool) > 0)
+		{
+			mTransformsVersion++;
+		}
+	}
+
+	void MeshModel::setVisible(bool visible)
+	{
+		if(mVisible != visible)
+		{
+			mVisible = visible;
+			changeSceneVersion();
+		}
+	}
+
+	mat4 MeshModel::getMeshTransform(size_t index) const
+	{
+		if(index < mMeshNodes.size())
+		{
+			return modelMatrix * mSceneGraph.getWorldTransform(mMeshNodes[index]);
+		}
+
+		return modelMatrix;
+	}
+
+	//Assimp matrices are row-major
+	static mat4 toMat4(const aiMatrix4x4& m)
+	{
+		return mat4(
+			m.a1, m.b1, m.c1, m.d1,
+			m.a2, m.b2, m.c2, m.d2,
+			m.a3, m.b3, m.c3, m.d3,
+			m.a4, m.b4, m.c4, m.d4);
+	}
+
+	static void extendBoundingBox(BoundingBox3D& bb, const BoundingBox3D& meshBB, const mat4& transform)
+	{
+		for (uint32_t i = 0; i < 8; i++)
+		{
+			const vec3 corner(
+				(i & 1) ? meshBB.mMax.x : meshBB.mMin.x,
+				(i & 2) ? meshBB.mMax.y : meshBB.mMin.y,
+				(i & 4) ? meshBB.mMax.z : meshBB.mMin.z);
+			const vec3 position = vec3(transform * vec4(corner, 1.0f));
+			bb.mMin = min(bb.mMin, position);
+			bb.mMax = max(bb.mMax, position);
+		}
 	}
 
 	std::vector<Mesh::Ptr> MeshModel::loadNode(aiNode* node, const aiScene* scene,
-		BoundingBox3D& bb, uint32_t materialOffset)
+		BoundingBox3D& bb, uint32_t materialOffset, SceneGraph& sceneGraph,
+		std::vector<uint32_t>& meshNodes, uint32_t parent)
 	{
 		std::vector<Mesh::Ptr> meshList;
 
+		//Node is added before children, so graph stays in depth-first order
+		const uint32_t sceneNode = sceneGraph.addNode(parent, toMat4(node->mTransformation));
+		const mat4& worldTransform = sceneGraph.getWorldTransform(sceneNode);
+
 		for (size_t i = 0; i < node->mNumMeshes; i++)
 		{
-			meshList.push_back(
-				loadMesh(scene->mMeshes[node->mMeshes[i]], bb, materialOffset)
-			);
+			Mesh::Ptr mesh = loadMesh(scene->mMeshes[node->mMeshes[i]], materialOffset);
+			extendBoundingBox(bb, mesh->getBoundingBox(), worldTransform);
+			meshList.push_back(mesh);
+			meshNodes.push_back(sceneNode);
 		}
 
 		//Go through each node attached to this node and load it,
 		//then append their meshes to this node's mesh list
 		for (size_t i = 0; i < node->mNumChildren; i++)
 		{
-			std::vector<Mesh::Ptr> newList = loadNode(node->mChildren[i], scene, bb, materialOffset);
+			std::vector<Mesh::Ptr> newList = loadNode(node->mChildren[i], scene, bb, materialOffset,
+				sceneGraph, meshNodes, sceneNode);
 			meshList.insert(meshList.end(), newList.begin(), newList.end());
 		}
 
 		return meshList;
 	}
 
-	Mesh::Ptr MeshModel::loadMesh(aiMesh * mesh, BoundingBox3D& bb, uint32_t materialOffset)
+	Mesh::Ptr MeshModel::loadMesh(aiMesh * mesh, uint32_t materialOffset)
 	{
 		//sync with mesh vertex numbers
 		Mesh::Ptr newMesh(new Mesh(mesh->mMaterialIndex + materialOffset));
@@ -111,14 +181,7 @@ namespace fre
 
 		newMesh->setVertices(vertices, sizeof(Vertex));
 
-		newMesh->setBoundingBox(bb);
-
-		bb.mMin.x = std::min(bb.mMin.x, thisBB.mMin.x);
-		bb.mMin.y = std::min(bb.mMin.y, thisBB.mMin.y);
-		bb.mMin.z = std::min(bb.mMin.z, thisBB.mMin.z);
-		bb.mMax.x = std::max(bb.mMax.x, thisBB.mMax.x);
-		bb.mMax.y = std::max(bb.mMax.y, thisBB.mMax.y);
-		bb.mMax.z = std::max(bb.mMax.z, thisBB.mMax.z);
+		newMesh->setBoundingBox(thisBB);
 
 		//LOG_TRACE("Mesh model BB: mn: {}, {}, {}", bb.mMin.x, bb.mMin.y, bb.mMin.z);
 		//LOG_TRACE("Mesh model BB: mx: {}, {}, {}", bb.mMax.x, bb.mMax.y, bb.mMax.z);
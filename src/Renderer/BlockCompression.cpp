@@ -0,0 +1,534 @@
+#include "Renderer/BlockCompression.hpp"
+#include "TextureContainer.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace fre
+{
+	const uint32_t BLOCK_TEXELS = 16;
+	//Least squares refinements of color endpoints
+	const uint32_t COLOR_REFINE_STEPS = 2;
+
+	struct ColorFit
+	{
+		uint16_t mColor0 = 0;
+		uint16_t mColor1 = 0;
+		uint8_t mIndices[BLOCK_TEXELS] = {};
+		uint32_t mError = 0;
+	};
+
+	static uint16_t packColor565(const float* color)
+	{
+		const auto quantize = [](float value, float scale)
+			{
+				return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 255.0f) * scale / 255.0f + 0.5f);
+			};
+
+		return static_cast<uint16_t>((quantize(color[0], 31.0f) << 11) | (quantize(color[1], 63.0f) << 5) | quantize(color[2], 31.0f));
+	}
+
+	static void unpackColor565(uint16_t color, int32_t* rgb)
+	{
+		const int32_t r = (color >> 11) & 31;
+		const int32_t g = (color >> 5) & 63;
+		const int32_t b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	//4 colors of 4 color mode or 3 colors and black of 3 color mode
+	static void getColorPalette(uint16_t color0, uint16_t color1, bool fourColors, int32_t palette[4][3])
+	{
+		unpackColor565(color0, palette[0]);
+		unpackColor565(color1, palette[1]);
+		for(uint32_t c = 0; c < 3; c++)
+		{
+			if(fourColors)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	static ColorFit fitColorIndices(const uint8_t* texels, uint16_t color0, uint16_t color1)
+	{
+		ColorFit result;
+		result.mColor0 = color0;
+		result.mColor1 = color1;
+		int32_t palette[4][3];
+		getColorPalette(color0, color1, true, palette);
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			uint32_t bestError = std::numeric_limits<uint32_t>::max();
+			for(uint8_t index = 0; index < 4; index++)
+			{
+				uint32_t error = 0;
+				for(uint32_t c = 0; c < 3; c++)
+				{
+					const int32_t difference = texels[i * 4 + c] - palette[index][c];
+					error += difference * difference;
+				}
+				if(error < bestError)
+				{
+					bestError = error;
+					result.mIndices[i] = index;
+				}
+			}
+			result.mError += bestError;
+		}
+
+		return result;
+	}
+
+	//Endpoints minimizing error of texels for given indices, false if all texels use the same weight
+	static bool refineColorEndpoints(const uint8_t* texels, const uint8_t* indices, float* color0, float* color1)
+	{
+		const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float ax[3] = {};
+		float bx[3] = {};
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			const float a = weights[indices[i]];
+			const float b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				ax[c] += a * texels[i * 4 + c];
+				bx[c] += b * texels[i * 4 + c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if(std::abs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+		for(uint32_t c = 0; c < 3; c++)
+		{
+			color0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+			color1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+		}
+
+		return true;
+	}
+
+	//Color block always decoded in 4 color mode, as BC3 color block is
+	static void encodeColorBlock(const uint8_t* texels, uint8_t* block)
+	{
+		float mean[3] = {};
+		float minimum[3] = { 255.0f, 255.0f, 255.0f };
+		float maximum[3] = {};
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				const float value = texels[i * 4 + c];
+				mean[c] += value / BLOCK_TEXELS;
+				minimum[c] = std::min(minimum[c], value);
+				maximum[c] = std::max(maximum[c], value);
+			}
+		}
+
+		//Principal axis of colors by power iteration, started from diagonal of bounding box
+		float covariance[3][3] = {};
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			float centered[3];
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				centered[c] = texels[i * 4 + c] - mean[c];
+			}
+			for(uint32_t row = 0; row < 3; row++)
+			{
+				for(uint32_t column = 0; column < 3; column++)
+				{
+					covariance[row][column] += centered[row] * centered[column];
+				}
+			}
+		}
+		float axis[3] = { maximum[0] - minimum[0], maximum[1] - minimum[1], maximum[2] - minimum[2] };
+		for(uint32_t iteration = 0; iteration < 8; iteration++)
+		{
+			float next[3] = {};
+			for(uint32_t row = 0; row < 3; row++)
+			{
+				next[row] = covariance[row][0] * axis[0] + covariance[row][1] * axis[1] + covariance[row][2] * axis[2];
+			}
+			const float length = std::max(std::abs(next[0]), std::max(std::abs(next[1]), std::abs(next[2])));
+			if(length < 1e-6f)
+			{
+				break;
+			}
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float color0[3] = { mean[0], mean[1], mean[2] };
+		float color1[3] = { mean[0], mean[1], mean[2] };
+		const float axisLength = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		if(axisLength > 1e-6f)
+		{
+			float minimumProjection = std::numeric_limits<float>::max();
+			float maximumProjection = -std::numeric_limits<float>::max();
+			for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+			{
+				float projection = 0.0f;
+				for(uint32_t c = 0; c < 3; c++)
+				{
+					projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+				}
+				minimumProjection = std::min(minimumProjection, projection / axisLength);
+				maximumProjection = std::max(maximumProjection, projection / axisLength);
+			}
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				color0[c] = mean[c] + axis[c] * maximumProjection;
+				color1[c] = mean[c] + axis[c] * minimumProjection;
+			}
+		}
+
+		ColorFit best = fitColorIndices(texels, packColor565(color0), packColor565(color1));
+		for(uint32_t step = 0; step < COLOR_REFINE_STEPS && best.mError > 0; step++)
+		{
+			if(!refineColorEndpoints(texels, best.mIndices, color0, color1))
+			{
+				break;
+			}
+			const ColorFit fit = fitColorIndices(texels, packColor565(color0), packColor565(color1));
+			if(fit.mError >= best.mError)
+			{
+				break;
+			}
+			best = fit;
+		}
+
+		//First endpoint is greater in 4 color mode, equal endpoints use the first one only
+		if(best.mColor0 < best.mColor1)
+		{
+			std::swap(best.mColor0, best.mColor1);
+			for(auto& index : best.mIndices)
+			{
+				index ^= 1;
+			}
+		}
+		else if(best.mColor0 == best.mColor1)
+		{
+			memset(best.mIndices, 0, sizeof(best.mIndices));
+		}
+
+		uint32_t indices = 0;
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			indices |= static_cast<uint32_t>(best.mIndices[i]) << (2 * i);
+		}
+		memcpy(block, &best.mColor0, 2);
+		memcpy(block + 2, &best.mColor1, 2);
+		memcpy(block + 4, &indices, 4);
+	}
+
+	static void decodeColorBlock(const uint8_t* block, bool forceFourColors, bool transparentBlack, uint8_t* texels)
+	{
+		uint16_t color0;
+		uint16_t color1;
+		uint32_t indices;
+		memcpy(&color0, block, 2);
+		memcpy(&color1, block + 2, 2);
+		memcpy(&indices, block + 4, 4);
+		const bool fourColors = forceFourColors || color0 > color1;
+		int32_t palette[4][3];
+		getColorPalette(color0, color1, fourColors, palette);
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			const uint32_t index = (indices >> (2 * i)) & 3;
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				texels[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+			}
+			texels[i * 4 + 3] = !fourColors && index == 3 && transparentBlack ? 0 : 255;
+		}
+	}
+
+	//8 values of 8 value mode if first endpoint is greater, 6 values with 0 and 255 otherwise
+	static void getChannelPalette(uint8_t value0, uint8_t value1, int32_t palette[8])
+	{
+		palette[0] = value0;
+		palette[1] = value1;
+		if(value0 > value1)
+		{
+			for(int32_t i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for(int32_t i = 1; i < 5; i++)
+			{
+				palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	static void decodeChannelBlock(const uint8_t* block, uint32_t channel, uint8_t* texels)
+	{
+		int32_t palette[8];
+		getChannelPalette(block[0], block[1], palette);
+		uint64_t indices = 0;
+		memcpy(&indices, block + 2, 6);
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			texels[i * 4 + channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+	//Texel of source image of any channels count as RGBA8, missing color channels are 0 and alpha is 255
+	static void expandTexel(const uint8_t* source, uint32_t channelsCount, uint8_t* texel)
+	{
+		texel[0] = source[0];
+		texel[1] = channelsCount > 1 ? source[1] : 0;
+		texel[2] = channelsCount > 2 ? source[2] : 0;
+		texel[3] = channelsCount > 3 ? source[3] : 255;
+	}
+
+	static void encodeBlock(VkFormat format, const uint8_t* texels, uint8_t* block)
+	{
+		switch(format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			encodeBC1Block(texels, block);
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			encodeBC3Block(texels, block);
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			encodeBC4Block(texels, 0, block);
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			encodeBC5Block(texels, block);
+			break;
+		default:
+			throw std::runtime_error(formatString("Format %u isn't supported by block encoder", format));
+		}
+	}
+
+	void encodeBC1Block(const uint8_t* texels, uint8_t* block)
+	{
+		encodeColorBlock(texels, block);
+	}
+
+	void encodeBC3Block(const uint8_t* texels, uint8_t* block)
+	{
+		encodeBC4Block(texels, 3, block);
+		encodeColorBlock(texels, block + 8);
+	}
+
+	void encodeBC4Block(const uint8_t* texels, uint32_t channel, uint8_t* block)
+	{
+		uint8_t minimum = 255;
+		uint8_t maximum = 0;
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			minimum = std::min(minimum, texels[i * 4 + channel]);
+			maximum = std::max(maximum, texels[i * 4 + channel]);
+		}
+
+		//Equal endpoints select 6 value mode where index 0 is the only value of block
+		block[0] = maximum;
+		block[1] = minimum;
+		int32_t palette[8];
+		getChannelPalette(maximum, minimum, palette);
+		uint64_t indices = 0;
+		if(maximum > minimum)
+		{
+			for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+			{
+				const int32_t value = texels[i * 4 + channel];
+				uint64_t bestIndex = 0;
+				int32_t bestError = std::numeric_limits<int32_t>::max();
+				for(uint32_t index = 0; index < 8; index++)
+				{
+					const int32_t error = std::abs(value - palette[index]);
+					if(error < bestError)
+					{
+						bestError = error;
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (3 * i);
+			}
+		}
+		memcpy(block + 2, &indices, 6);
+	}
+
+	void encodeBC5Block(const uint8_t* texels, uint8_t* block)
+	{
+		encodeBC4Block(texels, 0, block);
+		encodeBC4Block(texels, 1, block + 8);
+	}
+
+	void decodeBlock(VkFormat format, const uint8_t* block, uint8_t* texels)
+	{
+		for(uint32_t i = 0; i < BLOCK_TEXELS; i++)
+		{
+			texels[i * 4 + 0] = 0;
+			texels[i * 4 + 1] = 0;
+			texels[i * 4 + 2] = 0;
+			texels[i * 4 + 3] = 255;
+		}
+
+		switch(format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			decodeColorBlock(block, false, false, texels);
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			decodeColorBlock(block, false, true, texels);
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			decodeColorBlock(block + 8, true, false, texels);
+			decodeChannelBlock(block, 3, texels);
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			decodeChannelBlock(block, 0, texels);
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			decodeChannelBlock(block, 0, texels);
+			decodeChannelBlock(block + 8, 1, texels);
+			break;
+		default:
+			throw std::runtime_error(formatString("Format %u isn't supported by block decoder", format));
+		}
+	}
+
+	VkFormat chooseBlockCompressedFormat(const uint8_t* data, size_t texelsCount, uint32_t channelsCount)
+	{
+		switch(channelsCount)
+		{
+		case 1:
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		case 2:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		case 3:
+			return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case 4:
+			for(size_t texel = 0; texel < texelsCount; texel++)
+			{
+				if(data[texel * 4 + 3] != 255)
+				{
+					return VK_FORMAT_BC3_UNORM_BLOCK;
+				}
+			}
+			return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		default:
+			return VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	std::vector<MipLevel> compressImage(const uint8_t* data, uint32_t width, uint32_t height, uint32_t channelsCount,
+		bool srgb, VkFormat format, uint32_t threadsCount, std::vector<uint8_t>& levelsData)
+	{
+		//Unsupported format throws here, not in encoding threads
+		uint8_t testBlock[16];
+		const uint8_t testTexels[BLOCK_TEXELS * 4] = {};
+		encodeBlock(format, testTexels, testBlock);
+
+		std::vector<uint8_t> mipsData;
+		const auto mips = generateMipmaps(data, width, height, channelsCount, srgb, mipsData);
+
+		struct BlockRow
+		{
+			uint32_t mLevel;
+			uint32_t mY;
+		};
+		std::vector<MipLevel> levels(mips.size());
+		std::vector<BlockRow> rows;
+		size_t dataSize = 0;
+		for(uint32_t level = 0; level < mips.size(); level++)
+		{
+			auto& mip = levels[level];
+			mip.mWidth = mips[level].mWidth;
+			mip.mHeight = mips[level].mHeight;
+			mip.mOffset = dataSize;
+			mip.mSize = getLevelSize(format, mip.mWidth, mip.mHeight);
+			dataSize += mip.mSize;
+			for(uint32_t y = 0; y < (mip.mHeight + 3) / 4; y++)
+			{
+				rows.push_back({ level, y });
+			}
+		}
+		levelsData.resize(dataSize);
+
+		const uint32_t blockBytes = getFormatBlockBytes(format);
+		const auto encodeRow = [&](const BlockRow& row)
+			{
+				const auto& mip = mips[row.mLevel];
+				const uint8_t* source = &mipsData[mip.mOffset];
+				uint8_t* destination = &levelsData[levels[row.mLevel].mOffset];
+				const uint32_t blocksCount = (mip.mWidth + 3) / 4;
+				uint8_t texels[BLOCK_TEXELS * 4];
+				for(uint32_t blockX = 0; blockX < blocksCount; blockX++)
+				{
+					for(uint32_t y = 0; y < 4; y++)
+					{
+						const uint32_t sourceY = std::min(row.mY * 4 + y, mip.mHeight - 1);
+						for(uint32_t x = 0; x < 4; x++)
+						{
+							const uint32_t sourceX = std::min(blockX * 4 + x, mip.mWidth - 1);
+							expandTexel(&source[(static_cast<size_t>(sourceY) * mip.mWidth + sourceX) * channelsCount],
+								channelsCount, &texels[(y * 4 + x) * 4]);
+						}
+					}
+					encodeBlock(format, texels, &destination[(static_cast<size_t>(row.mY) * blocksCount + blockX) * blockBytes]);
+				}
+			};
+
+		//Rows are taken one by one, so levels of any size are spread evenly
+		std::atomic<size_t> nextRow = 0;
+		const auto encodeRows = [&]()
+			{
+				for(size_t row = nextRow++; row < rows.size(); row = nextRow++)
+				{
+					encodeRow(rows[row]);
+				}
+			};
+		std::vector<std::thread> threads;
+		for(uint32_t thread = 1; thread < threadsCount; thread++)
+		{
+			threads.emplace_back(encodeRows);
+		}
+		encodeRows();
+		for(auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		return levels;
+	}
+}
@@ -0,0 +1,228 @@
+#include "Renderer/Culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fre
+{
+	static glm::vec4 normalizePlane(const glm::vec4& plane)
+	{
+		return plane / glm::length(glm::vec3(plane));
+	}
+
+	//Depth texels covered by texel of smaller image, at least one
+	static void getFootprint(uint32_t texel, uint32_t srcSize, uint32_t dstSize, uint32_t& first, uint32_t& last)
+	{
+		const float ratio = static_cast<float>(srcSize) / dstSize;
+		first = static_cast<uint32_t>(std::floor(texel * ratio));
+		last = std::max(first, static_cast<uint32_t>(std::ceil((texel + 1) * ratio)) - 1);
+		last = std::min(last, srcSize - 1);
+	}
+
+	static std::vector<float> reduceMax(const float* src, uint32_t srcWidth, uint32_t srcHeight,
+		uint32_t dstWidth, uint32_t dstHeight)
+	{
+		std::vector<float> result(dstWidth * dstHeight);
+		for(uint32_t y = 0; y < dstHeight; y++)
+		{
+			uint32_t firstY = 0, lastY = 0;
+			getFootprint(y, srcHeight, dstHeight, firstY, lastY);
+			for(uint32_t x = 0; x < dstWidth; x++)
+			{
+				uint32_t firstX = 0, lastX = 0;
+				getFootprint(x, srcWidth, dstWidth, firstX, lastX);
+				float depth = 0.0f;
+				for(uint32_t sy = firstY; sy <= lastY; sy++)
+				{
+					for(uint32_t sx = firstX; sx <= lastX; sx++)
+					{
+						depth = std::max(depth, src[sy * srcWidth + sx]);
+					}
+				}
+				result[y * dstWidth + x] = depth;
+			}
+		}
+
+		return result;
+	}
+
+	void HiZPyramid::build(const float* depth, uint32_t depthWidth, uint32_t depthHeight, uint32_t width, uint32_t height)
+	{
+		mWidth = width;
+		mHeight = height;
+		mLevels.resize(getHiZLevelsCount(width, height));
+		mLevels[0] = reduceMax(depth, depthWidth, depthHeight, width, height);
+		for(uint32_t level = 1; level < mLevels.size(); level++)
+		{
+			mLevels[level] = reduceMax(mLevels[level - 1].data(),
+				getLevelWidth(level - 1), getLevelHeight(level - 1),
+				getLevelWidth(level), getLevelHeight(level));
+		}
+	}
+
+	uint32_t HiZPyramid::getLevelWidth(uint32_t level) const
+	{
+		return std::max(mWidth >> level, 1u);
+	}
+
+	uint32_t HiZPyramid::getLevelHeight(uint32_t level) const
+	{
+		return std::max(mHeight >> level, 1u);
+	}
+
+	float HiZPyramid::getDepth(uint32_t level, uint32_t x, uint32_t y) const
+	{
+		return mLevels[level][y * getLevelWidth(level) + x];
+	}
+
+	Frustum getFrustum(const glm::mat4& viewProjection)
+	{
+		const glm::mat4 m = glm::transpose(viewProjection);
+		Frustum result;
+		result.mPlanes[0] = normalizePlane(m[3] + m[0]);
+		result.mPlanes[1] = normalizePlane(m[3] - m[0]);
+		result.mPlanes[2] = normalizePlane(m[3] + m[1]);
+		result.mPlanes[3] = normalizePlane(m[3] - m[1]);
+		//Near plane is at zero depth
+		result.mPlanes[4] = normalizePlane(m[2]);
+		result.mPlanes[5] = normalizePlane(m[3] - m[2]);
+
+		return result;
+	}
+
+	BoundingSphere getBoundingSphere(const glm::vec3& mn, const glm::vec3& mx)
+	{
+		BoundingSphere result;
+		result.mCenter = (mn + mx) * 0.5f;
+		result.mRadius = glm::length(mx - mn) * 0.5f;
+
+		return result;
+	}
+
+	BoundingSphere transformSphere(const BoundingSphere& sphere, const glm::mat4& transform)
+	{
+		const float scale = std::max(std::max(
+			glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+			glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+			glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])));
+		BoundingSphere result;
+		result.mCenter = glm::vec3(transform * glm::vec4(sphere.mCenter, 1.0f));
+		result.mRadius = sphere.mRadius * std::sqrt(scale);
+
+		return result;
+	}
+
+	bool isSphereVisible(const Frustum& frustum, const BoundingSphere& sphere)
+	{
+		for(const auto& plane : frustum.mPlanes)
+		{
+			if(glm::dot(glm::vec3(plane), sphere.mCenter) + plane.w < -sphere.mRadius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool isSphereOccluded(const HiZPyramid& pyramid, const glm::mat4& viewProjection, const BoundingSphere& sphere)
+	{
+		return isBoxOccluded(pyramid, viewProjection, sphere.mCenter, glm::vec3(sphere.mRadius));
+	}
+
+	bool isBoxOccluded(const HiZPyramid& pyramid, const glm::mat4& viewProjection, const glm::vec3& center, const glm::vec3& extent)
+	{
+		//Screen rectangle and nearest depth of box
+		glm::vec2 uvMin(1.0f);
+		glm::vec2 uvMax(0.0f);
+		float nearestDepth = 1.0f;
+		for(uint32_t i = 0; i < 8; i++)
+		{
+			const glm::vec3 corner = center + extent * glm::vec3(
+				(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+			const glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+			if(clip.w <= 0.0f)
+			{
+				return false;
+			}
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			const glm::vec2 uv = glm::vec2(ndc) * 0.5f + 0.5f;
+			uvMin = glm::min(uvMin, uv);
+			uvMax = glm::max(uvMax, uv);
+			nearestDepth = std::min(nearestDepth, ndc.z);
+		}
+		if(nearestDepth <= 0.0f)
+		{
+			return false;
+		}
+
+		//Level where rectangle covers at most 2x2 texels
+		const glm::vec2 size(pyramid.mWidth, pyramid.mHeight);
+		const glm::vec2 rectMin = glm::clamp(uvMin, 0.0f, 1.0f) * size;
+		const glm::vec2 rectMax = glm::clamp(uvMax, 0.0f, 1.0f) * size;
+		const float rectangleSize = std::max(rectMax.x - rectMin.x, rectMax.y - rectMin.y);
+		const int32_t maxLevel = static_cast<int32_t>(pyramid.getLevelsCount()) - 1;
+		const uint32_t level = static_cast<uint32_t>(glm::clamp(
+			static_cast<int32_t>(std::ceil(std::log2(std::max(rectangleSize, 1.0f)))), 0, maxLevel));
+
+		const uint32_t maxX = pyramid.getLevelWidth(level) - 1;
+		const uint32_t maxY = pyramid.getLevelHeight(level) - 1;
+		const uint32_t x0 = std::min(static_cast<uint32_t>(rectMin.x) >> level, maxX);
+		const uint32_t y0 = std::min(static_cast<uint32_t>(rectMin.y) >> level, maxY);
+		const uint32_t x1 = std::min(static_cast<uint32_t>(rectMax.x) >> level, maxX);
+		const uint32_t y1 = std::min(static_cast<uint32_t>(rectMax.y) >> level, maxY);
+		const float maxDepth = std::max(
+			std::max(pyramid.getDepth(level, x0, y0), pyramid.getDepth(level, x1, y0)),
+			std::max(pyramid.getDepth(level, x0, y1), pyramid.getDepth(level, x1, y1)));
+
+		return nearestDepth > maxDepth;
+	}
+
+	uint32_t getHiZSize(uint32_t depthSize)
+	{
+		uint32_t result = 1;
+		while(result * 2 <= depthSize)
+		{
+			result *= 2;
+		}
+
+		return result;
+	}
+
+	uint32_t getHiZLevelsCount(uint32_t width, uint32_t height)
+	{
+		uint32_t result = 1;
+		while((std::max(width, height) >> result) > 0)
+		{
+			result++;
+		}
+
+		return result;
+	}
+
+	std::vector<uint32_t> cullDraws(
+		const std::vector<CullingDraw>& draws,
+		const std::vector<glm::mat4>& transforms,
+		uint32_t batchesCount,
+		const Frustum& frustum,
+		const HiZPyramid* pyramid,
+		const glm::mat4& occlusionViewProjection)
+	{
+		std::vector<uint32_t> result(batchesCount, 0);
+		for(uint32_t i = 0; i < draws.size(); i++)
+		{
+			const auto& draw = draws[i];
+			BoundingSphere sphere;
+			sphere.mCenter = glm::vec3(draw.mSphere);
+			sphere.mRadius = draw.mSphere.w;
+			sphere = transformSphere(sphere, transforms[i]);
+			if(isSphereVisible(frustum, sphere) &&
+				(pyramid == nullptr || !isSphereOccluded(*pyramid, occlusionViewProjection, sphere)))
+			{
+				result[draw.mBatch]++;
+			}
+		}
+
+		return result;
+	}
+}
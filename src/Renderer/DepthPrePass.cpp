@@ -0,0 +1,70 @@
+#include "Renderer/DepthPrePass.hpp"
+
+namespace fre
+{
+	bool DepthPrePass::beginFrame()
+	{
+		switch(mSettings.mMode)
+		{
+			case EDepthPrePassMode::On:
+				return true;
+			case EDepthPrePassMode::Auto:
+				if(!mAutoEnabled)
+				{
+					return false;
+				}
+				mFramesSinceProbe++;
+				if(mFramesSinceProbe >= mSettings.mProbeInterval)
+				{
+					//Measure overdraw without pre-pass
+					mFramesSinceProbe = 0;
+					return false;
+				}
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	void DepthPrePass::update(float overdraw, bool withPrePass)
+	{
+		//With pre-pass main draws shade visible fragments only, it says nothing about scene overdraw
+		if(withPrePass)
+		{
+			return;
+		}
+
+		mOverdraw = overdraw;
+		if(mSettings.mMode != EDepthPrePassMode::Auto)
+		{
+			return;
+		}
+
+		const bool outOfBand = mAutoEnabled ?
+			overdraw < mSettings.mDisableOverdraw :
+			overdraw > mSettings.mEnableOverdraw;
+		mOutOfBandFrames = outOfBand ? mOutOfBandFrames + 1 : 0;
+		//Probe frames are rare, single probe is enough to disable pre-pass
+		const uint32_t framesToChange = mAutoEnabled ? 1 : mSettings.mFramesToChange;
+		if(mOutOfBandFrames >= framesToChange)
+		{
+			mAutoEnabled = !mAutoEnabled;
+			mOutOfBandFrames = 0;
+			mFramesSinceProbe = 0;
+		}
+	}
+
+	void DepthPrePass::reset()
+	{
+		mAutoEnabled = false;
+		mOverdraw = 0.0f;
+		mOutOfBandFrames = 0;
+		mFramesSinceProbe = 0;
+	}
+
+	bool DepthPrePass::isEnabled() const
+	{
+		return mSettings.mMode == EDepthPrePassMode::On ||
+			(mSettings.mMode == EDepthPrePassMode::Auto && mAutoEnabled);
+	}
+}
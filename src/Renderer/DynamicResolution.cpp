@@ -0,0 +1,78 @@
+#include "Renderer/DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fre
+{
+	float DynamicResolution::quantize(float scale) const
+	{
+		const float step = mSettings.mScaleStep;
+		float result = step > 0.0f ? std::floor(scale / step + 0.001f) * step : scale;
+
+		return std::clamp(result, mSettings.mMinScale, mSettings.mMaxScale);
+	}
+
+	bool DynamicResolution::update(float gpuFrameTime)
+	{
+		if(mCooldown > 0)
+		{
+			mCooldown--;
+			return false;
+		}
+
+		mFrameTime = mHasFrameTime ? mFrameTime + (gpuFrameTime - mFrameTime) * mSettings.mSmoothing : gpuFrameTime;
+		mHasFrameTime = true;
+
+		const float target = mSettings.mTargetFrameTime;
+		mOverBudgetFrames = mFrameTime > target * mSettings.mHighThreshold ? mOverBudgetFrames + 1 : 0;
+		mUnderBudgetFrames = mFrameTime < target * mSettings.mLowThreshold ? mUnderBudgetFrames + 1 : 0;
+
+		float scale = mScale;
+		if(mOverBudgetFrames >= mSettings.mFramesToDecrease)
+		{
+			//Frame time is roughly proportional to pixels count, i.e. to scale squared
+			const float wanted = mScale * std::sqrt(target / mFrameTime);
+			scale = quantize(std::min(wanted, mScale - mSettings.mScaleStep));
+		}
+		else if(mUnderBudgetFrames >= mSettings.mFramesToIncrease)
+		{
+			scale = quantize(mScale + mSettings.mScaleStep);
+			//Don't go up if the bigger scale is expected to be over budget again
+			const float expected = mFrameTime * (scale * scale) / (mScale * mScale);
+			if(expected > target * mSettings.mHighThreshold)
+			{
+				scale = mScale;
+			}
+		}
+
+		if(scale == mScale)
+		{
+			return false;
+		}
+
+		//Samples measured at old scale don't describe new one
+		mScale = scale;
+		mHasFrameTime = false;
+		mOverBudgetFrames = 0;
+		mUnderBudgetFrames = 0;
+		mCooldown = mSettings.mCooldownFrames;
+
+		return true;
+	}
+
+	void DynamicResolution::reset(float scale)
+	{
+		mScale = std::clamp(scale, mSettings.mMinScale, mSettings.mMaxScale);
+		mFrameTime = 0.0f;
+		mHasFrameTime = false;
+		mOverBudgetFrames = 0;
+		mUnderBudgetFrames = 0;
+		mCooldown = 0;
+	}
+
+	uint32_t DynamicResolution::getScaledSize(uint32_t size) const
+	{
+		return std::max(1u, static_cast<uint32_t>(std::lround(size * mScale)));
+	}
+}
@@ -0,0 +1,235 @@
+#include "Renderer/FrustumCulling.hpp"
+#include "Renderer/SIMD.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fre
+{
+	//Plane with absolute values of normal, they project box extents onto normal
+	struct CullingPlane
+	{
+		float mNormal[3];
+		float mDistance;
+		float mAbsNormal[3];
+	};
+
+	static std::array<CullingPlane, 6> getCullingPlanes(const Frustum& frustum)
+	{
+		std::array<CullingPlane, 6> result;
+		for(uint32_t i = 0; i < frustum.mPlanes.size(); i++)
+		{
+			const auto& plane = frustum.mPlanes[i];
+			for(uint32_t c = 0; c < 3; c++)
+			{
+				result[i].mNormal[c] = plane[c];
+				result[i].mAbsNormal[c] = std::abs(plane[c]);
+			}
+			result[i].mDistance = plane.w;
+		}
+
+		return result;
+	}
+
+	uint32_t CullingBounds::push()
+	{
+		//Arrays grow by whole SIMD width, so tests never read past their end
+		if(mCount == mCenterX.size())
+		{
+			const size_t size = mCenterX.size() + CULLING_SIMD_WIDTH;
+			for(auto* array : { &mCenterX, &mCenterY, &mCenterZ, &mRadius, &mExtentX, &mExtentY, &mExtentZ })
+			{
+				array->resize(size, 0.0f);
+			}
+		}
+
+		return mCount++;
+	}
+
+	uint32_t CullingBounds::add(const glm::vec3& mn, const glm::vec3& mx, const glm::mat4& transform)
+	{
+		const uint32_t index = push();
+		const auto sphere = transformSphere(getBoundingSphere(mn, mx), transform);
+		//Box of rotated box: each world axis collects extents of all local axes
+		const glm::vec3 extent = (mx - mn) * 0.5f;
+		glm::vec3 worldExtent(0.0f);
+		for(uint32_t row = 0; row < 3; row++)
+		{
+			for(uint32_t column = 0; column < 3; column++)
+			{
+				worldExtent[row] += std::abs(transform[column][row]) * extent[column];
+			}
+		}
+
+		mCenterX[index] = sphere.mCenter.x;
+		mCenterY[index] = sphere.mCenter.y;
+		mCenterZ[index] = sphere.mCenter.z;
+		mRadius[index] = sphere.mRadius;
+		mExtentX[index] = worldExtent.x;
+		mExtentY[index] = worldExtent.y;
+		mExtentZ[index] = worldExtent.z;
+
+		return index;
+	}
+
+	uint32_t CullingBounds::addUnbounded()
+	{
+		const uint32_t index = push();
+		mCenterX[index] = 0.0f;
+		mCenterY[index] = 0.0f;
+		mCenterZ[index] = 0.0f;
+		mRadius[index] = UNBOUNDED_RADIUS;
+		mExtentX[index] = UNBOUNDED_RADIUS;
+		mExtentY[index] = UNBOUNDED_RADIUS;
+		mExtentZ[index] = UNBOUNDED_RADIUS;
+
+		return index;
+	}
+
+	uint32_t cullBoundsScalar(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint8_t>& visibility)
+	{
+		const auto planes = getCullingPlanes(frustum);
+		visibility.resize(bounds.mCenterX.size());
+		uint32_t result = 0;
+		for(uint32_t i = 0; i < bounds.mCount; i++)
+		{
+			bool inside = true;
+			for(const auto& plane : planes)
+			{
+				const float distance = plane.mNormal[0] * bounds.mCenterX[i] + plane.mNormal[1] * bounds.mCenterY[i] +
+					plane.mNormal[2] * bounds.mCenterZ[i] + plane.mDistance;
+				const float projection = plane.mAbsNormal[0] * bounds.mExtentX[i] + plane.mAbsNormal[1] * bounds.mExtentY[i] +
+					plane.mAbsNormal[2] * bounds.mExtentZ[i];
+				//The tighter of sphere and box decides
+				inside = inside && distance + std::min(bounds.mRadius[i], projection) >= 0.0f;
+			}
+			visibility[i] = inside ? 1 : 0;
+			result += visibility[i];
+		}
+
+		return result;
+	}
+
+	uint32_t cullBoundsSIMD(const Frustum& frustum, const CullingBounds& bounds, std::vector<uint8_t>& visibility)
+	{
+		const auto planes = getCullingPlanes(frustum);
+		visibility.resize(bounds.mCenterX.size());
+		uint32_t result = 0;
+#if defined(FRE_SIMD_AVX)
+		const __m256 zero = _mm256_setzero_ps();
+		for(uint32_t i = 0; i < bounds.mCount; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(bounds.mCenterX.data() + i);
+			const __m256 cy = _mm256_loadu_ps(bounds.mCenterY.data() + i);
+			const __m256 cz = _mm256_loadu_ps(bounds.mCenterZ.data() + i);
+			const __m256 r = _mm256_loadu_ps(bounds.mRadius.data() + i);
+			const __m256 ex = _mm256_loadu_ps(bounds.mExtentX.data() + i);
+			const __m256 ey = _mm256_loadu_ps(bounds.mExtentY.data() + i);
+			const __m256 ez = _mm256_loadu_ps(bounds.mExtentZ.data() + i);
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for(const auto& plane : planes)
+			{
+				const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(_mm256_set1_ps(plane.mNormal[0]), cx),
+					_mm256_mul_ps(_mm256_set1_ps(plane.mNormal[1]), cy)),
+					_mm256_mul_ps(_mm256_set1_ps(plane.mNormal[2]), cz)),
+					_mm256_set1_ps(plane.mDistance));
+				const __m256 projection = _mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(_mm256_set1_ps(plane.mAbsNormal[0]), ex),
+					_mm256_mul_ps(_mm256_set1_ps(plane.mAbsNormal[1]), ey)),
+					_mm256_mul_ps(_mm256_set1_ps(plane.mAbsNormal[2]), ez));
+				inside = _mm256_and_ps(inside,
+					_mm256_cmp_ps(_mm256_add_ps(distance, _mm256_min_ps(r, projection)), zero, _CMP_GE_OQ));
+			}
+			const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+			for(uint32_t k = 0; k < 8; k++)
+			{
+				visibility[i + k] = (mask >> k) & 1;
+			}
+		}
+#elif defined(FRE_SIMD_SSE)
+		const __m128 zero = _mm_setzero_ps();
+		for(uint32_t i = 0; i < bounds.mCount; i += 4)
+		{
+			const __m128 cx = _mm_loadu_ps(bounds.mCenterX.data() + i);
+			const __m128 cy = _mm_loadu_ps(bounds.mCenterY.data() + i);
+			const __m128 cz = _mm_loadu_ps(bounds.mCenterZ.data() + i);
+			const __m128 r = _mm_loadu_ps(bounds.mRadius.data() + i);
+			const __m128 ex = _mm_loadu_ps(bounds.mExtentX.data() + i);
+			const __m128 ey = _mm_loadu_ps(bounds.mExtentY.data() + i);
+			const __m128 ez = _mm_loadu_ps(bounds.mExtentZ.data() + i);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for(const auto& plane : planes)
+			{
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_set1_ps(plane.mNormal[0]), cx),
+					_mm_mul_ps(_mm_set1_ps(plane.mNormal[1]), cy)),
+					_mm_mul_ps(_mm_set1_ps(plane.mNormal[2]), cz)),
+					_mm_set1_ps(plane.mDistance));
+				const __m128 projection = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_set1_ps(plane.mAbsNormal[0]), ex),
+					_mm_mul_ps(_mm_set1_ps(plane.mAbsNormal[1]), ey)),
+					_mm_mul_ps(_mm_set1_ps(plane.mAbsNormal[2]), ez));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, _mm_min_ps(r, projection)), zero));
+			}
+			const uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+			for(uint32_t k = 0; k < 4; k++)
+			{
+				visibility[i + k] = (mask >> k) & 1;
+			}
+		}
+#elif defined(FRE_SIMD_NEON)
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+		for(uint32_t i = 0; i < bounds.mCount; i += 4)
+		{
+			const float32x4_t cx = vld1q_f32(bounds.mCenterX.data() + i);
+			const float32x4_t cy = vld1q_f32(bounds.mCenterY.data() + i);
+			const float32x4_t cz = vld1q_f32(bounds.mCenterZ.data() + i);
+			const float32x4_t r = vld1q_f32(bounds.mRadius.data() + i);
+			const float32x4_t ex = vld1q_f32(bounds.mExtentX.data() + i);
+			const float32x4_t ey = vld1q_f32(bounds.mExtentY.data() + i);
+			const float32x4_t ez = vld1q_f32(bounds.mExtentZ.data() + i);
+			uint32x4_t inside = vdupq_n_u32(0xffffffff);
+			for(const auto& plane : planes)
+			{
+				const float32x4_t distance = vaddq_f32(vaddq_f32(vaddq_f32(
+					vmulq_n_f32(cx, plane.mNormal[0]),
+					vmulq_n_f32(cy, plane.mNormal[1])),
+					vmulq_n_f32(cz, plane.mNormal[2])),
+					vdupq_n_f32(plane.mDistance));
+				const float32x4_t projection = vaddq_f32(vaddq_f32(
+					vmulq_n_f32(ex, plane.mAbsNormal[0]),
+					vmulq_n_f32(ey, plane.mAbsNormal[1])),
+					vmulq_n_f32(ez, plane.mAbsNormal[2]));
+				inside = vandq_u32(inside, vcgeq_f32(vaddq_f32(distance, vminq_f32(r, projection)), zero));
+			}
+			visibility[i] = vgetq_lane_u32(inside, 0) & 1;
+			visibility[i + 1] = vgetq_lane_u32(inside, 1) & 1;
+			visibility[i + 2] = vgetq_lane_u32(inside, 2) & 1;
+			visibility[i + 3] = vgetq_lane_u32(inside, 3) & 1;
+		}
+#else
+		return cullBoundsScalar(frustum, bounds, visibility);
+#endif
+		//Padding is tested too, but not counted
+		for(uint32_t i = 0; i < bounds.mCount; i++)
+		{
+			result += visibility[i];
+		}
+
+		return result;
+	}
+
+	const char* getCullingSIMDName()
+	{
+#if defined(FRE_SIMD_AVX)
+		return "AVX";
+#elif defined(FRE_SIMD_SSE)
+		return "SSE2";
+#elif defined(FRE_SIMD_NEON)
+		return "NEON";
+#else
+		return "Scalar";
+#endif
+	}
+}
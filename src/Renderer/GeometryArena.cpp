@@ -0,0 +1,68 @@
+#include "Renderer/GeometryArena.hpp"
+
+#include <cstring>
+
+namespace fre
+{
+	GeometryArenaRange GeometryArenas::add(uint32_t vertexSize, const void* vertices, uint32_t verticesCount,
+		const uint32_t* indices, uint32_t indicesCount)
+	{
+		const size_t verticesSize = static_cast<size_t>(verticesCount) * vertexSize;
+		const size_t indicesSize = static_cast<size_t>(indicesCount) * sizeof(uint32_t);
+
+		//Last arena with the same vertex size which still has space
+		GeometryArena* arena = nullptr;
+		uint32_t arenaId = 0;
+		for(uint32_t i = static_cast<uint32_t>(mArenas.size()); i > 0; i--)
+		{
+			auto& candidate = mArenas[i - 1];
+			if(candidate.mVertexSize == vertexSize)
+			{
+				const size_t arenaSize = candidate.mVertices.size() + candidate.mIndices.size() * sizeof(uint32_t);
+				//Empty arena always accepts mesh, even if mesh alone is bigger than arena limit
+				if(!candidate.mSealed && (arenaSize == 0 || arenaSize + verticesSize + indicesSize <= mMaxArenaSize))
+				{
+					arena = &candidate;
+					arenaId = i - 1;
+				}
+				break;
+			}
+		}
+		if(arena == nullptr)
+		{
+			arenaId = static_cast<uint32_t>(mArenas.size());
+			mArenas.push_back(GeometryArena());
+			arena = &mArenas.back();
+			arena->mVertexSize = vertexSize;
+		}
+
+		GeometryArenaRange result;
+		result.mArena = arenaId;
+		result.mFirstIndex = static_cast<uint32_t>(arena->mIndices.size());
+		result.mIndexCount = indicesCount;
+		result.mVertexOffset = static_cast<int32_t>(arena->getVertexCount());
+
+		const size_t verticesStart = arena->mVertices.size();
+		arena->mVertices.resize(verticesStart + verticesSize);
+		memcpy(arena->mVertices.data() + verticesStart, vertices, verticesSize);
+		//Indices stay mesh local, vertex offset is applied by draw
+		arena->mIndices.insert(arena->mIndices.end(), indices, indices + indicesCount);
+
+		return result;
+	}
+
+	void GeometryArenas::releaseCPUData()
+	{
+		for(auto& arena : mArenas)
+		{
+			arena.mVertices = std::vector<uint8_t>();
+			arena.mIndices = std::vector<uint32_t>();
+			arena.mSealed = true;
+		}
+	}
+
+	void GeometryArenas::clear()
+	{
+		mArenas.clear();
+	}
+}
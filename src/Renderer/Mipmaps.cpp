@@ -0,0 +1,213 @@
+#include "Renderer/Mipmaps.hpp"
+#include "Renderer/SIMD.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace fre
+{
+	//Texel is filtered as 4 floats whatever channels count is
+	const uint32_t MIP_TEXEL_FLOATS = 4;
+
+	//Source texels of destination texel along one axis
+	struct MipTaps
+	{
+		uint32_t mIndices[3] = {};
+		float mWeights[3] = {};
+		uint32_t mCount = 0;
+	};
+
+	struct SRGBTables
+	{
+		std::array<float, 256> mToLinear;
+		//Linear values halfway between neighbour codes, code is count of thresholds below value
+		std::array<float, 255> mThresholds;
+		//Code of each interval start, search for code starts from it
+		std::array<uint8_t, 4096> mFirstCodes;
+	};
+
+	static const SRGBTables& getSRGBTables()
+	{
+		static const SRGBTables tables = []()
+			{
+				SRGBTables result;
+				for(uint32_t i = 0; i < result.mToLinear.size(); i++)
+				{
+					const double value = i / 255.0;
+					result.mToLinear[i] = static_cast<float>(value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+				}
+				for(uint32_t i = 0; i < result.mThresholds.size(); i++)
+				{
+					result.mThresholds[i] = (result.mToLinear[i] + result.mToLinear[i + 1]) * 0.5f;
+				}
+				for(uint32_t i = 0; i < result.mFirstCodes.size(); i++)
+				{
+					const float value = static_cast<float>(i) / result.mFirstCodes.size();
+					result.mFirstCodes[i] = static_cast<uint8_t>(std::upper_bound(result.mThresholds.begin(), result.mThresholds.end(), value) -
+						result.mThresholds.begin());
+				}
+				return result;
+			}();
+
+		return tables;
+	}
+
+	static std::vector<MipTaps> getMipTaps(uint32_t size, uint32_t mipSize)
+	{
+		std::vector<MipTaps> result(mipSize);
+		for(uint32_t i = 0; i < mipSize; i++)
+		{
+			auto& taps = result[i];
+			if(size == 1)
+			{
+				taps.mIndices[0] = 0;
+				taps.mWeights[0] = 1.0f;
+				taps.mCount = 1;
+			}
+			else if(size % 2 == 0)
+			{
+				taps.mIndices[0] = 2 * i;
+				taps.mIndices[1] = 2 * i + 1;
+				taps.mWeights[0] = 0.5f;
+				taps.mWeights[1] = 0.5f;
+				taps.mCount = 2;
+			}
+			else
+			{
+				//Each of 2 * mipSize + 1 texels is covered by destination texels equally
+				const float scale = 1.0f / (2 * mipSize + 1);
+				taps.mIndices[0] = 2 * i;
+				taps.mIndices[1] = 2 * i + 1;
+				taps.mIndices[2] = 2 * i + 2;
+				taps.mWeights[0] = (mipSize - i) * scale;
+				taps.mWeights[1] = mipSize * scale;
+				taps.mWeights[2] = (i + 1) * scale;
+				taps.mCount = 3;
+			}
+		}
+
+		return result;
+	}
+
+	static bool isColorChannel(uint32_t channel, uint32_t channelsCount, bool srgb)
+	{
+		const bool alpha = (channelsCount == 2 || channelsCount == 4) && channel == channelsCount - 1;
+		return srgb && !alpha;
+	}
+
+	static uint8_t encodeChannel(const SRGBTables& tables, float value, bool color)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		if(color)
+		{
+			//Same code as search over all thresholds, only a few of them are above interval start
+			const uint32_t interval = std::min(static_cast<uint32_t>(value * tables.mFirstCodes.size()),
+				static_cast<uint32_t>(tables.mFirstCodes.size() - 1));
+			uint32_t code = tables.mFirstCodes[interval];
+			while(code < tables.mThresholds.size() && tables.mThresholds[code] <= value)
+			{
+				code++;
+			}
+			return static_cast<uint8_t>(code);
+		}
+
+		return static_cast<uint8_t>(value * 255.0f + 0.5f);
+	}
+
+	uint32_t getMipLevelsCount(uint32_t width, uint32_t height)
+	{
+		uint32_t result = 1;
+		for(uint32_t size = std::max(width, height); size > 1; size /= 2)
+		{
+			result++;
+		}
+
+		return result;
+	}
+
+	std::vector<MipLevel> generateMipmaps(const uint8_t* data, uint32_t width, uint32_t height,
+		uint32_t channelsCount, bool srgb, std::vector<uint8_t>& levelsData)
+	{
+		std::vector<MipLevel> levels(getMipLevelsCount(width, height));
+		size_t dataSize = 0;
+		for(uint32_t level = 0; level < levels.size(); level++)
+		{
+			auto& mip = levels[level];
+			mip.mWidth = std::max(width >> level, 1u);
+			mip.mHeight = std::max(height >> level, 1u);
+			mip.mOffset = dataSize;
+			mip.mSize = static_cast<size_t>(mip.mWidth) * mip.mHeight * channelsCount;
+			dataSize += mip.mSize;
+		}
+		levelsData.resize(dataSize);
+		memcpy(levelsData.data(), data, levels[0].mSize);
+
+		const auto& tables = getSRGBTables();
+		const auto& toLinear = tables.mToLinear;
+		std::vector<float> source(static_cast<size_t>(width) * height * MIP_TEXEL_FLOATS, 0.0f);
+		for(size_t texel = 0; texel < static_cast<size_t>(width) * height; texel++)
+		{
+			for(uint32_t c = 0; c < channelsCount; c++)
+			{
+				const uint8_t value = data[texel * channelsCount + c];
+				source[texel * MIP_TEXEL_FLOATS + c] = isColorChannel(c, channelsCount, srgb) ? toLinear[value] : value / 255.0f;
+			}
+		}
+
+		std::vector<float> rows;
+		std::vector<float> destination;
+		for(uint32_t level = 1; level < levels.size(); level++)
+		{
+			const auto& previous = levels[level - 1];
+			const auto& mip = levels[level];
+			const auto columnTaps = getMipTaps(previous.mWidth, mip.mWidth);
+			const auto rowTaps = getMipTaps(previous.mHeight, mip.mHeight);
+
+			//Separable filter: rows of previous level are narrowed, then narrowed rows are blended
+			rows.assign(static_cast<size_t>(mip.mWidth) * previous.mHeight * MIP_TEXEL_FLOATS, 0.0f);
+			for(uint32_t y = 0; y < previous.mHeight; y++)
+			{
+				const float* sourceRow = &source[static_cast<size_t>(y) * previous.mWidth * MIP_TEXEL_FLOATS];
+				float* row = &rows[static_cast<size_t>(y) * mip.mWidth * MIP_TEXEL_FLOATS];
+				for(uint32_t x = 0; x < mip.mWidth; x++)
+				{
+					const auto& taps = columnTaps[x];
+					SimdFloat4 sum = simdSet(0.0f);
+					for(uint32_t t = 0; t < taps.mCount; t++)
+					{
+						sum = simdAdd(sum, simdMul(simdLoad(&sourceRow[taps.mIndices[t] * MIP_TEXEL_FLOATS]), simdSet(taps.mWeights[t])));
+					}
+					simdStore(&row[x * MIP_TEXEL_FLOATS], sum);
+				}
+			}
+
+			destination.assign(static_cast<size_t>(mip.mWidth) * mip.mHeight * MIP_TEXEL_FLOATS, 0.0f);
+			uint8_t* mipData = &levelsData[mip.mOffset];
+			for(uint32_t y = 0; y < mip.mHeight; y++)
+			{
+				const auto& taps = rowTaps[y];
+				for(uint32_t x = 0; x < mip.mWidth; x++)
+				{
+					SimdFloat4 sum = simdSet(0.0f);
+					for(uint32_t t = 0; t < taps.mCount; t++)
+					{
+						const size_t texel = static_cast<size_t>(taps.mIndices[t]) * mip.mWidth + x;
+						sum = simdAdd(sum, simdMul(simdLoad(&rows[texel * MIP_TEXEL_FLOATS]), simdSet(taps.mWeights[t])));
+					}
+					const size_t texel = static_cast<size_t>(y) * mip.mWidth + x;
+					float* values = &destination[texel * MIP_TEXEL_FLOATS];
+					simdStore(values, sum);
+					for(uint32_t c = 0; c < channelsCount; c++)
+					{
+						mipData[texel * channelsCount + c] = encodeChannel(tables, values[c], isColorChannel(c, channelsCount, srgb));
+					}
+				}
+			}
+			source.swap(destination);
+		}
+
+		return levels;
+	}
+}
@@ -0,0 +1,596 @@
+#include "Renderer/RenderGraph.hpp"
+#include "Log.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace fre
+{
+	bool isWriteUsage(ERenderGraphUsage usage)
+	{
+		switch(usage)
+		{
+			case ERenderGraphUsage::ColorAttachment:
+			case ERenderGraphUsage::DepthAttachment:
+			case ERenderGraphUsage::StorageWrite:
+			case ERenderGraphUsage::TransferDst:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	bool isAttachmentUsage(ERenderGraphUsage usage)
+	{
+		switch(usage)
+		{
+			case ERenderGraphUsage::ColorAttachment:
+			case ERenderGraphUsage::DepthAttachment:
+			case ERenderGraphUsage::DepthReadOnly:
+			case ERenderGraphUsage::InputAttachment:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	VkImageLayout getUsageLayout(ERenderGraphUsage usage, VkImageAspectFlags aspect)
+	{
+		const bool depth = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+		VkImageLayout result = VK_IMAGE_LAYOUT_UNDEFINED;
+		switch(usage)
+		{
+			case ERenderGraphUsage::ColorAttachment: result = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+				break;
+			case ERenderGraphUsage::DepthAttachment: result = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+				break;
+			case ERenderGraphUsage::DepthReadOnly: result = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+				break;
+			case ERenderGraphUsage::InputAttachment:
+			case ERenderGraphUsage::Sampled:
+				result = depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				break;
+			case ERenderGraphUsage::StorageRead:
+			case ERenderGraphUsage::StorageWrite:
+				result = VK_IMAGE_LAYOUT_GENERAL;
+				break;
+			case ERenderGraphUsage::TransferSrc: result = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+				break;
+			case ERenderGraphUsage::TransferDst: result = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+				break;
+		}
+
+		return result;
+	}
+
+	VkPipelineStageFlags getUsageStage(ERenderGraphUsage usage)
+	{
+		VkPipelineStageFlags result = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		switch(usage)
+		{
+			case ERenderGraphUsage::ColorAttachment: result = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+				break;
+			case ERenderGraphUsage::DepthAttachment:
+			case ERenderGraphUsage::DepthReadOnly:
+				result = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				break;
+			case ERenderGraphUsage::InputAttachment: result = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+				break;
+			case ERenderGraphUsage::Sampled: result = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+				break;
+			case ERenderGraphUsage::StorageRead:
+			case ERenderGraphUsage::StorageWrite:
+				result = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+				break;
+			case ERenderGraphUsage::TransferSrc:
+			case ERenderGraphUsage::TransferDst:
+				result = VK_PIPELINE_STAGE_TRANSFER_BIT;
+				break;
+		}
+
+		return result;
+	}
+
+	VkAccessFlags getUsageAccess(ERenderGraphUsage usage)
+	{
+		VkAccessFlags result = 0;
+		switch(usage)
+		{
+			case ERenderGraphUsage::ColorAttachment: result = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+				break;
+			case ERenderGraphUsage::DepthAttachment: result = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				break;
+			case ERenderGraphUsage::DepthReadOnly: result = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+				break;
+			case ERenderGraphUsage::InputAttachment: result = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+				break;
+			case ERenderGraphUsage::Sampled:
+			case ERenderGraphUsage::StorageRead:
+				result = VK_ACCESS_SHADER_READ_BIT;
+				break;
+			case ERenderGraphUsage::StorageWrite: result = VK_ACCESS_SHADER_WRITE_BIT;
+				break;
+			case ERenderGraphUsage::TransferSrc: result = VK_ACCESS_TRANSFER_READ_BIT;
+				break;
+			case ERenderGraphUsage::TransferDst: result = VK_ACCESS_TRANSFER_WRITE_BIT;
+				break;
+		}
+
+		return result;
+	}
+
+	VkImageUsageFlags getUsageImageFlags(ERenderGraphUsage usage)
+	{
+		VkImageUsageFlags result = 0;
+		switch(usage)
+		{
+			case ERenderGraphUsage::ColorAttachment: result = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+				break;
+			case ERenderGraphUsage::DepthAttachment:
+			case ERenderGraphUsage::DepthReadOnly:
+				result = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+				break;
+			case ERenderGraphUsage::InputAttachment: result = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+				break;
+			case ERenderGraphUsage::Sampled: result = VK_IMAGE_USAGE_SAMPLED_BIT;
+				break;
+			case ERenderGraphUsage::StorageRead:
+			case ERenderGraphUsage::StorageWrite:
+				result = VK_IMAGE_USAGE_STORAGE_BIT;
+				break;
+			case ERenderGraphUsage::TransferSrc: result = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+				break;
+			case ERenderGraphUsage::TransferDst: result = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+				break;
+		}
+
+		return result;
+	}
+
+	static ERenderGraphUsage findUsage(const RenderGraphPass& pass, uint32_t resource)
+	{
+		for(const auto& access : pass.mAccesses)
+		{
+			if(access.mResource == resource)
+			{
+				return access.mUsage;
+			}
+		}
+
+		return ERenderGraphUsage::Count;
+	}
+
+	bool RenderGraphResource::isAttachment() const
+	{
+		return (mUsage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+			VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT)) != 0;
+	}
+
+	uint32_t RenderGraph::addResource(const RenderGraphResourceDesc& desc)
+	{
+		if(getResourceId(desc.mName) != RenderGraphBarrier::EXTERNAL)
+		{
+			throw std::runtime_error(formatString("Render graph resource %s already exists", desc.mName.c_str()));
+		}
+
+		RenderGraphResource resource;
+		resource.mDesc = desc;
+		mResources.push_back(resource);
+		mCompiled = false;
+
+		return static_cast<uint32_t>(mResources.size() - 1);
+	}
+
+	uint32_t RenderGraph::addPass(const std::string& name, bool dynamicResolution)
+	{
+		RenderGraphPass pass;
+		pass.mName = name;
+		pass.mDynamicResolution = dynamicResolution;
+		mPasses.push_back(pass);
+		mCompiled = false;
+
+		return static_cast<uint32_t>(mPasses.size() - 1);
+	}
+
+	void RenderGraph::read(uint32_t pass, uint32_t resource, ERenderGraphUsage usage)
+	{
+		if(isWriteUsage(usage))
+		{
+			throw std::runtime_error(formatString("Usage %i is not a read", static_cast<int>(usage)));
+		}
+		addAccess(pass, resource, usage);
+	}
+
+	void RenderGraph::write(uint32_t pass, uint32_t resource, ERenderGraphUsage usage)
+	{
+		if(!isWriteUsage(usage))
+		{
+			throw std::runtime_error(formatString("Usage %i is not a write", static_cast<int>(usage)));
+		}
+		addAccess(pass, resource, usage);
+	}
+
+	void RenderGraph::addAccess(uint32_t pass, uint32_t resource, ERenderGraphUsage usage)
+	{
+		if(pass >= mPasses.size() || resource >= mResources.size())
+		{
+			throw std::runtime_error(formatString("Invalid render graph access: pass %u, resource %u", pass, resource));
+		}
+		//One layout per resource per pass
+		if(findUsage(mPasses[pass], resource) != ERenderGraphUsage::Count)
+		{
+			throw std::runtime_error(formatString("Resource %s is accessed twice in pass %s",
+				mResources[resource].mDesc.mName.c_str(), mPasses[pass].mName.c_str()));
+		}
+
+		mPasses[pass].mAccesses.push_back({ resource, usage });
+		mCompiled = false;
+	}
+
+	void RenderGraph::clear()
+	{
+		mResources.clear();
+		mPasses.clear();
+		mBarriers.clear();
+		mFinalBarriers.clear();
+		mMemorySlotsCount = 0;
+		mRenderPassesCount = 0;
+		mCompiled = false;
+	}
+
+	uint32_t RenderGraph::getResourceId(const std::string& name) const
+	{
+		for(uint32_t i = 0; i < mResources.size(); i++)
+		{
+			if(mResources[i].mDesc.mName == name)
+			{
+				return i;
+			}
+		}
+
+		return RenderGraphBarrier::EXTERNAL;
+	}
+
+	const RenderGraphResource& RenderGraph::getResource(uint32_t id) const
+	{
+		assert(id < mResources.size());
+
+		return mResources[id];
+	}
+
+	const RenderGraphPass& RenderGraph::getPass(uint32_t id) const
+	{
+		assert(id < mPasses.size());
+
+		return mPasses[id];
+	}
+
+	std::vector<uint32_t> RenderGraph::getAttachments(uint32_t renderPass) const
+	{
+		std::vector<uint32_t> result;
+		for(uint32_t i = 0; i < mResources.size(); i++)
+		{
+			for(const auto& pass : mPasses)
+			{
+				const auto usage = findUsage(pass, i);
+				if(pass.mRenderPass == renderPass && usage != ERenderGraphUsage::Count && isAttachmentUsage(usage))
+				{
+					result.push_back(i);
+					break;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	VkImageLayout RenderGraph::getLayoutBefore(uint32_t resource, uint32_t pass) const
+	{
+		const auto& desc = mResources[resource].mDesc;
+		for(uint32_t p = pass; p-- > 0;)
+		{
+			const auto usage = findUsage(mPasses[p], resource);
+			if(usage == ERenderGraphUsage::Count)
+			{
+				continue;
+			}
+			//Render pass which has resource attached transitions it to layout of next access
+			if(isAttachmentUsage(usage) && mPasses[p].mRenderPass != mPasses[pass].mRenderPass)
+			{
+				return mResources[resource].mLayouts[pass];
+			}
+
+			return mResources[resource].mLayouts[p];
+		}
+
+		return desc.mExternal ? desc.mInitialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	const std::vector<RenderGraphBarrier>& RenderGraph::getBarriers(uint32_t pass) const
+	{
+		assert(mCompiled && pass < mBarriers.size());
+
+		return mBarriers[pass];
+	}
+
+	void RenderGraph::compile()
+	{
+		computeRenderPasses();
+		computeLifetimes();
+		assignMemorySlots();
+		computeBarriers();
+		mCompiled = true;
+
+		for(const auto& resource : mResources)
+		{
+			LOG_TRACE("Render graph resource {}: passes {}-{}, lazy {}, memory slot {}",
+				resource.mDesc.mName, resource.mFirstPass, resource.mLastPass,
+				resource.mLazy, resource.mMemorySlot);
+		}
+	}
+
+	void RenderGraph::computeRenderPasses()
+	{
+		mRenderPassesCount = 0;
+		//Attachments of current render pass
+		std::vector<bool> attached(mResources.size(), false);
+		for(uint32_t p = 0; p < mPasses.size(); p++)
+		{
+			auto& pass = mPasses[p];
+			bool split = p > 0 && pass.mDynamicResolution != mPasses[p - 1].mDynamicResolution;
+			for(const auto& access : pass.mAccesses)
+			{
+				//Attachment content is only available to other passes after render pass ends
+				split = split || (p > 0 && attached[access.mResource] && !isAttachmentUsage(access.mUsage));
+			}
+			if(p == 0 || split)
+			{
+				pass.mRenderPass = mRenderPassesCount++;
+				pass.mSubpass = 0;
+				attached.assign(mResources.size(), false);
+			}
+			else
+			{
+				pass.mRenderPass = mPasses[p - 1].mRenderPass;
+				pass.mSubpass = mPasses[p - 1].mSubpass + 1;
+			}
+			for(const auto& access : pass.mAccesses)
+			{
+				attached[access.mResource] = attached[access.mResource] || isAttachmentUsage(access.mUsage);
+			}
+		}
+	}
+
+	void RenderGraph::computeLifetimes()
+	{
+		for(uint32_t r = 0; r < mResources.size(); r++)
+		{
+			auto& resource = mResources[r];
+			resource.mFirstPass = RenderGraphBarrier::EXTERNAL;
+			resource.mLastPass = RenderGraphBarrier::EXTERNAL;
+			resource.mUsage = 0;
+			resource.mLayouts.assign(mPasses.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+			resource.mMemorySlot = RenderGraphResource::NO_MEMORY_SLOT;
+			resource.mAliasPredecessor = RenderGraphBarrier::EXTERNAL;
+
+			bool attachmentsOnly = true;
+			bool written = false;
+			for(uint32_t p = 0; p < mPasses.size(); p++)
+			{
+				const auto usage = findUsage(mPasses[p], r);
+				if(usage == ERenderGraphUsage::Count)
+				{
+					continue;
+				}
+				if(!resource.isUsed())
+				{
+					resource.mFirstPass = p;
+					//Content of transient resource is undefined at frame start
+					if(!resource.mDesc.mExternal && !isWriteUsage(usage))
+					{
+						LOG_WARNING("Render graph resource {} is read in pass {} before it is written",
+							resource.mDesc.mName, mPasses[p].mName);
+					}
+				}
+				resource.mLastPass = p;
+				resource.mUsage |= getUsageImageFlags(usage);
+				resource.mLayouts[p] = getUsageLayout(usage, resource.mDesc.mAspect);
+				attachmentsOnly = attachmentsOnly && isAttachmentUsage(usage);
+				written = written || isWriteUsage(usage);
+			}
+
+			resource.mFinalLayout = resource.isUsed() ? resource.mLayouts[resource.mLastPass] : VK_IMAGE_LAYOUT_UNDEFINED;
+			if(resource.mDesc.mExternal && resource.mDesc.mFinalLayout != VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				resource.mFinalLayout = resource.mDesc.mFinalLayout;
+			}
+
+			//Attachment written and consumed by passes of the same render pass is never stored to memory
+			resource.mLazy = resource.isUsed() && written && attachmentsOnly && !resource.mDesc.mExternal &&
+				mPasses[resource.mFirstPass].mRenderPass == mPasses[resource.mLastPass].mRenderPass;
+			if(resource.mLazy)
+			{
+				resource.mUsage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+			}
+		}
+	}
+
+	void RenderGraph::assignMemorySlots()
+	{
+		//Lazily allocated memory lives in tile memory, external resources are owned by somebody else
+		std::vector<uint32_t> candidates;
+		for(uint32_t r = 0; r < mResources.size(); r++)
+		{
+			const auto& resource = mResources[r];
+			if(resource.isUsed() && !resource.mLazy && !resource.mDesc.mExternal)
+			{
+				candidates.push_back(r);
+			}
+		}
+		std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+			{
+				return mResources[a].mFirstPass < mResources[b].mFirstPass;
+			});
+
+		//Greedy interval partitioning: reuse first slot which is free when resource is born
+		std::vector<std::vector<uint32_t>> slots;
+		for(const auto r : candidates)
+		{
+			auto& resource = mResources[r];
+			uint32_t slot = 0;
+			for(; slot < slots.size(); slot++)
+			{
+				if(mResources[slots[slot].back()].mLastPass < resource.mFirstPass)
+				{
+					break;
+				}
+			}
+			if(slot == slots.size())
+			{
+				slots.push_back({});
+			}
+			resource.mMemorySlot = static_cast<int32_t>(slot);
+			slots[slot].push_back(r);
+		}
+
+		for(const auto& occupants : slots)
+		{
+			//First occupant reuses memory of last occupant of previous frame
+			for(uint32_t i = 0; i < occupants.size() && occupants.size() > 1; i++)
+			{
+				const auto prev = i == 0 ? occupants.back() : occupants[i - 1];
+				mResources[occupants[i]].mAliasPredecessor = prev;
+			}
+		}
+		mMemorySlotsCount = static_cast<uint32_t>(slots.size());
+	}
+
+	void RenderGraph::computeBarriers()
+	{
+		mBarriers.assign(mPasses.size(), {});
+		mFinalBarriers.clear();
+
+		struct AccessState
+		{
+			uint32_t mPass = RenderGraphBarrier::EXTERNAL;
+			ERenderGraphUsage mUsage = ERenderGraphUsage::Count;
+		};
+
+		for(uint32_t r = 0; r < mResources.size(); r++)
+		{
+			const auto& resource = mResources[r];
+			if(!resource.isUsed())
+			{
+				continue;
+			}
+
+			VkImageLayout layout = resource.mDesc.mExternal ? resource.mDesc.mInitialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+			//Last write and reads after it
+			AccessState lastWrite;
+			std::vector<AccessState> reads;
+			//Stages and accesses which already waited for last write or layout transition
+			VkPipelineStageFlags syncedStages = 0;
+			VkAccessFlags syncedAccess = 0;
+
+			for(uint32_t p = resource.mFirstPass; p <= resource.mLastPass; p++)
+			{
+				const auto usage = findUsage(mPasses[p], r);
+				if(usage == ERenderGraphUsage::Count)
+				{
+					continue;
+				}
+
+				RenderGraphBarrier barrier;
+				barrier.mResource = r;
+				barrier.mDstPass = p;
+				barrier.mOldLayout = layout;
+				barrier.mNewLayout = resource.mLayouts[p];
+				barrier.mDstStage = getUsageStage(usage);
+				barrier.mDstAccess = getUsageAccess(usage);
+				const bool transition = layout != barrier.mNewLayout;
+				const size_t barriersCount = mBarriers[p].size();
+
+				if(p == resource.mFirstPass)
+				{
+					if(resource.mDesc.mExternal)
+					{
+						//Wait for acquire semaphore at the same stage
+						barrier.mSrcStage = barrier.mDstStage;
+					}
+					else
+					{
+						//Previous user of the memory: aliased resource or this resource in previous frame
+						const uint32_t prev = resource.mAliasPredecessor != RenderGraphBarrier::EXTERNAL ? resource.mAliasPredecessor : r;
+						const auto& prevResource = mResources[prev];
+						const auto prevUsage = findUsage(mPasses[prevResource.mLastPass], prev);
+						barrier.mSrcPass = prevResource.mLastPass < p ? prevResource.mLastPass : RenderGraphBarrier::EXTERNAL;
+						barrier.mSrcStage = getUsageStage(prevUsage);
+						barrier.mSrcAccess = isWriteUsage(prevUsage) ? getUsageAccess(prevUsage) : 0;
+						//Content is discarded
+						barrier.mOldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					}
+					mBarriers[p].push_back(barrier);
+				}
+				else
+				{
+					const bool synced = (barrier.mDstStage & ~syncedStages) == 0 && (barrier.mDstAccess & ~syncedAccess) == 0;
+					if(!reads.empty() && (isWriteUsage(usage) || transition))
+					{
+						//Write after read and layout change wait for every read since last write in one barrier,
+						//several barriers would repeat layout transition
+						barrier.mSrcPass = reads.back().mPass;
+						for(const auto& read : reads)
+						{
+							barrier.mSrcStage |= getUsageStage(read.mUsage);
+						}
+						mBarriers[p].push_back(barrier);
+					}
+					else if(lastWrite.mPass != RenderGraphBarrier::EXTERNAL && (isWriteUsage(usage) || reads.empty() || !synced))
+					{
+						//Read in the same layout at stage which didn't wait for last write yet needs its own barrier
+						barrier.mSrcPass = lastWrite.mPass;
+						barrier.mSrcStage = getUsageStage(lastWrite.mUsage);
+						barrier.mSrcAccess = getUsageAccess(lastWrite.mUsage);
+						mBarriers[p].push_back(barrier);
+					}
+					//Read in the same layout at already synchronised stage needs no barrier
+				}
+				if(mBarriers[p].size() != barriersCount)
+				{
+					syncedStages = transition ? barrier.mDstStage : syncedStages | barrier.mDstStage;
+					syncedAccess = transition ? barrier.mDstAccess : syncedAccess | barrier.mDstAccess;
+				}
+
+				layout = barrier.mNewLayout;
+				if(isWriteUsage(usage))
+				{
+					lastWrite = { p, usage };
+					reads.clear();
+					syncedStages = 0;
+					syncedAccess = 0;
+				}
+				else
+				{
+					reads.push_back({ p, usage });
+				}
+			}
+
+			if(resource.mDesc.mExternal && layout != resource.mFinalLayout)
+			{
+				const auto usage = findUsage(mPasses[resource.mLastPass], r);
+				RenderGraphBarrier barrier;
+				barrier.mResource = r;
+				barrier.mSrcPass = resource.mLastPass;
+				barrier.mOldLayout = layout;
+				barrier.mNewLayout = resource.mFinalLayout;
+				barrier.mSrcStage = getUsageStage(usage);
+				barrier.mSrcAccess = getUsageAccess(usage);
+				barrier.mDstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+				mFinalBarriers.push_back(barrier);
+			}
+		}
+	}
+}
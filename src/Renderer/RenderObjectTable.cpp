@@ -0,0 +1,120 @@
+#include "Renderer/RenderObjectTable.hpp"
+
+#include <algorithm>
+#include <limits>
+
+using namespace glm;
+
+namespace fre
+{
+	void RenderObjectTable::clear()
+	{
+		mModelIds.clear();
+		mMeshIndices.clear();
+		mTransformIds.clear();
+		mMaterialIds.clear();
+		mFirstIndices.clear();
+		mIndexCounts.clear();
+		mVertexOffsets.clear();
+		mDrawCounts.clear();
+		mFlags.clear();
+		mTransforms.clear();
+		mModelFirstObjects.clear();
+		mModelFirstTransforms.clear();
+	}
+
+	uint32_t RenderObjectTable::addModel(uint32_t modelId, const MeshModel::Ptr& model)
+	{
+		const uint32_t firstObject = size();
+		const uint32_t firstTransform = static_cast<uint32_t>(mTransforms.size());
+		mModelFirstObjects.push_back(firstObject);
+		mModelFirstTransforms.push_back(firstTransform);
+		const mat4& modelMatrix = model->getModelMatrix();
+		const auto& sceneGraph = model->getSceneGraph();
+		const uint32_t nodesCount = sceneGraph.getNodesCount();
+		if(nodesCount == 0)
+		{
+			mTransforms.push_back(modelMatrix);
+		}
+		for(uint32_t node = 0; node < nodesCount; node++)
+		{
+			mTransforms.push_back(modelMatrix * sceneGraph.getWorldTransform(node));
+		}
+
+		const uint8_t modelFlags = model->isVisible() ? RO_VISIBLE : 0;
+		for(uint32_t i = 0; i < model->getMeshCount(); i++)
+		{
+			const auto& mesh = model->getMesh(i);
+			const uint32_t node = model->getMeshNode(i);
+			uint8_t flags = mesh->getVisible() ? modelFlags : 0;
+			if(mesh->hasVisitCallbacks())
+			{
+				flags |= RO_VISIT_CALLBACKS;
+			}
+			if(mesh->hasRecordCallbacks())
+			{
+				flags |= RO_RECORD_CALLBACKS;
+			}
+			if(mesh->getComputeShaderId() != std::numeric_limits<uint32_t>::max())
+			{
+				flags |= RO_COMPUTE;
+			}
+
+			mModelIds.push_back(modelId);
+			mMeshIndices.push_back(i);
+			mTransformIds.push_back(firstTransform + (node != SceneGraph::NO_PARENT && nodesCount > 0 ? node : 0));
+			mMaterialIds.push_back(mesh->getMaterialId());
+			mFirstIndices.push_back(0);
+			mIndexCounts.push_back(mesh->getIndexCount());
+			mVertexOffsets.push_back(0);
+			mDrawCounts.push_back(mesh->hasInstances() ? 1 : mesh->getInstanceCount());
+			mFlags.push_back(flags);
+		}
+
+		return firstObject;
+	}
+
+	uint32_t RenderObjectTable::updateModelTransforms(uint32_t model, const MeshModel::Ptr& meshModel)
+	{
+		const uint32_t firstTransform = mModelFirstTransforms[model];
+		const mat4& modelMatrix = meshModel->getModelMatrix();
+		const auto& sceneGraph = meshModel->getSceneGraph();
+		const uint32_t nodesCount = sceneGraph.getNodesCount();
+		if(nodesCount == 0)
+		{
+			mTransforms[firstTransform] = modelMatrix;
+		}
+		for(uint32_t node = 0; node < nodesCount; node++)
+		{
+			mTransforms[firstTransform + node] = modelMatrix * sceneGraph.getWorldTransform(node);
+		}
+
+		return updateNormalMatrices(firstTransform, firstTransform + std::max(nodesCount, 1u));
+	}
+
+	uint32_t RenderObjectTable::updateNormalMatrices()
+	{
+		return updateNormalMatrices(0, mTransforms.size());
+	}
+
+	uint32_t RenderObjectTable::updateNormalMatrices(size_t first, size_t end)
+	{
+		uint32_t result = 0;
+		const size_t cachedCount = std::min(mNormalSources.size(), mTransforms.size());
+		mNormalSources.resize(mTransforms.size());
+		mNormalMatrices.resize(mTransforms.size());
+		for(size_t i = first; i < end; i++)
+		{
+			//Comparison is much cheaper than inverse
+			if(i < cachedCount && mNormalSources[i] == mTransforms[i])
+			{
+				continue;
+			}
+			mNormalSources[i] = mTransforms[i];
+			mNormalMatrices[i] = fre::getNormalMatrix(mTransforms[i]);
+			result++;
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,23 @@
+#include "Renderer/ShaderVariant.hpp"
+
+namespace fre
+{
+    ShaderSpecialization::ShaderSpecialization(const ShaderVariantKey& key)
+    {
+        //One boolean constant per feature bit, constant_id equals bit index
+        mMapEntries.resize(SF_COUNT);
+        mData.resize(SF_COUNT);
+        for(uint32_t i = 0; i < SF_COUNT; i++)
+        {
+            mMapEntries[i].constantID = i;
+            mMapEntries[i].offset = i * sizeof(VkBool32);
+            mMapEntries[i].size = sizeof(VkBool32);
+            mData[i] = (key.mFeatures & (1u << i)) != 0u ? VK_TRUE : VK_FALSE;
+        }
+
+        mInfo.mapEntryCount = static_cast<uint32_t>(mMapEntries.size());
+        mInfo.pMapEntries = mMapEntries.data();
+        mInfo.dataSize = mData.size() * sizeof(VkBool32);
+        mInfo.pData = mData.data();
+    }
+}
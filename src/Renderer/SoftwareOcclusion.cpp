@@ -0,0 +1,191 @@
+#include "Renderer/SoftwareOcclusion.hpp"
+#include "Renderer/SIMD.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace fre
+{
+	//Coefficients of edge function a * x + b * y + c, positive on the left of edge
+	struct EdgeFunction
+	{
+		EdgeFunction(const glm::vec3& from, const glm::vec3& to)
+			: mA(from.y - to.y)
+			, mB(to.x - from.x)
+			, mC(-(mA * from.x + mB * from.y))
+		{
+		}
+
+		float mA;
+		float mB;
+		float mC;
+	};
+
+	void OcclusionRasterizer::resize(uint32_t width, uint32_t height)
+	{
+		//Rows are processed by 4 pixels
+		const uint32_t newWidth = std::max(getHiZSize(width), 4u);
+		const uint32_t newHeight = getHiZSize(height);
+		if(newWidth == mWidth && newHeight == mHeight)
+		{
+			return;
+		}
+
+		mWidth = newWidth;
+		mHeight = newHeight;
+		mDepth.resize(mWidth * mHeight);
+		clear();
+	}
+
+	void OcclusionRasterizer::clear()
+	{
+		std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+		mTrianglesCount = 0;
+	}
+
+	void OcclusionRasterizer::rasterize(const void* vertices, uint32_t vertexSize, uint32_t verticesCount,
+		const uint32_t* indices, uint32_t indicesCount, const glm::mat4& modelViewProjection)
+	{
+		if(mDepth.empty() || vertexSize < sizeof(glm::vec3))
+		{
+			return;
+		}
+
+		//Shared vertices are transformed once
+		const auto* bytes = static_cast<const uint8_t*>(vertices);
+		mClipPositions.resize(verticesCount);
+		for(uint32_t i = 0; i < verticesCount; i++)
+		{
+			glm::vec3 position;
+			memcpy(&position, bytes + i * vertexSize, sizeof(position));
+			mClipPositions[i] = modelViewProjection * glm::vec4(position, 1.0f);
+		}
+
+		const uint32_t count = indices != nullptr ? indicesCount : verticesCount;
+		for(uint32_t i = 0; i + 2 < count; i += 3)
+		{
+			const uint32_t i0 = indices != nullptr ? indices[i] : i;
+			const uint32_t i1 = indices != nullptr ? indices[i + 1] : i + 1;
+			const uint32_t i2 = indices != nullptr ? indices[i + 2] : i + 2;
+			if(i0 < verticesCount && i1 < verticesCount && i2 < verticesCount)
+			{
+				clipAndRasterize(mClipPositions[i0], mClipPositions[i1], mClipPositions[i2]);
+			}
+		}
+	}
+
+	void OcclusionRasterizer::buildPyramid(HiZPyramid& pyramid) const
+	{
+		pyramid.build(mDepth.data(), mWidth, mHeight, mWidth, mHeight);
+	}
+
+	void OcclusionRasterizer::clipAndRasterize(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+	{
+		//Near plane is at zero depth in Vulkan clip space, clipped triangle has up to 4 vertices
+		const glm::vec4 input[3] = { a, b, c };
+		glm::vec4 clipped[4];
+		uint32_t clippedCount = 0;
+		for(uint32_t i = 0; i < 3; i++)
+		{
+			const glm::vec4& current = input[i];
+			const glm::vec4& next = input[(i + 1) % 3];
+			if(current.z >= 0.0f)
+			{
+				clipped[clippedCount++] = current;
+			}
+			if((current.z >= 0.0f) != (next.z >= 0.0f))
+			{
+				const float t = current.z / (current.z - next.z);
+				clipped[clippedCount++] = current + (next - current) * t;
+			}
+		}
+		if(clippedCount < 3)
+		{
+			return;
+		}
+
+		glm::vec3 screen[4];
+		for(uint32_t i = 0; i < clippedCount; i++)
+		{
+			const glm::vec4& position = clipped[i];
+			if(position.w <= 0.0f)
+			{
+				return;
+			}
+			screen[i] = glm::vec3(
+				(position.x / position.w * 0.5f + 0.5f) * mWidth,
+				(position.y / position.w * 0.5f + 0.5f) * mHeight,
+				position.z / position.w);
+		}
+		rasterizeTriangle(screen[0], screen[1], screen[2]);
+		if(clippedCount == 4)
+		{
+			rasterizeTriangle(screen[0], screen[2], screen[3]);
+		}
+	}
+
+	void OcclusionRasterizer::rasterizeTriangle(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+	{
+		float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+		if(!(area != 0.0f))
+		{
+			return;
+		}
+		//Both windings are rasterized: occluders are usually closed, nearest side wins depth test anyway
+		if(area < 0.0f)
+		{
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		const float minX = std::max(std::floor(std::min({ v0.x, v1.x, v2.x })), 0.0f);
+		const float maxX = std::min(std::ceil(std::max({ v0.x, v1.x, v2.x })), mWidth - 1.0f);
+		const float minY = std::max(std::floor(std::min({ v0.y, v1.y, v2.y })), 0.0f);
+		const float maxY = std::min(std::ceil(std::max({ v0.y, v1.y, v2.y })), mHeight - 1.0f);
+		if(minX > maxX || minY > maxY)
+		{
+			return;
+		}
+		mTrianglesCount++;
+
+		//Weight of vertex is edge function of opposite edge, sampled at pixel centers
+		const EdgeFunction edge0(v1, v2);
+		const EdgeFunction edge1(v2, v0);
+		const EdgeFunction edge2(v0, v1);
+		const float inverseArea = 1.0f / area;
+		const SimdFloat4 depth0 = simdSet(v0.z);
+		const SimdFloat4 depthStep1 = simdSet((v1.z - v0.z) * inverseArea);
+		const SimdFloat4 depthStep2 = simdSet((v2.z - v0.z) * inverseArea);
+		const SimdFloat4 zero = simdSet(0.0f);
+
+		//Blocks of 4 pixels start at multiples of 4, width is multiple of 4 too
+		const uint32_t firstX = static_cast<uint32_t>(minX) & ~3u;
+		const uint32_t lastX = static_cast<uint32_t>(maxX);
+		for(uint32_t y = static_cast<uint32_t>(minY); y <= static_cast<uint32_t>(maxY); y++)
+		{
+			const float centerY = y + 0.5f;
+			const SimdFloat4 row0 = simdSet(edge0.mB * centerY + edge0.mC);
+			const SimdFloat4 row1 = simdSet(edge1.mB * centerY + edge1.mC);
+			const SimdFloat4 row2 = simdSet(edge2.mB * centerY + edge2.mC);
+			float* depthRow = mDepth.data() + y * mWidth;
+			for(uint32_t x = firstX; x <= lastX; x += 4)
+			{
+				const SimdFloat4 centerX = simdRamp(x + 0.5f);
+				const SimdFloat4 w0 = simdAdd(simdMul(simdSet(edge0.mA), centerX), row0);
+				const SimdFloat4 w1 = simdAdd(simdMul(simdSet(edge1.mA), centerX), row1);
+				const SimdFloat4 w2 = simdAdd(simdMul(simdSet(edge2.mA), centerX), row2);
+				const SimdFloat4 inside = simdAnd(simdAnd(simdGreaterEqual(w0, zero), simdGreaterEqual(w1, zero)),
+					simdGreaterEqual(w2, zero));
+				if(!simdAny(inside))
+				{
+					continue;
+				}
+
+				const SimdFloat4 depth = simdAdd(depth0, simdAdd(simdMul(w1, depthStep1), simdMul(w2, depthStep2)));
+				const SimdFloat4 stored = simdLoad(depthRow + x);
+				simdStore(depthRow + x, simdSelect(inside, simdMin(stored, depth), stored));
+			}
+		}
+	}
+}
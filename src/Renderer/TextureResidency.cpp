@@ -0,0 +1,235 @@
+#include "Renderer/TextureResidency.hpp"
+
+#include <algorithm>
+
+namespace fre
+{
+	uint32_t TextureResidency::addTexture(uint32_t texture, const std::vector<uint64_t>& levelSizes, uint32_t tailLevel)
+	{
+		removeTexture(texture);
+		if(texture >= mTextures.size())
+		{
+			mTextures.resize(texture + 1);
+		}
+
+		auto& entry = mTextures[texture];
+		entry.mLevelSizes = levelSizes;
+		entry.mTailLevel = levelSizes.empty() ? 0 : std::min(tailLevel, static_cast<uint32_t>(levelSizes.size() - 1));
+		entry.mResidentLevel = entry.mTailLevel;
+		entry.mRequestedLevel = entry.mTailLevel;
+		entry.mRequestFrame = 0;
+		entry.mAdded = true;
+		for(uint32_t level = entry.mTailLevel; level < levelSizes.size(); level++)
+		{
+			mResidentSize += levelSizes[level];
+			mMinimumSize += levelSizes[level];
+		}
+		mTexturesCount++;
+
+		return entry.mTailLevel;
+	}
+
+	void TextureResidency::removeTexture(uint32_t texture)
+	{
+		if(!hasTexture(texture))
+		{
+			return;
+		}
+
+		auto& entry = mTextures[texture];
+		for(uint32_t level = entry.mResidentLevel; level < entry.mLevelSizes.size(); level++)
+		{
+			mResidentSize -= entry.mLevelSizes[level];
+		}
+		for(uint32_t level = entry.mTailLevel; level < entry.mLevelSizes.size(); level++)
+		{
+			mMinimumSize -= entry.mLevelSizes[level];
+		}
+		entry = Texture();
+		mTexturesCount--;
+	}
+
+	void TextureResidency::request(uint32_t texture, uint32_t level, uint64_t frame)
+	{
+		if(!hasTexture(texture))
+		{
+			return;
+		}
+
+		auto& entry = mTextures[texture];
+		level = std::min(level, entry.mTailLevel);
+		if(frame > entry.mRequestFrame)
+		{
+			entry.mRequestedLevel = level;
+			entry.mRequestFrame = frame;
+		}
+		else if(frame == entry.mRequestFrame)
+		{
+			entry.mRequestedLevel = std::min(entry.mRequestedLevel, level);
+		}
+	}
+
+	void TextureResidency::setResidentLevel(uint32_t texture, uint32_t level, std::vector<TextureResidencyChange>& changes)
+	{
+		auto& entry = mTextures[texture];
+		if(level < entry.mResidentLevel)
+		{
+			for(uint32_t i = level; i < entry.mResidentLevel; i++)
+			{
+				mResidentSize += entry.mLevelSizes[i];
+			}
+		}
+		else
+		{
+			for(uint32_t i = entry.mResidentLevel; i < level; i++)
+			{
+				mResidentSize -= entry.mLevelSizes[i];
+			}
+			mEvicted[texture] = 1;
+		}
+
+		//Texture changes once per update, from its level before update to the last one
+		auto found = std::find_if(changes.begin(), changes.end(),
+			[texture](const TextureResidencyChange& change) { return change.mTexture == texture; });
+		if(found == changes.end())
+		{
+			changes.push_back({ texture, entry.mResidentLevel, level });
+		}
+		else
+		{
+			found->mToLevel = level;
+		}
+		entry.mResidentLevel = level;
+	}
+
+	bool TextureResidency::freeMemory(uint64_t neededSize, uint64_t frame, std::vector<TextureResidencyChange>& changes)
+	{
+		const auto fits = [this, neededSize]() { return neededSize <= mBudget && mResidentSize <= mBudget - neededSize; };
+		if(fits())
+		{
+			return true;
+		}
+
+		//Nothing is dropped for load if everything that can go isn't enough for it
+		if(neededSize > 0)
+		{
+			uint64_t evictableSize = 0;
+			for(const uint32_t texture : mVictims)
+			{
+				const auto& entry = mTextures[texture];
+				const uint32_t lowest = entry.mRequestFrame < frame ? entry.mTailLevel : entry.mRequestedLevel;
+				for(uint32_t level = entry.mResidentLevel; level < lowest; level++)
+				{
+					evictableSize += entry.mLevelSizes[level];
+				}
+			}
+			if(neededSize > mBudget || mResidentSize - evictableSize > mBudget - neededSize)
+			{
+				return false;
+			}
+		}
+
+		//Textures are sorted from least recently requested one, levels nobody samples go first
+		for(const bool requestedLevels : { false, true })
+		{
+			for(const uint32_t texture : mVictims)
+			{
+				if(fits())
+				{
+					return true;
+				}
+
+				const auto& entry = mTextures[texture];
+				if(requestedLevels && entry.mRequestFrame >= frame)
+				{
+					break;
+				}
+				const uint32_t lowest = requestedLevels ? entry.mTailLevel : entry.mRequestedLevel;
+				while(entry.mResidentLevel < lowest && !fits())
+				{
+					setResidentLevel(texture, entry.mResidentLevel + 1, changes);
+				}
+			}
+		}
+
+		return fits();
+	}
+
+	std::vector<TextureResidencyChange> TextureResidency::update(uint64_t frame)
+	{
+		std::vector<TextureResidencyChange> changes;
+		mEvicted.assign(mTextures.size(), 0);
+		mVictims.clear();
+		std::vector<uint32_t> candidates;
+		for(uint32_t texture = 0; texture < mTextures.size(); texture++)
+		{
+			const auto& entry = mTextures[texture];
+			if(!entry.mAdded)
+			{
+				continue;
+			}
+			mVictims.push_back(texture);
+			if(entry.mRequestedLevel < entry.mResidentLevel && entry.mRequestFrame <= frame)
+			{
+				candidates.push_back(texture);
+			}
+		}
+		std::stable_sort(mVictims.begin(), mVictims.end(), [this](uint32_t a, uint32_t b)
+			{
+				return mTextures[a].mRequestFrame < mTextures[b].mRequestFrame;
+			});
+		//Most recent requests are loaded first, textures needing most levels first among them
+		std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+			{
+				const auto& first = mTextures[a];
+				const auto& second = mTextures[b];
+				if(first.mRequestFrame != second.mRequestFrame)
+				{
+					return first.mRequestFrame > second.mRequestFrame;
+				}
+				return first.mResidentLevel - first.mRequestedLevel > second.mResidentLevel - second.mRequestedLevel;
+			});
+
+		//Lowered budget drops levels of any texture
+		freeMemory(0, UINT64_MAX, changes);
+
+		uint64_t loadedSize = 0;
+		for(const uint32_t texture : candidates)
+		{
+			const auto& entry = mTextures[texture];
+			if(mEvicted[texture] != 0)
+			{
+				continue;
+			}
+			while(entry.mResidentLevel > entry.mRequestedLevel)
+			{
+				const uint64_t size = entry.mLevelSizes[entry.mResidentLevel - 1];
+				//First level is loaded whatever its size is, so large levels don't wait forever
+				if(mLoadLimit != 0 && loadedSize != 0 && loadedSize + size > mLoadLimit)
+				{
+					return changes;
+				}
+				if(!freeMemory(size, entry.mRequestFrame, changes))
+				{
+					break;
+				}
+				setResidentLevel(texture, entry.mResidentLevel - 1, changes);
+				loadedSize += size;
+			}
+		}
+
+		return changes;
+	}
+
+	void TextureResidency::revert(const TextureResidencyChange& change)
+	{
+		if(!hasTexture(change.mTexture) || mTextures[change.mTexture].mResidentLevel != change.mToLevel)
+		{
+			return;
+		}
+
+		std::vector<TextureResidencyChange> changes;
+		mEvicted.assign(mTextures.size(), 0);
+		setResidentLevel(change.mTexture, change.mFromLevel, changes);
+	}
+}
@@ -1,4 +1,5 @@
 #include "Renderer/VulkanAttachment.hpp"
+#include "Renderer/RenderGraph.hpp"
 #include "Renderer/VulkanImage.hpp"
 #include "Utilities.hpp"
 
@@ -93,7 +94,7 @@ namespace fre
 
         //Create color buffer image
 		uint32_t actualImageSize;
-        mImage = createImage(
+        mImage = fre::createImage(
             mainDevice,
             swapChainExtent.width, swapChainExtent.height,
             imageFormat, VK_IMAGE_TILING_OPTIMAL,
@@ -102,17 +103,96 @@ namespace fre
             &mImageMemory, actualImageSize);
 
         //Create Color Image View
-        mImageView = createImageView(
-            mainDevice.logicalDevice, mImage, imageFormat,
-            getImageAspectFlags(attachmentKind, imageFormat));
+        mFormat = imageFormat;
+        mAspect = getImageAspectFlags(attachmentKind, imageFormat);
+        mImageView = fre::createImageView(
+            mainDevice.logicalDevice, mImage, mFormat, mAspect);
 		
 		LOG_INFO("Attachment created");
 	}
 
+	static bool hasMemoryType(VkPhysicalDevice physicalDevice, uint32_t allowedTypes, VkMemoryPropertyFlags properties)
+	{
+		VkPhysicalDeviceMemoryProperties memoryProperties;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((allowedTypes & (1u << i)) != 0
+				&& (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void VulkanAttachment::createImage(const MainDevice& mainDevice, const RenderGraphResource& resource, VkExtent2D extent)
+	{
+		LOG_INFO("Create render graph attachment {}", resource.mDesc.mName);
+
+		mFormat = resource.mDesc.mFormat;
+		mAspect = resource.mDesc.mAspect;
+
+		VkImageCreateInfo imageCreateInfo = {};
+		imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageCreateInfo.extent.width = extent.width;
+		imageCreateInfo.extent.height = extent.height;
+		imageCreateInfo.extent.depth = 1;
+		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.arrayLayers = 1;
+		imageCreateInfo.format = mFormat;
+		imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageCreateInfo.usage = resource.mUsage;
+		imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VK_CHECK(vkCreateImage(mainDevice.logicalDevice, &imageCreateInfo, nullptr, &mImage));
+	}
+
+	void VulkanAttachment::allocateMemory(const MainDevice& mainDevice, bool lazy)
+	{
+		VkMemoryRequirements memoryRequirement;
+		vkGetImageMemoryRequirements(mainDevice.logicalDevice, mImage, &memoryRequirement);
+
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		//Tile based GPUs never back lazily allocated memory if content stays in tile memory
+		if(lazy && hasMemoryType(mainDevice.physicalDevice, memoryRequirement.memoryTypeBits,
+			VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT))
+		{
+			properties = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+		}
+
+		VkMemoryAllocateInfo memoryAllocInfo = {};
+		memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryAllocInfo.allocationSize = memoryRequirement.size;
+		memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(mainDevice.physicalDevice, memoryRequirement.memoryTypeBits, properties);
+
+		VK_CHECK(vkAllocateMemory(mainDevice.logicalDevice, &memoryAllocInfo, nullptr, &mImageMemory));
+		bindMemory(mainDevice.logicalDevice, mImageMemory);
+	}
+
+	void VulkanAttachment::bindMemory(VkDevice logicalDevice, VkDeviceMemory memory)
+	{
+		VK_CHECK(vkBindImageMemory(logicalDevice, mImage, memory, 0));
+	}
+
+	void VulkanAttachment::createImageView(VkDevice logicalDevice)
+	{
+		mImageView = fre::createImageView(logicalDevice, mImage, mFormat, mAspect);
+	}
+
     void fre::VulkanAttachment::destroy(VkDevice logicalDevice)
     {
         vkDestroyImageView(logicalDevice, mImageView, nullptr);
         vkDestroyImage(logicalDevice, mImage, nullptr);
+        //Aliased attachments don't own memory
         vkFreeMemory(logicalDevice, mImageMemory, nullptr);
+        mImageView = VK_NULL_HANDLE;
+        mImage = VK_NULL_HANDLE;
+        mImageMemory = VK_NULL_HANDLE;
     }
 }
@@ -35,7 +35,7 @@ namespace fre
     }
 
 	VulkanBuffer VulkanBufferManager::createStagingBuffer(const MainDevice& mainDevice, VkQueue transferQueue,
-		VkCommandPool transferCommandPool, const void* data, size_t size)
+		VulkanOneTimeCommandPool& transferCommandPool, const void* data, size_t size)
 	{
 		VulkanBuffer result;
 
@@ -62,7 +62,7 @@ namespace fre
     
     //Data size in bytes. Example: sizeof(Vertex) * mVertices.size();
     const VulkanBuffer& VulkanBufferManager::createBuffer(const MainDevice& mainDevice, VkQueue transferQueue,
-		VkCommandPool transferCommandPool, VkBufferUsageFlags bufferUsage,
+		VulkanOneTimeCommandPool& transferCommandPool, VkBufferUsageFlags bufferUsage,
 		VkMemoryPropertyFlags memoryFlags, const void* data, size_t size)
 	{
 		//Temporary buffer to "stage" vertex data before transferring to GPU
@@ -0,0 +1,427 @@
+#include "Renderer/VulkanCullingPass.hpp"
+#include "Renderer/VulkanShader.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+
+namespace fre
+{
+	static const uint32_t CULL_GROUP_SIZE = 64;
+	static const uint32_t HIZ_GROUP_SIZE = 8;
+
+	struct HiZSizes
+	{
+		uint32_t mSrcWidth = 0;
+		uint32_t mSrcHeight = 0;
+		uint32_t mDstWidth = 0;
+		uint32_t mDstHeight = 0;
+	};
+
+	static VulkanDescriptorSetLayoutInfo getLayoutInfo(const std::vector<VkDescriptorType>& types)
+	{
+		VulkanDescriptorSetLayoutInfo result;
+		for(uint32_t i = 0; i < types.size(); i++)
+		{
+			result.mDescriptorTypes.push_back(types[i]);
+			result.mBindings.push_back(i);
+			result.mDescriptorCount.push_back(1);
+			result.mStageFlags.push_back(VK_SHADER_STAGE_COMPUTE_BIT);
+		}
+
+		return result;
+	}
+
+	static std::vector<VkDescriptorSet> allocateDescriptorSets(VkDevice logicalDevice, VkDescriptorPool pool,
+		VkDescriptorSetLayout layout, uint32_t count)
+	{
+		std::vector<VkDescriptorSet> result(count, VK_NULL_HANDLE);
+		if(count == 0)
+		{
+			return result;
+		}
+
+		std::vector<VkDescriptorSetLayout> layouts(count, layout);
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = pool;
+		allocInfo.descriptorSetCount = count;
+		allocInfo.pSetLayouts = layouts.data();
+		VK_CHECK(vkAllocateDescriptorSets(logicalDevice, &allocInfo, result.data()));
+
+		return result;
+	}
+
+	static void writeImages(VkDevice logicalDevice, VkDescriptorSet set, VkImageView src, VkImageLayout srcLayout,
+		VkSampler sampler, VkImageView dst)
+	{
+		VkDescriptorImageInfo srcInfo = { sampler, src, srcLayout };
+		VkDescriptorImageInfo dstInfo = { VK_NULL_HANDLE, dst, VK_IMAGE_LAYOUT_GENERAL };
+		VkWriteDescriptorSet writes[2] = {};
+		for(uint32_t i = 0; i < 2; i++)
+		{
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = set;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+		}
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &srcInfo;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &dstInfo;
+		vkUpdateDescriptorSets(logicalDevice, 2, writes, 0, nullptr);
+	}
+
+	static VkImageView createLevelView(VkDevice logicalDevice, VkImage image, uint32_t firstLevel, uint32_t levelsCount)
+	{
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = firstLevel;
+		viewInfo.subresourceRange.levelCount = levelsCount;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		VkImageView result = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateImageView(logicalDevice, &viewInfo, nullptr, &result));
+
+		return result;
+	}
+
+	static void computeBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+		VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	bool VulkanCullingPass::create(const MainDevice& mainDevice, uint32_t regionsCount, VkSampler sampler,
+		VkPipelineCache pipelineCache)
+	{
+		mLogicalDevice = mainDevice.logicalDevice;
+		mSampler = sampler;
+
+		VulkanShader cullShader;
+		VulkanShader hiZShader;
+		cullShader.create(mLogicalDevice, "Shaders/cull.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		hiZShader.create(mLogicalDevice, "Shaders/hiZ.comp.spv", VK_SHADER_STAGE_COMPUTE_BIT);
+		if(cullShader.mShaderModule == VK_NULL_HANDLE || hiZShader.mShaderModule == VK_NULL_HANDLE)
+		{
+			cullShader.destroy(mLogicalDevice);
+			hiZShader.destroy(mLogicalDevice);
+			return false;
+		}
+
+		mCullLayout.create(mLogicalDevice, getLayoutInfo({
+			VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER }));
+		mHiZLayout.create(mLogicalDevice, getLayoutInfo({
+			VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			VK_DESCRIPTOR_TYPE_STORAGE_IMAGE }));
+
+		mCullPipeline.createComputePipeline(mLogicalDevice, cullShader, { mCullLayout.mDescriptorSetLayout }, {}, pipelineCache);
+		VkPushConstantRange sizesRange = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZSizes) };
+		mHiZPipeline.createComputePipeline(mLogicalDevice, hiZShader, { mHiZLayout.mDescriptorSetLayout }, { sizesRange }, pipelineCache);
+
+		mCullDescriptorPool.create(mLogicalDevice, regionsCount, {
+			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, regionsCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5 * regionsCount },
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, regionsCount } });
+		mCullDescriptorSets = allocateDescriptorSets(mLogicalDevice, mCullDescriptorPool.mDescriptorPool,
+			mCullLayout.mDescriptorSetLayout, regionsCount);
+
+		mDataBuffer.create(mainDevice, sizeof(CullingData), regionsCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+		LOG_INFO("Culling pass created");
+
+		return true;
+	}
+
+	void VulkanCullingPass::destroy(VkDevice logicalDevice)
+	{
+		destroyHiZ(logicalDevice);
+		mCullPipeline.destroy(logicalDevice);
+		mCullPipeline = VulkanPipeline();
+		mHiZPipeline.destroy(logicalDevice);
+		mHiZPipeline = VulkanPipeline();
+		mCullDescriptorPool.destroy(logicalDevice);
+		mCullDescriptorPool.mDescriptorPool = VK_NULL_HANDLE;
+		mCullDescriptorSets.clear();
+		mCullLayout.destroy(logicalDevice);
+		mCullLayout.mDescriptorSetLayout = VK_NULL_HANDLE;
+		mHiZLayout.destroy(logicalDevice);
+		mHiZLayout.mDescriptorSetLayout = VK_NULL_HANDLE;
+
+		mDrawsBuffer.destroy(logicalDevice);
+		mDataBuffer.destroy(logicalDevice);
+		mCountsBuffer.destroy(logicalDevice);
+		vkDestroyBuffer(logicalDevice, mCulledCommandsBuffer, nullptr);
+		vkFreeMemory(logicalDevice, mCulledCommandsMemory, nullptr);
+		mCulledCommandsBuffer = VK_NULL_HANDLE;
+		mCulledCommandsMemory = VK_NULL_HANDLE;
+		mCulledCommandsRegionSize = 0;
+	}
+
+	void VulkanCullingPass::createHiZ(const MainDevice& mainDevice, VkExtent2D extent, const std::vector<VkImageView>& depthViews)
+	{
+		mHiZWidth = getHiZSize(extent.width);
+		mHiZHeight = getHiZSize(extent.height);
+		const uint32_t levelsCount = getHiZLevelsCount(mHiZWidth, mHiZHeight);
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { mHiZWidth, mHiZHeight, 1 };
+		imageInfo.mipLevels = levelsCount;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VK_CHECK(vkCreateImage(mainDevice.logicalDevice, &imageInfo, nullptr, &mHiZImage));
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(mainDevice.logicalDevice, mHiZImage, &memoryRequirements);
+		VkMemoryAllocateInfo memoryAllocInfo = {};
+		memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memoryAllocInfo.allocationSize = memoryRequirements.size;
+		memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(mainDevice.physicalDevice, memoryRequirements.memoryTypeBits,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VK_CHECK(vkAllocateMemory(mainDevice.logicalDevice, &memoryAllocInfo, nullptr, &mHiZMemory));
+		VK_CHECK(vkBindImageMemory(mainDevice.logicalDevice, mHiZImage, mHiZMemory, 0));
+
+		mHiZView = createLevelView(mainDevice.logicalDevice, mHiZImage, 0, levelsCount);
+		for(uint32_t level = 0; level < levelsCount; level++)
+		{
+			mHiZLevelViews.push_back(createLevelView(mainDevice.logicalDevice, mHiZImage, level, 1));
+		}
+		mHiZTransitioned = false;
+		mHiZValid = false;
+
+		if(depthViews.empty())
+		{
+			return;
+		}
+
+		const uint32_t setsCount = static_cast<uint32_t>(depthViews.size()) + levelsCount - 1;
+		mHiZDescriptorPool.create(mainDevice.logicalDevice, setsCount, {
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setsCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setsCount } });
+		mHiZDepthDescriptorSets = allocateDescriptorSets(mainDevice.logicalDevice, mHiZDescriptorPool.mDescriptorPool,
+			mHiZLayout.mDescriptorSetLayout, static_cast<uint32_t>(depthViews.size()));
+		for(uint32_t i = 0; i < depthViews.size(); i++)
+		{
+			writeImages(mainDevice.logicalDevice, mHiZDepthDescriptorSets[i], depthViews[i],
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, mSampler, mHiZLevelViews[0]);
+		}
+		mHiZLevelDescriptorSets = allocateDescriptorSets(mainDevice.logicalDevice, mHiZDescriptorPool.mDescriptorPool,
+			mHiZLayout.mDescriptorSetLayout, levelsCount - 1);
+		for(uint32_t level = 1; level < levelsCount; level++)
+		{
+			writeImages(mainDevice.logicalDevice, mHiZLevelDescriptorSets[level - 1], mHiZLevelViews[level - 1],
+				VK_IMAGE_LAYOUT_GENERAL, mSampler, mHiZLevelViews[level]);
+		}
+
+		LOG_INFO("Hi-Z pyramid created: {}x{}, levels {}", mHiZWidth, mHiZHeight, levelsCount);
+	}
+
+	void VulkanCullingPass::destroyHiZ(VkDevice logicalDevice)
+	{
+		mHiZDescriptorPool.destroy(logicalDevice);
+		mHiZDescriptorPool.mDescriptorPool = VK_NULL_HANDLE;
+		mHiZDepthDescriptorSets.clear();
+		mHiZLevelDescriptorSets.clear();
+		for(auto view : mHiZLevelViews)
+		{
+			vkDestroyImageView(logicalDevice, view, nullptr);
+		}
+		mHiZLevelViews.clear();
+		vkDestroyImageView(logicalDevice, mHiZView, nullptr);
+		vkDestroyImage(logicalDevice, mHiZImage, nullptr);
+		vkFreeMemory(logicalDevice, mHiZMemory, nullptr);
+		mHiZView = VK_NULL_HANDLE;
+		mHiZImage = VK_NULL_HANDLE;
+		mHiZMemory = VK_NULL_HANDLE;
+		mHiZValid = false;
+	}
+
+	bool VulkanCullingPass::reserve(const MainDevice& mainDevice, VulkanDeletionQueue& deletionQueue, uint32_t drawsCount, uint32_t batchesCount)
+	{
+		const uint32_t regionsCount = static_cast<uint32_t>(mCullDescriptorSets.size());
+		const VkDeviceSize drawsSize = drawsCount * sizeof(CullingDraw);
+		const VkDeviceSize countsSize = batchesCount * sizeof(uint32_t);
+		if(mDrawsBuffer.getRegionSize() >= drawsSize && mCountsBuffer.getRegionSize() >= countsSize)
+		{
+			return false;
+		}
+
+		if(mDrawsBuffer.isCreated())
+		{
+			//Command buffers in flight may still read old buffers
+			deletionQueue.push([logicalDevice = mainDevice.logicalDevice, drawsBuffer = mDrawsBuffer, countsBuffer = mCountsBuffer,
+				commandsBuffer = mCulledCommandsBuffer, commandsMemory = mCulledCommandsMemory]() mutable
+				{
+					drawsBuffer.destroy(logicalDevice);
+					countsBuffer.destroy(logicalDevice);
+					vkDestroyBuffer(logicalDevice, commandsBuffer, nullptr);
+					vkFreeMemory(logicalDevice, commandsMemory, nullptr);
+				});
+			mDrawsBuffer = VulkanStreamBuffer();
+			mCountsBuffer = VulkanStreamBuffer();
+		}
+
+		//Grow with reserve, so scene changes don't stall every frame
+		const uint32_t reservedDraws = drawsCount + drawsCount / 2;
+		const uint32_t reservedBatches = batchesCount + batchesCount / 2;
+		mDrawsBuffer.create(mainDevice, reservedDraws * sizeof(CullingDraw), regionsCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		mCountsBuffer.create(mainDevice, reservedBatches * sizeof(uint32_t), regionsCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		//Survivors are only written and read by device
+		mCulledCommandsRegionSize = mDrawsBuffer.getRegionSize() / sizeof(CullingDraw) * sizeof(VkDrawIndexedIndirectCommand);
+		mCulledCommandsRegionSize = alignedSize(static_cast<uint32_t>(mCulledCommandsRegionSize), STREAM_BUFFER_ALIGNMENT);
+		fre::createBuffer(mainDevice, mCulledCommandsRegionSize * regionsCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+			&mCulledCommandsBuffer, nullptr, &mCulledCommandsMemory);
+
+		return true;
+	}
+
+	void VulkanCullingPass::updateDraws(uint32_t region, const std::vector<CullingDraw>& draws, uint32_t version)
+	{
+		mDrawsBuffer.update(region, draws.data(), draws.size() * sizeof(CullingDraw), version);
+	}
+
+	CullingData* VulkanCullingPass::getData(uint32_t region)
+	{
+		return static_cast<CullingData*>(mDataBuffer.getRegionData(region));
+	}
+
+	const uint32_t* VulkanCullingPass::getCounts(uint32_t region)
+	{
+		return static_cast<const uint32_t*>(mCountsBuffer.getRegionData(region));
+	}
+
+	void VulkanCullingPass::transitionHiZ(VkCommandBuffer commandBuffer)
+	{
+		if(mHiZTransitioned)
+		{
+			return;
+		}
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = mHiZImage;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+		mHiZTransitioned = true;
+	}
+
+	void VulkanCullingPass::recordCulling(VkCommandBuffer commandBuffer, uint32_t region, uint32_t drawsCount, uint32_t batchesCount,
+		VkDescriptorBufferInfo commands, VkDescriptorBufferInfo instances)
+	{
+		transitionHiZ(commandBuffer);
+
+		VkDescriptorBufferInfo bufferInfos[] =
+		{
+			{ mDataBuffer.mBuffer, mDataBuffer.getOffset(region), sizeof(CullingData) },
+			{ mDrawsBuffer.mBuffer, mDrawsBuffer.getOffset(region), mDrawsBuffer.getRegionSize() },
+			instances,
+			commands,
+			{ mCulledCommandsBuffer, getCulledCommandsOffset(region), mCulledCommandsRegionSize },
+			{ mCountsBuffer.mBuffer, mCountsBuffer.getOffset(region), mCountsBuffer.getRegionSize() }
+		};
+		VkDescriptorImageInfo hiZInfo = { mSampler, mHiZView, VK_IMAGE_LAYOUT_GENERAL };
+		VkWriteDescriptorSet writes[7] = {};
+		for(uint32_t i = 0; i < 7; i++)
+		{
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = mCullDescriptorSets[region];
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = i < 6 ? &bufferInfos[i] : nullptr;
+		}
+		writes[6].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[6].pImageInfo = &hiZInfo;
+		//Set of region is not used by any command buffer in flight
+		vkUpdateDescriptorSets(mLogicalDevice, 7, writes, 0, nullptr);
+
+		vkCmdFillBuffer(commandBuffer, mCountsBuffer.mBuffer, mCountsBuffer.getOffset(region), batchesCount * sizeof(uint32_t), 0);
+		//Counts are reset, pyramid of previous frame is written. Depth attachment is not overwritten
+		//by this frame until pyramid building of frame which used it before is done
+		computeBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline.mPipeline);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline.mPipelineLayout,
+			0, 1, &mCullDescriptorSets[region], 0, nullptr);
+		vkCmdDispatch(commandBuffer, (drawsCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+		computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+	}
+
+	void VulkanCullingPass::recordHiZ(VkCommandBuffer commandBuffer, uint32_t region, VkExtent2D depthExtent, const glm::mat4& viewProjection)
+	{
+		if(region >= mHiZDepthDescriptorSets.size())
+		{
+			return;
+		}
+		transitionHiZ(commandBuffer);
+
+		//Depth writes are done and culling of this frame finished reading pyramid
+		computeBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_ACCESS_SHADER_READ_BIT);
+
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mHiZPipeline.mPipeline);
+		HiZSizes sizes;
+		sizes.mSrcWidth = depthExtent.width;
+		sizes.mSrcHeight = depthExtent.height;
+		for(uint32_t level = 0; level < mHiZLevelViews.size(); level++)
+		{
+			sizes.mDstWidth = std::max(mHiZWidth >> level, 1u);
+			sizes.mDstHeight = std::max(mHiZHeight >> level, 1u);
+			const VkDescriptorSet set = level == 0 ? mHiZDepthDescriptorSets[region] : mHiZLevelDescriptorSets[level - 1];
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mHiZPipeline.mPipelineLayout,
+				0, 1, &set, 0, nullptr);
+			vkCmdPushConstants(commandBuffer, mHiZPipeline.mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(HiZSizes), &sizes);
+			vkCmdDispatch(commandBuffer,
+				(sizes.mDstWidth + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+				(sizes.mDstHeight + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+			computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+			sizes.mSrcWidth = sizes.mDstWidth;
+			sizes.mSrcHeight = sizes.mDstHeight;
+		}
+
+		mHiZValid = true;
+		mHiZViewProjection = viewProjection;
+	}
+}
@@ -0,0 +1,57 @@
+#include "Renderer/VulkanDeletionQueue.hpp"
+
+#include <algorithm>
+
+namespace fre
+{
+	void VulkanDeletionQueue::create(uint32_t framesCount)
+	{
+		mFrames.resize(std::max(framesCount, 1u));
+		mCurrentFrame = 0;
+	}
+
+	void VulkanDeletionQueue::destroy()
+	{
+		for(uint32_t i = 0; i < mFrames.size(); i++)
+		{
+			//Oldest releases first, as they would retire
+			retire((mCurrentFrame + 1 + i) % mFrames.size());
+		}
+	}
+
+	void VulkanDeletionQueue::beginFrame(uint32_t frame)
+	{
+		retire(frame);
+		mCurrentFrame = frame;
+	}
+
+	void VulkanDeletionQueue::push(Deleter&& deleter)
+	{
+		if(mFrames.empty())
+		{
+			//Queue isn't created, nothing can be in flight
+			deleter();
+			return;
+		}
+		mFrames[mCurrentFrame].push_back(std::move(deleter));
+		mPendingCount++;
+	}
+
+	void VulkanDeletionQueue::retire(uint32_t frame)
+	{
+		//Deleter may release more objects, they go to current slot
+		std::vector<Deleter> deleters;
+		deleters.swap(mFrames[frame]);
+		mPendingCount -= static_cast<uint32_t>(deleters.size());
+		for(auto& deleter : deleters)
+		{
+			deleter();
+		}
+		//Keep capacity of slot
+		deleters.clear();
+		if(mFrames[frame].empty())
+		{
+			mFrames[frame].swap(deleters);
+		}
+	}
+}
@@ -0,0 +1,220 @@
+#include "Renderer/VulkanDescriptorAllocator.hpp"
+#include "Renderer/VulkanDescriptorSetLayout.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace fre
+{
+    //Each new pool holds twice as many sets as previous one up to this count
+    static const uint32_t MAX_SETS_PER_POOL = 4096;
+
+    void VulkanDescriptorAllocator::create(
+        VkDevice logicalDevice,
+        uint32_t setsPerPool,
+        const std::vector<VulkanDescriptorPoolRatio>& ratios,
+        VkDescriptorPoolCreateFlags flags)
+    {
+        mSetsPerPool = std::max(setsPerPool, 1u);
+        mFlags = flags;
+        setRatios(ratios);
+    }
+
+    void VulkanDescriptorAllocator::destroy(VkDevice logicalDevice)
+    {
+        for(auto& pool : mPools)
+        {
+            vkDestroyDescriptorPool(logicalDevice, pool.mDescriptorPool, nullptr);
+        }
+        mPools.clear();
+        mCurrentPool = 0;
+        mSetsPerPool = 0;
+        mRatios.clear();
+        mAllocatedDescriptors.clear();
+        mMaxDescriptors.clear();
+        mAllocatedSets = 0;
+        mStatistics = {};
+    }
+
+    void VulkanDescriptorAllocator::setRatios(const std::vector<VulkanDescriptorPoolRatio>& ratios)
+    {
+        for(const auto& ratio : ratios)
+        {
+            mRatios[getTypeIndex(ratio.mType)].mRatio = ratio.mRatio;
+        }
+    }
+
+    VkDescriptorSet VulkanDescriptorAllocator::allocate(VkDevice logicalDevice, const VulkanDescriptorSetLayout& layout,
+        VkDescriptorPool& pool)
+    {
+        //Demand of layout is counted first, so pool created for it has room for it
+        for(const auto& poolSize : layout.mPoolSizes)
+        {
+            const size_t index = getTypeIndex(poolSize.type);
+            mAllocatedDescriptors[index] += poolSize.descriptorCount;
+            mMaxDescriptors[index] = std::max(mMaxDescriptors[index], poolSize.descriptorCount);
+        }
+        mAllocatedSets++;
+
+        VkDescriptorSet result = VK_NULL_HANDLE;
+        for(;;)
+        {
+            Pool& current = mPools[getPool(logicalDevice)];
+            VkDescriptorSetAllocateInfo setAllocInfo = {};
+            setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            setAllocInfo.descriptorPool = current.mDescriptorPool;
+            setAllocInfo.descriptorSetCount = 1;
+            setAllocInfo.pSetLayouts = &layout.mDescriptorSetLayout;
+            const VkResult allocResult = vkAllocateDescriptorSets(logicalDevice, &setAllocInfo, &result);
+            if(allocResult == VK_SUCCESS)
+            {
+                current.mLiveSets++;
+                pool = current.mDescriptorPool;
+                break;
+            }
+            if(allocResult != VK_ERROR_OUT_OF_POOL_MEMORY && allocResult != VK_ERROR_FRAGMENTED_POOL)
+            {
+                VK_CHECK(allocResult);
+            }
+            if(current.mLiveSets == 0)
+            {
+                throw std::runtime_error("Descriptor set doesn't fit empty descriptor pool");
+            }
+
+            //Pool stays full until its sets are released or it is reset
+            current.mFull = true;
+            mStatistics.mFullPools++;
+            mStatistics.mPoolOverflows++;
+        }
+
+        mStatistics.mAllocatedSets++;
+        mStatistics.mLiveSets++;
+
+        return result;
+    }
+
+    void VulkanDescriptorAllocator::release(VkDevice logicalDevice, VkDescriptorPool pool)
+    {
+        auto foundIt = std::find_if(mPools.begin(), mPools.end(),
+            [pool](const Pool& item) { return item.mDescriptorPool == pool; });
+        if(foundIt == mPools.end() || foundIt->mLiveSets == 0)
+        {
+            LOG_WARNING("Descriptor set is released to pool which has no live sets of this allocator");
+            return;
+        }
+
+        foundIt->mLiveSets--;
+        mStatistics.mLiveSets--;
+        if(foundIt->mLiveSets == 0)
+        {
+            if(foundIt->mFull)
+            {
+                mStatistics.mRecycledPools++;
+            }
+            resetPool(logicalDevice, *foundIt);
+        }
+    }
+
+    void VulkanDescriptorAllocator::reset(VkDevice logicalDevice)
+    {
+        for(auto& pool : mPools)
+        {
+            resetPool(logicalDevice, pool);
+        }
+        mCurrentPool = 0;
+        mStatistics.mResets++;
+    }
+
+    uint32_t VulkanDescriptorAllocator::createPool(VkDevice logicalDevice)
+    {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for(size_t i = 0; i < mRatios.size(); i++)
+        {
+            //Largest set seen must fit empty pool
+            const uint32_t descriptorCount = std::max(
+                static_cast<uint32_t>(std::ceil(getRatio(i) * mSetsPerPool)), mMaxDescriptors[i]);
+            if(descriptorCount > 0)
+            {
+                poolSizes.push_back({ mRatios[i].mType, descriptorCount });
+            }
+        }
+        if(poolSizes.empty())
+        {
+            throw std::runtime_error("Descriptor pool sizes are unknown: no ratios are given and no layouts are allocated");
+        }
+
+        Pool pool;
+        VkDescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.flags = mFlags;
+        poolCreateInfo.maxSets = mSetsPerPool;
+        poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        poolCreateInfo.pPoolSizes = poolSizes.data();
+        VK_CHECK(vkCreateDescriptorPool(logicalDevice, &poolCreateInfo, nullptr, &pool.mDescriptorPool));
+
+        LOG_DEBUG("Descriptor pool {} created for {} sets", mPools.size(), mSetsPerPool);
+        if(mSetsPerPool < MAX_SETS_PER_POOL)
+        {
+            mSetsPerPool = std::min(mSetsPerPool * 2, MAX_SETS_PER_POOL);
+        }
+        mPools.push_back(pool);
+        mStatistics.mPools = static_cast<uint32_t>(mPools.size());
+        for(const auto& poolSize : poolSizes)
+        {
+            mStatistics.mPoolDescriptors += poolSize.descriptorCount;
+        }
+
+        return static_cast<uint32_t>(mPools.size() - 1);
+    }
+
+    uint32_t VulkanDescriptorAllocator::getPool(VkDevice logicalDevice)
+    {
+        if(mCurrentPool < mPools.size() && !mPools[mCurrentPool].mFull)
+        {
+            return mCurrentPool;
+        }
+
+        //Recycled and reset pools are reused before new one is created
+        auto foundIt = std::find_if(mPools.begin(), mPools.end(), [](const Pool& pool) { return !pool.mFull; });
+        mCurrentPool = foundIt != mPools.end() ? static_cast<uint32_t>(foundIt - mPools.begin()) : createPool(logicalDevice);
+
+        return mCurrentPool;
+    }
+
+    void VulkanDescriptorAllocator::resetPool(VkDevice logicalDevice, Pool& pool)
+    {
+        VK_CHECK(vkResetDescriptorPool(logicalDevice, pool.mDescriptorPool, 0));
+        mStatistics.mLiveSets -= pool.mLiveSets;
+        if(pool.mFull)
+        {
+            mStatistics.mFullPools--;
+        }
+        pool.mLiveSets = 0;
+        pool.mFull = false;
+    }
+
+    size_t VulkanDescriptorAllocator::getTypeIndex(VkDescriptorType type)
+    {
+        auto foundIt = std::find_if(mRatios.begin(), mRatios.end(),
+            [type](const VulkanDescriptorPoolRatio& item) { return item.mType == type; });
+        if(foundIt != mRatios.end())
+        {
+            return foundIt - mRatios.begin();
+        }
+
+        mRatios.push_back({ type, 0.0f });
+        mAllocatedDescriptors.push_back(0);
+        mMaxDescriptors.push_back(0);
+
+        return mRatios.size() - 1;
+    }
+
+    float VulkanDescriptorAllocator::getRatio(size_t typeIndex) const
+    {
+        const float seen = mAllocatedSets > 0 ?
+            static_cast<float>(mAllocatedDescriptors[typeIndex]) / static_cast<float>(mAllocatedSets) : 0.0f;
+        return std::max(mRatios[typeIndex].mRatio, seen);
+    }
+}
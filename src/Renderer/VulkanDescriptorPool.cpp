@@ -8,7 +8,8 @@ namespace fre
     void VulkanDescriptorPool::create(
 		VkDevice logicalDevice,
 		uint32_t setsCount,
-		const std::vector<VkDescriptorPoolSize>& poolSizes)
+		const std::vector<VkDescriptorPoolSize>& poolSizes,
+		VkDescriptorPoolCreateFlags flags)
     {
         //CREATE UNIFORM DESCRIPTOR POOL
 		
@@ -22,7 +23,7 @@ namespace fre
 		//Data to create descriptor pool
 		VkDescriptorPoolCreateInfo poolCreateInfo = {};
 		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolCreateInfo.flags = 0;
+		poolCreateInfo.flags = flags;
         //Maximum number of descriptor sets that can be created from pool
 		poolCreateInfo.maxSets = setsCount;
         //Amount of pool sizes being passed
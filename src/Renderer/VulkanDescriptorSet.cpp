@@ -53,10 +53,11 @@ namespace fre
 
 std::size_t std::hash<fre::VulkanDescriptorSetKey>::operator()(const fre::VulkanDescriptorSetKey& key) const {
     std::size_t seed = 0;
-    std::hash<uint32_t> hasher;
-    seed ^= hasher(key.mShaderId) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-    seed ^= hasher(key.mDPId) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    std::hash<uint64_t> hasher;
     seed ^= hasher(key.mDSLId) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-    seed ^= hasher(key.mMeshId) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    for(const auto resource : key.mResources)
+    {
+        seed ^= hasher(resource) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
     return seed;
 }
\ No newline at end of file
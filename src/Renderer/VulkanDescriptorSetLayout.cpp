@@ -1,5 +1,6 @@
 #include "Renderer/VulkanDescriptorSetLayout.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <cassert>
 
@@ -12,7 +13,8 @@ namespace fre
 		assert
 		(
 			key.mBindings.size() == key.mDescriptorCount.size() &&
-			key.mDescriptorCount.size() == key.mDescriptorTypes.size()
+			key.mDescriptorCount.size() == key.mDescriptorTypes.size() &&
+			(key.mBindingFlags.empty() || key.mBindingFlags.size() == key.mBindings.size())
 		);
 
         std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
@@ -24,6 +26,15 @@ namespace fre
             layoutBindings[i].descriptorCount = key.mDescriptorCount[i];	//Number of descriptors for binding
             layoutBindings[i].stageFlags = key.mStageFlags[i];	//Shader stage we bind to
             layoutBindings[i].pImmutableSamplers = nullptr;	//Immutability by specifying the layout
+
+            auto poolSizeIt = std::find_if(mPoolSizes.begin(), mPoolSizes.end(),
+                [&key, i](const VkDescriptorPoolSize& poolSize) { return poolSize.type == key.mDescriptorTypes[i]; });
+            if(poolSizeIt == mPoolSizes.end())
+            {
+                mPoolSizes.push_back({ key.mDescriptorTypes[i], 0 });
+                poolSizeIt = mPoolSizes.end() - 1;
+            }
+            poolSizeIt->descriptorCount += key.mDescriptorCount[i];
         }
 
 		//Create descriptor set layout with given bindings
@@ -32,6 +43,23 @@ namespace fre
 		layoutCreateInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
 		layoutCreateInfo.pBindings = layoutBindings.data();
 
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+		if(!key.mBindingFlags.empty())
+		{
+			bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+			bindingFlagsInfo.bindingCount = static_cast<uint32_t>(key.mBindingFlags.size());
+			bindingFlagsInfo.pBindingFlags = key.mBindingFlags.data();
+			layoutCreateInfo.pNext = &bindingFlagsInfo;
+			for(const auto flags : key.mBindingFlags)
+			{
+				//Sets of such layout are allocated from update after bind pools only
+				if((flags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0)
+				{
+					layoutCreateInfo.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+				}
+			}
+		}
+
 		//Create descriptor set layout
 		VkResult result = vkCreateDescriptorSetLayout(logicalDevice, &layoutCreateInfo, nullptr, &mDescriptorSetLayout);
 
@@ -58,5 +86,9 @@ std::size_t std::hash<fre::VulkanDescriptorSetLayoutInfo>::operator()(const fre:
         seed ^= hasher(key.mDescriptorCount[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
         seed ^= hasher(key.mStageFlags[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     }
+    for(const auto flags : key.mBindingFlags)
+    {
+        seed ^= hasher(flags) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    }
     return seed;
 }
\ No newline at end of file
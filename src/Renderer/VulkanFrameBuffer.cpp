@@ -1,8 +1,11 @@
 #include "Renderer/VulkanFrameBuffer.hpp"
+#include "Renderer/RenderGraph.hpp"
 #include "Utilities.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 #include <array>
+#include <cassert>
 
 namespace fre
 {
@@ -21,29 +24,124 @@ namespace fre
         framebufferCreateInfo.height = swapChainExtent.height;
         framebufferCreateInfo.layers = 1;
 
-        VK_CHECK(vkCreateFramebuffer(mainDevice.logicalDevice, &framebufferCreateInfo, nullptr, &mFrameBuffer));
+        VkFramebuffer frameBuffer = VK_NULL_HANDLE;
+        VK_CHECK(vkCreateFramebuffer(mainDevice.logicalDevice, &framebufferCreateInfo, nullptr, &frameBuffer));
+        mFrameBuffers.push_back(frameBuffer);
 
         LOG_INFO("Framebuffer created");
     }
 
-    void VulkanFrameBuffer::addColorAttachment(const VulkanAttachment& colorAttachment)
+    void VulkanFrameBuffer::create(const MainDevice& mainDevice, const RenderGraph& renderGraph,
+        const std::vector<VkImageView>& externalViews,
+        VkExtent2D swapChainExtent, const std::vector<VkRenderPass>& renderPasses)
     {
-        mColorAttachments.push_back(colorAttachment);
+        assert(renderGraph.isCompiled() && renderPasses.size() == renderGraph.getRenderPassesCount());
+
+        mAttachments.resize(renderGraph.getResourcesCount());
+        for(uint32_t i = 0; i < renderGraph.getResourcesCount(); i++)
+        {
+            const auto& resource = renderGraph.getResource(i);
+            if(resource.isUsed() && !resource.mDesc.mExternal)
+            {
+                mAttachments[i].createImage(mainDevice, resource, swapChainExtent);
+            }
+        }
+
+        //Memory slot must fit every resource aliasing it
+        std::vector<VkMemoryRequirements> slotRequirements(renderGraph.getMemorySlotsCount());
+        for(auto& requirements : slotRequirements)
+        {
+            requirements.size = 0;
+            requirements.alignment = 1;
+            requirements.memoryTypeBits = ~0u;
+        }
+        for(uint32_t i = 0; i < renderGraph.getResourcesCount(); i++)
+        {
+            const auto& resource = renderGraph.getResource(i);
+            if(resource.mMemorySlot != RenderGraphResource::NO_MEMORY_SLOT)
+            {
+                VkMemoryRequirements requirements;
+                vkGetImageMemoryRequirements(mainDevice.logicalDevice, mAttachments[i].mImage, &requirements);
+                auto& slot = slotRequirements[resource.mMemorySlot];
+                //Every resource is bound at offset 0, so alignment is always satisfied
+                slot.size = std::max(slot.size, requirements.size);
+                slot.memoryTypeBits &= requirements.memoryTypeBits;
+            }
+        }
+
+        mAliasedMemory.resize(slotRequirements.size(), VK_NULL_HANDLE);
+        for(uint32_t i = 0; i < slotRequirements.size(); i++)
+        {
+            const auto& slot = slotRequirements[i];
+            if(slot.memoryTypeBits == 0)
+            {
+                //Resources of slot have no common memory type, they get own memory below
+                LOG_WARNING("Render graph memory slot {} can't be aliased", i);
+                continue;
+            }
+            VkMemoryAllocateInfo memoryAllocInfo = {};
+            memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            memoryAllocInfo.allocationSize = slot.size;
+            memoryAllocInfo.memoryTypeIndex = findMemoryTypeIndex(mainDevice.physicalDevice, slot.memoryTypeBits,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            VK_CHECK(vkAllocateMemory(mainDevice.logicalDevice, &memoryAllocInfo, nullptr, &mAliasedMemory[i]));
+        }
+
+        for(uint32_t i = 0; i < renderGraph.getResourcesCount(); i++)
+        {
+            const auto& resource = renderGraph.getResource(i);
+            if(!resource.isUsed() || resource.mDesc.mExternal)
+            {
+                continue;
+            }
+            if(resource.mMemorySlot != RenderGraphResource::NO_MEMORY_SLOT && mAliasedMemory[resource.mMemorySlot] != VK_NULL_HANDLE)
+            {
+                mAttachments[i].bindMemory(mainDevice.logicalDevice, mAliasedMemory[resource.mMemorySlot]);
+            }
+            else
+            {
+                mAttachments[i].allocateMemory(mainDevice, resource.mLazy);
+            }
+            mAttachments[i].createImageView(mainDevice.logicalDevice);
+        }
+
+        //Attachments are shared by framebuffers of all render passes
+        for(uint32_t renderPass = 0; renderPass < renderPasses.size(); renderPass++)
+        {
+            std::vector<VkImageView> attachmentsViews;
+            for(const auto i : renderGraph.getAttachments(renderPass))
+            {
+                const auto& resource = renderGraph.getResource(i);
+                attachmentsViews.push_back(resource.mDesc.mExternal ? externalViews[i] : mAttachments[i].mImageView);
+            }
+
+            create(mainDevice, attachmentsViews, swapChainExtent, renderPasses[renderPass]);
+        }
     }
-    
-    void VulkanFrameBuffer::setDepthAttachment(const VulkanAttachment& depthAttachment)
+
+    const VulkanAttachment& VulkanFrameBuffer::getAttachment(uint32_t resource) const
     {
-        mDepthAttachment = depthAttachment;
+        assert(resource < mAttachments.size());
+
+        return mAttachments[resource];
     }
 
     void VulkanFrameBuffer::destroy(VkDevice logicalDevice)
     {
-        for(auto& colorAttachment : mColorAttachments)
+        for(auto& attachment : mAttachments)
+        {
+            attachment.destroy(logicalDevice);
+        }
+        mAttachments.clear();
+        for(auto memory : mAliasedMemory)
+        {
+            vkFreeMemory(logicalDevice, memory, nullptr);
+        }
+        mAliasedMemory.clear();
+        for(auto frameBuffer : mFrameBuffers)
         {
-            colorAttachment.destroy(logicalDevice);
+            vkDestroyFramebuffer(logicalDevice, frameBuffer, nullptr);
         }
-        mColorAttachments.clear();
-        mDepthAttachment.destroy(logicalDevice);
-        vkDestroyFramebuffer(logicalDevice, mFrameBuffer, nullptr);
+        mFrameBuffers.clear();
     }
 }
\ No newline at end of file
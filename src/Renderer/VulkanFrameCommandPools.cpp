@@ -0,0 +1,178 @@
+#include "Renderer/VulkanFrameCommandPools.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace fre
+{
+	void VulkanFrameCommandPools::create(VkDevice logicalDevice, uint32_t queueFamilyId, uint32_t framesCount, uint32_t threadsCount)
+	{
+		mThreadsCount = std::max(threadsCount, 1u);
+		mPools.resize(std::max(framesCount, 1u) * mThreadsCount);
+		mCurrentFrame = 0;
+
+		//Buffers live for a frame and are reset with their pool only
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyId;
+		for(auto& pool : mPools)
+		{
+			VK_CHECK(vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &pool.mCommandPool));
+		}
+	}
+
+	void VulkanFrameCommandPools::destroy(VkDevice logicalDevice)
+	{
+		//Buffers are freed with their pool
+		for(auto& pool : mPools)
+		{
+			vkDestroyCommandPool(logicalDevice, pool.mCommandPool, nullptr);
+		}
+		mPools.clear();
+		mThreadsCount = 0;
+		mCurrentFrame = 0;
+	}
+
+	void VulkanFrameCommandPools::beginFrame(VkDevice logicalDevice, uint32_t frame)
+	{
+		mCurrentFrame = frame;
+		for(uint32_t thread = 0; thread < mThreadsCount; thread++)
+		{
+			Pool& pool = mPools[frame * mThreadsCount + thread];
+			if(pool.mUsed > 0)
+			{
+				VK_CHECK(vkResetCommandPool(logicalDevice, pool.mCommandPool, 0));
+				pool.mUsed = 0;
+				mStatistics.mResets++;
+			}
+		}
+	}
+
+	VkCommandBuffer VulkanFrameCommandPools::acquire(VkDevice logicalDevice, uint32_t thread)
+	{
+		if(thread >= mThreadsCount)
+		{
+			throw std::runtime_error(formatString("Command pools are created for %u threads, thread %u is requested",
+				mThreadsCount, thread));
+		}
+
+		Pool& pool = mPools[mCurrentFrame * mThreadsCount + thread];
+		if(pool.mUsed == pool.mCommandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = pool.mCommandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandBufferCount = 1;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VK_CHECK(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer));
+			pool.mCommandBuffers.push_back(commandBuffer);
+			mStatistics.mAllocations++;
+		}
+		else
+		{
+			mStatistics.mRecycled++;
+		}
+
+		return pool.mCommandBuffers[pool.mUsed++];
+	}
+
+	void VulkanOneTimeCommandPool::create(VkDevice logicalDevice, uint32_t queueFamilyId)
+	{
+		//Beginning recycled buffer resets it
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = queueFamilyId;
+		VK_CHECK(vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &mCommandPool));
+	}
+
+	void VulkanOneTimeCommandPool::destroy(VkDevice logicalDevice)
+	{
+		//Every submission is finished, buffers are freed with pool
+		std::lock_guard<std::mutex> lock(mMutex);
+		for(VkFence fence : mFreeFences)
+		{
+			vkDestroyFence(logicalDevice, fence, nullptr);
+		}
+		vkDestroyCommandPool(logicalDevice, mCommandPool, nullptr);
+		mCommandPool = VK_NULL_HANDLE;
+		mFreeCommandBuffers.clear();
+		mFreeFences.clear();
+	}
+
+	VkCommandBuffer VulkanOneTimeCommandPool::begin(VkDevice logicalDevice)
+	{
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(!mFreeCommandBuffers.empty())
+			{
+				commandBuffer = mFreeCommandBuffers.back();
+				mFreeCommandBuffers.pop_back();
+				mStatistics.mRecycled++;
+			}
+			else
+			{
+				//Allocation is guarded as well, pool must not be used by two threads at once
+				VkCommandBufferAllocateInfo allocInfo = {};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.commandPool = mCommandPool;
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				allocInfo.commandBufferCount = 1;
+				VK_CHECK(vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer));
+				mStatistics.mAllocations++;
+			}
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+		return commandBuffer;
+	}
+
+	void VulkanOneTimeCommandPool::endAndSubmit(VkDevice logicalDevice, VkQueue queue, VkCommandBuffer commandBuffer)
+	{
+		VK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+		VkFence fence = VK_NULL_HANDLE;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(!mFreeFences.empty())
+			{
+				fence = mFreeFences.back();
+				mFreeFences.pop_back();
+			}
+		}
+		if(fence == VK_NULL_HANDLE)
+		{
+			VkFenceCreateInfo fenceInfo = {};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VK_CHECK(vkCreateFence(logicalDevice, &fenceInfo, nullptr, &fence));
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		VK_CHECK(vkQueueSubmit(queue, 1, &submitInfo, fence));
+
+		//Only this submission is waited for, not other work of queue
+		VK_CHECK(vkWaitForFences(logicalDevice, 1, &fence, VK_TRUE, UINT64_MAX));
+		VK_CHECK(vkResetFences(logicalDevice, 1, &fence));
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFreeCommandBuffers.push_back(commandBuffer);
+		mFreeFences.push_back(fence);
+	}
+
+	VulkanOneTimeCommandPoolStatistics VulkanOneTimeCommandPool::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mStatistics;
+	}
+}
@@ -1,4 +1,5 @@
 #include "Renderer/VulkanImage.hpp"
+#include "Renderer/VulkanFrameCommandPools.hpp"
 #include "Utilities.hpp"
 
 #ifdef _WIN64
@@ -8,6 +9,7 @@
 	#include <windows.h>
 #endif /* _WIN64 */
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace fre
@@ -122,7 +124,7 @@ namespace fre
 	VkImage createImage(const MainDevice& mainDevice,
 		uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling,
 		VkImageUsageFlags useFlags, VkMemoryPropertyFlags propFlags,
-		VkDeviceMemory* imageMemory, uint32_t& actualSize)
+		VkDeviceMemory* imageMemory, uint32_t& actualSize, uint32_t mipLevels)
 	{
 		//Create Image
 		VkImageCreateInfo imageCreateInfo = {};
@@ -131,7 +133,7 @@ namespace fre
 		imageCreateInfo.extent.width = width;
 		imageCreateInfo.extent.height = height;
 		imageCreateInfo.extent.depth = 1;
-		imageCreateInfo.mipLevels = 1;
+		imageCreateInfo.mipLevels = mipLevels;
 		imageCreateInfo.arrayLayers = 1;
 		imageCreateInfo.format = format;
 		imageCreateInfo.tiling = tiling;
@@ -164,7 +166,7 @@ namespace fre
 	}
 
 	VkImageView createImageView(VkDevice logicalDevice,
-		VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+		VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels)
 	{
 		VkImageViewCreateInfo viewCreateInfo = {};
 		viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -179,7 +181,7 @@ namespace fre
 		//Subresource allow the view to view only a part of an image
 		viewCreateInfo.subresourceRange.aspectMask = aspectFlags;		//Which aspect of image to view (COLOR_BIT, etc.)
 		viewCreateInfo.subresourceRange.baseMipLevel = 0;				//Starting mip-level to view image from
-		viewCreateInfo.subresourceRange.levelCount = 1;
+		viewCreateInfo.subresourceRange.levelCount = mipLevels;	//Number of mip levels to view
 		viewCreateInfo.subresourceRange.baseArrayLayer = 0;				//Starting array layer to view from
 		viewCreateInfo.subresourceRange.layerCount = 1;
 
@@ -193,7 +195,7 @@ namespace fre
 		VkImageLayout oldLayout, VkImageLayout newLayout,
 		VkAccessFlags srcAccessFlags, VkAccessFlags dstAccessFlags,
 		VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
-		bool isDepth, VkCommandBuffer commandBuffer)
+		bool isDepth, VkCommandBuffer commandBuffer, uint32_t baseMipLevel = 0, uint32_t mipLevels = 1)
 	{
 		VkImageMemoryBarrier barrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
 		barrier.image = image;
@@ -202,9 +204,9 @@ namespace fre
 		barrier.subresourceRange.aspectMask = isDepth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
 		barrier.subresourceRange.baseArrayLayer = 0;
 		barrier.subresourceRange.layerCount = 1;
-		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.levelCount = mipLevels;
 
-		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.baseMipLevel = baseMipLevel;
 		barrier.oldLayout = oldLayout;
 		barrier.newLayout = newLayout;
 		barrier.srcAccessMask = srcAccessFlags;
@@ -214,49 +216,56 @@ namespace fre
 	}
 
 	void copyImageBuffer(VkDevice device, int8_t transferQueueFamilyId, int8_t graphicsQueueFamilyId, VkQueue queue,
-		VkCommandPool transferCommandPool, VkBuffer srcBuffer,
-		VkImage image, uint32_t width, uint32_t height)
+		VulkanOneTimeCommandPool& transferCommandPool, VkBuffer srcBuffer,
+		VkImage image, uint32_t width, uint32_t height, const std::vector<MipLevel>& levels)
 	{
 		//Create buffer
-		VkCommandBuffer transferCommandBuffer = beginCommandBuffer(device, transferCommandPool);
-
-		VkBufferImageCopy imageRegion = {};
-		imageRegion.bufferOffset = 0;	//Offset into data
-		imageRegion.bufferRowLength = 0;	//Row length of data to calculate data spacing
-		imageRegion.bufferImageHeight = 0;	//Image height to calculate data spacing
-		imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;	//Which aspect of image to copy
-		imageRegion.imageSubresource.mipLevel = 0;	//Mip level to copy
-		imageRegion.imageSubresource.baseArrayLayer = 0;	//Starting array layer (if presented)
-		imageRegion.imageSubresource.layerCount = 1;	//Number of layers to copy starting at baseArrayLayer
-		imageRegion.imageOffset = { 0, 0, 0 };	//Start origin (xyz)
-		imageRegion.imageExtent = { width, height, 1 };	//Region size to copy (xyz)
+		VkCommandBuffer transferCommandBuffer = transferCommandPool.begin(device);
+
+		std::vector<VkBufferImageCopy> imageRegions(std::max<size_t>(levels.size(), 1));
+		for(uint32_t level = 0; level < imageRegions.size(); level++)
+		{
+			auto& imageRegion = imageRegions[level];
+			imageRegion.bufferOffset = levels.empty() ? 0 : levels[level].mOffset;	//Offset into data
+			imageRegion.bufferRowLength = 0;	//Row length of data to calculate data spacing
+			imageRegion.bufferImageHeight = 0;	//Image height to calculate data spacing
+			imageRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;	//Which aspect of image to copy
+			imageRegion.imageSubresource.mipLevel = level;	//Mip level to copy
+			imageRegion.imageSubresource.baseArrayLayer = 0;	//Starting array layer (if presented)
+			imageRegion.imageSubresource.layerCount = 1;	//Number of layers to copy starting at baseArrayLayer
+			imageRegion.imageOffset = { 0, 0, 0 };	//Start origin (xyz)
+			//Region size to copy (xyz)
+			imageRegion.imageExtent = levels.empty() ? VkExtent3D{ width, height, 1 } : VkExtent3D{ levels[level].mWidth, levels[level].mHeight, 1 };
+		}
+		const uint32_t mipLevels = static_cast<uint32_t>(imageRegions.size());
 
 		addImageBarrier(image,
 			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
 			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			VK_ACCESS_NONE, VK_ACCESS_TRANSFER_WRITE_BIT,
 			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			false, transferCommandBuffer);
+			false, transferCommandBuffer, 0, mipLevels);
 
 		//Copy buffer to image
-		vkCmdCopyBufferToImage(transferCommandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &imageRegion);
+		vkCmdCopyBufferToImage(transferCommandBuffer, srcBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			mipLevels, imageRegions.data());
 
 		addImageBarrier(image,
 			transferQueueFamilyId, graphicsQueueFamilyId,
 			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_NONE,
 			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-			false, transferCommandBuffer);
+			false, transferCommandBuffer, 0, mipLevels);
 
-		endAndSubmitCommitBuffer(device, transferCommandPool, queue, transferCommandBuffer);
+		transferCommandPool.endAndSubmit(device, queue, transferCommandBuffer);
 	}
 
 	void transitionImageLayout(VkDevice device, VkQueue queue,
-		VkCommandPool commandPool, VkImage image, VkImageAspectFlags aspectMask,
-		VkImageLayout oldLayout, VkImageLayout newLayout)
+		VulkanOneTimeCommandPool& commandPool, VkImage image, VkImageAspectFlags aspectMask,
+		VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels)
 	{
 		//Create buffer
-		VkCommandBuffer commandBuffer = beginCommandBuffer(device, commandPool);
+		VkCommandBuffer commandBuffer = commandPool.begin(device);
 
 		VkImageMemoryBarrier imageMemoryBarrier = {};
 		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -267,7 +276,7 @@ namespace fre
 		imageMemoryBarrier.image = image;	//Image being accessed and modified as part of barrier
 		imageMemoryBarrier.subresourceRange.aspectMask = aspectMask;
 		imageMemoryBarrier.subresourceRange.baseMipLevel = 0;	//Mip level to start alternation on
-		imageMemoryBarrier.subresourceRange.levelCount = 1;	//First mip level to start alternation on
+		imageMemoryBarrier.subresourceRange.levelCount = mipLevels;	//Number of mip levels to start alternation on
 		imageMemoryBarrier.subresourceRange.baseArrayLayer = 0;	//First layer to start alternation on
 		imageMemoryBarrier.subresourceRange.layerCount = 1;	//Number of layers to start alternation on
 
@@ -331,6 +340,118 @@ namespace fre
 			LOG_ERROR("Can't transition image layout from {} to {}", oldLayout, newLayout);
 		}
 
-		endAndSubmitCommitBuffer(device, commandPool, queue, commandBuffer);
+		commandPool.endAndSubmit(device, queue, commandBuffer);
+	}
+
+	bool isLinearBlitSupported(VkPhysicalDevice physicalDevice, VkFormat format)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+		const VkFormatFeatureFlags features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+			VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+		return (properties.optimalTilingFeatures & features) == features;
+	}
+
+	void blitMipmaps(VkDevice device, VkQueue queue, VulkanOneTimeCommandPool& commandPool, VkImage image,
+		uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout finalLayout)
+	{
+		VkCommandBuffer commandBuffer = commandPool.begin(device);
+
+		int32_t mipWidth = static_cast<int32_t>(width);
+		int32_t mipHeight = static_cast<int32_t>(height);
+		for(uint32_t level = 1; level < mipLevels; level++)
+		{
+			//Previous level is written, it becomes blit source
+			addImageBarrier(image,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				false, commandBuffer, level - 1, 1);
+
+			const int32_t nextWidth = std::max(mipWidth / 2, 1);
+			const int32_t nextHeight = std::max(mipHeight / 2, 1);
+			VkImageBlit blit = {};
+			blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+			blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+			blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+			vkCmdBlitImage(commandBuffer,
+				image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit, VK_FILTER_LINEAR);
+
+			mipWidth = nextWidth;
+			mipHeight = nextHeight;
+		}
+
+		//All levels but the last one are blit sources now
+		if(mipLevels > 1)
+		{
+			addImageBarrier(image,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, finalLayout,
+				VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				false, commandBuffer, 0, mipLevels - 1);
+		}
+		addImageBarrier(image,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			false, commandBuffer, mipLevels - 1, 1);
+
+		commandPool.endAndSubmit(device, queue, commandBuffer);
+	}
+	void copyImageLevels(VkDevice device, VkQueue queue, VulkanOneTimeCommandPool& commandPool, VkImage srcImage, uint32_t srcLevel,
+		VkImage dstImage, uint32_t width, uint32_t height, uint32_t mipLevels, VkImageLayout layout)
+	{
+		VkCommandBuffer commandBuffer = commandPool.begin(device);
+
+		addImageBarrier(srcImage,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			layout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			false, commandBuffer, srcLevel, mipLevels);
+		addImageBarrier(dstImage,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_ACCESS_NONE, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			false, commandBuffer, 0, mipLevels);
+
+		std::vector<VkImageCopy> regions(mipLevels);
+		for(uint32_t level = 0; level < mipLevels; level++)
+		{
+			auto& region = regions[level];
+			region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, srcLevel + level, 0, 1 };
+			region.srcOffset = { 0, 0, 0 };
+			region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			region.dstOffset = { 0, 0, 0 };
+			//Whole levels, so extents of block compressed levels needn't be multiples of block
+			region.extent = { std::max(width >> level, 1u), std::max(height >> level, 1u), 1 };
+		}
+		vkCmdCopyImage(commandBuffer,
+			srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			mipLevels, regions.data());
+
+		addImageBarrier(srcImage,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, layout,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			false, commandBuffer, srcLevel, mipLevels);
+		addImageBarrier(dstImage,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			false, commandBuffer, 0, mipLevels);
+
+		commandPool.endAndSubmit(device, queue, commandBuffer);
 	}
 }
\ No newline at end of file
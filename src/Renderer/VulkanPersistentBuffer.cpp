@@ -0,0 +1,104 @@
+#include "Renderer/VulkanPersistentBuffer.hpp"
+#include "Utilities.hpp"
+
+#include <stdexcept>
+
+namespace fre
+{
+	void VulkanPersistentBuffer::create(const MainDevice& mainDevice, VkDeviceSize size, uint32_t regionsCount,
+		VkBufferUsageFlags usage)
+	{
+		mSize = size;
+		mCopies.assign(regionsCount, {});
+		mStagingSizes.assign(regionsCount, 0);
+		mUploadedSize = 0;
+
+		fre::createBuffer(mainDevice, mSize, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			0,
+			&mBuffer, nullptr, &mMemory);
+		//Whole buffer can be updated by one frame
+		mStaging.create(mainDevice, mSize, regionsCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+
+		LOG_TRACE("Persistent buffer created: size {}, regions count {}", mSize, regionsCount);
+	}
+
+	void VulkanPersistentBuffer::destroy(VkDevice logicalDevice)
+	{
+		if(mBuffer != VK_NULL_HANDLE)
+		{
+			vkDestroyBuffer(logicalDevice, mBuffer, nullptr);
+			vkFreeMemory(logicalDevice, mMemory, nullptr);
+		}
+		mStaging.destroy(logicalDevice);
+		mBuffer = VK_NULL_HANDLE;
+		mMemory = VK_NULL_HANDLE;
+		mSize = 0;
+		mCopies.clear();
+		mStagingSizes.clear();
+	}
+
+	void* VulkanPersistentBuffer::update(uint32_t region, VkDeviceSize offset, VkDeviceSize size)
+	{
+		auto& stagingSize = mStagingSizes[region];
+		if(offset + size > mSize || stagingSize + size > mStaging.getRegionSize())
+		{
+			throw std::runtime_error("Persistent buffer update doesn't fit!");
+		}
+
+		//Staging is filled in update order, so range adjacent to previous one extends its copy
+		auto& copies = mCopies[region];
+		if(!copies.empty() && copies.back().dstOffset + copies.back().size == offset)
+		{
+			copies.back().size += size;
+		}
+		else
+		{
+			copies.push_back({ mStaging.getOffset(region) + stagingSize, offset, size });
+		}
+		void* data = static_cast<uint8_t*>(mStaging.getRegionData(region)) + stagingSize;
+		stagingSize += size;
+
+		return data;
+	}
+
+	void VulkanPersistentBuffer::recordUpload(VkCommandBuffer commandBuffer, uint32_t region, VkPipelineStageFlags stages,
+		VkAccessFlags access)
+	{
+		mUploadedSize = 0;
+		if(mBuffer == VK_NULL_HANDLE || mCopies[region].empty())
+		{
+			return;
+		}
+
+		auto& copies = mCopies[region];
+		for(const auto& copy : copies)
+		{
+			mUploadedSize += copy.size;
+		}
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = mBuffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		//Frames in flight may still read ranges being overwritten
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+			0, nullptr, 1, &barrier, 0, nullptr);
+
+		vkCmdCopyBuffer(commandBuffer, mStaging.mBuffer, mBuffer, static_cast<uint32_t>(copies.size()), copies.data());
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = access;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, stages, 0,
+			0, nullptr, 1, &barrier, 0, nullptr);
+
+		copies.clear();
+		mStagingSizes[region] = 0;
+	}
+}
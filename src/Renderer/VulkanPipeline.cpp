@@ -1,12 +1,17 @@
 #include "Renderer/VulkanPipeline.hpp"
 
+#include "Renderer/VulkanPipelineLibrary.hpp"
 #include "Renderer/VulkanShader.hpp"
+#include "Log.hpp"
 
 #include <algorithm>
 #include <stdexcept>
 
 namespace fre
 {
+	//Frames variant may stay unrequested before it is evicted, materials drawn again later create it from pipeline cache
+	const uint32_t VARIANT_MAX_AGE = 600;
+
 	std::vector<VkPipelineShaderStageCreateInfo> getPipelineShaderStageCreateInfo(const std::vector<VulkanShader*> shaders)
 	{
 		std::vector<VkPipelineShaderStageCreateInfo> result;
@@ -45,108 +50,90 @@ namespace fre
 		return pipelineLayout;
 	}
 
-    void VulkanPipeline::createGeometryPipeline(
-		VkDevice logicalDevice,
-		std::vector<VulkanShader*> shaders,
-		VkPrimitiveTopology topology,
-		uint32_t stride,
-        const std::vector<VulkanVertexAttribute>& vertexAttributes,
-		VkBool32 depthWriteEnable,
-		VkRenderPass renderPass,
-		uint32_t subpassIndex,
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-		std::vector<VkPushConstantRange> pushConstantRanges,
-		uint32_t attachmentsCount,
-		float lineWidth,
-		VkCullModeFlags cullMode)
-    {
-        //Put shader stage creation info in to container
-		//Graphics Pipeline creation info requires array of shader stage creates
-        auto shaderStages = getPipelineShaderStageCreateInfo(shaders);
-        
-		//How the data for an attribute is defined within a vertex
-		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
-        attributeDescriptions.resize(vertexAttributes.size());
-        for(uint32_t i = 0; i < attributeDescriptions.size(); i++)
-        {
-            attributeDescriptions[i].binding = 0;	//Which binding the data is at (should be the same as above)
-            attributeDescriptions[i].location = i;	//Location in shader where data will be read from
-            attributeDescriptions[i].format = vertexAttributes[i].mFormat;	//Data format
-            attributeDescriptions[i].offset = vertexAttributes[i].mOffset;	//Where this attribute is defined in the data for a single vertex
-        }
+	GeometryPipelineCreateInfos::GeometryPipelineCreateInfos(const GeometryPipelineState& state, bool extendedDynamicState)
+	{
+		const uint32_t stride = state.mStride;
+		const auto& attributeDescriptions = state.mAttributeDescriptions;
 
 		// -- VERTEX INPUT --
 
         //How data for the single vertex (position, color, tex coords, normals, etc.) is as whole
-		VkVertexInputBindingDescription bindingDescription = {};
-		bindingDescription.binding = 0;	//Can bind multiple streams of data, this defines which one
-		bindingDescription.stride = stride;
-		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;	//How to move between data after each vertex (instanced rendering or not, etc.)
-
-		VkPipelineVertexInputStateCreateInfo vertexInputCreateInfo = {};
-		vertexInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputCreateInfo.vertexBindingDescriptionCount = stride == 0 ? 0 : 1;
-		vertexInputCreateInfo.pVertexBindingDescriptions = stride == 0 ? nullptr : &bindingDescription;		//List of vertex binding descriptions (data spacing/stride info)
-		vertexInputCreateInfo.vertexAttributeDescriptionCount = stride == 0 ? 0 : static_cast<uint32_t>(attributeDescriptions.size());
-		vertexInputCreateInfo.pVertexAttributeDescriptions = stride == 0 ? nullptr : attributeDescriptions.data();	//List of vertex attribute descriptions (data format and where to bind to/from)
+		if(stride != 0)
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = VERTEX_BINDING;	//Can bind multiple streams of data, this defines which one
+			bindingDescription.stride = stride;
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;	//How to move between data after each vertex (instanced rendering or not, etc.)
+			mBindingDescriptions.push_back(bindingDescription);
+		}
+		//Per-instance data advances once per instance
+		if(stride != 0 && state.mInstanceStride != 0)
+		{
+			VkVertexInputBindingDescription bindingDescription = {};
+			bindingDescription.binding = INSTANCE_BINDING;
+			bindingDescription.stride = state.mInstanceStride;
+			bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+			mBindingDescriptions.push_back(bindingDescription);
+		}
+
+		mVertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		mVertexInput.vertexBindingDescriptionCount = static_cast<uint32_t>(mBindingDescriptions.size());
+		mVertexInput.pVertexBindingDescriptions = mBindingDescriptions.empty() ? nullptr : mBindingDescriptions.data();		//List of vertex binding descriptions (data spacing/stride info)
+		mVertexInput.vertexAttributeDescriptionCount = stride == 0 ? 0 : static_cast<uint32_t>(attributeDescriptions.size());
+		mVertexInput.pVertexAttributeDescriptions = stride == 0 ? nullptr : attributeDescriptions.data();	//List of vertex attribute descriptions (data format and where to bind to/from)
 
 		// -- INPUT ASSEMBLY --
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = topology;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
-		viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportStateCreateInfo.viewportCount = 1;
-		//viewportStateCreateInfo.pViewports = &viewport;
-		viewportStateCreateInfo.scissorCount = 1;
-		//viewportStateCreateInfo.pScissors = &scissor;
+		mInputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		mInputAssembly.topology = state.mTopology;
+		mInputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		mViewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		mViewport.viewportCount = 1;
+		mViewport.scissorCount = 1;
 
 		// -- DYNAMIC STATES --
 		//Dynamic states to enable
-		std::vector<VkDynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_VIEWPORT);	//Dynamic viewport : Can resize in command buffer with vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-		dynamicStateEnables.push_back(VK_DYNAMIC_STATE_SCISSOR);	//Dynamic scissor : Can rsize in command buffer with vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-		if(lineWidth > 0.0f)
+		mDynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);	//Dynamic viewport : Can resize in command buffer with vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		mDynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);	//Dynamic scissor : Can rsize in command buffer with vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		if(state.mLineWidth > 0.0f)
+		{
+			mDynamicStates.push_back(VK_DYNAMIC_STATE_LINE_WIDTH);
+		}
+		if(extendedDynamicState)
 		{
-			dynamicStateEnables.push_back(VK_DYNAMIC_STATE_LINE_WIDTH);
+			//Set at record time, see VulkanPipeline::applyDynamicState
+			mDynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
+			mDynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT);
+			mDynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT);
+			mDynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT);
+			mDynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
 		}
 
 		//Dynamic state creation info
-		VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
-		dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-		dynamicStateCreateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-		dynamicStateCreateInfo.pDynamicStates = dynamicStateEnables.data();
+		mDynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		mDynamicState.dynamicStateCount = static_cast<uint32_t>(mDynamicStates.size());
+		mDynamicState.pDynamicStates = mDynamicStates.data();
 
 		// -- RASTERIZER --
-		VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
-		rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizerCreateInfo.depthClampEnable = VK_FALSE;		//Change if fragments beyond near/far planes are clipped (default) or clamped to plane
-		rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;//Whether to discard data skip rasterizer, only suitable for pipeline without framebuffer output
-		rasterizerCreateInfo.polygonMode = topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST ? VK_POLYGON_MODE_POINT : VK_POLYGON_MODE_FILL;
-		rasterizerCreateInfo.lineWidth = std::max(1.0f, lineWidth);
-		rasterizerCreateInfo.cullMode = cullMode;
-		rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-		rasterizerCreateInfo.depthBiasEnable = VK_FALSE;
+		mRasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		mRasterization.depthClampEnable = VK_FALSE;		//Change if fragments beyond near/far planes are clipped (default) or clamped to plane
+		mRasterization.rasterizerDiscardEnable = VK_FALSE;//Whether to discard data skip rasterizer, only suitable for pipeline without framebuffer output
+		mRasterization.polygonMode = state.mTopology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST ? VK_POLYGON_MODE_POINT : VK_POLYGON_MODE_FILL;
+		mRasterization.lineWidth = std::max(1.0f, state.mLineWidth);
+		mRasterization.cullMode = state.mCullMode;
+		mRasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		mRasterization.depthBiasEnable = VK_FALSE;
 
 		// -- MULTISAMPLING --
-		VkPipelineMultisampleStateCreateInfo multisamplingCreateInfo = {};
-		multisamplingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisamplingCreateInfo.sampleShadingEnable = VK_FALSE;
-		multisamplingCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		// Optional
-		//multisamplingCreateInfo.minSampleShading = 1.0f;
-		//multisamplingCreateInfo.pSampleMask = nullptr;
-		//multisamplingCreateInfo.alphaToCoverageEnable = VK_FALSE;
-		//multisamplingCreateInfo.alphaToOneEnable = VK_FALSE;
+		mMultisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		mMultisample.sampleShadingEnable = VK_FALSE;
+		mMultisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
 		// -- BLENDING --
 
 		//Blend Attachment State (how blending is handled)
 		VkPipelineColorBlendAttachmentState colorState = {};
-		colorState.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT	//Colours to apply blending to
-			| VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorState.colorWriteMask = state.mColorWriteMask;	//Colours to apply blending to
 		colorState.blendEnable = VK_TRUE;			//Enable blending
 
 		colorState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
@@ -161,63 +148,287 @@ namespace fre
 		colorState.alphaBlendOp = VK_BLEND_OP_ADD;
 		//Summarized: (1 * new alpha) + (0 * old color) = new alpha
 
-		std::vector<VkPipelineColorBlendAttachmentState> colorStates(attachmentsCount, colorState);
+		mColorBlendAttachments.assign(state.mAttachmentsCount, colorState);
 
-		VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo = {};
-		colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlendingCreateInfo.logicOpEnable = VK_FALSE;	//Alternative to calculations is to use logical operations
-		colorBlendingCreateInfo.attachmentCount = colorStates.size();
-		colorBlendingCreateInfo.pAttachments = colorStates.data();
+		mColorBlend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		mColorBlend.logicOpEnable = VK_FALSE;	//Alternative to calculations is to use logical operations
+		mColorBlend.attachmentCount = static_cast<uint32_t>(mColorBlendAttachments.size());
+		mColorBlend.pAttachments = mColorBlendAttachments.data();
 
-		// -- PIPELINE LAYOUT --
+		// -- DEPTH STENCIL TESTING --
+		mDepthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		mDepthStencil.depthTestEnable = state.mDepthTestEnable;
+		mDepthStencil.depthWriteEnable = state.mDepthWriteEnable;
+		mDepthStencil.depthCompareOp = state.mDepthCompareOp;
+		mDepthStencil.depthBoundsTestEnable = VK_FALSE;	//Does depth value exists between bounds
+		mDepthStencil.stencilTestEnable = VK_FALSE;
+		mDepthStencil.minDepthBounds = 0.0f;
+		mDepthStencil.maxDepthBounds = 1.0f;
+		mDepthStencil.front = {};
+		mDepthStencil.back = {};
+	}
+
+    void VulkanPipeline::createGeometryPipeline(
+		VkDevice logicalDevice,
+		std::vector<VulkanShader*> shaders,
+		VkPrimitiveTopology topology,
+		uint32_t stride,
+        const std::vector<VulkanVertexAttribute>& vertexAttributes,
+		uint32_t instanceStride,
+		const std::vector<VulkanVertexAttribute>& instanceAttributes,
+		VkBool32 depthWriteEnable,
+		VkRenderPass renderPass,
+		uint32_t subpassIndex,
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
+		std::vector<VkPushConstantRange> pushConstantRanges,
+		uint32_t attachmentsCount,
+		float lineWidth,
+		VkCullModeFlags cullMode,
+		bool hasVariants,
+		VulkanPipelineLibrary* library,
+		const GeometryPipelineIdentity& identity,
+		VkPipelineCache pipelineCache)
+    {
+		mGeometryState = {};
+		mGeometryState.mIdentity = identity;
+		for(auto shader : shaders)
+		{
+			mGeometryState.mStages.push_back(shader->mShaderStage);
+			mGeometryState.mModules.push_back(shader->mShaderModule);
+		}
+		mGeometryState.mTopology = topology;
+		mGeometryState.mStride = stride;
+		mGeometryState.mInstanceStride = instanceAttributes.empty() ? 0 : instanceStride;
+
+		//How the data for an attribute is defined within a vertex
+		auto& attributeDescriptions = mGeometryState.mAttributeDescriptions;
+        attributeDescriptions.resize(vertexAttributes.size());
+        for(uint32_t i = 0; i < attributeDescriptions.size(); i++)
+        {
+            attributeDescriptions[i].binding = VERTEX_BINDING;	//Which binding the data is at (should be the same as above)
+            attributeDescriptions[i].location = i;	//Location in shader where data will be read from
+            attributeDescriptions[i].format = vertexAttributes[i].mFormat;	//Data format
+            attributeDescriptions[i].offset = vertexAttributes[i].mOffset;	//Where this attribute is defined in the data for a single vertex
+        }
+		//Per-instance attributes follow vertex attributes
+		if(mGeometryState.mInstanceStride != 0)
+		{
+			for(const auto& attribute : instanceAttributes)
+			{
+				VkVertexInputAttributeDescription description = {};
+				description.binding = INSTANCE_BINDING;
+				description.location = static_cast<uint32_t>(attributeDescriptions.size());
+				description.format = attribute.mFormat;
+				description.offset = attribute.mOffset;
+				attributeDescriptions.push_back(description);
+			}
+		}
 
+		mGeometryState.mDepthTestEnable = depthWriteEnable;
+		mGeometryState.mDepthWriteEnable = depthWriteEnable;
+		mGeometryState.mRenderPass = renderPass;
+		mGeometryState.mSubpassIndex = subpassIndex;
+		mGeometryState.mAttachmentsCount = attachmentsCount;
+		mGeometryState.mLineWidth = lineWidth;
+		mGeometryState.mCullMode = cullMode;
+		mGeometryState.mDescriptorSetLayouts = descriptorSetLayouts;
+		mGeometryState.mPushConstantRanges = pushConstantRanges;
+		mHasVariants = hasVariants;
+		mLibrary = library;
+		mPipelineCache = pipelineCache;
+
+		// -- PIPELINE LAYOUT --
+		//Layout does not depend on specialization constants, so it is shared by all variants
 		mPipelineLayout = createPipelineLayout(logicalDevice, descriptorSetLayouts, pushConstantRanges);
 
-		// -- DEPTH STENCIL TESTING --
-		VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo = {};
-		depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-		depthStencilCreateInfo.depthTestEnable = depthWriteEnable;
-		depthStencilCreateInfo.depthWriteEnable = depthWriteEnable;
-		depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
-		depthStencilCreateInfo.depthBoundsTestEnable = VK_FALSE;	//Does depth value exists between bounds
-		depthStencilCreateInfo.stencilTestEnable = VK_FALSE;
-		depthStencilCreateInfo.minDepthBounds = 0.0f;
-		depthStencilCreateInfo.maxDepthBounds = 1.0f;
-		depthStencilCreateInfo.front = {};
-		depthStencilCreateInfo.back = {};
+		mBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+		//Default variant has all features disabled
+		mPipeline = createGeometryVariant(logicalDevice, ShaderVariantKey(), mGeometryState);
+		for(auto& variants : mVariants)
+		{
+			variants = std::make_unique<VariantCache>();
+			//Modules of shaders without variants are destroyed once pipeline is created, so their depth pass
+			//variants couldn't be created again
+			if(mHasVariants)
+			{
+				variants->setEviction(ECacheEviction::FrameAge, VARIANT_MAX_AGE, MAX_FRAME_DRAWS,
+					[logicalDevice](VkPipeline& pipeline) { vkDestroyPipeline(logicalDevice, pipeline, nullptr); });
+			}
+		}
+    }
+
+	VkPipeline VulkanPipeline::getVariant(VkDevice logicalDevice, const ShaderVariantKey& key, EDepthPass depthPass)
+	{
+		//Depth state of main pass is set at record time with extended dynamic state
+		if(depthPass == EDepthPass::Equal && hasExtendedDynamicState())
+		{
+			depthPass = EDepthPass::Default;
+		}
+		const ShaderVariantKey variantKey = mHasVariants ? key : ShaderVariantKey();
+		if(depthPass == EDepthPass::Default && variantKey == ShaderVariantKey())
+		{
+			return mPipeline;
+		}
+
+		auto& variants = *mVariants[static_cast<size_t>(depthPass)];
+		const auto index = variants.findOrCreate(variantKey, [this, logicalDevice, depthPass](const ShaderVariantKey& variantKey)
+			{
+				LOG_TRACE("Create pipeline variant: features {}, depth pass {}", variantKey.mFeatures, static_cast<uint32_t>(depthPass));
+				return createGeometryVariant(logicalDevice, variantKey, getDepthPassState(depthPass));
+			});
+
+		return variants.getByIndex(index);
+	}
+
+	bool VulkanPipeline::update(uint64_t frame)
+	{
+		bool result = false;
+		for(auto& variants : mVariants)
+		{
+			if(variants != nullptr)
+			{
+				const uint64_t evictions = variants->getStatistics().mEvictions;
+				variants->update(frame);
+				result = result || variants->getStatistics().mEvictions != evictions;
+			}
+		}
+
+		return result;
+	}
+
+	void VulkanPipeline::applyDynamicState(VkCommandBuffer commandBuffer, EDepthPass depthPass) const
+	{
+		if(mBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && hasExtendedDynamicState())
+		{
+			const auto state = getDepthPassState(depthPass);
+			vkCmdSetCullModeEXT(commandBuffer, state.mCullMode);
+			vkCmdSetDepthTestEnableEXT(commandBuffer, state.mDepthTestEnable);
+			vkCmdSetDepthWriteEnableEXT(commandBuffer, state.mDepthWriteEnable);
+			vkCmdSetDepthCompareOpEXT(commandBuffer, state.mDepthCompareOp);
+			vkCmdSetPrimitiveTopologyEXT(commandBuffer, state.mTopology);
+		}
+	}
+
+	GeometryPipelineState VulkanPipeline::getDepthPassState(EDepthPass depthPass) const
+	{
+		GeometryPipelineState state = mGeometryState;
+		switch(depthPass)
+		{
+			case EDepthPass::PrePass:
+				{
+					//Depth is written without fragment shader
+					for(uint32_t i = 0; i < state.mStages.size(); )
+					{
+						if(state.mStages[i] != VK_SHADER_STAGE_VERTEX_BIT)
+						{
+							state.mStages.erase(state.mStages.begin() + i);
+							state.mModules.erase(state.mModules.begin() + i);
+						}
+						else
+						{
+							i++;
+						}
+					}
+					//Position is the first attribute. Vertex shader is shared with main pass,
+					//so its other inputs are fed with position too, their values don't affect depth.
+					//Per-instance attributes are kept, they place instances
+					const VkFormat positionFormat = state.mAttributeDescriptions.empty() ?
+						VK_FORMAT_R32G32B32_SFLOAT : state.mAttributeDescriptions.front().format;
+					for(auto& attribute : state.mAttributeDescriptions)
+					{
+						if(attribute.binding == VERTEX_BINDING)
+						{
+							attribute.format = positionFormat;
+							attribute.offset = 0;
+						}
+					}
+					state.mStride = POSITION_STREAM_STRIDE;
+					state.mColorWriteMask = 0;
+					state.mDepthTestEnable = VK_TRUE;
+					state.mDepthWriteEnable = VK_TRUE;
+				}
+				break;
+			case EDepthPass::Equal:
+				state.mDepthTestEnable = VK_TRUE;
+				state.mDepthWriteEnable = VK_FALSE;
+				state.mDepthCompareOp = VK_COMPARE_OP_EQUAL;
+				break;
+			default:
+				break;
+		}
+
+		return state;
+	}
+
+	bool VulkanPipeline::hasExtendedDynamicState() const
+	{
+		return mLibrary != nullptr && mLibrary->mSupport.mExtendedDynamicState;
+	}
+
+	VkPipeline VulkanPipeline::createGeometryVariant(VkDevice logicalDevice, const ShaderVariantKey& key,
+		const GeometryPipelineState& state) const
+	{
+		//Specialization constants are passed only to shaders with variants
+		ShaderSpecialization specialization(key);
+		const VkSpecializationInfo* specializationInfo = mHasVariants ? &specialization.mInfo : nullptr;
+
+		//Parts are shared only between pipelines with stable identity
+		if(mLibrary != nullptr && mLibrary->mSupport.mGraphicsPipelineLibrary && state.mIdentity.isValid())
+		{
+			//Fast link from cached parts
+			return mLibrary->link(logicalDevice, state, mPipelineLayout, key, specializationInfo);
+		}
+
+		GeometryPipelineCreateInfos infos(state, hasExtendedDynamicState());
+
+        //Put shader stage creation info in to container
+		//Graphics Pipeline creation info requires array of shader stage creates
+		std::vector<VkPipelineShaderStageCreateInfo> shaderStages(state.mStages.size());
+		for(uint32_t i = 0; i < shaderStages.size(); i++)
+		{
+			shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStages[i].stage = state.mStages[i];
+			shaderStages[i].module = state.mModules[i];
+			shaderStages[i].pName = "main";
+			shaderStages[i].pSpecializationInfo = specializationInfo;
+		}
 
 		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
 		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
 		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vertexInputCreateInfo;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssembly;
-		pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
-		pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
-		pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
-		pipelineCreateInfo.pMultisampleState = &multisamplingCreateInfo;
-		pipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
+		pipelineCreateInfo.pVertexInputState = &infos.mVertexInput;
+		pipelineCreateInfo.pInputAssemblyState = &infos.mInputAssembly;
+		pipelineCreateInfo.pViewportState = &infos.mViewport;
+		pipelineCreateInfo.pDynamicState = &infos.mDynamicState;
+		pipelineCreateInfo.pRasterizationState = &infos.mRasterization;
+		pipelineCreateInfo.pMultisampleState = &infos.mMultisample;
+		pipelineCreateInfo.pColorBlendState = &infos.mColorBlend;
+		pipelineCreateInfo.pDepthStencilState = &infos.mDepthStencil;
 		pipelineCreateInfo.layout = mPipelineLayout;
-		pipelineCreateInfo.renderPass = renderPass;
-		pipelineCreateInfo.subpass = subpassIndex;
+		pipelineCreateInfo.renderPass = state.mRenderPass;
+		pipelineCreateInfo.subpass = state.mSubpassIndex;
 		//Pipeline derivatives: Can create multiple pipelines that derive from one another for optimisation
 		pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;	//Existing pipeline to derive from...
 		pipelineCreateInfo.basePipelineIndex = -1;	//or index of pipeline being created to derive from (in case creating multiple at once)
 
-		mBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-
 		//Create graphics pipeline
-		VK_CHECK(vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &mPipeline));
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateGraphicsPipelines(logicalDevice, mPipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+
+		return pipeline;
     }
 
 	void VulkanPipeline::createComputePipeline(
         VkDevice logicalDevice,
         VulkanShader& shader,
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-		std::vector<VkPushConstantRange> pushConstantRanges)
+		std::vector<VkPushConstantRange> pushConstantRanges,
+		VkPipelineCache pipelineCache)
 	{
 		mPipelineLayout = createPipelineLayout(logicalDevice, descriptorSetLayouts, pushConstantRanges);
+		mPipelineCache = pipelineCache;
 
 		VkComputePipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -225,7 +436,7 @@ namespace fre
         auto shaderStageInfos = getPipelineShaderStageCreateInfo({&shader});
 		pipelineInfo.stage = shaderStageInfos.front();
 
-		VK_CHECK(vkCreateComputePipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mPipeline));
+		VK_CHECK(vkCreateComputePipelines(logicalDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &mPipeline));
 
         mBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
 
@@ -233,7 +444,7 @@ namespace fre
 	}
 
 	void VulkanPipeline::createShaderBindingTables(
-		MainDevice& mainDevice, VkQueue transferQueue, VkCommandPool transferCommandPool,
+		MainDevice& mainDevice, VkQueue transferQueue, VulkanOneTimeCommandPool& transferCommandPool,
 		const VkPhysicalDeviceRayTracingPipelinePropertiesKHR& mRayTracingPipelineProperties,
 		VulkanBufferManager& bufferManager)
 	{
@@ -262,9 +473,11 @@ namespace fre
 	void VulkanPipeline::createRTPipeline(VkDevice logicalDevice,
 		std::vector<VulkanShader*> shaders,
 		std::vector<VkDescriptorSetLayout> descriptorSetLayouts,
-		std::vector<VkPushConstantRange> pushConstantRanges)
+		std::vector<VkPushConstantRange> pushConstantRanges,
+		VkPipelineCache pipelineCache)
 	{
 		mPipelineLayout = createPipelineLayout(logicalDevice, descriptorSetLayouts, pushConstantRanges);
+		mPipelineCache = pipelineCache;
 		
 		auto shaderStageInfos = getPipelineShaderStageCreateInfo(shaders);
 
@@ -299,13 +512,27 @@ namespace fre
 		raytracing_pipeline_create_info.pGroups = mShaderGroups.data();
 		raytracing_pipeline_create_info.maxPipelineRayRecursionDepth = 1;
 		raytracing_pipeline_create_info.layout = mPipelineLayout;
-		VK_CHECK(vkCreateRayTracingPipelinesKHR(logicalDevice, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &raytracing_pipeline_create_info, nullptr, &mPipeline));
+		VK_CHECK(vkCreateRayTracingPipelinesKHR(logicalDevice, VK_NULL_HANDLE, mPipelineCache, 1, &raytracing_pipeline_create_info, nullptr, &mPipeline));
 		
 		mBindPoint = VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR;
 	}
 
 	void VulkanPipeline::destroy(VkDevice logicalDevice)
 	{
+		for(auto& variants : mVariants)
+		{
+			if(variants == nullptr)
+			{
+				continue;
+			}
+			//Evicted variants go to destroyer, slots of erased ones hold null handles
+			variants->destroyEvicted();
+			for(VariantCache::Index i = 0; i < variants->size(); i++)
+			{
+				vkDestroyPipeline(logicalDevice, variants->getByIndex(i), nullptr);
+			}
+			variants.reset();
+		}
 		vkDestroyPipeline(logicalDevice, mPipeline, nullptr);
 		vkDestroyPipelineLayout(logicalDevice, mPipelineLayout, nullptr);
 	}
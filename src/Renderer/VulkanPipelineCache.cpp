@@ -0,0 +1,98 @@
+#include "Renderer/VulkanPipelineCache.hpp"
+#include "Log.hpp"
+#include "Utilities.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fre
+{
+	//Driver rejects or ignores foreign data, but not every driver does it gracefully
+	static bool isCompatible(const MainDevice& mainDevice, const std::vector<char>& data)
+	{
+		VkPipelineCacheHeaderVersionOne header = {};
+		if(data.size() < sizeof(header))
+		{
+			return false;
+		}
+		memcpy(&header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(mainDevice.physicalDevice, &properties);
+
+		return header.headerSize >= sizeof(header) &&
+			header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header.vendorID == properties.vendorID &&
+			header.deviceID == properties.deviceID &&
+			memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	void VulkanPipelineCache::create(const MainDevice& mainDevice, const std::string& fileName)
+	{
+		mFileName = fileName;
+		std::vector<char> data;
+		if(!mFileName.empty() && std::filesystem::exists(mFileName))
+		{
+			data = readFile(mFileName);
+			if(!isCompatible(mainDevice, data))
+			{
+				LOG_INFO("Pipeline cache {} is from other device or driver, starting empty", mFileName);
+				data.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.initialDataSize = data.size();
+		createInfo.pInitialData = data.empty() ? nullptr : data.data();
+		VK_CHECK(vkCreatePipelineCache(mainDevice.logicalDevice, &createInfo, nullptr, &mPipelineCache));
+
+		LOG_TRACE("Pipeline cache created: {}, initial size {}", mFileName, data.size());
+	}
+
+	void VulkanPipelineCache::save(VkDevice logicalDevice) const
+	{
+		if(mFileName.empty() || mPipelineCache == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		size_t size = 0;
+		VK_CHECK(vkGetPipelineCacheData(logicalDevice, mPipelineCache, &size, nullptr));
+		std::vector<char> data(size);
+		VK_CHECK(vkGetPipelineCacheData(logicalDevice, mPipelineCache, &size, data.data()));
+
+		//Launch killed while writing leaves previous file intact
+		const std::string temporaryPath = mFileName + ".tmp";
+		bool written = false;
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(data.data(), static_cast<std::streamsize>(size));
+			written = file.good();
+		}
+		std::error_code error;
+		if(!written)
+		{
+			LOG_WARNING("Pipeline cache {} isn't saved", mFileName);
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+		std::filesystem::rename(temporaryPath, mFileName, error);
+		if(error)
+		{
+			LOG_WARNING("Pipeline cache {} isn't saved: {}", mFileName, error.message());
+			std::filesystem::remove(temporaryPath, error);
+		}
+	}
+
+	void VulkanPipelineCache::destroy(VkDevice logicalDevice)
+	{
+		if(mPipelineCache != VK_NULL_HANDLE)
+		{
+			vkDestroyPipelineCache(logicalDevice, mPipelineCache, nullptr);
+			mPipelineCache = VK_NULL_HANDLE;
+		}
+	}
+}
@@ -0,0 +1,227 @@
+#include "Renderer/VulkanPipelineLibrary.hpp"
+#include "Renderer/VulkanPipeline.hpp"
+#include "Log.hpp"
+#include "Utilities.hpp"
+
+#include <array>
+#include <cstring>
+
+namespace fre
+{
+	static uint64_t floatBits(float value)
+	{
+		uint32_t result = 0;
+		memcpy(&result, &value, sizeof(float));
+		return result;
+	}
+
+	static bool hasModule(const GeometryPipelineState& state, VkShaderStageFlagBits stage)
+	{
+		for(uint32_t i = 0; i < state.mStages.size(); i++)
+		{
+			if(state.mStages[i] == stage && state.mModules[i] != VK_NULL_HANDLE)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	//Shader and index of its metadata fix modules and pipeline layout
+	static void addShaderIdentity(const GeometryPipelineState& state, VkShaderStageFlagBits stage, std::vector<uint64_t>& values)
+	{
+		values.push_back(state.mIdentity.mShaderId);
+		values.push_back(state.mIdentity.mMetaDataIndex);
+		//Depth pre-pass drops fragment stage of the same shader
+		values.push_back(hasModule(state, stage));
+	}
+
+	static std::vector<VkPipelineShaderStageCreateInfo> getStages(
+		const GeometryPipelineState& state,
+		VkShaderStageFlags stages,
+		const VkSpecializationInfo* specializationInfo)
+	{
+		std::vector<VkPipelineShaderStageCreateInfo> result;
+		for(uint32_t i = 0; i < state.mStages.size(); i++)
+		{
+			if((state.mStages[i] & stages) != 0 && state.mModules[i] != VK_NULL_HANDLE)
+			{
+				VkPipelineShaderStageCreateInfo stage = {};
+				stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+				stage.stage = state.mStages[i];
+				stage.module = state.mModules[i];
+				stage.pName = "main";
+				stage.pSpecializationInfo = specializationInfo;
+				result.push_back(stage);
+			}
+		}
+
+		return result;
+	}
+
+
+	void VulkanPipelineLibrary::destroy(VkDevice logicalDevice)
+	{
+		for(auto& [key, part] : mParts)
+		{
+			vkDestroyPipeline(logicalDevice, part, nullptr);
+		}
+		mParts.clear();
+	}
+
+	VkPipeline VulkanPipelineLibrary::link(
+		VkDevice logicalDevice,
+		const GeometryPipelineState& state,
+		VkPipelineLayout pipelineLayout,
+		const ShaderVariantKey& variantKey,
+		const VkSpecializationInfo* specializationInfo)
+	{
+		std::array<VkPipeline, 4> parts =
+		{
+			getPart(logicalDevice, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, state, pipelineLayout, variantKey, specializationInfo),
+			getPart(logicalDevice, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, state, pipelineLayout, variantKey, specializationInfo),
+			getPart(logicalDevice, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, state, pipelineLayout, variantKey, specializationInfo),
+			getPart(logicalDevice, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, state, pipelineLayout, variantKey, specializationInfo)
+		};
+
+		VkPipelineLibraryCreateInfoKHR linkInfo = {};
+		linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+		linkInfo.libraryCount = static_cast<uint32_t>(parts.size());
+		linkInfo.pLibraries = parts.data();
+
+		//No link time optimization: linking must be fast enough to do it mid-frame
+		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.pNext = &linkInfo;
+		pipelineCreateInfo.layout = pipelineLayout;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateGraphicsPipelines(logicalDevice, mPipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+
+		return pipeline;
+	}
+
+	PipelinePartKey VulkanPipelineLibrary::getPartKey(
+		VkGraphicsPipelineLibraryFlagsEXT part,
+		const GeometryPipelineState& state,
+		const ShaderVariantKey& variantKey) const
+	{
+		PipelinePartKey key;
+		key.mPart = part;
+		auto& values = key.mValues;
+		//State covered by extended dynamic state does not produce new parts
+		const bool dynamic = mSupport.mExtendedDynamicState;
+		switch(part)
+		{
+			case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+				values.push_back(state.mStride);
+				values.push_back(state.mInstanceStride);
+				for(const auto& attribute : state.mAttributeDescriptions)
+				{
+					values.push_back(attribute.binding);
+					values.push_back(attribute.location);
+					values.push_back(attribute.format);
+					values.push_back(attribute.offset);
+				}
+				values.push_back(state.mTopology);
+				values.push_back(dynamic);
+				break;
+			case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+				addShaderIdentity(state, VK_SHADER_STAGE_VERTEX_BIT, values);
+				values.push_back(variantKey.mFeatures);
+				values.push_back(state.mTopology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+				values.push_back(floatBits(state.mLineWidth));
+				values.push_back(dynamic ? MAX(uint64_t) : state.mCullMode);
+				values.push_back(state.mIdentity.mRenderPassId);
+				values.push_back(state.mSubpassIndex);
+				break;
+			case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+				addShaderIdentity(state, VK_SHADER_STAGE_FRAGMENT_BIT, values);
+				values.push_back(variantKey.mFeatures);
+				values.push_back(dynamic ? MAX(uint64_t) : state.mDepthTestEnable);
+				values.push_back(dynamic ? MAX(uint64_t) : state.mDepthWriteEnable);
+				values.push_back(dynamic ? MAX(uint64_t) : state.mDepthCompareOp);
+				values.push_back(state.mIdentity.mRenderPassId);
+				values.push_back(state.mSubpassIndex);
+				break;
+			case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+				values.push_back(state.mIdentity.mRenderPassId);
+				values.push_back(state.mSubpassIndex);
+				values.push_back(state.mAttachmentsCount);
+				values.push_back(state.mColorWriteMask);
+				break;
+		}
+
+		return key;
+	}
+
+	VkPipeline VulkanPipelineLibrary::getPart(
+		VkDevice logicalDevice,
+		VkGraphicsPipelineLibraryFlagsEXT part,
+		const GeometryPipelineState& state,
+		VkPipelineLayout pipelineLayout,
+		const ShaderVariantKey& variantKey,
+		const VkSpecializationInfo* specializationInfo)
+	{
+		const auto key = getPartKey(part, state, variantKey);
+		auto foundIt = mParts.find(key);
+		if(foundIt != mParts.end())
+		{
+			return foundIt->second;
+		}
+
+		GeometryPipelineCreateInfos infos(state, mSupport.mExtendedDynamicState);
+
+		VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {};
+		libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+		libraryInfo.flags = part;
+
+		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.pNext = &libraryInfo;
+		pipelineCreateInfo.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+		pipelineCreateInfo.pDynamicState = &infos.mDynamicState;
+
+		std::vector<VkPipelineShaderStageCreateInfo> stages;
+		switch(part)
+		{
+			case VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT:
+				pipelineCreateInfo.pVertexInputState = &infos.mVertexInput;
+				pipelineCreateInfo.pInputAssemblyState = &infos.mInputAssembly;
+				break;
+			case VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT:
+				stages = getStages(state, VK_SHADER_STAGE_VERTEX_BIT, specializationInfo);
+				pipelineCreateInfo.pViewportState = &infos.mViewport;
+				pipelineCreateInfo.pRasterizationState = &infos.mRasterization;
+				pipelineCreateInfo.layout = pipelineLayout;
+				pipelineCreateInfo.renderPass = state.mRenderPass;
+				pipelineCreateInfo.subpass = state.mSubpassIndex;
+				break;
+			case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT:
+				stages = getStages(state, VK_SHADER_STAGE_FRAGMENT_BIT, specializationInfo);
+				pipelineCreateInfo.pDepthStencilState = &infos.mDepthStencil;
+				pipelineCreateInfo.pMultisampleState = &infos.mMultisample;
+				pipelineCreateInfo.layout = pipelineLayout;
+				pipelineCreateInfo.renderPass = state.mRenderPass;
+				pipelineCreateInfo.subpass = state.mSubpassIndex;
+				break;
+			case VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT:
+				pipelineCreateInfo.pColorBlendState = &infos.mColorBlend;
+				pipelineCreateInfo.pMultisampleState = &infos.mMultisample;
+				pipelineCreateInfo.renderPass = state.mRenderPass;
+				pipelineCreateInfo.subpass = state.mSubpassIndex;
+				break;
+		}
+		pipelineCreateInfo.stageCount = static_cast<uint32_t>(stages.size());
+		pipelineCreateInfo.pStages = stages.empty() ? nullptr : stages.data();
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateGraphicsPipelines(logicalDevice, mPipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline));
+		mParts[key] = pipeline;
+
+		LOG_TRACE("Pipeline library part created: {}, parts count {}", part, mParts.size());
+
+		return pipeline;
+	}
+}
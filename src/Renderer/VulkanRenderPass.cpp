@@ -1,189 +1,223 @@
-#include "Renderer/VulkanAttachment.hpp"
+#include "Renderer/RenderGraph.hpp"
 #include "Renderer/VulkanRenderPass.hpp"
-#include "Renderer/VulkanImage.hpp"
 #include "Log.hpp"
 #include "Utilities.hpp"
 
-#include <array>
+#include <cassert>
+#include <vector>
 
 using namespace glm;
 
 namespace fre
 {
-    void VulkanRenderPass::create(const MainDevice& mainDevice, VkFormat swapChainImageFormat)
+	static bool isFramebufferLocal(VkAccessFlags access)
+	{
+		const VkAccessFlags localAccess = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT |
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		return (access & ~localAccess) == 0;
+	}
+
+	static void addDependency(std::vector<VkSubpassDependency>& dependencies, const RenderGraphBarrier& barrier,
+		uint32_t srcSubpass, uint32_t dstSubpass)
+	{
+		//Pixel of next subpass depends only on the same pixel of previous one
+		const VkDependencyFlags flags = srcSubpass != VK_SUBPASS_EXTERNAL && dstSubpass != VK_SUBPASS_EXTERNAL
+			&& isFramebufferLocal(barrier.mDstAccess) ? VK_DEPENDENCY_BY_REGION_BIT : 0;
+
+		//One dependency per pair of subpasses
+		for(auto& dependency : dependencies)
+		{
+			if(dependency.srcSubpass == srcSubpass && dependency.dstSubpass == dstSubpass)
+			{
+				dependency.srcStageMask |= barrier.mSrcStage;
+				dependency.srcAccessMask |= barrier.mSrcAccess;
+				dependency.dstStageMask |= barrier.mDstStage;
+				dependency.dstAccessMask |= barrier.mDstAccess;
+				dependency.dependencyFlags &= flags;
+				return;
+			}
+		}
+
+		VkSubpassDependency dependency = {};
+		dependency.srcSubpass = srcSubpass;
+		dependency.srcStageMask = barrier.mSrcStage;
+		dependency.srcAccessMask = barrier.mSrcAccess;
+		dependency.dstSubpass = dstSubpass;
+		dependency.dstStageMask = barrier.mDstStage;
+		dependency.dstAccessMask = barrier.mDstAccess;
+		dependency.dependencyFlags = flags;
+		dependencies.push_back(dependency);
+	}
+
+    void VulkanRenderPass::create(const MainDevice& mainDevice, const RenderGraph& renderGraph, uint32_t renderPass)
     {
-		LOG_INFO("Create render pass");
+		LOG_INFO("Create render pass {}", renderPass);
+
+		assert(renderGraph.isCompiled());
+
+		//Render graph passes of this render pass
+		std::vector<uint32_t> passes;
+		for(uint32_t p = 0; p < renderGraph.getPassesCount(); p++)
+		{
+			if(renderGraph.getPass(p).mRenderPass == renderPass)
+			{
+				passes.push_back(p);
+			}
+		}
+		const uint32_t firstPass = passes.front();
+		const uint32_t lastPass = passes.back();
+
+		auto getSubpass = [&renderGraph, renderPass](uint32_t pass)
+			{
+				return pass != RenderGraphBarrier::EXTERNAL && renderGraph.getPass(pass).mRenderPass == renderPass ?
+					renderGraph.getPass(pass).mSubpass : VK_SUBPASS_EXTERNAL;
+			};
+
 		//ATTACHMENTS
-		//SUBPASS 1 ATTACHMENTS + REFERENCES (INPUT ATTACHMENTS)
-
-		//Color Attachment (Input)
-		VkAttachmentDescription colorAttachment = {};
-		colorAttachment.format = chooseSupportedImageFormat(
-			mainDevice.physicalDevice,
-			getImageFormats(COLOR_ATTACHMENT),
-			VK_IMAGE_TILING_OPTIMAL,
-			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-		);
-		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;	//Before render pass
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;	//Don't care after render pass
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;	//Image data layout before render pass starts
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;	//Image data layout after render pass (to change to)
-
-		//Depth attachment (Input)
-		VkAttachmentDescription depthAttachment = {};
-		depthAttachment.format = chooseSupportedImageFormat(
-			mainDevice.physicalDevice,
-			getImageFormats(DEPTH_ATTACHMENT),
-			VK_IMAGE_TILING_OPTIMAL,
-			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
-		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;	//We need to store after rendering to present image on screen
-		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-		//Color Attachment (Input) Reference
-		VkAttachmentReference colorAttachmentReference = {};
-		colorAttachmentReference.attachment = 1;	//This is attachment index in (std::array<VkImageView, 3> attachments) in createFrameBuffers()
-		colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;	//Layout before subpass
-
-		//Depth Attachment Reference
-		VkAttachmentReference depthAttachmentReference = {};
-		depthAttachmentReference.attachment = 2;
-		depthAttachmentReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;		//Layout before subpass
-
-		//Array of subpasses
-		std::array<VkSubpassDescription, 2> subpasses{};
-		
-		std::vector<VkAttachmentReference> colorAttachmentRefs = {colorAttachmentReference};
-
-		//Setup subpass 1
-		subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;	//pipeline type subpass is to be bound to
-		subpasses[0].colorAttachmentCount = colorAttachmentRefs.size();
-		subpasses[0].pColorAttachments = colorAttachmentRefs.data();
-		subpasses[0].pDepthStencilAttachment = &depthAttachmentReference;
-
-		//2 ATTACHMENTS + REFERENCES
-
-		//Swapchain color attachment
-		VkAttachmentDescription swapchainColorAttachment = {};
-		swapchainColorAttachment.format = swapChainImageFormat;
-		swapchainColorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-		swapchainColorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		swapchainColorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;	//We need to store after rendering to present image on screen
-		swapchainColorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		swapchainColorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		
-		//Framebuffer data will be stored as an image, but images can be given different data layouts
-		//to give optimal use for certain operations
-		swapchainColorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;	//Image data layout before render pass starts
-		swapchainColorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;	//Image data layout after render pass (to change to)
-
-		//Attachment reference uses an attachment index that refers to index in the attachment list passed to renderPassCreateInfo
-		VkAttachmentReference swapchainColorAttachmentReference = {};
-		swapchainColorAttachmentReference.attachment = 0;
-		swapchainColorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-		//References to attachments that subpass will take input from
-		std::array<VkAttachmentReference, 1> inputReferences;
-		inputReferences[0].attachment = 1;	//Color
-		inputReferences[0].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;	//Layout before subpass
-		//inputReferences[1].attachment = 2;	//Depth
-		//inputReferences[1].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;	//Layout before subpass
-
-		//Setup subpass 2
-		subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;	//pipeline type subpass is to be bound to
-		subpasses[1].colorAttachmentCount = 1;
-		subpasses[1].pColorAttachments = &swapchainColorAttachmentReference;
-		subpasses[1].inputAttachmentCount = static_cast<uint32_t>(inputReferences.size());
-		subpasses[1].pInputAttachments = inputReferences.data();
+		const auto attachmentResources = renderGraph.getAttachments(renderPass);
+		//Resource id to attachment index
+		std::vector<uint32_t> attachmentIndices(renderGraph.getResourcesCount(), VK_ATTACHMENT_UNUSED);
+		std::vector<uint32_t> firstAccesses(renderGraph.getResourcesCount(), RenderGraphBarrier::EXTERNAL);
+		std::vector<uint32_t> lastAccesses(renderGraph.getResourcesCount(), RenderGraphBarrier::EXTERNAL);
+		std::vector<VkAttachmentDescription> renderPassAttachments;
+		mAttachmentAspects.clear();
+		for(const auto r : attachmentResources)
+		{
+			const auto& resource = renderGraph.getResource(r);
+			//First and last access inside of render pass, first access after it
+			uint32_t firstAccess = RenderGraphBarrier::EXTERNAL;
+			uint32_t lastAccess = RenderGraphBarrier::EXTERNAL;
+			uint32_t nextAccess = RenderGraphBarrier::EXTERNAL;
+			for(uint32_t p = firstPass; p < renderGraph.getPassesCount(); p++)
+			{
+				if(resource.mLayouts[p] == VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					continue;
+				}
+				if(p <= lastPass)
+				{
+					firstAccess = firstAccess == RenderGraphBarrier::EXTERNAL ? p : firstAccess;
+					lastAccess = p;
+				}
+				else if(nextAccess == RenderGraphBarrier::EXTERNAL)
+				{
+					nextAccess = p;
+				}
+			}
+
+			bool written = false;
+			for(const auto& access : renderGraph.getPass(firstAccess).mAccesses)
+			{
+				written = written || (access.mResource == r && isWriteUsage(access.mUsage));
+			}
+			const bool firstInFrame = firstAccess == resource.mFirstPass;
+			VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			if(firstInFrame && written)
+			{
+				loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			}
+			else if(firstInFrame && !resource.mDesc.mExternal)
+			{
+				loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			}
+			//Content is needed after render pass by later passes or by presentation
+			const bool store = resource.mDesc.mExternal || nextAccess != RenderGraphBarrier::EXTERNAL;
+
+			VkAttachmentDescription attachment = {};
+			attachment.format = resource.mDesc.mFormat;
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = loadOp;	//Before render pass
+			attachment.storeOp = store ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;	//After render pass
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = renderGraph.getLayoutBefore(r, firstAccess);	//Image data layout before render pass starts
+			//Image data layout after render pass (to change to): layout of the next access
+			attachment.finalLayout = nextAccess != RenderGraphBarrier::EXTERNAL ? resource.mLayouts[nextAccess] : resource.mFinalLayout;
+
+			attachmentIndices[r] = static_cast<uint32_t>(renderPassAttachments.size());
+			firstAccesses[r] = firstAccess;
+			lastAccesses[r] = lastAccess;
+			renderPassAttachments.push_back(attachment);
+			mAttachmentAspects.push_back(resource.mDesc.mAspect);
+		}
+
+		//SUBPASSES
+		const uint32_t subpassesCount = static_cast<uint32_t>(passes.size());
+		std::vector<std::vector<VkAttachmentReference>> colorReferences(subpassesCount);
+		std::vector<std::vector<VkAttachmentReference>> inputReferences(subpassesCount);
+		std::vector<VkAttachmentReference> depthReferences(subpassesCount);
+		std::vector<std::vector<uint32_t>> preserveReferences(subpassesCount);
+		std::vector<VkSubpassDescription> subpasses(subpassesCount);
+		for(uint32_t s = 0; s < subpassesCount; s++)
+		{
+			const uint32_t p = passes[s];
+			depthReferences[s] = { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED };
+			for(const auto& access : renderGraph.getPass(p).mAccesses)
+			{
+				const auto& resource = renderGraph.getResource(access.mResource);
+				//Layout before subpass
+				VkAttachmentReference reference = { attachmentIndices[access.mResource], resource.mLayouts[p] };
+				switch(access.mUsage)
+				{
+					case ERenderGraphUsage::ColorAttachment: colorReferences[s].push_back(reference);
+						break;
+					case ERenderGraphUsage::DepthAttachment:
+					case ERenderGraphUsage::DepthReadOnly:
+						depthReferences[s] = reference;
+						break;
+					case ERenderGraphUsage::InputAttachment: inputReferences[s].push_back(reference);
+						break;
+					default:
+						break;
+				}
+			}
+
+			//Attachments which are not used by subpass, but used before and after it must be preserved
+			for(const auto r : attachmentResources)
+			{
+				const auto& resource = renderGraph.getResource(r);
+				if(firstAccesses[r] < p && p < lastAccesses[r] && resource.mLayouts[p] == VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					preserveReferences[s].push_back(attachmentIndices[r]);
+				}
+			}
+
+			subpasses[s].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;	//pipeline type subpass is to be bound to
+			subpasses[s].colorAttachmentCount = static_cast<uint32_t>(colorReferences[s].size());
+			subpasses[s].pColorAttachments = colorReferences[s].data();
+			subpasses[s].pDepthStencilAttachment = depthReferences[s].attachment != VK_ATTACHMENT_UNUSED ? &depthReferences[s] : nullptr;
+			subpasses[s].inputAttachmentCount = static_cast<uint32_t>(inputReferences[s].size());
+			subpasses[s].pInputAttachments = inputReferences[s].data();
+			subpasses[s].preserveAttachmentCount = static_cast<uint32_t>(preserveReferences[s].size());
+			subpasses[s].pPreserveAttachments = preserveReferences[s].data();
+		}
 
 		//SUBPASS DEPENDENCIES
-		//Need to determine when layout transitions occur using subpass dependencies
-		std::array<VkSubpassDependency, 3> subpassDependencies;
-
-		//Convertion from VK_IMAGE_LAYOUT_UNDEFINED to VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-		//Transition must happen after...
-		subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;		//Subpass index (VK_SUBPASS_EXTERNAL = Special value meaning outside of renderpass)
-		subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;		//Pipeline stage
-		subpassDependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;				//Stage access mask (memory access)
-		//But must happen before
-		subpassDependencies[0].dstSubpass = 0;
-		subpassDependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[0].dependencyFlags = 0;
-
-		//Subpass 1 layout (color/depth) to Subpass 2 layout (shader read)
-		subpassDependencies[1].srcSubpass = 0;
-		subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[1].dstSubpass = 1;
-		subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[1].dependencyFlags = 0;
-
-		//Convertion from VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-		//Transition must happen after...
-		subpassDependencies[2].srcSubpass = 0;
-		subpassDependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		subpassDependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-		//But must happen before
-		subpassDependencies[2].dstSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[2].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-		subpassDependencies[2].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-		subpassDependencies[2].dependencyFlags = 0;
-
-		/*subpassDependencies[3].srcSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[3].dstSubpass = 1;
-		subpassDependencies[3].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
-		subpassDependencies[3].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		subpassDependencies[3].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[3].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[3].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-		subpassDependencies[4].srcSubpass = 1;
-		subpassDependencies[4].dstSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[4].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		subpassDependencies[4].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
-		subpassDependencies[4].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[4].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[4].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;*/
-
-		//That was color attachments dependencies. Now add depth dependencies
-		/*subpassDependencies[3].srcSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[3].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		subpassDependencies[3].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		//But must happen before
-		subpassDependencies[3].dstSubpass = 0;
-		subpassDependencies[3].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		subpassDependencies[3].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[3].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-		subpassDependencies[4].srcSubpass = 0;
-		subpassDependencies[4].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		subpassDependencies[4].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[4].dstSubpass = 1;
-		subpassDependencies[4].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		subpassDependencies[4].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		subpassDependencies[4].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-		//Convertion from VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-		//Transition must happen after...
-		subpassDependencies[5].srcSubpass = 1;
-		subpassDependencies[5].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
-		subpassDependencies[5].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-		//But must happen before
-		subpassDependencies[5].dstSubpass = VK_SUBPASS_EXTERNAL;
-		subpassDependencies[5].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		subpassDependencies[5].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		subpassDependencies[5].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;*/
-
-		std::array<VkAttachmentDescription, 3> renderPassAttachments = { swapchainColorAttachment, colorAttachment, depthAttachment };
+		//Layout transitions happen inside dependencies derived from graph barriers.
+		//Barriers to and from passes of other render passes become external dependencies
+		std::vector<VkSubpassDependency> subpassDependencies;
+		auto addBarrier = [&](const RenderGraphBarrier& barrier)
+			{
+				const uint32_t srcSubpass = getSubpass(barrier.mSrcPass);
+				const uint32_t dstSubpass = getSubpass(barrier.mDstPass);
+				if(srcSubpass != VK_SUBPASS_EXTERNAL || dstSubpass != VK_SUBPASS_EXTERNAL)
+				{
+					addDependency(subpassDependencies, barrier, srcSubpass, dstSubpass);
+				}
+			};
+		for(uint32_t p = 0; p < renderGraph.getPassesCount(); p++)
+		{
+			for(const auto& barrier : renderGraph.getBarriers(p))
+			{
+				addBarrier(barrier);
+			}
+		}
+		for(const auto& barrier : renderGraph.getFinalBarriers())
+		{
+			addBarrier(barrier);
+		}
 
 		//Create info for render pass
 		VkRenderPassCreateInfo renderPassCreateInfo = {};
@@ -197,30 +231,39 @@ namespace fre
 
 		VK_CHECK(vkCreateRenderPass(mainDevice.logicalDevice, &renderPassCreateInfo, nullptr, &mRenderPass));
 
-		LOG_INFO("Render pass created");
+		LOG_INFO("Render pass created: {} attachments, {} subpasses, {} dependencies",
+			renderPassAttachments.size(), subpasses.size(), subpassDependencies.size());
     }
 
     void VulkanRenderPass::begin(
         VkFramebuffer swapChainFrameBuffer,
-        VkExtent2D swapChainExtent, VkCommandBuffer commandBuffer,
-		const vec4& clearColor)
+        VkExtent2D renderArea, VkCommandBuffer commandBuffer,
+		const vec4& clearColor, VkSubpassContents contents)
     {
-        std::array<VkClearValue, 3> clearValues = {};
-		clearValues[0].color = {clearColor.r, clearColor.g, clearColor.b, clearColor.a};
-		clearValues[1].color = {clearColor.r, clearColor.g, clearColor.b, clearColor.a};
-		clearValues[2].depthStencil.depth = 1.0f;
+        std::vector<VkClearValue> clearValues(mAttachmentAspects.size());
+		for(uint32_t i = 0; i < clearValues.size(); i++)
+		{
+			if((mAttachmentAspects[i] & VK_IMAGE_ASPECT_DEPTH_BIT) != 0)
+			{
+				clearValues[i].depthStencil.depth = 1.0f;
+			}
+			else
+			{
+				clearValues[i].color = {clearColor.r, clearColor.g, clearColor.b, clearColor.a};
+			}
+		}
 
 		//Information about how to begin render pass (only need for graphical applications)
 		VkRenderPassBeginInfo renderPassBeginInfo = {};
 		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassBeginInfo.renderPass = mRenderPass;
 		renderPassBeginInfo.renderArea.offset = { 0, 0 };	//Start point in pixels
-		renderPassBeginInfo.renderArea.extent = swapChainExtent;
+		renderPassBeginInfo.renderArea.extent = renderArea;
 		renderPassBeginInfo.pClearValues = clearValues.data();
 		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassBeginInfo.framebuffer = swapChainFrameBuffer;
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, contents);
     }
 
     void VulkanRenderPass::end(VkCommandBuffer commandBuffer)
@@ -27,8 +27,11 @@
 
 #include <spdlog/fmt/bin_to_hex.h>
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
 #include <stdexcept>
+#include <tuple>
 #include <mutex>
 
 #ifdef NDEBUG
@@ -44,6 +47,14 @@ using namespace glm;
 namespace fre
 {
     std::mutex gRenderMutex;
+
+	//Instance data drawn in place of pushed model matrix of render object
+	static void writeMeshInstance(const RenderObjectTable& renderObjects, uint32_t object, MeshInstance& instance)
+	{
+		instance.transform = renderObjects.getTransform(object);
+		instance.color = vec4(1.0f);
+		instance.normalMatrix = renderObjects.getNormalMatrix(object);
+	}
 	
 	VulkanRenderer::VulkanRenderer(ThreadPool& threadPool)
 	: mThreadPool(threadPool)
@@ -76,16 +87,25 @@ namespace fre
 			createSurface();
 			getPhysicalDevice();
 			createLogicalDevice();
+			mPipelineCache.create(mainDevice, mPipelineCacheFileName);
+			mPipelineLibrary.mPipelineCache = mPipelineCache.mPipelineCache;
 			if(isRayTracingSupported())
 			{
 				initRayTracing();
 			}
 			mSwapChain.create(mWindow, mainDevice, mGraphicsQueueFamilyId,
 				mPresentationQueueFamilyId, mSurface);
-			mRenderPass.create(mainDevice, mSwapChain.mSwapChainImageFormat);
+			createRenderGraph();
+			mRenderPasses.resize(mRenderGraph.getRenderPassesCount());
+			for(uint32_t i = 0; i < mRenderPasses.size(); i++)
+			{
+				mRenderPasses[i].create(mainDevice, mRenderGraph, i);
+			}
 			createSwapChainFrameBuffers();
 			mTextureManager.create(mainDevice.logicalDevice);
+			createBindlessTextures();
 			createSynchronisation();
+			mDeletionQueue.create(MAX_FRAME_DRAWS);
 
 			LOG_INFO("VulkanRenderer. Core GPU resources created");
 		}
@@ -101,6 +121,10 @@ namespace fre
 		{
 			createCommandPools();
 			createCommandBuffers();
+			createFrameQueries();
+			createDefaultInstanceBuffer();
+			createFrameUniforms();
+			createCullingPass();
 		}
 		catch (std::runtime_error& e)
 		{
@@ -131,25 +155,33 @@ namespace fre
 		mDepthAttacmentDescriptors.resize(MAX_FRAME_DRAWS);
 		for(uint32_t i = 0; i < mColorAttacmentDescriptors.size(); i++)
 		{
-			mColorAttacmentDescriptors[i] = std::make_shared<DescriptorImage>(
-				VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				mFrameBuffers[i].mColorAttachments[0].mImageView, VK_NULL_HANDLE);
+			//Scene color is sampled with linear filter to upscale it from dynamic resolution
 			auto samplerId = createSampler({ VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_FILTER_LINEAR, VK_FALSE });
+			mColorAttacmentDescriptors[i] = std::make_shared<DescriptorImage>(
+				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				mFrameBuffers[i].getAttachment(mSceneColorResource).mImageView, getSampler(samplerId));
 			mDepthAttacmentDescriptors[i] = std::make_shared<DescriptorImage>(
 				VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
-				mFrameBuffers[i].mColorAttachments[0].mImageView, getSampler(samplerId));
+				mFrameBuffers[i].getAttachment(mSceneColorResource).mImageView, getSampler(samplerId));
 		}
-        mFullscreenTriangleMesh->setBeforeRecordCallback([this](VulkanRenderer* renderer, uint32_t subPass, VkPipelineBindPoint pipelineBindPoint)
-            {
-                mFullscreenTriangleMesh->setDescriptors(
-					//{ { mColorAttacmentDescriptors[mImageIndex], mDepthAttacmentDescriptors[mImageIndex] } }
-					{ { mColorAttacmentDescriptors[mImageIndex] } }
-				);
-            });
-
+		//Descriptors of current swapchain image are set once per frame in recordCommands
 		addMeshModel({ mFullscreenTriangleMesh });
 	}
 
+	void VulkanRenderer::updateAttachmentDescriptors()
+	{
+		const size_t count = std::min(mColorAttacmentDescriptors.size(), mFrameBuffers.size());
+		for(size_t i = 0; i < count; i++)
+		{
+			const VkImageView imageView = mFrameBuffers[i].getAttachment(mSceneColorResource).mImageView;
+			for(const auto& descriptor : { mColorAttacmentDescriptors[i], mDepthAttacmentDescriptors[i] })
+			{
+				static_cast<DescriptorImage&>(*descriptor).mImageView = imageView;
+				descriptor->invalidate();
+			}
+		}
+	}
+
 	int VulkanRenderer::createMeshGPUResources()
 	{
 		LOG_INFO("VulkanRenderer. Create mesh GPU resources");
@@ -178,6 +210,7 @@ namespace fre
 		{
 			loadUsedShaders();
 			createPipelines();
+			createDepthPrePassStreams();
 			loadImages();
 
 			createUI();
@@ -211,14 +244,26 @@ namespace fre
 	{
 		if(mainDevice.logicalDevice != VK_NULL_HANDLE)
 		{
+			//Device is idle, objects released during last frames are destroyed first
+			mDeletionQueue.destroy();
 			cleanupRayTracing();
 
 			cleanupUI();
+			cleanupFrameQueries();
+			cleanupInstanceBuffers();
+			cleanupFrameUniforms();
+			cleanupCullingPass();
 
 			//_aligned_free(modetTransferSpace);
 
 			mBufferManager.destroy(mainDevice.logicalDevice);
 
+			mDescriptorAllocator.destroy(mainDevice.logicalDevice);
+			for(auto& allocator : mFrameDescriptorAllocators)
+			{
+				allocator.destroy(mainDevice.logicalDevice);
+			}
+
             int count = mDescriptorPoolCache.size();
 			for(int i = 0; i < count; i++)
 			{
@@ -254,10 +299,17 @@ namespace fre
 			cleanupComputeFinishedSemaphores();
 			cleanupTransferSynchronisation();
 			cleanupSemaphores();
+			cleanupCommandPools();
 		
 			cleanupPipelines(mainDevice.logicalDevice);
+			mPipelineCache.save(mainDevice.logicalDevice);
+			mPipelineCache.destroy(mainDevice.logicalDevice);
 
-			mRenderPass.destroy(mainDevice.logicalDevice);
+			for(auto& renderPass : mRenderPasses)
+			{
+				renderPass.destroy(mainDevice.logicalDevice);
+			}
+			mRenderPasses.clear();
 		
 			vkDestroyDevice(mainDevice.logicalDevice, nullptr);
 		}
@@ -295,18 +347,72 @@ namespace fre
 		return mDescriptorSetLayoutCache.getByIndex(index);
 	}
 
-    uint32_t VulkanRenderer::createDescriptorSet(const VulkanDescriptorSetKey& key)
+    uint32_t VulkanRenderer::createDescriptorSet(const VulkanDescriptorSetKey& key, const std::vector<VulkanDescriptorPtr>& descriptors)
 	{
-		return mDescriptorSetCache.findOrCreate(key, [this](const VulkanDescriptorSetKey& key)
+		return mDescriptorSetCache.findOrCreate(key, [this, &descriptors](const VulkanDescriptorSetKey& key)
 			{
-                VulkanDescriptorPoolPtr dp = mDescriptorPoolCache.getByIndex(key.mDPId);
                 VulkanDescriptorSetLayoutPtr dsl = mDescriptorSetLayoutCache.getByIndex(key.mDSLId);
 				VulkanDescriptorSetPtr ds = std::make_shared<VulkanDescriptorSet>();
-				ds->allocate(mainDevice.logicalDevice, dp->mDescriptorPool, dsl->mDescriptorSetLayout);
+				ds->mDescriptorSet = mDescriptorAllocator.allocate(mainDevice.logicalDevice, *dsl, ds->mDescriptorPool);
+				ds->mDescriptorSetLayout = dsl->mDescriptorSetLayout;
+				//Key holds everything written, so set never needs update
+				if(!descriptors.empty())
+				{
+					ds->update(mainDevice.logicalDevice, descriptors);
+				}
 				return ds;
 			});
 	}
 
+	void VulkanRenderer::acquireDescriptorSet(const uint32_t index)
+	{
+		getDescriptorSet(index)->mReferences++;
+		mDescriptorSetReferences++;
+	}
+
+	void VulkanRenderer::releaseDescriptorSet(const uint32_t index)
+	{
+		auto& descriptorSet = getDescriptorSet(index);
+		assert(descriptorSet->mReferences > 0);
+		mDescriptorSetReferences--;
+		if(--descriptorSet->mReferences == 0)
+		{
+			descriptorSet->mUnusedSinceFrame = mFrameNumber;
+			mUnusedDescriptorSets.push_back(index);
+		}
+	}
+
+	void VulkanRenderer::destroyUnusedDescriptorSets(bool all)
+	{
+		//Frames in flight may still use set. Sets of per swapchain image inputs are used
+		//again in a few frames, they are kept a bit longer to not recreate them
+		const uint32_t retainFrames = all ? 0 : 2 * MAX_FRAME_DRAWS;
+		auto destroyedIt = std::remove_if(mUnusedDescriptorSets.begin(), mUnusedDescriptorSets.end(),
+			[this, retainFrames](uint32_t index)
+			{
+				auto& descriptorSet = getDescriptorSet(index);
+				if(descriptorSet->mReferences > 0)
+				{
+					return true;
+				}
+				if(mFrameNumber - descriptorSet->mUnusedSinceFrame < retainFrames)
+				{
+					return false;
+				}
+				mDescriptorAllocator.release(mainDevice.logicalDevice, descriptorSet->mDescriptorPool);
+				mDescriptorSetCache.erase(index);
+				return true;
+			});
+		mUnusedDescriptorSets.erase(destroyedIt, mUnusedDescriptorSets.end());
+	}
+
+	VkDescriptorSet VulkanRenderer::allocateFrameDescriptorSet(const uint32_t dslId)
+	{
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		return mFrameDescriptorAllocators[mCurrentFrame].allocate(mainDevice.logicalDevice,
+			*mDescriptorSetLayoutCache.getByIndex(dslId), pool);
+	}
+
 	VulkanDescriptorSetPtr& VulkanRenderer::getDescriptorSet(const uint32_t index)
 	{
         return mDescriptorSetCache.getByIndex(index);
@@ -316,9 +422,15 @@ namespace fre
 	{
         assert(setIds.size() > 0 && "No descriptor sets to bind");
 		std::vector<VkDescriptorSet> sets;
+		//Frame uniforms set is the only one with dynamic buffer
+		std::vector<uint32_t> dynamicOffsets;
 		for(const auto s : setIds)
 		{
 			sets.push_back(getDescriptorSet(s)->mDescriptorSet);
+			if(s == mFrameUniformsSetId)
+			{
+				dynamicOffsets.push_back(static_cast<uint32_t>(mFrameUniformsBuffer.getOffset(mImageIndex)));
+			}
 		}
 
 		vkCmdBindDescriptorSets(
@@ -330,8 +442,8 @@ namespace fre
 			0,
 			sets.size(),
 			sets.data(),
-			0,
-			nullptr);
+			static_cast<uint32_t>(dynamicOffsets.size()),
+			dynamicOffsets.data());
 	}
 
 	uint32_t VulkanRenderer::createSampler(const VulkanSamplerKey& key)
@@ -353,7 +465,8 @@ namespace fre
 				//Level of details bias for mip level
 				samplerCreateInfo.mipLodBias = 0.0f;
 				samplerCreateInfo.minLod = 0.0f;
-				samplerCreateInfo.maxLod = 0.0f;
+				//Whole mip chain of texture is sampled
+				samplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
 				samplerCreateInfo.anisotropyEnable = VK_TRUE;
 				//Anisotropy sample level
 				samplerCreateInfo.maxAnisotropy = 16.0f;
@@ -408,7 +521,8 @@ namespace fre
 	void VulkanRenderer::updateTextureImage(const VulkanTextureInfoPtr& info)
 	{
 		mTextureManager.updateTextureImage(mainDevice, mTransferQueueFamilyId, mGraphicsQueueFamilyId,
-			mGraphicsQueue, mGraphicsCommandPool, info);
+			mGraphicsQueue, mGraphicsCommandPool, mDeletionQueue, info);
+		invalidateSceneCommands();
 	}
 
 	VulkanBuffer VulkanRenderer::createStagingBuffer(const void* data, size_t size)
@@ -442,7 +556,7 @@ namespace fre
 		return result;
 	}
 
-	void VulkanRenderer::copyBuffer(VkBuffer src, VkBuffer dst, size_t dataSize, VkPipelineBindPoint pipelineBindPoint) const
+	void VulkanRenderer::copyBuffer(VkBuffer src, VkBuffer dst, size_t dataSize, VkPipelineBindPoint pipelineBindPoint)
 	{
 		fre::copyBuffer(mainDevice.logicalDevice,
 			pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mComputeQueue : mTransferQueue,
@@ -453,6 +567,7 @@ namespace fre
 	MeshModel::Ptr& VulkanRenderer::addMeshModel(const MeshModel::MeshList& meshList)
 	{
 		mMeshModels.push_back(MeshModel::Ptr(new MeshModel(meshList)));
+		changeSceneVersion();
 		return mMeshModels.back();
 	}
 
@@ -512,9 +627,13 @@ namespace fre
 
 				VK_CHECK(vkResetFences(mainDevice.logicalDevice, 1, &mComputeFences[mCurrentFrame]));
 
+				//Compute buffers of frame slot aren't used by GPU anymore
+				mComputeFrameCommandPools.beginFrame(mainDevice.logicalDevice, mCurrentFrame);
+				mComputeCommandBuffers[mImageIndex].mCommandBuffer = mComputeFrameCommandPools.acquire(mainDevice.logicalDevice);
 				const auto commandBuffer = mComputeCommandBuffers[mImageIndex];
-				VK_CHECK(vkResetCommandBuffer(commandBuffer.mCommandBuffer, 0));
 				commandBuffer.begin();
+				//Compute commands are recorded before frame commands, so objects are gathered for them separately
+				prepareRenderObjects();
 				recordSceneCommands(camera, light, VK_PIPELINE_BIND_POINT_COMPUTE, 0);
 				commandBuffer.end();
 
@@ -545,6 +664,33 @@ namespace fre
 			//Wait for given fence to signal (open) from last draw before continuing
 			VK_CHECK(vkWaitForFences(mainDevice.logicalDevice, 1, &mDrawFences[mCurrentFrame],
 				VK_TRUE, std::numeric_limits<uint32_t>::max()));
+			//Transient sets of frame slot aren't used by GPU anymore
+			if(mFrameDescriptorAllocators[mCurrentFrame].isCreated())
+			{
+				mFrameDescriptorAllocators[mCurrentFrame].reset(mainDevice.logicalDevice);
+			}
+			destroyUnusedDescriptorSets();
+			//Pipeline variants of materials not drawn for a while are evicted, reused scene commands may bind them
+			bool pipelinesEvicted = false;
+			for(auto& pipeline : mPipelines)
+			{
+				pipelinesEvicted = pipeline.update(mFrameNumber) || pipelinesEvicted;
+			}
+			if(pipelinesEvicted)
+			{
+				invalidateSceneCommands();
+			}
+			//Objects released while slot was recorded before aren't used by GPU anymore
+			mDeletionQueue.beginFrame(mCurrentFrame);
+			mGraphicsFrameCommandPools.beginFrame(mainDevice.logicalDevice, mCurrentFrame);
+			//Textures created from image headers get data of images decoded since previous frame
+			mTextureManager.uploadLoadedImages(mainDevice, mTransferQueueFamilyId, mGraphicsQueueFamilyId,
+				mGraphicsQueue, mGraphicsCommandPool, mDeletionQueue);
+			//Textures get levels streamed for previous frames
+			mTextureManager.updateStreaming(mainDevice, mTransferQueueFamilyId, mGraphicsQueueFamilyId,
+				mGraphicsQueue, mGraphicsCommandPool, mDeletionQueue, mThreadPool);
+			//Material entries changed by uploads above and since the slot was recorded last time
+			mTextureManager.updateMaterialTable(mCurrentFrame);
 
 			//Get index of next image to be drawn to, and signal semaphore when ready to be drawn to
 			VkResult result = vkAcquireNextImageKHR(mainDevice.logicalDevice, mSwapChain.mSwapChain,
@@ -566,7 +712,7 @@ namespace fre
 				//Manually reset (close) fences
 				VK_CHECK(vkResetFences(mainDevice.logicalDevice, 1, &mDrawFences[mCurrentFrame]));
 			
-				VK_CHECK(vkResetCommandBuffer(mGraphicsCommandBuffers[mCurrentFrame].mCommandBuffer, 0));
+				mGraphicsCommandBuffers[mImageIndex].mCommandBuffer = mGraphicsFrameCommandPools.acquire(mainDevice.logicalDevice);
 
 				recordCommands(camera, light);
 
@@ -671,12 +817,41 @@ namespace fre
 			ImGui::Render();
 			ImDrawData* draw_data = ImGui::GetDrawData();
 			ImGui_ImplVulkan_RenderDrawData(draw_data, mGraphicsCommandBuffers[mImageIndex].mCommandBuffer);
+			//UI pushes its own constants
+			resetPushedConstants();
 			mUIFrameStarted = false;
 		}
 	}
 
 	void VulkanRenderer::pushConstants(VkPushConstantRange pushConstants, const void* data, VkPipelineLayout pipelineLayout, VkPipelineBindPoint pipelineBindPoint)
 	{
+		if(pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+		{
+			//Most draws push the same lighting and model matrix, equal constants stay valid for the same layout
+			if(pipelineLayout != mPushedLayout)
+			{
+				resetPushedConstants();
+				mPushedLayout = pipelineLayout;
+			}
+			const uint32_t end = pushConstants.offset + pushConstants.size;
+			if(mPushedConstants.size() < end)
+			{
+				mPushedConstants.resize(end);
+				mPushedConstantsMask.resize(end, 0);
+			}
+			uint8_t* pushed = mPushedConstants.data() + pushConstants.offset;
+			uint8_t* mask = mPushedConstantsMask.data() + pushConstants.offset;
+			if(std::find(mask, mask + pushConstants.size, 0) == mask + pushConstants.size &&
+				memcmp(pushed, data, pushConstants.size) == 0)
+			{
+				mRecordingStatistics.mSkippedPushConstants++;
+				return;
+			}
+			memcpy(pushed, data, pushConstants.size);
+			std::fill(mask, mask + pushConstants.size, 1);
+			mRecordingStatistics.mPushConstants++;
+		}
+
         vkCmdPushConstants(
 			pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mComputeCommandBuffers[mImageIndex].mCommandBuffer : mGraphicsCommandBuffers[mImageIndex].mCommandBuffer,
             pipelineLayout,
@@ -889,25 +1064,13 @@ namespace fre
 
 		// Build the acceleration structure on the device via a one-time command buffer submission
 		// Some implementations may support acceleration structure building on the host (VkPhysicalDeviceAccelerationStructureFeaturesKHR->accelerationStructureHostCommands), but we prefer device builds
-		VulkanCommandBuffer command_buffer;
-		command_buffer.allocate(mGraphicsCommandPool, mainDevice.logicalDevice);
-		command_buffer.begin();
+		VkCommandBuffer commandBuffer = mGraphicsCommandPool.begin(mainDevice.logicalDevice);
 		vkCmdBuildAccelerationStructuresKHR(
-			command_buffer.mCommandBuffer,
+			commandBuffer,
 			1,
 			&acceleration_build_geometry_info,
 			acceleration_build_structure_range_infos.data());
-
-		// Create fence to ensure that the command buffer has finished executing
-		VkFenceCreateInfo fence_info{};
-		fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-		fence_info.flags = 0;
-		VkFence fence;
-		VK_CHECK(vkCreateFence(mainDevice.logicalDevice, &fence_info, nullptr, &fence));
-		std::vector<VkSemaphore> semaphores;
-		command_buffer.flush(mainDevice.logicalDevice, mGraphicsQueue, fence, semaphores);
-
-		vkDestroyFence(mainDevice.logicalDevice, fence, nullptr);
+		mGraphicsCommandPool.endAndSubmit(mainDevice.logicalDevice, mGraphicsQueue, commandBuffer);
 
 		mBufferManager.destroyBuffer(mainDevice.logicalDevice, scratch_buffer);
 
@@ -956,16 +1119,18 @@ namespace fre
 		mDefaultShininess = shininess;
 	}
 
-	void VulkanRenderer::fillLightingPushConstant(const Mesh::Ptr& mesh, const mat4& modelMatrix, const Camera& camera, const Light& light, Lighting& lighting)
+	void VulkanRenderer::fillLightingPushConstant(const Mesh::Ptr& mesh, const mat4& modelMatrix, Lighting& lighting)
 	{
-		mat3 normalMatrix(modelMatrix);
-		normalMatrix = transpose(inverse(normalMatrix));
-		lighting.normalMatrix = mat4(normalMatrix);
-		lighting.cameraEye = vec4(-camera.getEye(), 0.0);
-		const auto& material = mMaterials[mesh->getMaterialId()];
-		lighting.lightPos = vec4(light.mPosition, material.mShininess);
-		lighting.lightDiffuseColor = vec4(light.mDiffuseColor, 1.0f);
-		lighting.lightSpecularColor = vec4(light.mSpecularColor, 1.0f);
+		if(mRecordingNormalMatrix != nullptr)
+		{
+			lighting.normalMatrix = *mRecordingNormalMatrix;
+		}
+		else
+		{
+			lighting.normalMatrix = getNormalMatrix(modelMatrix);
+		}
+		lighting.material.x = mesh->getMaterialId();
+		lighting.materialParams.x = mMaterials[mesh->getMaterialId()].mShininess;
 	}
 
 	void VulkanRenderer::transitionDepthLayout(VkImageLayout from, VkImageLayout to, VkPipelineBindPoint pipelineBindPoint)
@@ -973,7 +1138,7 @@ namespace fre
 		transitionImageLayout(mainDevice.logicalDevice,
 			pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mComputeQueue : mGraphicsQueue,
 			pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mComputeCommandPool : mGraphicsCommandPool,
-			mFrameBuffers[mImageIndex].mDepthAttachment.mImage,
+			mFrameBuffers[mImageIndex].getAttachment(mSceneDepthResource).mImage,
 			VK_IMAGE_ASPECT_DEPTH_BIT,
 			from, to);
 	}
@@ -982,6 +1147,8 @@ namespace fre
 	{
 		assert(id < mMaterials.size());
 
+		//Material may be changed through reference
+		changeSceneVersion();
 		return mMaterials[id];
 	}
 
@@ -1028,6 +1195,138 @@ namespace fre
 		mDeviceFeatures.features.wideLines = VK_TRUE;
 		mDeviceFeatures.features.samplerAnisotropy = VK_TRUE;
 		mLastDeviceFeatures = &mDeviceFeatures.pNext;
+
+		//Optional. Reduce pipeline permutations and compile hitches if supported
+		mExtendedDynamicStateFeatures = queryDeviceFeature<VkPhysicalDeviceExtendedDynamicStateFeaturesEXT>(
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT);
+		mGraphicsPipelineLibraryFeatures = queryDeviceFeature<VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT>(
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT);
+		//Bindless textures
+		mDescriptorIndexingFeatures = queryDeviceFeature<VkPhysicalDeviceDescriptorIndexingFeatures>(
+			VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES);
+	}
+
+	template<typename T>
+	T* VulkanRenderer::queryDeviceFeature(VkStructureType structureType)
+	{
+		auto storage = std::make_unique<FeatureStorage<T>>();
+		auto* feature = static_cast<T*>(storage->get());
+		feature->sType = structureType;
+		feature->pNext = nullptr;
+		*mLastDeviceFeatures = feature;
+		mLastDeviceFeatures = &feature->pNext;
+		mFeatureChain.push_back(std::move(storage));
+
+		return feature;
+	}
+
+	void VulkanRenderer::removeDeviceFeature(void* feature)
+	{
+		void** link = &mDeviceFeatures.pNext;
+		while(*link != nullptr)
+		{
+			auto* current = static_cast<VkBaseOutStructure*>(*link);
+			if(current == feature)
+			{
+				*link = current->pNext;
+				if(mLastDeviceFeatures == reinterpret_cast<void**>(&current->pNext))
+				{
+					mLastDeviceFeatures = link;
+				}
+				current->pNext = nullptr;
+				break;
+			}
+			link = reinterpret_cast<void**>(&current->pNext);
+		}
+	}
+
+	bool VulkanRenderer::isDeviceExtensionAvailable(VkPhysicalDevice device, const char* extensionName)
+	{
+		uint32_t extensionCount = 0;
+		VK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr));
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		VK_CHECK(vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data()));
+
+		for(const auto& extension : extensions)
+		{
+			if(strcmp(extensionName, extension.extensionName) == 0)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void VulkanRenderer::enableOptionalDeviceFeatures()
+	{
+		//Feature structs hold supported values of selected device
+		vkGetPhysicalDeviceFeatures2(mainDevice.physicalDevice, &mDeviceFeatures);
+
+		auto& support = mPipelineLibrary.mSupport;
+		support.mExtendedDynamicState =
+			mExtendedDynamicStateFeatures != nullptr &&
+			mExtendedDynamicStateFeatures->extendedDynamicState == VK_TRUE &&
+			isDeviceExtensionAvailable(mainDevice.physicalDevice, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+		if(support.mExtendedDynamicState)
+		{
+			addDeviceExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+		}
+		else if(mExtendedDynamicStateFeatures != nullptr)
+		{
+			removeDeviceFeature(mExtendedDynamicStateFeatures);
+		}
+
+		support.mGraphicsPipelineLibrary =
+			mGraphicsPipelineLibraryFeatures != nullptr &&
+			mGraphicsPipelineLibraryFeatures->graphicsPipelineLibrary == VK_TRUE &&
+			isDeviceExtensionAvailable(mainDevice.physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+			isDeviceExtensionAvailable(mainDevice.physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+		if(support.mGraphicsPipelineLibrary)
+		{
+			addDeviceExtension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			addDeviceExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+		}
+		else if(mGraphicsPipelineLibraryFeatures != nullptr)
+		{
+			removeDeviceFeature(mGraphicsPipelineLibraryFeatures);
+		}
+
+		const bool descriptorIndexing =
+			mDescriptorIndexingFeatures != nullptr &&
+			mDescriptorIndexingFeatures->runtimeDescriptorArray == VK_TRUE &&
+			mDescriptorIndexingFeatures->descriptorBindingPartiallyBound == VK_TRUE &&
+			mDescriptorIndexingFeatures->descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+			isDeviceExtensionAvailable(mainDevice.physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+		if(descriptorIndexing)
+		{
+			addDeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+			mBindlessTextureFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+			//New textures are written while frames in flight use other slots
+			if(mDescriptorIndexingFeatures->descriptorBindingUpdateUnusedWhilePending == VK_TRUE)
+			{
+				mBindlessTextureFlags |= VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+			}
+		}
+		else if(mDescriptorIndexingFeatures != nullptr)
+		{
+			removeDeviceFeature(mDescriptorIndexingFeatures);
+		}
+
+		//Culled draws are drawn with count written by culling pass. Count draws replace multi-draws, so both are needed
+		mDrawIndirectCount = mDeviceFeatures.features.multiDrawIndirect == VK_TRUE &&
+			isDeviceExtensionAvailable(mainDevice.physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		if(mDrawIndirectCount)
+		{
+			addDeviceExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+		}
+
+		//Feature is enabled with other supported ones, textures are compressed only if it is there
+		const bool textureCompressionBC = mDeviceFeatures.features.textureCompressionBC == VK_TRUE;
+		mTextureManager.setBlockCompressionSupported(textureCompressionBC);
+
+		LOG_INFO("Extended dynamic state: {}, graphics pipeline library: {}, draw indirect count: {}, bindless textures: {}, BC textures: {}",
+			support.mExtendedDynamicState, support.mGraphicsPipelineLibrary, mDrawIndirectCount, descriptorIndexing, textureCompressionBC);
 	}
 
     void VulkanRenderer::createInstance()
@@ -1159,6 +1458,8 @@ namespace fre
 			}
 		}
 
+		enableOptionalDeviceFeatures();
+
 		//Information to create logical device
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -1214,33 +1515,82 @@ namespace fre
 		LOG_INFO("Logical device created");
 	}
 
+	void VulkanRenderer::createRenderGraph()
+	{
+		LOG_INFO("Create render graph");
+
+		mRenderGraph.clear();
+
+		RenderGraphResourceDesc swapChainDesc;
+		swapChainDesc.mName = "swapChain";
+		swapChainDesc.mFormat = mSwapChain.mSwapChainImageFormat;
+		swapChainDesc.mExternal = true;
+		swapChainDesc.mFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		mSwapChainResource = mRenderGraph.addResource(swapChainDesc);
+
+		RenderGraphResourceDesc sceneColorDesc;
+		sceneColorDesc.mName = "sceneColor";
+		sceneColorDesc.mFormat = chooseSupportedImageFormat(
+			mainDevice.physicalDevice,
+			getImageFormats(COLOR_ATTACHMENT),
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+		mSceneColorResource = mRenderGraph.addResource(sceneColorDesc);
+
+		RenderGraphResourceDesc sceneDepthDesc;
+		sceneDepthDesc.mName = "sceneDepth";
+		sceneDepthDesc.mFormat = chooseSupportedImageFormat(
+			mainDevice.physicalDevice,
+			getImageFormats(DEPTH_ATTACHMENT),
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		sceneDepthDesc.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		mSceneDepthResource = mRenderGraph.addResource(sceneDepthDesc);
+
+		//Pass 0: scene geometry, rendered at dynamic resolution
+		const uint32_t geometryPass = mRenderGraph.addPass("geometry", true);
+		mGeometryPass = geometryPass;
+		mRenderGraph.write(geometryPass, mSceneColorResource, ERenderGraphUsage::ColorAttachment);
+		mRenderGraph.write(geometryPass, mSceneDepthResource, ERenderGraphUsage::DepthAttachment);
+
+		//Pass 1: post process of scene color and UI at full resolution.
+		//Scene color is sampled to upscale it, so post process starts new render pass
+		const uint32_t postProcessPass = mRenderGraph.addPass("postProcess");
+		mRenderGraph.read(postProcessPass, mSceneColorResource, ERenderGraphUsage::Sampled);
+		//Hi-Z pyramid for occlusion culling of next frame is built from scene depth between passes
+		if(mCullingSettings.mEnabled && mCullingSettings.mOcclusion)
+		{
+			mRenderGraph.read(postProcessPass, mSceneDepthResource, ERenderGraphUsage::Sampled);
+		}
+		mRenderGraph.write(postProcessPass, mSwapChainResource, ERenderGraphUsage::ColorAttachment);
+
+		mRenderGraph.compile();
+
+		LOG_INFO("Render graph created");
+	}
+
 	void VulkanRenderer::createSwapChainFrameBuffers()
 	{
 		LOG_INFO("Create swapchain framebuffers");
 
 		mFrameBuffers.resize(mSwapChain.mSwapChainImages.size());
 		
-		for (size_t i = 0; i < mSwapChain.mSwapChainImages.size(); i++)
+		std::vector<VkRenderPass> renderPasses(mRenderPasses.size());
+		for(size_t i = 0; i < mRenderPasses.size(); i++)
 		{
-			VulkanAttachment colorAttachment;
-			VulkanAttachment depthAttachment;
-			
-			colorAttachment.create(mainDevice, COLOR_ATTACHMENT, mSwapChain.mSwapChainExtent);
-			depthAttachment.create(mainDevice, DEPTH_ATTACHMENT, mSwapChain.mSwapChainExtent);
+			renderPasses[i] = mRenderPasses[i].mRenderPass;
+		}
 
-			std::vector<VkImageView> attachmentsViews =
-			{
-				mSwapChain.mSwapChainImages[i].imageView,
-				colorAttachment.mImageView,
-				depthAttachment.mImageView
-			};
+		for (size_t i = 0; i < mSwapChain.mSwapChainImages.size(); i++)
+		{
+			std::vector<VkImageView> externalViews(mRenderGraph.getResourcesCount(), VK_NULL_HANDLE);
+			externalViews[mSwapChainResource] = mSwapChain.mSwapChainImages[i].imageView;
 
 			mFrameBuffers[i].create(mainDevice,
-				attachmentsViews,
+				mRenderGraph,
+				externalViews,
 				mSwapChain.mSwapChainExtent,
-				mRenderPass.mRenderPass);
-			mFrameBuffers[i].addColorAttachment(colorAttachment);
-			mFrameBuffers[i].setDepthAttachment(depthAttachment);
+				renderPasses);
 		}
 
 		LOG_INFO("Swapchain framebuffers created");
@@ -1270,13 +1620,16 @@ namespace fre
 
 	void VulkanRenderer::createPipelines()
 	{
+		//Merged draws and scene commands hold pipelines
+		changeSceneVersion();
 		for(auto& shader : mShaders)
 		{
 			LOG_TRACE("Create pipeline for shader: {}", shader.mName);
 
 			ShaderMetaDatum& shaderMetaDatum = mShaderMetaDatum[shader.mId];
-			for(const auto& shaderMetaData : shaderMetaDatum)
+			for(uint32_t metaDataIndex = 0; metaDataIndex < shaderMetaDatum.size(); metaDataIndex++)
 			{
+				const auto& shaderMetaData = shaderMetaDatum[metaDataIndex];
 				std::vector<VkDescriptorSetLayout> dsls(shader.mDSLs.size());
 				for(int i = 0; i < shader.mDSLs.size(); i++)
 				{
@@ -1291,7 +1644,8 @@ namespace fre
 						mainDevice.logicalDevice,
 						shader.mComputeShader,
 						shaderMetaData.mDescriptorSetLayouts.empty() ? dsls : shaderMetaData.mDescriptorSetLayouts,
-						shaderMetaData.mPushConstantRanges);
+						shaderMetaData.mPushConstantRanges,
+						mPipelineCache.mPipelineCache);
 				}
 
 				if(
@@ -1301,20 +1655,27 @@ namespace fre
 					shader.mGraphicsPipelineIds.push_back(static_cast<uint32_t>(mPipelines.size()));
 					mPipelines.push_back(VulkanPipeline());
 					auto& pipeline = mPipelines.back();
+					const auto& graphPass = mRenderGraph.getPass(shaderMetaData.mSubPassIndex);
 					pipeline.createGeometryPipeline(
 						mainDevice.logicalDevice,
 						{&shader.mVertexShader, &shader.mFragmentShader},
 						shaderMetaData.mTopology,
 						shaderMetaData.mVertexSize,
 						shaderMetaData.mVertexAttributes,
+						shaderMetaData.mInstanceSize,
+						shaderMetaData.mInstanceAttributes,
 						shaderMetaData.mDepthTestEnabled ? VK_TRUE : VK_FALSE,
-						mRenderPass.mRenderPass,
-						shaderMetaData.mSubPassIndex,
+						mRenderPasses[graphPass.mRenderPass].mRenderPass,
+						graphPass.mSubpass,
 						shaderMetaData.mDescriptorSetLayouts.empty() ? dsls : shaderMetaData.mDescriptorSetLayouts,
 						shaderMetaData.mPushConstantRanges,
 						shaderMetaData.mAttachmentsCount,
 						shaderMetaData.mLineWidth,
-						shaderMetaData.mCullMode
+						shaderMetaData.mCullMode,
+						shaderMetaData.mHasVariants,
+						&mPipelineLibrary,
+						{ shader.mId, metaDataIndex, graphPass.mRenderPass },
+						mPipelineCache.mPipelineCache
 					);
 				}
 
@@ -1330,7 +1691,8 @@ namespace fre
 						mainDevice.logicalDevice,
 						{&shader.mRayGenShader, &shader.mRayMissShader,&shader.mRayClosestHitShader},
 						dsls,
-						shaderMetaData.mPushConstantRanges);
+						shaderMetaData.mPushConstantRanges,
+						mPipelineCache.mPipelineCache);
 					pipeline.createShaderBindingTables(mainDevice, mTransferQueue, mTransferCommandPool,
 						mRayTracingPipelineProperties, mBufferManager);
 				}
@@ -1338,11 +1700,54 @@ namespace fre
 			}
 			
 			//Destroy shader modules, no longer needed after Pipeline created
-			shader.destroy(mainDevice.logicalDevice);
+			//Shaders with variants keep modules to create new variants on demand
+			const bool hasVariants = std::any_of(shaderMetaDatum.begin(), shaderMetaDatum.end(),
+				[](const ShaderMetaData& md) { return md.mHasVariants; });
+			if(!hasVariants)
+			{
+				shader.destroy(mainDevice.logicalDevice);
+			}
+		}
+
+		//One sub pass per render graph pass
+        mSubPassesCount = static_cast<int32_t>(mRenderGraph.getPassesCount());
+
+		prewarmPipelineVariants();
+	}
+
+	void VulkanRenderer::prewarmPipelineVariants()
+	{
+		uint32_t variantsCount = 0;
+		for(const auto& material : mMaterials)
+		{
+			if(material.mShaderId >= mShaders.size())
+			{
+				continue;
+			}
+			const auto& shader = mShaders[material.mShaderId];
+			const auto& shaderMetaDatum = mShaderMetaDatum[shader.mId];
+			for(uint32_t i = 0; i < shader.mGraphicsPipelineIds.size(); i++)
+			{
+				auto& pipeline = mPipelines[shader.mGraphicsPipelineIds[i]];
+				const auto& shaderMetaData = shaderMetaDatum[i];
+				if(!pipeline.hasVariants())
+				{
+					continue;
+				}
+				pipeline.getVariant(mainDevice.logicalDevice, material.mShaderVariant, EDepthPass::Default);
+				variantsCount++;
+				//Candidacy depends on mesh streams as well, so a few of these may never be drawn
+				if(shaderMetaData.mDepthPrePass && shaderMetaData.mDepthTestEnabled &&
+					shaderMetaData.mTopology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+				{
+					pipeline.getVariant(mainDevice.logicalDevice, material.mShaderVariant, EDepthPass::PrePass);
+					pipeline.getVariant(mainDevice.logicalDevice, material.mShaderVariant, EDepthPass::Equal);
+					variantsCount += 2;
+				}
+			}
 		}
 
-		//2 sub passes each using 1 pipeline
-        mSubPassesCount = 2;
+		LOG_TRACE("Pipeline variants pre-warmed: {}", variantsCount);
 	}
 
 	void VulkanRenderer::cleanupPipelines(VkDevice logicalDevice)
@@ -1351,6 +1756,7 @@ namespace fre
 		{
 			pipeline.destroy(logicalDevice);
 		}
+		mPipelineLibrary.destroy(logicalDevice);
 
 		for(auto& shader : mShaders)
 		{
@@ -1366,25 +1772,29 @@ namespace fre
 	{
 		LOG_INFO("Create command pools");
 
-		VkCommandPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-		poolInfo.queueFamilyIndex = mGraphicsQueueFamilyId;	//Queue family type that buffers trom this command pool will use
-
-		//Create a Graphics Queue Family Command Pool
-		VK_CHECK(vkCreateCommandPool(mainDevice.logicalDevice, &poolInfo, nullptr, &mGraphicsCommandPool));
-
-		poolInfo.queueFamilyIndex = mTransferQueueFamilyId;
+		//Pools of one-time submissions per queue family, other command buffers of family are allocated from them too
+		mGraphicsCommandPool.create(mainDevice.logicalDevice, mGraphicsQueueFamilyId);
+		mTransferCommandPool.create(mainDevice.logicalDevice, mTransferQueueFamilyId);
+		mComputeCommandPool.create(mainDevice.logicalDevice, mComputeQueueFamilyId);
 
-		VK_CHECK(vkCreateCommandPool(mainDevice.logicalDevice, &poolInfo, nullptr, &mTransferCommandPool));
-		
-		poolInfo.queueFamilyIndex = mComputeQueueFamilyId;
-
-		VK_CHECK(vkCreateCommandPool(mainDevice.logicalDevice, &poolInfo, nullptr, &mComputeCommandPool));
+		//Scene is recorded by one thread
+		mGraphicsFrameCommandPools.create(mainDevice.logicalDevice, mGraphicsQueueFamilyId, MAX_FRAME_DRAWS, 1);
+		mComputeFrameCommandPools.create(mainDevice.logicalDevice, mComputeQueueFamilyId, MAX_FRAME_DRAWS, 1);
 
 		LOG_INFO("Command pools created");
 	}
 
+	void VulkanRenderer::cleanupCommandPools()
+	{
+		mGraphicsFrameCommandPools.destroy(mainDevice.logicalDevice);
+		mComputeFrameCommandPools.destroy(mainDevice.logicalDevice);
+		mGraphicsCommandPool.destroy(mainDevice.logicalDevice);
+		//Scene commands are freed with graphics pool
+		mSceneCommands.clear();
+		mTransferCommandPool.destroy(mainDevice.logicalDevice);
+		mComputeCommandPool.destroy(mainDevice.logicalDevice);
+	}
+
 	void VulkanRenderer::createCommandBuffers()
 	{
 		LOG_INFO("Create command buffers");
@@ -1392,16 +1802,68 @@ namespace fre
 		mGraphicsCommandBuffers.resize(mFrameBuffers.size());
 		mTransferCommandBuffers.resize(mFrameBuffers.size());
 		mComputeCommandBuffers.resize(mFrameBuffers.size());
+		mSceneCommands.resize(mFrameBuffers.size());
 		for(int i = 0; i < mFrameBuffers.size(); i++)
 		{
-			mGraphicsCommandBuffers[i].allocate(mGraphicsCommandPool, mainDevice.logicalDevice);
-			mTransferCommandBuffers[i].allocate(mTransferCommandPool, mainDevice.logicalDevice);
-			mComputeCommandBuffers[i].allocate(mComputeCommandPool, mainDevice.logicalDevice);
+			mTransferCommandBuffers[i].allocate(mTransferCommandPool.getCommandPool(), mainDevice.logicalDevice);
 		}
 
 		LOG_INFO("Command buffers created");
 	}
 
+	void VulkanRenderer::createFrameQueries()
+	{
+		const uint32_t commandBuffersCount = static_cast<uint32_t>(mGraphicsCommandBuffers.size());
+		mFrameQueries.assign(commandBuffersCount, FrameQueries());
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(mainDevice.physicalDevice, &deviceProperties);
+		if(deviceProperties.limits.timestampComputeAndGraphics == VK_TRUE)
+		{
+			mTimestampPeriod = deviceProperties.limits.timestampPeriod;
+
+			VkQueryPoolCreateInfo queryPoolInfo = {};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			queryPoolInfo.queryCount = commandBuffersCount * 2;
+			VK_CHECK(vkCreateQueryPool(mainDevice.logicalDevice, &queryPoolInfo, nullptr, &mTimestampQueryPool));
+		}
+		else
+		{
+			LOG_WARNING("GPU timestamps are not supported, dynamic resolution is not available");
+		}
+
+		//Feature value is filled with supported one in enableOptionalDeviceFeatures
+		if(mDeviceFeatures.features.pipelineStatisticsQuery == VK_TRUE)
+		{
+			VkQueryPoolCreateInfo queryPoolInfo = {};
+			queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			queryPoolInfo.queryCount = commandBuffersCount;
+			queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+			VK_CHECK(vkCreateQueryPool(mainDevice.logicalDevice, &queryPoolInfo, nullptr, &mPipelineStatisticsQueryPool));
+		}
+		else
+		{
+			LOG_WARNING("Pipeline statistics are not supported, overdraw is not measured");
+		}
+	}
+
+	void VulkanRenderer::cleanupFrameQueries()
+	{
+		if(mTimestampQueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(mainDevice.logicalDevice, mTimestampQueryPool, nullptr);
+			mTimestampQueryPool = VK_NULL_HANDLE;
+		}
+		if(mPipelineStatisticsQueryPool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(mainDevice.logicalDevice, mPipelineStatisticsQueryPool, nullptr);
+			mPipelineStatisticsQueryPool = VK_NULL_HANDLE;
+		}
+		mFrameQueries.clear();
+	}
+
 	static PFN_vkVoidFunction VKAPI_PTR imguiVulkanFunctionLoader(const char* name, void* user_data)
 	{
 		return vkGetInstanceProcAddr((VkInstance)user_data, name);
@@ -1431,8 +1893,10 @@ namespace fre
 		init_info.Queue = mGraphicsQueue;
 		//init_info.PipelineCache = g_PipelineCache;
 		init_info.DescriptorPool = mUIDescriptorPool->mDescriptorPool;
-		init_info.RenderPass = mRenderPass.mRenderPass;
-		init_info.Subpass = 1;
+		//UI is drawn in last pass of graph
+		const auto& uiPass = mRenderGraph.getPass(mRenderGraph.getPassesCount() - 1);
+		init_info.RenderPass = mRenderPasses[uiPass.mRenderPass].mRenderPass;
+		init_info.Subpass = uiPass.mSubpass;
 		init_info.MinImageCount = MAX_FRAME_DRAWS;
 		init_info.ImageCount = MAX_FRAME_DRAWS;
 		init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
@@ -1448,16 +1912,22 @@ namespace fre
 		ImGui_ImplVulkan_Init(&init_info);
 	}
 
-	void VulkanRenderer::updateUniformBuffers(const Camera& camera)
+	void VulkanRenderer::updateUniformBuffers(const Camera& camera, const Light& light)
 	{
-		//Copy VP data
-		/*void* data;
-		UboViewProjection vp;
-		vp.mView = camera.mView;
-		vp.mProjection = camera.mProjection;
-		VK_CHECK(vkMapMemory(mainDevice.logicalDevice, mVPUniformBufferMemory[mImageIndex], 0, sizeof(UboViewProjection), 0, &data));
-		memcpy(data, &vp, sizeof(UboViewProjection));
-		vkUnmapMemory(mainDevice.logicalDevice, mVPUniformBufferMemory[mImageIndex]);*/
+		if(!mFrameUniformsBuffer.isCreated())
+		{
+			return;
+		}
+
+		FrameUniforms uniforms;
+		uniforms.mProjection = camera.mProjection;
+		uniforms.mView = camera.mView;
+		uniforms.mCameraEye = vec4(-camera.getEye(), 0.0f);
+		uniforms.mLightPos = vec4(light.mPosition, 1.0f);
+		uniforms.mLightDiffuseColor = vec4(light.mDiffuseColor, 1.0f);
+		uniforms.mLightSpecularColor = vec4(light.mSpecularColor, 1.0f);
+		uniforms.mMaterialTable = uvec4(mTextureManager.getMaterialTableBase(mCurrentFrame), 0u, 0u, 0u);
+		memcpy(mFrameUniformsBuffer.getRegionData(mImageIndex), &uniforms, sizeof(FrameUniforms));
 
 		//Copy ModelMatrix data
 		/*for (size_t i = 0; i < meshList.size(); i++)
@@ -1472,13 +1942,15 @@ namespace fre
 	}
 
 	void VulkanRenderer::recordMeshCommands(
-		const MeshModel::Ptr& model, const Mesh::Ptr& mesh, const Camera& camera,
-		const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass, uint32_t instanceId)
+		const MeshModel::Ptr& model, const Mesh::Ptr& mesh, uint32_t renderObject, const Camera& camera,
+		const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass, uint32_t instanceId,
+		EDepthPass depthPass)
 	{
-		const auto& material = mMaterials[mesh->getMaterialId()];
+		const auto& material = mMaterials[mRenderObjects.mMaterialIds[renderObject]];
 		const auto computeShaderId = mesh->getComputeShaderId();
-		if((pipelineBindPoint != VK_PIPELINE_BIND_POINT_COMPUTE || mesh->getComputeShaderId() != std::numeric_limits<uint32_t>::max())
-			&& model->isVisible())
+		//Callbacks are looked up only for meshes which have them
+		const bool recordCallbacks = (mRenderObjects.mFlags[renderObject] & RO_RECORD_CALLBACKS) != 0;
+		if(pipelineBindPoint != VK_PIPELINE_BIND_POINT_COMPUTE || (mRenderObjects.mFlags[renderObject] & RO_COMPUTE) != 0)
 		{
 			const auto& shader = pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mShaders[computeShaderId] : mShaders[material.mShaderId];
 
@@ -1495,20 +1967,39 @@ namespace fre
 				const auto& shaderMetaDatum = mShaderMetaDatum[shader.mId];
 				for(uint32_t i = 0; i < pipelineIds.size(); i++)
 				{
-					const auto& pipeline = mPipelines[pipelineIds[i]];
+					auto& pipeline = mPipelines[pipelineIds[i]];
 					const auto& shaderMetaData = shaderMetaDatum[i];
 
+					//Meshes which are not pre-pass candidates are drawn as usual in main pass
+					const bool prePassCandidate = depthPass != EDepthPass::Default &&
+						pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && isDepthPrePassCandidate(shaderMetaData, mesh);
+					if(depthPass == EDepthPass::PrePass && !prePassCandidate)
+					{
+						continue;
+					}
+					const EDepthPass meshDepthPass = prePassCandidate ? depthPass : EDepthPass::Default;
+
 					if(shaderMetaData.mSubPassIndex == subPass && pipeline.mBindPoint == pipelineBindPoint) 
 					{
 						LOG_DEBUG("Render mesh: subpass {}, id {}, shader {}", subPass, mesh->getId(), shader.mName);
-						if(mesh->getBeforeRecordCallback() != nullptr)
+						if(recordCallbacks && mesh->getBeforeRecordCallback() != nullptr)
 						{
 							mesh->getBeforeRecordCallback()(this, subPass, pipelineBindPoint);
 						}
 						
-						bindPipeline(pipeline);
+						bindPipeline(pipeline, material.mShaderVariant, meshDepthPass);
+						if(pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+						{
+							pipeline.applyDynamicState(mGraphicsCommandBuffers[mImageIndex].mCommandBuffer, meshDepthPass);
+						}
 
-						const mat4& modelMatrix = model->getModelMatrix();
+						//Model matrix of draw data is read as instance, pushed one stays identity
+						const bool drawData = pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS &&
+							(meshDepthPass == EDepthPass::PrePass || vertexBuffer != nullptr) &&
+							useDrawData(shaderMetaData, mesh, renderObject);
+						static const mat4 identity(1.0f);
+						const mat4& modelMatrix = drawData ? identity : mRenderObjects.getTransform(renderObject);
+						mRecordingNormalMatrix = drawData ? &identity : &mRenderObjects.getNormalMatrix(renderObject);
 
 						//"Push" constants to given shader stage directly (no buffer)
 					
@@ -1517,17 +2008,40 @@ namespace fre
 							shaderMetaData.mPushConstantsCallback(mesh, modelMatrix, camera, light, pipeline.mPipelineLayout, instanceId);
 						}
 
-                        if(mesh->mPushConstantsCallback != nullptr)
+                        if(recordCallbacks && mesh->mPushConstantsCallback != nullptr)
                         {
                             mesh->mPushConstantsCallback(mesh, modelMatrix, camera, light, pipeline.mPipelineLayout, instanceId);
                         }
+						mRecordingNormalMatrix = nullptr;
 			
-						if(vertexBuffer != nullptr && pipelineBindPoint != VK_PIPELINE_BIND_POINT_COMPUTE &&
+						if((meshDepthPass == EDepthPass::PrePass || vertexBuffer != nullptr) &&
+							pipelineBindPoint != VK_PIPELINE_BIND_POINT_COMPUTE &&
 							pipelineBindPoint != VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR)
 						{
-							VkBuffer vertexBuffers[] = { vertexBuffer->mBuffer };	//Buffers to bind
-							VkDeviceSize offsets[] = { 0 };		//Offsets into buffers being bound
-							bindVertexBuffers(vertexBuffers, 1, offsets, pipelineBindPoint);
+							VkBuffer vertexBuffers[] = { VK_NULL_HANDLE, VK_NULL_HANDLE };	//Buffers to bind
+							VkDeviceSize offsets[] = { 0, 0 };		//Offsets into buffers being bound
+							vertexBuffers[VERTEX_BINDING] = meshDepthPass == EDepthPass::PrePass ?
+								mBufferManager.getBuffer(mMeshToPositionBufferMap[mesh->getId()])->mBuffer :
+								vertexBuffer->mBuffer;
+							uint32_t buffersCount = 1;
+							if(shaderMetaData.mInstanceSize > 0)
+							{
+								//Meshes without instances read their draw data or single default instance
+								const auto foundIt = mMeshToInstanceBufferMap.find(mesh->getId());
+								const bool hasInstanceBuffer = foundIt != mMeshToInstanceBufferMap.end();
+								if(drawData)
+								{
+									vertexBuffers[INSTANCE_BINDING] = mDrawDataBuffer.mBuffer;
+									offsets[INSTANCE_BINDING] = 0;
+								}
+								else
+								{
+									vertexBuffers[INSTANCE_BINDING] = hasInstanceBuffer ? foundIt->second.mBuffer : mDefaultInstanceBuffer.mBuffer;
+									offsets[INSTANCE_BINDING] = hasInstanceBuffer ? foundIt->second.getOffset(mImageIndex) : 0;
+								}
+								buffersCount = 2;
+							}
+							bindVertexBuffers(vertexBuffers, buffersCount, offsets, pipelineBindPoint);
 						}
 
 						const auto* indexBuffer = getIndexBuffer(mesh->getId());
@@ -1537,29 +2051,7 @@ namespace fre
 							bindIndexBuffer(indexBuffer->mBuffer, pipelineBindPoint);
 						}
 
-                        if(mesh->getDescriptorSets().empty())
-                        {
-							std::vector<uint32_t> descriptorSetIds;
-							for(const auto& dslId : shader.mDSLs)
-							{
-								const VulkanDescriptorSetKey key = { shader.mId, mSharedDescriptorPoolId, dslId, mesh->getId() };
-								auto setId = createDescriptorSet(key);
-                                descriptorSetIds.push_back(setId);
-							}
-							mesh->setDescriptorSets(descriptorSetIds);
-						}
-
-                        auto descriptorSets = mesh->getDescriptorSets();
-						auto shaderInputs = mesh->getDescriptors();
-						if(descriptorSets.size() == shaderInputs.size())
-						{
-							for(int i = 0; i < descriptorSets.size(); i++)
-							{
-								const auto& dsId = descriptorSets[i];
-								auto& descriptorSet = getDescriptorSet(dsId);
-								descriptorSet->update(mainDevice.logicalDevice, shaderInputs[i]);
-							}
-						}
+						updateMeshDescriptorSets(mesh, shader);
 
                         //Bind descriptor sets
 						bindDescriptorSets(mesh->getDescriptorSets(), pipeline.mPipelineLayout, pipelineBindPoint);
@@ -1587,17 +2079,32 @@ namespace fre
 								{
 									vkCmdSetLineWidth(commandBuffer, shaderMetaData.mLineWidth);
 								}
+								const uint32_t instancesCount = mesh->hasInstances() ?
+									static_cast<uint32_t>(mesh->getInstances().size()) : 1;
+								//Position stream of pre-pass is per mesh, so only index offset applies to it
+								const uint32_t firstIndex = mRenderObjects.mFirstIndices[renderObject];
+								const int32_t vertexOffset = meshDepthPass != EDepthPass::PrePass ? mRenderObjects.mVertexOffsets[renderObject] : 0;
+								const uint32_t firstInstance = drawData ? renderObject : 0;
+								if(meshDepthPass == EDepthPass::PrePass)
+								{
+									mRecordingStatistics.mDepthPrePassDrawCalls++;
+								}
+								else
+								{
+									mRecordingStatistics.mDrawCalls++;
+									mRecordingStatistics.mInstances += instancesCount;
+								}
 								if(mesh->getGeneratedVerticesCount() > 0)
 								{
-									vkCmdDraw(commandBuffer, mesh->getGeneratedVerticesCount(), 1, 0, 0);
+									vkCmdDraw(commandBuffer, mesh->getGeneratedVerticesCount(), instancesCount, 0, firstInstance);
 								}
 								else if(indexBuffer != nullptr)
 								{
-									vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mesh->getIndexCount()), 1, 0, 0, 0);
+									vkCmdDrawIndexed(commandBuffer, mRenderObjects.mIndexCounts[renderObject], instancesCount, firstIndex, vertexOffset, firstInstance);
 								}
 								else
 								{
-									vkCmdDraw(commandBuffer, mesh->getVertexCount(), 1, 0, 0);
+									vkCmdDraw(commandBuffer, mesh->getVertexCount(), instancesCount, 0, firstInstance);
 								}
 							}
 							break;
@@ -1627,13 +2134,13 @@ namespace fre
 									&miss_shader_sbt_entry,
 									&hit_shader_sbt_entry,
 									&callable_shader_sbt_entry,
-									mSwapChain.mSwapChainExtent.width,
-									mSwapChain.mSwapChainExtent.height,
+									getRenderExtent().width,
+									getRenderExtent().height,
 									1);
 							}
 							break;
 						}
-						if(mesh->getAfterRecordCallback() != nullptr)
+						if(recordCallbacks && mesh->getAfterRecordCallback() != nullptr)
 						{
 							mesh->getAfterRecordCallback()(this, subPass, pipelineBindPoint);
 						}
@@ -1643,32 +2150,111 @@ namespace fre
 		}
 	}
 
-	void VulkanRenderer::recordSceneCommands(const Camera& camera, const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass)
+	void VulkanRenderer::updateMeshDescriptorSets(const Mesh::Ptr& mesh, const Shader& shader)
 	{
-		for (size_t j = 0; j < mMeshModels.size(); j++)
+		//Sets are shared by meshes binding the same resources. Mesh without descriptor per set
+		//gets sets which are never written, one per layout
+		const auto& shaderInputs = mesh->getDescriptors();
+		const bool written = shaderInputs.size() == shader.mDSLs.size();
+		const std::vector<VulkanDescriptorPtr> noDescriptors;
+		const auto& descriptorSets = mesh->getDescriptorSets();
+		bool changed = descriptorSets.size() != shader.mDSLs.size();
+		std::vector<uint32_t> descriptorSetIds(shader.mDSLs.size(), MAX(uint32_t));
+		for(uint32_t i = 0; i < shader.mDSLs.size(); i++)
 		{
-			auto& model = mMeshModels[j];
+			const uint32_t dslId = shader.mDSLs[i];
+			//Bindless set is written by texture manager, frame uniforms are written by renderer
+			if(dslId == mBindlessDSLId)
+			{
+				descriptorSetIds[i] = mBindlessSetId;
+				continue;
+			}
+			if(dslId == mFrameUniformsDSLId)
+			{
+				descriptorSetIds[i] = mFrameUniformsSetId;
+				continue;
+			}
 
-			for (size_t k = 0; k < model->getMeshCount(); k++)
+			mDescriptorSetKey.mDSLId = dslId;
+			mDescriptorSetKey.mResources.clear();
+			if(written)
 			{
-				const auto& mesh = model->getMesh(k);
-				if(mesh->getBeforeVisitCallback())
+				for(const auto& descriptor : shaderInputs[i])
 				{
-					mesh->getBeforeVisitCallback()(this, subPass, pipelineBindPoint);
+					descriptor->getResourceKey(mDescriptorSetKey.mResources);
 				}
-				if(mesh->getVisible())
-				{
-					auto count = mesh->getInstanceCount();
-					for(uint32_t i = 0; i < count; i++)
-					{
-						recordMeshCommands(model, mesh, camera, light, pipelineBindPoint, subPass, i);
-					}
-				}
-				if(mesh->getAfterVisitCallback())
+			}
+			descriptorSetIds[i] = createDescriptorSet(mDescriptorSetKey, written ? shaderInputs[i] : noDescriptors);
+			changed = changed || descriptorSets[i] != descriptorSetIds[i];
+		}
+		if(!changed)
+		{
+			return;
+		}
+
+		//New sets are referenced before old ones are released, so set kept by mesh survives
+		for(const auto setId : descriptorSetIds)
+		{
+			if(setId != mBindlessSetId && setId != mFrameUniformsSetId)
+			{
+				acquireDescriptorSet(setId);
+			}
+		}
+		for(const auto setId : descriptorSets)
+		{
+			if(setId != mBindlessSetId && setId != mFrameUniformsSetId && setId != MAX(uint32_t))
+			{
+				releaseDescriptorSet(setId);
+			}
+		}
+		mesh->setDescriptorSets(descriptorSetIds);
+	}
+
+	void VulkanRenderer::recordSceneCommands(const Camera& camera, const Light& light, VkPipelineBindPoint pipelineBindPoint, uint32_t subPass,
+		EDepthPass depthPass)
+	{
+		//Depth pre-pass reads per-mesh position streams, so merged meshes are drawn one by one there
+		const bool mergedDraws = pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS && depthPass != EDepthPass::PrePass &&
+			!mMergedDrawBatches.empty();
+		//Object is recorded when its flags masked by these are equal to required ones.
+		//Culled meshes still get their visit callbacks
+		const uint8_t requiredFlags = RO_VISIBLE | (pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? RO_COMPUTE : 0);
+		const uint8_t flagsMask = requiredFlags |
+			(mFrameCPUCulling && pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS ? RO_CULLED : 0) |
+			(mergedDraws ? RO_MERGED : 0);
+		for(uint32_t object = 0; object < mRenderObjects.size(); object++)
+		{
+			const uint8_t flags = mRenderObjects.mFlags[object];
+			const bool visitCallbacks = (flags & RO_VISIT_CALLBACKS) != 0;
+			const bool recorded = (flags & flagsMask) == requiredFlags;
+			if(!visitCallbacks && !recorded)
+			{
+				continue;
+			}
+
+			const auto& model = mMeshModels[mRenderObjects.mModelIds[object]];
+			const auto& mesh = model->getMesh(mRenderObjects.mMeshIndices[object]);
+			if(visitCallbacks && mesh->getBeforeVisitCallback())
+			{
+				mesh->getBeforeVisitCallback()(this, subPass, pipelineBindPoint);
+			}
+			if(recorded)
+			{
+				//Mesh instances are drawn by one instanced draw call
+				for(uint32_t i = 0; i < mRenderObjects.mDrawCounts[object]; i++)
 				{
-					mesh->getAfterVisitCallback()(this, subPass, pipelineBindPoint);
+					recordMeshCommands(model, mesh, object, camera, light, pipelineBindPoint, subPass, i, depthPass);
 				}
 			}
+			if(visitCallbacks && mesh->getAfterVisitCallback())
+			{
+				mesh->getAfterVisitCallback()(this, subPass, pipelineBindPoint);
+			}
+		}
+
+		if(mergedDraws)
+		{
+			recordMergedDraws(camera, light, subPass, depthPass);
 		}
 	}
 
@@ -1685,13 +2271,64 @@ namespace fre
 			vec2(mSwapChain.mSwapChainExtent.width, mSwapChain.mSwapChainExtent.height));
     }
 
-	void VulkanRenderer::renderSubPass(uint32_t subPassIndex, const Camera& camera,
+    VkExtent2D VulkanRenderer::getRenderExtent() const
+    {
+		return
+		{
+			mDynamicResolution.getScaledSize(mSwapChain.mSwapChainExtent.width),
+			mDynamicResolution.getScaledSize(mSwapChain.mSwapChainExtent.height)
+		};
+    }
+
+	float VulkanRenderer::getRenderScale() const
+	{
+		return mDynamicResolution.getScale();
+	}
+
+	void VulkanRenderer::setDynamicResolutionEnabled(bool enabled)
+	{
+		mDynamicResolutionEnabled = enabled;
+		if(!enabled)
+		{
+			mDynamicResolution.reset(1.0f);
+		}
+	}
+
+	void VulkanRenderer::renderSubPass(uint32_t passId, const Camera& camera,
 		const Light& light)
 	{
 		auto maxViewSize = getViewport();
+		if(mRenderGraph.getPass(passId).mDynamicResolution)
+		{
+			const auto renderExtent = getRenderExtent();
+			maxViewSize = BoundingBox2D(vec2(0.0f), vec2(renderExtent.width, renderExtent.height));
+		}
 		setViewport(maxViewSize);
         setScissor(maxViewSize);
-        recordSceneCommands(camera, light, VK_PIPELINE_BIND_POINT_GRAPHICS, subPassIndex);
+		if(passId != mGeometryPass)
+		{
+			recordSceneCommands(camera, light, VK_PIPELINE_BIND_POINT_GRAPHICS, passId);
+			return;
+		}
+
+		//Depth of candidates goes first, then only visible fragments are shaded
+		if(mFrameDepthPrePass)
+		{
+			recordSceneCommands(camera, light, VK_PIPELINE_BIND_POINT_GRAPHICS, passId, EDepthPass::PrePass);
+		}
+		VkCommandBuffer commandBuffer = mGraphicsCommandBuffers[mImageIndex].mCommandBuffer;
+		//Query can't be active across secondary command buffer
+		const bool pipelineStatistics = mPipelineStatisticsQueryPool != VK_NULL_HANDLE && !mFrameSceneCommands;
+		if(pipelineStatistics)
+		{
+			vkCmdBeginQuery(commandBuffer, mPipelineStatisticsQueryPool, mImageIndex, 0);
+		}
+		recordSceneCommands(camera, light, VK_PIPELINE_BIND_POINT_GRAPHICS, passId,
+			mFrameDepthPrePass ? EDepthPass::Equal : EDepthPass::Default);
+		if(pipelineStatistics)
+		{
+			vkCmdEndQuery(commandBuffer, mPipelineStatisticsQueryPool, mImageIndex);
+		}
 	}
 
 	void VulkanRenderer::loadShaderStage(
@@ -1728,19 +2365,41 @@ namespace fre
 		loadShaderStage(parser, shader.mRayMissShader, shaderFileName, VK_SHADER_STAGE_MISS_BIT_KHR, layoutInfos);
 		loadShaderStage(parser, shader.mRayClosestHitShader, shaderFileName, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR, layoutInfos);
 
-		for(const auto& layoutInfo : layoutInfos)
+		for(uint32_t set = 0; set < layoutInfos.size(); set++)
 		{
-			if(!layoutInfo.mBindings.empty())
+			const auto& layoutInfo = layoutInfos[set];
+			//Uniform block at set 0 binding 0 holds camera and light, see FrameUniforms
+			const bool frameUniforms = set == 0 && mFrameUniformsDSLId != MAX(uint32_t) &&
+				layoutInfo.mDescriptorTypes == std::vector<VkDescriptorType>{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER } &&
+				layoutInfo.mBindings == std::vector<uint32_t>{ 0 };
+			//Runtime sized array is reflected with zero descriptors, such set is the shared bindless one
+			const bool bindless = std::find(layoutInfo.mDescriptorCount.begin(), layoutInfo.mDescriptorCount.end(), 0u) !=
+				layoutInfo.mDescriptorCount.end();
+			if(bindless)
+			{
+				if(mBindlessDSLId == MAX(uint32_t))
+				{
+					throw std::runtime_error(formatString("Shader %s uses bindless textures, but descriptor indexing is not supported",
+						shaderFileName.c_str()));
+				}
+				if(layoutInfo.mDescriptorTypes != VulkanTextureManager::getBindlessLayoutInfo(0, 0).mDescriptorTypes)
+				{
+					throw std::runtime_error(formatString("Shader %s declares bindless set which doesn't match textures and material table",
+						shaderFileName.c_str()));
+				}
+				shader.mDSLs.push_back(mBindlessDSLId);
+			}
+			else if(frameUniforms)
+			{
+				shader.mDSLs.push_back(mFrameUniformsDSLId);
+			}
+			else if(!layoutInfo.mBindings.empty())
 			{
 				uint32_t dslId = createDescriptorSetLayout(layoutInfo);
 				shader.mDSLs.push_back(dslId);
-				for(const auto dt : layoutInfo.mDescriptorTypes)
+				for(uint32_t i = 0; i < layoutInfo.mDescriptorTypes.size(); i++)
 				{
-					if(descriptorTypes.find(dt) == descriptorTypes.end())
-					{
-						descriptorTypes[dt] = 0;
-					}
-					descriptorTypes[dt]++;
+					descriptorTypes[layoutInfo.mDescriptorTypes[i]] += layoutInfo.mDescriptorCount[i];
 				}
 			}
 		}
@@ -1756,13 +2415,18 @@ namespace fre
 		mModelMatrixPCR.offset = 0;
 		mModelMatrixPCR.size = sizeof(mat4);
 
-        mLightingPCR.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;	//Shader stage push constant will go to
+        //Vertex stage reads normal matrix of pushed model matrix
+        mLightingPCR.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		mLightingPCR.offset = sizeof(mat4);
 		mLightingPCR.size = sizeof(Lighting);
 
         mNearFarPCR.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;	//Shader stage push constant will go to
 		mNearFarPCR.offset = 0;
 		mNearFarPCR.size = sizeof(vec2);
+
+		mRenderScalePCR.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		mRenderScalePCR.offset = 0;
+		mRenderScalePCR.size = sizeof(vec4);
 		addShader("postProcess");
         std::unordered_map<VkDescriptorType, uint32_t> descriptorTypes;
 
@@ -1772,21 +2436,41 @@ namespace fre
 			loadShader(shaderFileName, descriptorTypes);
 		}
 
-		VulkanDescriptorPoolKey descriptorPoolKey;
-        for(const auto& [descriptorType, count] : descriptorTypes)
+		//Initial pool sizes assume a set of every shader layout per mesh, allocators adjust them to
+		//layouts actually allocated
+		uint32_t layoutsCount = 0;
+		for(const auto& shader : mShaders)
+		{
+			layoutsCount += static_cast<uint32_t>(std::count_if(shader.mDSLs.begin(), shader.mDSLs.end(),
+				[this](uint32_t dslId) { return dslId != mBindlessDSLId && dslId != mFrameUniformsDSLId; }));
+		}
+		std::vector<VulkanDescriptorPoolRatio> ratios;
+		for(const auto& [descriptorType, count] : descriptorTypes)
+		{
+			ratios.push_back({ descriptorType, static_cast<float>(count) / static_cast<float>(std::max(layoutsCount, 1u)) });
+		}
+
+		mDescriptorAllocator.create(mainDevice.logicalDevice, 32, ratios);
+		for(auto& allocator : mFrameDescriptorAllocators)
 		{
-            descriptorPoolKey.mPoolSizes.push_back({ descriptorType, count * MAX_FRAME_DRAWS });
+			allocator.create(mainDevice.logicalDevice, 32, ratios);
 		}
-        
-		mSharedDescriptorPoolId = createDescriptorPool(descriptorPoolKey);
 	}
 
-	void VulkanRenderer::bindPipeline(const VulkanPipeline& pipeline)
+	void VulkanRenderer::bindPipeline(VulkanPipeline& pipeline, const ShaderVariantKey& variantKey, EDepthPass depthPass)
 	{
 		vkCmdBindPipeline(
 				pipeline.isCompute() ? mComputeCommandBuffers[mImageIndex].mCommandBuffer : mGraphicsCommandBuffers[mImageIndex].mCommandBuffer,
 				pipeline.mBindPoint,
-				pipeline.mPipeline);
+				pipeline.getVariant(mainDevice.logicalDevice, variantKey, depthPass));
+	}
+
+	bool VulkanRenderer::isDepthPrePassCandidate(const ShaderMetaData& shaderMetaData, const Mesh::Ptr& mesh) const
+	{
+		return shaderMetaData.mDepthPrePass &&
+			shaderMetaData.mDepthTestEnabled &&
+			shaderMetaData.mTopology == VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST &&
+			mMeshToPositionBufferMap.find(mesh->getId()) != mMeshToPositionBufferMap.end();
 	}
 
 	void VulkanRenderer::bindVertexBuffers(const VkBuffer* buffers, uint32_t count, VkDeviceSize* offsets, VkPipelineBindPoint pipelineBindPoint)
@@ -1809,6 +2493,12 @@ namespace fre
 
 	const VulkanBuffer* VulkanRenderer::getVertexBuffer(const uint32_t meshId) const
 	{
+		const auto* range = getGeometryRange(meshId);
+		if(range != nullptr)
+		{
+			return mBufferManager.getBuffer(mGeometryArenas.mArenas[range->mArena].mVertexBufferId);
+		}
+
 		const auto found = mMeshToVertexBufferMap.find(meshId);
 		const VulkanBuffer* result = found == mMeshToVertexBufferMap.end() ? nullptr :
 			mBufferManager.getBuffer(found->second);
@@ -1818,6 +2508,12 @@ namespace fre
 
 	const VulkanBuffer* VulkanRenderer::getIndexBuffer(const uint32_t meshId) const
 	{
+		const auto* range = getGeometryRange(meshId);
+		if(range != nullptr)
+		{
+			return mBufferManager.getBuffer(mGeometryArenas.mArenas[range->mArena].mIndexBufferId);
+		}
+
 		const auto found = mMeshToIndexBufferMap.find(meshId);
 		const VulkanBuffer* result = found == mMeshToIndexBufferMap.end() ? nullptr :
 			mBufferManager.getBuffer(found->second);
@@ -1825,33 +2521,217 @@ namespace fre
 		return result;
 	}
 
+	const GeometryArenaRange* VulkanRenderer::getGeometryRange(const uint32_t meshId) const
+	{
+		const auto found = mMeshToGeometryRangeMap.find(meshId);
+
+		return found == mMeshToGeometryRangeMap.end() ? nullptr : &found->second;
+	}
+
 	void VulkanRenderer::recordCommands(const Camera& camera, const Light& light)
 	{
 		LOG_DEBUG("recordCommands");
 
+		const double recordStartTime = Timer::getInstance().getTime();
+
+		//Queries of this command buffer belong to frame which used it before
+		readFrameQueries();
+		const bool transformsChanged = updateTransforms();
+		if(mFullscreenTriangleMesh != nullptr && mImageIndex < mColorAttacmentDescriptors.size())
+		{
+			//Post-process is recorded every frame, scene is kept
+			mFullscreenTriangleMesh->setFrameDescriptors({ { mColorAttacmentDescriptors[mImageIndex] } });
+		}
+		updateUniformBuffers(camera, light);
+		prepareRenderObjects(transformsChanged);
+		prepareDrawData();
+		updateInstanceBuffers();
+		prepareMergedDraws();
+		prepareCulling(camera);
+		prepareCPUCulling(camera);
+		requestStreamedTextures(camera);
+
+		auto& frameQueries = mFrameQueries[mImageIndex];
+		mFrameDepthPrePass = mDepthPrePass.beginFrame();
+		mRecordingStatistics = RenderStatistics();
+		mRecordingStatistics.mDepthPrePass = mFrameDepthPrePass;
+
 		mGraphicsCommandBuffers[mImageIndex].begin();
+		resetPushedConstants();
+		VkCommandBuffer commandBuffer = mGraphicsCommandBuffers[mImageIndex].mCommandBuffer;
+		const uint32_t firstQuery = mImageIndex * 2;
+		if(mTimestampQueryPool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(commandBuffer, mTimestampQueryPool, firstQuery, 2);
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mTimestampQueryPool, firstQuery);
+		}
+		if(mPipelineStatisticsQueryPool != VK_NULL_HANDLE)
+		{
+			vkCmdResetQueryPool(commandBuffer, mPipelineStatisticsQueryPool, mImageIndex, 1);
+		}
+		recordSceneUploads(commandBuffer);
+		if(mFrameCulling)
+		{
+			const VkDeviceSize drawsCount = mMergedDraws.size();
+			mCullingPass.recordCulling(commandBuffer, mImageIndex,
+				static_cast<uint32_t>(drawsCount), static_cast<uint32_t>(mMergedDrawBatches.size()),
+				{ mIndirectCommandsBuffer.mBuffer, 0, drawsCount * sizeof(VkDrawIndexedIndirectCommand) },
+				{ mMergedInstanceBuffer.mBuffer, 0, drawsCount * sizeof(MeshInstance) });
+		}
 
 		recordSceneCommands(camera, light, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, 0);
-		VkCommandBuffer commandBuffer = mGraphicsCommandBuffers[mImageIndex].mCommandBuffer;
-		mRenderPass.begin(mFrameBuffers[mImageIndex].mFrameBuffer, mSwapChain.mSwapChainExtent,
-			commandBuffer, mClearColor);
 
+		const auto renderExtent = getRenderExtent();
+		const uint64_t sceneCommandsVersion = updateSceneCommandsVersion();
+		mFrameSceneCommands = sceneCommandsVersion != 0;
 		for(int32_t i = 0; i < mSubPassesCount; i++)
 		{
-			renderSubPass(i, camera, light);
+			const auto& pass = mRenderGraph.getPass(i);
+			auto& renderPass = mRenderPasses[pass.mRenderPass];
+			const bool sceneCommands = mFrameSceneCommands && i == mGeometryPass;
+			const VkSubpassContents contents = sceneCommands ?
+				VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+			if(pass.mSubpass == 0)
+			{
+				renderPass.begin(mFrameBuffers[mImageIndex].mFrameBuffers[pass.mRenderPass],
+					pass.mDynamicResolution ? renderExtent : mSwapChain.mSwapChainExtent,
+					commandBuffer, mClearColor, contents);
+			}
+			else
+			{
+				vkCmdNextSubpass(commandBuffer, contents);
+			}
 
-			if(i < mSubPassesCount - 1)
+			if(sceneCommands)
 			{
-				vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+				executeSceneCommands(i, sceneCommandsVersion, camera, light);
+			}
+			else
+			{
+				renderSubPass(i, camera, light);
 			}
-		}
 
-		LOG_DEBUG("Draw UI");
-		drawUI();
+			const bool lastPass = i == mSubPassesCount - 1;
+			if(lastPass)
+			{
+				LOG_DEBUG("Draw UI");
+				drawUI();
+			}
+			if(lastPass || mRenderGraph.getPass(i + 1).mRenderPass != pass.mRenderPass)
+			{
+				renderPass.end(commandBuffer);
+				//Pyramid for occlusion culling of next frame
+				if(mCullingPass.isCreated() && mCullingSettings.mOcclusion &&
+					pass.mRenderPass == mRenderGraph.getPass(mGeometryPass).mRenderPass)
+				{
+					mCullingPass.recordHiZ(commandBuffer, mImageIndex, renderExtent, camera.mProjection * camera.mView);
+				}
+			}
+		}
 
-		mRenderPass.end(commandBuffer);
+		if(mTimestampQueryPool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mTimestampQueryPool, firstQuery + 1);
+			frameQueries.mTimestamps = true;
+		}
+		frameQueries.mPipelineStatistics = mPipelineStatisticsQueryPool != VK_NULL_HANDLE && !mFrameSceneCommands;
+		frameQueries.mDepthPrePass = mFrameDepthPrePass;
+		frameQueries.mPixelsCount = renderExtent.width * renderExtent.height;
+
+		mRenderStatistics.mDrawCalls = mRecordingStatistics.mDrawCalls;
+		mRenderStatistics.mDepthPrePassDrawCalls = mRecordingStatistics.mDepthPrePassDrawCalls;
+		mRenderStatistics.mDepthPrePass = mRecordingStatistics.mDepthPrePass;
+		mRenderStatistics.mInstances = mRecordingStatistics.mInstances;
+		mRenderStatistics.mIndirectDrawCalls = mRecordingStatistics.mIndirectDrawCalls;
+		mRenderStatistics.mMergedMeshes = mRecordingStatistics.mMergedMeshes;
+		mRenderStatistics.mPushConstants = mRecordingStatistics.mPushConstants;
+		mRenderStatistics.mSkippedPushConstants = mRecordingStatistics.mSkippedPushConstants;
+		mRenderStatistics.mSceneCommandsReused = mRecordingStatistics.mSceneCommandsReused;
+		mRenderStatistics.mUploadedSceneBytes = mRecordingStatistics.mUploadedSceneBytes;
+		mRenderStatistics.mDescriptorPools = mDescriptorAllocator.getStatistics().mPools;
+		mRenderStatistics.mDescriptorSets = mDescriptorAllocator.getStatistics().mLiveSets;
+		mRenderStatistics.mDescriptorPoolOverflows = mDescriptorAllocator.getStatistics().mPoolOverflows;
+		mRenderStatistics.mDescriptorPoolDescriptors = mDescriptorAllocator.getStatistics().mPoolDescriptors;
+		mRenderStatistics.mDescriptorSetReferences = mDescriptorSetReferences;
+		uint64_t commandBufferAllocations = mGraphicsFrameCommandPools.getStatistics().mAllocations +
+			mComputeFrameCommandPools.getStatistics().mAllocations;
+		uint64_t recycledCommandBuffers = mGraphicsFrameCommandPools.getStatistics().mRecycled +
+			mComputeFrameCommandPools.getStatistics().mRecycled;
+		for(const auto* commandPool : { &mGraphicsCommandPool, &mTransferCommandPool, &mComputeCommandPool })
+		{
+			const auto statistics = commandPool->getStatistics();
+			commandBufferAllocations += statistics.mAllocations;
+			recycledCommandBuffers += statistics.mRecycled;
+		}
+		mRenderStatistics.mCommandBufferAllocations = static_cast<uint32_t>(commandBufferAllocations - mCommandBufferAllocations);
+		mRenderStatistics.mRecycledCommandBuffers = static_cast<uint32_t>(recycledCommandBuffers - mRecycledCommandBuffers);
+		mCommandBufferAllocations = commandBufferAllocations;
+		mRecycledCommandBuffers = recycledCommandBuffers;
+		for(const auto& allocator : mFrameDescriptorAllocators)
+		{
+			mRenderStatistics.mDescriptorPools += allocator.getStatistics().mPools;
+			mRenderStatistics.mDescriptorSets += allocator.getStatistics().mLiveSets;
+			mRenderStatistics.mDescriptorPoolOverflows += allocator.getStatistics().mPoolOverflows;
+			mRenderStatistics.mDescriptorPoolDescriptors += allocator.getStatistics().mPoolDescriptors;
+		}
 
 		mGraphicsCommandBuffers[mImageIndex].end();
+		mRenderStatistics.mRecordTime = static_cast<float>((Timer::getInstance().getTime() - recordStartTime) * 1000.0);
+	}
+
+	void VulkanRenderer::readFrameQueries()
+	{
+		auto& frameQueries = mFrameQueries[mImageIndex];
+
+		//Don't wait: if results are not ready yet, frame is just skipped
+		uint64_t timestamps[2] = {};
+		if(frameQueries.mTimestamps && vkGetQueryPoolResults(mainDevice.logicalDevice, mTimestampQueryPool,
+			mImageIndex * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS &&
+			timestamps[1] >= timestamps[0])
+		{
+			const float gpuFrameTime = static_cast<float>(timestamps[1] - timestamps[0]) * mTimestampPeriod / 1000000.0f;
+			if(mDynamicResolutionEnabled && mDynamicResolution.update(gpuFrameTime))
+			{
+				LOG_DEBUG("Render scale changed to {}, GPU frame time {} ms",
+					mDynamicResolution.getScale(), mDynamicResolution.getAverageFrameTime());
+			}
+		}
+
+		uint64_t fragmentInvocations = 0;
+		if(frameQueries.mPipelineStatistics && frameQueries.mPixelsCount > 0 &&
+			vkGetQueryPoolResults(mainDevice.logicalDevice, mPipelineStatisticsQueryPool,
+			mImageIndex, 1, sizeof(fragmentInvocations), &fragmentInvocations, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			const float overdraw = static_cast<float>(fragmentInvocations) / frameQueries.mPixelsCount;
+			mRenderStatistics.mFragmentInvocations = fragmentInvocations;
+			mRenderStatistics.mOverdraw = overdraw;
+
+			const bool wasEnabled = mDepthPrePass.isEnabled();
+			mDepthPrePass.update(overdraw, frameQueries.mDepthPrePass);
+			if(wasEnabled != mDepthPrePass.isEnabled())
+			{
+				LOG_INFO("Depth pre-pass {}, overdraw {}", mDepthPrePass.isEnabled() ? "enabled" : "disabled", overdraw);
+			}
+		}
+
+		if(frameQueries.mCullingBatches > 0)
+		{
+			//Fence of command buffer was waited, so counts are final
+			const uint32_t* counts = mCullingPass.getCounts(mImageIndex);
+			const auto& reference = frameQueries.mCullingReference;
+			uint32_t visible = 0;
+			for(uint32_t b = 0; b < frameQueries.mCullingBatches; b++)
+			{
+				visible += counts[b];
+				if(!reference.empty() && (frameQueries.mCullingOcclusion ? counts[b] > reference[b] : counts[b] != reference[b]))
+				{
+					LOG_WARNING("GPU culling kept {} draws of batch {}, CPU reference kept {}", counts[b], b, reference[b]);
+				}
+			}
+			mRenderStatistics.mVisibleMergedMeshes = visible;
+		}
+
+		frameQueries = FrameQueries();
 	}
 
 	void VulkanRenderer::getPhysicalDevice()
@@ -1919,6 +2799,7 @@ namespace fre
 
 	void VulkanRenderer::cleanupSwapChain()
 	{
+		mCullingPass.destroyHiZ(mainDevice.logicalDevice);
 		mSwapChain.destroy(mainDevice.logicalDevice);
 		cleanupSwapChainFrameBuffers();
 		cleanupSwapchainImagesSemaphores();
@@ -1930,6 +2811,10 @@ namespace fre
 			mPresentationQueueFamilyId, mSurface);
 		createSwapChainFrameBuffers();
 		createSwapchainImagesSemaphores();
+		if(mCullingPass.isCreated())
+		{
+			createHiZPyramid();
+		}
 	}
 
 	void VulkanRenderer::recreateSwapChain()
@@ -1945,10 +2830,15 @@ namespace fre
 		}
 
 		VK_CHECK(vkDeviceWaitIdle(mainDevice.logicalDevice));
+		//Framebuffers scene commands were recorded with are destroyed
+		invalidateSceneCommands();
 
 		cleanupSwapChain();
 
         createSwapChain();
+		updateAttachmentDescriptors();
+		//Sets written with destroyed attachments mustn't be found by handles reused for new ones
+		destroyUnusedDescriptorSets(true);
 
 		LOG_INFO("Swapchain recreated");
 	}
@@ -2307,6 +3197,10 @@ namespace fre
 				{
 					this->mStatistics.stopMeasure("load images", static_cast<float>(Timer::getInstance().getTime()));
 					this->mStatistics.print();
+					//Load time of warm start is compared against cold one by these
+					const auto cache = this->mTextureManager.getTextureCacheStatistics();
+					LOG_INFO("Texture cache: {} hits, {} misses, {} evictions, {} bytes", cache.mHits, cache.mMisses,
+						cache.mEvictions, cache.mSize);
 				}
 
 				this->requestRedraw();
@@ -2317,6 +3211,8 @@ namespace fre
 
 	void VulkanRenderer::loadMeshes()
 	{
+		//Objects are merged by ranges in geometry arenas
+		changeSceneVersion();
 		for(auto& meshModel : mMeshModels)
 		{
 			for(uint32_t i = 0; i < meshModel->getMeshCount(); i++)
@@ -2325,6 +3221,20 @@ namespace fre
 				uint32_t meshId = mesh->getId();
 				const Material& material = mMaterials[mesh->getMaterialId()];
 				bool useCompute = mesh->getComputeShaderId() != std::numeric_limits<uint32_t>::max();
+
+				//Static indexed meshes go to shared arenas. Compute meshes write their own vertex buffers
+				if(mMeshToGeometryRangeMap.find(meshId) != mMeshToGeometryRangeMap.end())
+				{
+					continue;
+				}
+				if(mMergedGeometryEnabled && !useCompute && mesh->getGeneratedVerticesCount() == 0 &&
+					mesh->getVertexCount() > 0 && mesh->getIndexCount() > 0)
+				{
+					mMeshToGeometryRangeMap[meshId] = mGeometryArenas.add(mesh->getVertexSize(), mesh->getVertexData(),
+						mesh->getVertexCount(), static_cast<const uint32_t*>(mesh->getIndexData()), mesh->getIndexCount());
+					continue;
+				}
+
 				uint32_t usage = 0;
 				if(useCompute)
 				{
@@ -2354,128 +3264,1177 @@ namespace fre
 				}
 			}
 		}
+
+		uploadGeometryArenas();
 	}
 
-	void VulkanRenderer::createBarrier(VkBuffer buffer, VkPipelineBindPoint pipelineBindPoint)
+	void VulkanRenderer::uploadGeometryArenas()
 	{
-		VkBufferMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;   // Compute shader writes
-		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;    // Vertex shader reads
-		barrier.srcQueueFamilyIndex = mComputeQueueFamilyId;
-		barrier.dstQueueFamilyIndex = mGraphicsQueueFamilyId;
-		barrier.buffer = buffer;
-		barrier.offset = 0;
-		barrier.size = VK_WHOLE_SIZE;
+		invalidateSceneCommands();
+		for(auto& arena : mGeometryArenas.mArenas)
+		{
+			if(arena.mSealed)
+			{
+				continue;
+			}
 
-		vkCmdPipelineBarrier(
-			pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mComputeCommandBuffers[mImageIndex].mCommandBuffer
-				: mGraphicsCommandBuffers[mImageIndex].mCommandBuffer,
-			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
-			0,
-			0, nullptr,
-			1, &barrier,
-			0, nullptr
-		);
+			arena.mVertexBufferId = static_cast<uint32_t>(mBufferManager.mBuffers.size());
+			mBufferManager.createBuffer(
+				mainDevice, mTransferQueue, mTransferCommandPool,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, arena.mVertices.data(), arena.mVertices.size());
+			arena.mIndexBufferId = static_cast<uint32_t>(mBufferManager.mBuffers.size());
+			mBufferManager.createBuffer(
+				mainDevice, mTransferQueue, mTransferCommandPool,
+				VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, arena.mIndices.data(), arena.mIndices.size() * sizeof(uint32_t));
+
+			LOG_INFO("Geometry arena uploaded: vertex size {}, vertices {}, indices {}",
+				arena.mVertexSize, arena.getVertexCount(), arena.mIndices.size());
+		}
+
+		//Meshes keep their own CPU copies
+		mGeometryArenas.releaseCPUData();
 	}
-	
-	ShaderMetaDatum VulkanRenderer::getShaderMetaData(const std::string& shaderFileName)
+
+	bool VulkanRenderer::isMergedDrawCandidate(const Mesh::Ptr& mesh) const
 	{
-		ShaderMetaDatum result;
+		//Draw index is passed as first instance to fetch per-draw data
+		if(mDeviceFeatures.features.drawIndirectFirstInstance != VK_TRUE || getGeometryRange(mesh->getId()) == nullptr)
+		{
+			return false;
+		}
+		//Meshes with custom recording keep their own draw calls
+		if(mesh->hasInstances() || mesh->getInstanceCount() != 1 || mesh->mPushConstantsCallback != nullptr ||
+			mesh->getBeforeRecordCallback() != nullptr || mesh->getAfterRecordCallback() != nullptr ||
+			mesh->getBeforeVisitCallback() != nullptr || mesh->getAfterVisitCallback() != nullptr)
+		{
+			return false;
+		}
 
-		auto commonPushConstantsCallback =
-			[this](const Mesh::Ptr& mesh, const mat4& modelMatrix, const Camera& camera, const Light& light, VkPipelineLayout pipelineLayout, uint32_t instanceId)
+		const auto& material = mMaterials[mesh->getMaterialId()];
+		if(material.mShaderId >= mShaders.size())
+		{
+			return false;
+		}
+		const auto& shader = mShaders[material.mShaderId];
+		if(shader.mRayGenShader.mShaderStage != 0 || shader.mGraphicsPipelineIds.empty())
+		{
+			return false;
+		}
+		//Model matrix is read from per-draw instance data
+		for(const auto& shaderMetaData : mShaderMetaDatum[shader.mId])
+		{
+			if(shaderMetaData.mInstanceSize != sizeof(MeshInstance) || shaderMetaData.mBindDescriptorSetsCallback != nullptr)
 			{
-				if (mesh != nullptr)
-				{
-					pushConstants(mModelMatrixPCR, &modelMatrix[0], pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+				return false;
+			}
+		}
 
-					fillLightingPushConstant(mesh, modelMatrix, camera, light, mLighting);
-					pushConstants(mLightingPCR, &mLighting, pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
-				}
-			};
+		return true;
+	}
 
-		if(shaderFileName == "pbr")
+	void VulkanRenderer::groupMergedDraws()
+	{
+		mMergedDraws.clear();
+		mMergedDrawBatches.clear();
+		mCullingDraws.clear();
+		mObjectFirstDraws.assign(mRenderObjects.size() + 1, 0);
+		mObjectDraws.clear();
+		if(mMeshToGeometryRangeMap.empty())
 		{
-			ShaderMetaData md;
-			md.mVertexAttributes =
-			{
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tex)}
-			};
-			md.mPushConstantRanges = {mModelMatrixPCR, mLightingPCR};
-			md.mPushConstantsCallback = commonPushConstantsCallback;
-			md.mDepthTestEnabled = true;
-			md.mVertexSize = sizeof(Vertex);
-			md.mSubPassIndex = 0;
-
-			result.push_back(md);
+			return;
 		}
-		else if(shaderFileName == "normalMap")
+
+		//Merged flag is set for visible candidates when objects are gathered, callback may hide them after
+		for(uint32_t object = 0; object < mRenderObjects.size(); object++)
 		{
-			ShaderMetaData md;
+			if((mRenderObjects.mFlags[object] & (RO_VISIBLE | RO_MERGED)) != (RO_VISIBLE | RO_MERGED))
+			{
+				continue;
+			}
 
-			md.mVertexAttributes =
+			const auto& mesh = mMeshModels[mRenderObjects.mModelIds[object]]->getMesh(mRenderObjects.mMeshIndices[object]);
+			const auto& range = *getGeometryRange(mesh->getId());
+			const auto& shader = mShaders[mMaterials[mesh->getMaterialId()].mShaderId];
+			const auto& shaderMetaDatum = mShaderMetaDatum[shader.mId];
+			size_t descriptorsHash = 0;
+			for(const auto& descriptors : mesh->getDescriptors())
 			{
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tex)}
-			};
-			md.mPushConstantRanges = {mModelMatrixPCR, mLightingPCR};
-			md.mPushConstantsCallback = commonPushConstantsCallback;
-			md.mDepthTestEnabled = true;
-			md.mVertexSize = sizeof(Vertex);
-			md.mSubPassIndex = 0;
+				for(const auto& descriptor : descriptors)
+				{
+					descriptorsHash ^= std::hash<VulkanDescriptor*>()(descriptor.get()) + 0x9e3779b9 + (descriptorsHash << 6) + (descriptorsHash >> 2);
+				}
+				descriptorsHash ^= descriptors.size() + 0x9e3779b9 + (descriptorsHash << 6) + (descriptorsHash >> 2);
+			}
 
-			result.push_back(md);
+			for(uint32_t p = 0; p < shader.mGraphicsPipelineIds.size(); p++)
+			{
+				MergedDraw draw;
+				draw.mSubPass = shaderMetaDatum[p].mSubPassIndex;
+				draw.mPipelineId = shader.mGraphicsPipelineIds[p];
+				draw.mPipelineIndex = p;
+				draw.mMaterialId = mesh->getMaterialId();
+				draw.mArena = range.mArena;
+				draw.mDescriptorsHash = descriptorsHash;
+				draw.mMesh = mesh;
+				draw.mObject = object;
+				draw.mCommand.indexCount = range.mIndexCount;
+				draw.mCommand.instanceCount = 1;
+				draw.mCommand.firstIndex = range.mFirstIndex;
+				draw.mCommand.vertexOffset = range.mVertexOffset;
+				mMergedDraws.push_back(draw);
+			}
 		}
-		else if(shaderFileName == "textured")
+		if(mMergedDraws.empty())
 		{
-			ShaderMetaData md;
+			return;
+		}
 
-			md.mVertexAttributes =
+		//Draws with equal state become neighbours. Hash orders draws quickly, descriptors are compared
+		//too, so draws whose different descriptors collide never share sets of the first mesh
+		auto getBatchKey = [](const MergedDraw& draw)
 			{
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tex)}
+				return std::make_tuple(draw.mSubPass, draw.mPipelineId, draw.mMaterialId, draw.mArena, draw.mDescriptorsHash);
 			};
-			md.mPushConstantRanges = {mModelMatrixPCR, mLightingPCR};
-			md.mPushConstantsCallback = commonPushConstantsCallback;
-			md.mDepthTestEnabled = true;
-			md.mVertexSize = sizeof(Vertex);
-			md.mSubPassIndex = 0;
-			
-			result.push_back(md);
-		}
-		else if(shaderFileName == "colored")
-		{
-			ShaderMetaData md;
+		std::sort(mMergedDraws.begin(), mMergedDraws.end(),
+			[&getBatchKey](const MergedDraw& a, const MergedDraw& b)
+			{
+				const auto keyA = getBatchKey(a);
+				const auto keyB = getBatchKey(b);
+				if(keyA != keyB)
+				{
+					return keyA < keyB;
+				}
 
-			md.mVertexAttributes =
+				return a.mMesh->getDescriptors() < b.mMesh->getDescriptors();
+			});
+
+		for(uint32_t i = 0; i < mMergedDraws.size(); i++)
+		{
+			const auto& draw = mMergedDraws[i];
+			mMergedDraws[i].mCommand.firstInstance = i;
+			if(mMergedDrawBatches.empty() || getBatchKey(mMergedDraws[i - 1]) != getBatchKey(draw) ||
+				mMergedDraws[i - 1].mMesh->getDescriptors() != draw.mMesh->getDescriptors())
 			{
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent)},
-				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tex)}
-			};
-			md.mPushConstantRanges = {mModelMatrixPCR, mLightingPCR};
-			md.mPushConstantsCallback = commonPushConstantsCallback;
-			md.mDepthTestEnabled = true;
-			md.mVertexSize = sizeof(Vertex);
-			md.mSubPassIndex = 0;
-			
-			result.push_back(md);
+				MergedDrawBatch batch;
+				batch.mSubPass = draw.mSubPass;
+				batch.mPipelineId = draw.mPipelineId;
+				batch.mPipelineIndex = draw.mPipelineIndex;
+				batch.mArena = draw.mArena;
+				batch.mMesh = draw.mMesh;
+				batch.mFirstDraw = i;
+				mMergedDrawBatches.push_back(batch);
+			}
+			mMergedDrawBatches.back().mDrawsCount++;
 		}
-		else if(shaderFileName == "fog")
+
+		//Spheres are in mesh space, culling shader transforms them by per-draw data
+		mCullingDraws.resize(mMergedDraws.size());
+		for(uint32_t b = 0; b < mMergedDrawBatches.size(); b++)
 		{
-			ShaderMetaData md;
+			const auto& batch = mMergedDrawBatches[b];
+			for(uint32_t i = batch.mFirstDraw; i < batch.mFirstDraw + batch.mDrawsCount; i++)
+			{
+				const auto boundingBox = mMergedDraws[i].mMesh->getBoundingBox();
+				const auto sphere = getBoundingSphere(boundingBox.mMin, boundingBox.mMax);
+				//Meshes without bounds are never culled
+				mCullingDraws[i].mSphere = vec4(sphere.mCenter,
+					boundingBox.mMin == boundingBox.mMax ? UNBOUNDED_RADIUS : sphere.mRadius);
+				mCullingDraws[i].mBatch = b;
+				mCullingDraws[i].mBatchFirstDraw = batch.mFirstDraw;
+			}
+		}
 
-			md.mPushConstantRanges = {mNearFarPCR};
+		//Draws of each object, counted first and then placed
+		for(const auto& draw : mMergedDraws)
+		{
+			mObjectFirstDraws[draw.mObject + 1]++;
+		}
+		for(uint32_t object = 0; object < mRenderObjects.size(); object++)
+		{
+			mObjectFirstDraws[object + 1] += mObjectFirstDraws[object];
+		}
+		std::vector<uint32_t> placed(mObjectFirstDraws.begin(), mObjectFirstDraws.end() - 1);
+		mObjectDraws.resize(mMergedDraws.size());
+		for(uint32_t i = 0; i < mMergedDraws.size(); i++)
+		{
+			mObjectDraws[placed[mMergedDraws[i].mObject]++] = i;
+		}
+	}
+
+	void VulkanRenderer::prepareMergedDraws()
+	{
+		//Draws are grouped and uploaded again only when objects are gathered again
+		bool uploadAll = false;
+		if(mMergedDrawsVersion != mRenderObjectsVersion)
+		{
+			mMergedDrawsVersion = mRenderObjectsVersion;
+			groupMergedDraws();
+			uploadAll = true;
+		}
+		if(mMergedDraws.empty())
+		{
+			return;
+		}
+
+		const uint32_t regionsCount = static_cast<uint32_t>(mGraphicsCommandBuffers.size());
+		const uint32_t drawsCount = static_cast<uint32_t>(mMergedDraws.size());
+		if(mIndirectCommandsBuffer.getSize() < drawsCount * sizeof(VkDrawIndexedIndirectCommand) ||
+			mIndirectCommandsBuffer.getRegionsCount() != regionsCount)
+		{
+			const uint32_t reservedDraws = drawsCount + drawsCount / 2;
+			if(mIndirectCommandsBuffer.isCreated())
+			{
+				//Command buffers in flight may still read old buffers
+				releasePersistentBuffer(mIndirectCommandsBuffer);
+				releasePersistentBuffer(mMergedInstanceBuffer);
+			}
+			//Culling pass reads commands and instances from storage buffers
+			mIndirectCommandsBuffer.create(mainDevice, reservedDraws * sizeof(VkDrawIndexedIndirectCommand), regionsCount,
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+			mMergedInstanceBuffer.create(mainDevice, reservedDraws * sizeof(MeshInstance), regionsCount,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+			uploadAll = true;
+		}
+
+		if(uploadAll)
+		{
+			auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(
+				mIndirectCommandsBuffer.update(mImageIndex, 0, drawsCount * sizeof(VkDrawIndexedIndirectCommand)));
+			auto* instances = static_cast<MeshInstance*>(
+				mMergedInstanceBuffer.update(mImageIndex, 0, drawsCount * sizeof(MeshInstance)));
+			for(uint32_t i = 0; i < drawsCount; i++)
+			{
+				commands[i] = mMergedDraws[i].mCommand;
+				writeMeshInstance(mRenderObjects, mMergedDraws[i].mObject, instances[i]);
+			}
+			return;
+		}
+
+		//Commands are kept, per-draw data of moved models is written again
+		for(const auto model : mMovedModels)
+		{
+			const uint32_t end = mRenderObjects.getModelFirstObject(model + 1);
+			for(uint32_t object = mRenderObjects.getModelFirstObject(model); object < end; object++)
+			{
+				for(uint32_t i = mObjectFirstDraws[object]; i < mObjectFirstDraws[object + 1]; i++)
+				{
+					const uint32_t draw = mObjectDraws[i];
+					auto* instance = static_cast<MeshInstance*>(
+						mMergedInstanceBuffer.update(mImageIndex, draw * sizeof(MeshInstance), sizeof(MeshInstance)));
+					writeMeshInstance(mRenderObjects, object, *instance);
+				}
+			}
+		}
+	}
+
+	void VulkanRenderer::recordMergedDraws(const Camera& camera, const Light& light, uint32_t subPass, EDepthPass depthPass)
+	{
+		VkCommandBuffer commandBuffer = mGraphicsCommandBuffers[mImageIndex].mCommandBuffer;
+		const uint32_t commandStride = sizeof(VkDrawIndexedIndirectCommand);
+		//Culled commands keep layout of source ones
+		VkBuffer commandsBuffer = mIndirectCommandsBuffer.mBuffer;
+		VkDeviceSize commandsOffset = 0;
+		if(mFrameCulling)
+		{
+			commandsBuffer = mCullingPass.getCulledCommandsBuffer();
+			commandsOffset = mCullingPass.getCulledCommandsOffset(mImageIndex);
+		}
+		for(uint32_t b = 0; b < mMergedDrawBatches.size(); b++)
+		{
+			const auto& batch = mMergedDrawBatches[b];
+			if(batch.mSubPass != subPass)
+			{
+				continue;
+			}
+
+			const auto& material = mMaterials[batch.mMesh->getMaterialId()];
+			const auto& shader = mShaders[material.mShaderId];
+			const auto& shaderMetaData = mShaderMetaDatum[shader.mId][batch.mPipelineIndex];
+			auto& pipeline = mPipelines[batch.mPipelineId];
+
+			//Batch shares material, so pre-pass candidacy is the same for all its meshes
+			const EDepthPass batchDepthPass = depthPass == EDepthPass::Equal &&
+				isDepthPrePassCandidate(shaderMetaData, batch.mMesh) ? EDepthPass::Equal : EDepthPass::Default;
+			bindPipeline(pipeline, material.mShaderVariant, batchDepthPass);
+			pipeline.applyDynamicState(commandBuffer, batchDepthPass);
+
+			//Model matrices come from per-draw instance data
+			if(shaderMetaData.mPushConstantsCallback != nullptr)
+			{
+				shaderMetaData.mPushConstantsCallback(batch.mMesh, mat4(1.0f), camera, light, pipeline.mPipelineLayout, 0);
+			}
+
+			const auto& arena = mGeometryArenas.mArenas[batch.mArena];
+			VkBuffer vertexBuffers[] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+			VkDeviceSize offsets[] = { 0, 0 };
+			vertexBuffers[VERTEX_BINDING] = mBufferManager.getBuffer(arena.mVertexBufferId)->mBuffer;
+			vertexBuffers[INSTANCE_BINDING] = mMergedInstanceBuffer.mBuffer;
+			offsets[INSTANCE_BINDING] = 0;
+			bindVertexBuffers(vertexBuffers, 2, offsets, VK_PIPELINE_BIND_POINT_GRAPHICS);
+			bindIndexBuffer(mBufferManager.getBuffer(arena.mIndexBufferId)->mBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+			//Meshes of batch have equal descriptors, sets of the first one serve all
+			updateMeshDescriptorSets(batch.mMesh, shader);
+			bindDescriptorSets(batch.mMesh->getDescriptorSets(), pipeline.mPipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+			if(shaderMetaData.mLineWidth > 0.0f)
+			{
+				vkCmdSetLineWidth(commandBuffer, shaderMetaData.mLineWidth);
+			}
+
+			const VkDeviceSize firstCommandOffset = commandsOffset + batch.mFirstDraw * commandStride;
+			if(mFrameCulling && mDrawIndirectCount)
+			{
+				//Survivors are packed at the beginning of batch range, their count is written by culling pass
+				vkCmdDrawIndexedIndirectCountKHR(commandBuffer, commandsBuffer, firstCommandOffset,
+					mCullingPass.getCountsBuffer(), mCullingPass.getCountsOffset(mImageIndex) + b * sizeof(uint32_t),
+					batch.mDrawsCount, commandStride);
+				mRecordingStatistics.mDrawCalls++;
+				mRecordingStatistics.mIndirectDrawCalls++;
+			}
+			else if(mDeviceFeatures.features.multiDrawIndirect == VK_TRUE)
+			{
+				//Culled commands without draw count have zero instances
+				vkCmdDrawIndexedIndirect(commandBuffer, commandsBuffer, firstCommandOffset, batch.mDrawsCount, commandStride);
+				mRecordingStatistics.mDrawCalls++;
+				mRecordingStatistics.mIndirectDrawCalls++;
+			}
+			else
+			{
+				for(uint32_t i = 0; i < batch.mDrawsCount; i++)
+				{
+					vkCmdDrawIndexedIndirect(commandBuffer, commandsBuffer, firstCommandOffset + i * commandStride, 1, commandStride);
+				}
+				mRecordingStatistics.mDrawCalls += batch.mDrawsCount;
+				mRecordingStatistics.mIndirectDrawCalls += batch.mDrawsCount;
+			}
+			mRecordingStatistics.mInstances += batch.mDrawsCount;
+			mRecordingStatistics.mMergedMeshes += batch.mDrawsCount;
+		}
+	}
+
+	void VulkanRenderer::prepareCulling(const Camera& camera)
+	{
+		mFrameCulling = mCullingSettings.mEnabled && mCullingPass.isCreated() && !mMergedDrawBatches.empty();
+		if(!mFrameCulling)
+		{
+			return;
+		}
+
+		const uint32_t drawsCount = static_cast<uint32_t>(mMergedDraws.size());
+		const uint32_t batchesCount = static_cast<uint32_t>(mMergedDrawBatches.size());
+		if(mCullingPass.reserve(mainDevice, mDeletionQueue, drawsCount, batchesCount))
+		{
+			invalidateSceneCommands();
+			//Counts written by previous frames are lost with old buffers
+			for(auto& frameQueries : mFrameQueries)
+			{
+				frameQueries.mCullingBatches = 0;
+				frameQueries.mCullingReference.clear();
+			}
+		}
+
+		//Draws change only when they are grouped again
+		mCullingPass.updateDraws(mImageIndex, mCullingDraws, static_cast<uint32_t>(mMergedDrawsVersion));
+
+		const mat4 viewProjection = camera.mProjection * camera.mView;
+		const Frustum frustum = getFrustum(viewProjection);
+		//Pyramid of previous frame is tested with view projection it was rendered with
+		const bool occlusion = mCullingSettings.mOcclusion && mCullingPass.isHiZValid();
+		auto* data = mCullingPass.getData(mImageIndex);
+		data->mFrustum = frustum.mPlanes;
+		data->mOcclusionViewProjection = mCullingPass.getHiZViewProjection();
+		data->mHiZ = vec4(mCullingPass.getHiZWidth(), mCullingPass.getHiZHeight(), mCullingPass.getHiZLevelsCount(), 0.0f);
+		data->mParams = uvec4(drawsCount, occlusion ? 1 : 0, mDrawIndirectCount ? 1 : 0, 0);
+
+		auto& frameQueries = mFrameQueries[mImageIndex];
+		frameQueries.mCullingBatches = batchesCount;
+		frameQueries.mCullingOcclusion = occlusion;
+		if(mCullingSettings.mValidate)
+		{
+			//Pyramid stays on GPU, reference tests frustum only
+			std::vector<mat4> transforms(drawsCount);
+			for(uint32_t i = 0; i < drawsCount; i++)
+			{
+				transforms[i] = mRenderObjects.getTransform(mMergedDraws[i].mObject);
+			}
+			frameQueries.mCullingReference = cullDraws(mCullingDraws, transforms, batchesCount, frustum, nullptr, viewProjection);
+		}
+	}
+
+	void VulkanRenderer::createCullingPass()
+	{
+		if(!mCullingSettings.mEnabled)
+		{
+			return;
+		}
+
+		//Pyramid and depth are read with texel fetches
+		const auto samplerId = createSampler({ VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_FILTER_NEAREST, VK_FALSE });
+		if(!mCullingPass.create(mainDevice, static_cast<uint32_t>(mGraphicsCommandBuffers.size()), getSampler(samplerId),
+			mPipelineCache.mPipelineCache))
+		{
+			LOG_WARNING("Culling shaders are not found, merged draws are not culled");
+			return;
+		}
+		createHiZPyramid();
+
+		LOG_INFO("GPU culling created: occlusion {}, draw count {}", mCullingSettings.mOcclusion, mDrawIndirectCount);
+	}
+
+	void VulkanRenderer::prepareCPUCulling(const Camera& camera)
+	{
+		const bool previousCPUCulling = mFrameCPUCulling;
+		mFrameCPUCulling = mCullingSettings.mCPUFrustum;
+		mRenderStatistics.mCPUCulledMeshes = 0;
+		mRenderStatistics.mCPUOcclusionTested = 0;
+		mRenderStatistics.mCPUOccludedMeshes = 0;
+		mRenderStatistics.mCPUOccluderTriangles = 0;
+		mRenderStatistics.mCPUCullingTime = 0.0f;
+		if(!mFrameCPUCulling)
+		{
+			//Result of last culled frame isn't valid anymore
+			if(previousCPUCulling)
+			{
+				for(auto& flags : mRenderObjects.mFlags)
+				{
+					flags &= ~RO_CULLED;
+				}
+			}
+			return;
+		}
+
+		const double startTime = Timer::getInstance().getTime();
+
+		//Bounds follow transforms, they are computed again when objects move
+		if(mMeshBoundsVersion != mRenderTransformsVersion)
+		{
+			mMeshBoundsVersion = mRenderTransformsVersion;
+			mMeshBounds.clear();
+			for(uint32_t object = 0; object < mRenderObjects.size(); object++)
+			{
+				//Instances and generated geometry may be anywhere
+				const auto& mesh = mMeshModels[mRenderObjects.mModelIds[object]]->getMesh(mRenderObjects.mMeshIndices[object]);
+				const auto boundingBox = mesh->getBoundingBox();
+				if(mesh->hasInstances() || mesh->getInstanceCount() != 1 || mesh->getVertexCount() == 0 ||
+					boundingBox.mMin == boundingBox.mMax)
+				{
+					mMeshBounds.addUnbounded();
+				}
+				else
+				{
+					mMeshBounds.add(boundingBox.mMin, boundingBox.mMax, mRenderObjects.getTransform(object));
+				}
+			}
+		}
+
+		const mat4 viewProjection = camera.mProjection * camera.mView;
+		const uint32_t visible = cullBoundsSIMD(getFrustum(viewProjection), mMeshBounds, mMeshVisibility);
+		mRenderStatistics.mCPUCulledMeshes = mMeshBounds.size() - visible;
+		if(mCullingSettings.mCPUOcclusion)
+		{
+			prepareCPUOcclusion(viewProjection);
+		}
+		//Scene commands skip culled objects
+		bool culledChanged = false;
+		for(uint32_t object = 0; object < mRenderObjects.size(); object++)
+		{
+			auto& flags = mRenderObjects.mFlags[object];
+			const uint8_t culledFlags = (flags & ~RO_CULLED) | (mMeshVisibility[object] == 0 ? RO_CULLED : 0);
+			culledChanged = culledChanged || culledFlags != flags;
+			flags = culledFlags;
+		}
+		if(culledChanged)
+		{
+			invalidateSceneCommands();
+		}
+		mRenderStatistics.mCPUCullingTime = static_cast<float>((Timer::getInstance().getTime() - startTime) * 1000.0);
+	}
+
+	void VulkanRenderer::prepareCPUOcclusion(const mat4& viewProjection)
+	{
+		//Only occluders which passed frustum test can hide anything
+		mOcclusionRasterizer.resize(mCullingSettings.mOcclusionWidth, mCullingSettings.mOcclusionHeight);
+		mOcclusionRasterizer.clear();
+		uint32_t meshIndex = 0;
+		for(const auto& model : mMeshModels)
+		{
+			for(uint32_t i = 0; i < model->getMeshCount(); i++, meshIndex++)
+			{
+				const auto& mesh = model->getMesh(i);
+				if(mesh->getOccluder() && (mRenderObjects.mFlags[meshIndex] & RO_VISIBLE) != 0 && mMeshVisibility[meshIndex] != 0)
+				{
+					mOcclusionRasterizer.rasterize(mesh->getVertexData(), mesh->getVertexSize(), mesh->getVertexCount(),
+						mesh->getIndexCount() > 0 ? static_cast<const uint32_t*>(mesh->getIndexData()) : nullptr,
+						mesh->getIndexCount(), viewProjection * mRenderObjects.getTransform(meshIndex));
+				}
+			}
+		}
+		mRenderStatistics.mCPUOccluderTriangles = mOcclusionRasterizer.getTrianglesCount();
+		if(mOcclusionRasterizer.getTrianglesCount() == 0)
+		{
+			return;
+		}
+		mOcclusionRasterizer.buildPyramid(mOcclusionPyramid);
+
+		//Occluders are kept, so they don't hide each other because of coarse depth
+		meshIndex = 0;
+		for(const auto& model : mMeshModels)
+		{
+			for(uint32_t i = 0; i < model->getMeshCount(); i++, meshIndex++)
+			{
+				if(mMeshVisibility[meshIndex] == 0 || mMeshBounds.mRadius[meshIndex] >= UNBOUNDED_RADIUS ||
+					model->getMesh(i)->getOccluder())
+				{
+					continue;
+				}
+
+				//Box around the tighter of bounding sphere and box
+				const vec3 center(mMeshBounds.mCenterX[meshIndex], mMeshBounds.mCenterY[meshIndex], mMeshBounds.mCenterZ[meshIndex]);
+				const vec3 extent = min(vec3(mMeshBounds.mRadius[meshIndex]),
+					vec3(mMeshBounds.mExtentX[meshIndex], mMeshBounds.mExtentY[meshIndex], mMeshBounds.mExtentZ[meshIndex]));
+				mRenderStatistics.mCPUOcclusionTested++;
+				if(isBoxOccluded(mOcclusionPyramid, viewProjection, center, extent))
+				{
+					mMeshVisibility[meshIndex] = 0;
+					mRenderStatistics.mCPUOccludedMeshes++;
+				}
+			}
+		}
+	}
+
+	void VulkanRenderer::requestStreamedTextures(const Camera& camera)
+	{
+		if(!mTextureManager.isTextureStreaming())
+		{
+			return;
+		}
+
+		//Pixels covered by unit size at unit distance
+		const float pixelsScale = camera.mProjection[1][1] * 0.5f * static_cast<float>(mSwapChain.mSwapChainExtent.height);
+		uint32_t object = 0;
+		for(const auto& model : mMeshModels)
+		{
+			for(uint32_t i = 0; i < model->getMeshCount(); i++, object++)
+			{
+				if((mRenderObjects.mFlags[object] & RO_VISIBLE) == 0 || (mRenderObjects.mFlags[object] & RO_CULLED) != 0)
+				{
+					continue;
+				}
+
+				//Unbounded meshes may cover the whole screen
+				float screenSize = std::numeric_limits<float>::max();
+				const auto& mesh = model->getMesh(i);
+				const auto boundingBox = mesh->getBoundingBox();
+				if(!mesh->hasInstances() && mesh->getInstanceCount() == 1 && boundingBox.mMin != boundingBox.mMax)
+				{
+					//Sphere around box in view space, the largest axis scale keeps it around
+					const mat4 modelView = camera.mView * mRenderObjects.getTransform(object);
+					const vec3 center = vec3(modelView * vec4((boundingBox.mMin + boundingBox.mMax) * 0.5f, 1.0f));
+					const float scale = std::max({ length(vec3(modelView[0])), length(vec3(modelView[1])), length(vec3(modelView[2])) });
+					const float radius = length(boundingBox.mMax - boundingBox.mMin) * 0.5f * scale;
+					const float distance = length(center);
+					screenSize = distance > radius ? 2.0f * radius * pixelsScale / distance : screenSize;
+				}
+				mTextureManager.requestMaterialLevels(mRenderObjects.mMaterialIds[object], screenSize);
+			}
+		}
+	}
+
+	void VulkanRenderer::createHiZPyramid()
+	{
+		std::vector<VkImageView> depthViews;
+		if(mCullingSettings.mOcclusion)
+		{
+			for(const auto& frameBuffer : mFrameBuffers)
+			{
+				depthViews.push_back(frameBuffer.getAttachment(mSceneDepthResource).mImageView);
+			}
+		}
+		mCullingPass.createHiZ(mainDevice, mSwapChain.mSwapChainExtent, depthViews);
+	}
+
+	void VulkanRenderer::createDepthPrePassStreams()
+	{
+		invalidateSceneCommands();
+		uint32_t streamsCount = 0;
+		for(auto& meshModel : mMeshModels)
+		{
+			for(uint32_t i = 0; i < meshModel->getMeshCount(); i++)
+			{
+				const auto& mesh = meshModel->getMesh(i);
+				const uint32_t meshId = mesh->getId();
+				const Material& material = mMaterials[mesh->getMaterialId()];
+				if(mesh->getVertexCount() == 0 || material.mShaderId >= mShaders.size() ||
+					mMeshToPositionBufferMap.find(meshId) != mMeshToPositionBufferMap.end())
+				{
+					continue;
+				}
+
+				//Position is the first vertex attribute
+				const auto& shaderMetaDatum = mShaderMetaDatum[mShaders[material.mShaderId].mId];
+				const auto foundIt = std::find_if(shaderMetaDatum.begin(), shaderMetaDatum.end(),
+					[](const ShaderMetaData& md)
+					{
+						return md.mDepthPrePass && !md.mVertexAttributes.empty() &&
+							md.mVertexAttributes.front().mFormat == VK_FORMAT_R32G32B32_SFLOAT;
+					});
+				if(foundIt == shaderMetaDatum.end())
+				{
+					continue;
+				}
+
+				const uint32_t positionOffset = foundIt->mVertexAttributes.front().mOffset;
+				const uint32_t vertexSize = mesh->getVertexSize();
+				const uint32_t verticesCount = mesh->getVertexCount();
+				const auto* vertexData = static_cast<const uint8_t*>(mesh->getVertexData());
+				std::vector<uint8_t> positions(verticesCount * POSITION_STREAM_STRIDE);
+				for(uint32_t v = 0; v < verticesCount; v++)
+				{
+					memcpy(positions.data() + v * POSITION_STREAM_STRIDE, vertexData + v * vertexSize + positionOffset, POSITION_STREAM_STRIDE);
+				}
+
+				mMeshToPositionBufferMap[meshId] = static_cast<uint32_t>(mBufferManager.mBuffers.size());
+				mBufferManager.createBuffer(
+					mainDevice, mTransferQueue, mTransferCommandPool,
+					VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, positions.data(), positions.size());
+				streamsCount++;
+			}
+		}
+
+		LOG_INFO("Depth pre-pass position streams created: {}", streamsCount);
+	}
+
+	void VulkanRenderer::createDefaultInstanceBuffer()
+	{
+		if(!mDefaultInstanceBuffer.isCreated())
+		{
+			const MeshInstance defaultInstance;
+			mDefaultInstanceBuffer.create(mainDevice, sizeof(MeshInstance), 1);
+			mDefaultInstanceBuffer.update(0, &defaultInstance, sizeof(MeshInstance), 0);
+		}
+	}
+
+	void VulkanRenderer::createFrameUniforms()
+	{
+		if(mFrameUniformsBuffer.isCreated())
+		{
+			return;
+		}
+
+		//Region per command buffer like other stream buffers
+		mFrameUniformsBuffer.create(mainDevice, sizeof(FrameUniforms), static_cast<uint32_t>(mGraphicsCommandBuffers.size()),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+		VulkanDescriptorSetLayoutInfo layoutInfo;
+		layoutInfo.mDescriptorTypes = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC };
+		layoutInfo.mBindings = { 0 };
+		layoutInfo.mDescriptorCount = { 1 };
+		layoutInfo.mStageFlags = { VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT };
+		mFrameUniformsDSLId = createDescriptorSetLayout(layoutInfo);
+		const VkDescriptorSetLayout layout = getDescriptorSetLayout(mFrameUniformsDSLId)->mDescriptorSetLayout;
+
+		VkDescriptorPoolSize poolSize = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+		VkDescriptorPoolCreateInfo poolCreateInfo = {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.maxSets = 1;
+		poolCreateInfo.poolSizeCount = 1;
+		poolCreateInfo.pPoolSizes = &poolSize;
+		VK_CHECK(vkCreateDescriptorPool(mainDevice.logicalDevice, &poolCreateInfo, nullptr, &mFrameUniformsPool));
+
+		VkDescriptorSetAllocateInfo setAllocInfo = {};
+		setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setAllocInfo.descriptorPool = mFrameUniformsPool;
+		setAllocInfo.descriptorSetCount = 1;
+		setAllocInfo.pSetLayouts = &layout;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		VK_CHECK(vkAllocateDescriptorSets(mainDevice.logicalDevice, &setAllocInfo, &descriptorSet));
+
+		//Offset of current region is given when set is bound
+		VkDescriptorBufferInfo bufferInfo = { mFrameUniformsBuffer.mBuffer, 0, sizeof(FrameUniforms) };
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = 0;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		write.descriptorCount = 1;
+		write.pBufferInfo = &bufferInfo;
+		vkUpdateDescriptorSets(mainDevice.logicalDevice, 1, &write, 0, nullptr);
+
+		//Set lives in own pool, cache only hands it out to meshes
+		const VulkanDescriptorSetKey key = { mFrameUniformsDSLId, {} };
+		mFrameUniformsSetId = mDescriptorSetCache.findOrCreate(key, [layout, descriptorSet](const VulkanDescriptorSetKey& key)
+			{
+				VulkanDescriptorSetPtr ds = std::make_shared<VulkanDescriptorSet>();
+				ds->mDescriptorSetLayout = layout;
+				ds->mDescriptorSet = descriptorSet;
+				return ds;
+			});
+	}
+
+	void VulkanRenderer::cleanupFrameUniforms()
+	{
+		if(mFrameUniformsSetId != MAX(uint32_t))
+		{
+			mDescriptorSetCache.erase(mFrameUniformsSetId);
+			mFrameUniformsSetId = MAX(uint32_t);
+		}
+		if(mFrameUniformsPool != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorPool(mainDevice.logicalDevice, mFrameUniformsPool, nullptr);
+			mFrameUniformsPool = VK_NULL_HANDLE;
+		}
+		mFrameUniformsBuffer.destroy(mainDevice.logicalDevice);
+	}
+
+	bool VulkanRenderer::updateTransforms()
+	{
+		const uint64_t transformsVersion = getTransformsVersion();
+		if(transformsVersion == mTransformsVersion)
+		{
+			return false;
+		}
+
+		mTransformsVersion = transformsVersion;
+		for(auto& meshModel : mMeshModels)
+		{
+			meshModel->updateTransforms(&mThreadPool);
+		}
+
+		return true;
+	}
+
+	void VulkanRenderer::prepareRenderObjects(bool transformsChanged)
+	{
+		mMovedModels.clear();
+		const uint64_t sceneVersion = getSceneVersion();
+		if(sceneVersion == mSceneVersion && mRenderObjectsCallback == nullptr)
+		{
+			if(!transformsChanged)
+			{
+				return;
+			}
+
+			uint32_t changed = 0;
+			for(uint32_t j = 0; j < mMeshModels.size(); j++)
+			{
+				const uint64_t version = mMeshModels[j]->getTransformsVersion();
+				if(version != mModelTransformsVersions[j])
+				{
+					mModelTransformsVersions[j] = version;
+					const uint32_t modelChanged = mRenderObjects.updateModelTransforms(j, mMeshModels[j]);
+					if(modelChanged > 0)
+					{
+						mMovedModels.push_back(j);
+					}
+					changed += modelChanged;
+				}
+			}
+			//Model matrices are pushed by scene commands
+			if(changed > 0)
+			{
+				mRenderTransformsVersion++;
+				invalidateSceneCommands();
+			}
+			return;
+		}
+
+		mSceneVersion = sceneVersion;
+		mRenderObjects.clear();
+		mModelTransformsVersions.resize(mMeshModels.size());
+		for(uint32_t j = 0; j < mMeshModels.size(); j++)
+		{
+			const auto& model = mMeshModels[j];
+			mModelTransformsVersions[j] = model->getTransformsVersion();
+			for(uint32_t object = mRenderObjects.addModel(j, model); object < mRenderObjects.size(); object++)
+			{
+				const auto& mesh = model->getMesh(mRenderObjects.mMeshIndices[object]);
+				const auto* range = getGeometryRange(mesh->getId());
+				if(range != nullptr)
+				{
+					mRenderObjects.mFirstIndices[object] = range->mFirstIndex;
+					mRenderObjects.mVertexOffsets[object] = range->mVertexOffset;
+				}
+				if((mRenderObjects.mFlags[object] & RO_VISIBLE) != 0 && isMergedDrawCandidate(mesh))
+				{
+					mRenderObjects.mFlags[object] |= RO_MERGED;
+				}
+			}
+		}
+
+		if(mRenderObjectsCallback != nullptr)
+		{
+			mRenderObjectsCallback(mRenderObjects);
+		}
+		mRenderObjects.updateNormalMatrices();
+		mRenderObjectsCallbacks = std::any_of(mRenderObjects.mFlags.begin(), mRenderObjects.mFlags.end(),
+			[](uint8_t flags) { return (flags & (RO_VISIT_CALLBACKS | RO_RECORD_CALLBACKS)) != 0; });
+		mRenderObjectsVersion++;
+		mRenderTransformsVersion++;
+		invalidateSceneCommands();
+	}
+
+	void VulkanRenderer::prepareDrawData()
+	{
+		const uint32_t regionsCount = static_cast<uint32_t>(mGraphicsCommandBuffers.size());
+		const uint32_t objectsCount = mRenderObjects.size();
+		if(objectsCount == 0)
+		{
+			return;
+		}
+
+		bool uploadAll = mDrawDataVersion != mRenderObjectsVersion;
+		mDrawDataVersion = mRenderObjectsVersion;
+		if(mDrawDataBuffer.getSize() < objectsCount * sizeof(MeshInstance) || mDrawDataBuffer.getRegionsCount() != regionsCount)
+		{
+			if(mDrawDataBuffer.isCreated())
+			{
+				//Command buffers in flight may still read old buffer
+				releasePersistentBuffer(mDrawDataBuffer);
+			}
+			mDrawDataBuffer.create(mainDevice, (objectsCount + objectsCount / 2) * sizeof(MeshInstance), regionsCount,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+			uploadAll = true;
+		}
+
+		if(uploadAll)
+		{
+			writeDrawData(0, objectsCount);
+			return;
+		}
+		for(const auto model : mMovedModels)
+		{
+			writeDrawData(mRenderObjects.getModelFirstObject(model), mRenderObjects.getModelFirstObject(model + 1));
+		}
+	}
+
+	void VulkanRenderer::writeDrawData(uint32_t first, uint32_t end)
+	{
+		if(first == end)
+		{
+			return;
+		}
+
+		auto* drawData = static_cast<MeshInstance*>(
+			mDrawDataBuffer.update(mImageIndex, first * sizeof(MeshInstance), (end - first) * sizeof(MeshInstance)));
+		for(uint32_t object = first; object < end; object++)
+		{
+			writeMeshInstance(mRenderObjects, object, drawData[object - first]);
+		}
+	}
+
+	bool VulkanRenderer::useDrawData(const ShaderMetaData& shaderMetaData, const Mesh::Ptr& mesh, uint32_t renderObject) const
+	{
+		//Own push constants callback may expect model matrix of mesh
+		const bool pushCallback = (mRenderObjects.mFlags[renderObject] & RO_RECORD_CALLBACKS) != 0 &&
+			mesh->mPushConstantsCallback != nullptr;
+
+		return shaderMetaData.mInstanceSize == sizeof(MeshInstance) &&
+			!mesh->hasInstances() &&
+			!pushCallback &&
+			renderObject < mDrawDataBuffer.getSize() / sizeof(MeshInstance);
+	}
+
+	void VulkanRenderer::createBindlessTextures()
+	{
+		if(mBindlessTextureFlags == 0)
+		{
+			return;
+		}
+
+		//Update after bind limits are separate from regular ones
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties = {};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2(mainDevice.physicalDevice, &properties);
+		const uint32_t texturesCount = std::min({ MAX_BINDLESS_TEXTURES,
+			indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages });
+
+		mBindlessDSLId = createDescriptorSetLayout(VulkanTextureManager::getBindlessLayoutInfo(texturesCount, mBindlessTextureFlags));
+		const VkDescriptorSetLayout layout = getDescriptorSetLayout(mBindlessDSLId)->mDescriptorSetLayout;
+		mTextureManager.createBindless(mainDevice, layout, texturesCount, MAX_BINDLESS_MATERIALS, MAX_FRAME_DRAWS,
+			[this](const VulkanTextureInfo& info)
+			{
+				return getSampler(createSampler({ info.mAddressMode, VK_FILTER_LINEAR, VK_FALSE }));
+			});
+
+		//Set lives in texture manager pool, cache only hands it out to meshes
+		const VulkanDescriptorSetKey key = { mBindlessDSLId, {} };
+		mBindlessSetId = mDescriptorSetCache.findOrCreate(key, [this, layout](const VulkanDescriptorSetKey& key)
+			{
+				VulkanDescriptorSetPtr ds = std::make_shared<VulkanDescriptorSet>();
+				ds->mDescriptorSetLayout = layout;
+				ds->mDescriptorSet = mTextureManager.getBindlessSet();
+				return ds;
+			});
+	}
+
+	void VulkanRenderer::resetPushedConstants()
+	{
+		mPushedLayout = VK_NULL_HANDLE;
+		std::fill(mPushedConstantsMask.begin(), mPushedConstantsMask.end(), 0);
+	}
+
+	void VulkanRenderer::updateInstanceBuffers()
+	{
+		const uint32_t regionsCount = static_cast<uint32_t>(mGraphicsCommandBuffers.size());
+		for(auto& meshModel : mMeshModels)
+		{
+			for(uint32_t i = 0; i < meshModel->getMeshCount(); i++)
+			{
+				const auto& mesh = meshModel->getMesh(i);
+				if(!mesh->hasInstances())
+				{
+					continue;
+				}
+
+				const auto& instances = mesh->getInstances();
+				const VkDeviceSize dataSize = instances.size() * sizeof(MeshInstance);
+				auto& instanceBuffer = mMeshToInstanceBufferMap[mesh->getId()];
+				if(instanceBuffer.getRegionSize() < dataSize || instanceBuffer.getRegionsCount() != regionsCount)
+				{
+					//Reserve space, so growing instances don't recreate buffer every frame
+					const VkDeviceSize regionSize = std::max(dataSize + dataSize / 2, instanceBuffer.getRegionSize());
+					if(instanceBuffer.isCreated())
+					{
+						//Command buffers in flight may still read old buffer
+						releaseStreamBuffer(instanceBuffer);
+					}
+					instanceBuffer.create(mainDevice, regionSize, regionsCount);
+				}
+				instanceBuffer.update(mImageIndex, instances.data(), dataSize, mesh->getInstancesVersion());
+			}
+		}
+	}
+
+	void VulkanRenderer::releaseStreamBuffer(VulkanStreamBuffer& buffer)
+	{
+		VkDevice logicalDevice = mainDevice.logicalDevice;
+		mDeletionQueue.push([logicalDevice, released = buffer]() mutable { released.destroy(logicalDevice); });
+		buffer = VulkanStreamBuffer();
+		//Scene commands reference released buffer
+		invalidateSceneCommands();
+	}
+
+	void VulkanRenderer::releasePersistentBuffer(VulkanPersistentBuffer& buffer)
+	{
+		VkDevice logicalDevice = mainDevice.logicalDevice;
+		mDeletionQueue.push([logicalDevice, released = buffer]() mutable { released.destroy(logicalDevice); });
+		buffer = VulkanPersistentBuffer();
+		//Scene commands reference released buffer
+		invalidateSceneCommands();
+	}
+
+	void VulkanRenderer::recordSceneUploads(VkCommandBuffer commandBuffer)
+	{
+		//Culling pass reads commands and per-draw data as storage buffers
+		mDrawDataBuffer.recordUpload(commandBuffer, mImageIndex,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+		mIndirectCommandsBuffer.recordUpload(commandBuffer, mImageIndex,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+		mMergedInstanceBuffer.recordUpload(commandBuffer, mImageIndex,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+		mRecordingStatistics.mUploadedSceneBytes = mDrawDataBuffer.getUploadedSize() +
+			mIndirectCommandsBuffer.getUploadedSize() + mMergedInstanceBuffer.getUploadedSize();
+	}
+
+	void VulkanRenderer::cleanupInstanceBuffers()
+	{
+		for(auto& [meshId, instanceBuffer] : mMeshToInstanceBufferMap)
+		{
+			instanceBuffer.destroy(mainDevice.logicalDevice);
+		}
+		mMeshToInstanceBufferMap.clear();
+		mDefaultInstanceBuffer.destroy(mainDevice.logicalDevice);
+		mIndirectCommandsBuffer.destroy(mainDevice.logicalDevice);
+		mMergedInstanceBuffer.destroy(mainDevice.logicalDevice);
+		mDrawDataBuffer.destroy(mainDevice.logicalDevice);
+	}
+
+	void VulkanRenderer::cleanupCullingPass()
+	{
+		mCullingPass.destroy(mainDevice.logicalDevice);
+	}
+
+	void VulkanRenderer::setDepthPrePassMode(EDepthPrePassMode mode)
+	{
+		mDepthPrePass.mSettings.mMode = mode;
+		mDepthPrePass.reset();
+	}
+
+	void VulkanRenderer::setSceneCommandsReuse(bool enabled)
+	{
+		mSceneCommandsReuse = enabled;
+		invalidateSceneCommands();
+	}
+
+	uint64_t VulkanRenderer::updateSceneCommandsVersion()
+	{
+		if(!mSceneCommandsReuse || mRenderObjectsCallbacks)
+		{
+			return 0;
+		}
+
+		//Objects, materials and descriptors bump version when objects are gathered, moved or culled.
+		//Settings of frame are compared with previous one
+		const auto renderExtent = getRenderExtent();
+		const std::array<uint64_t, 5> state = { renderExtent.width, renderExtent.height, mFrameDepthPrePass,
+			mFrameCulling, mFrameCPUCulling };
+		if(state != mSceneCommandsState)
+		{
+			invalidateSceneCommands();
+			mSceneCommandsState = state;
+		}
+
+		return mSceneCommandsVersion;
+	}
+
+	void VulkanRenderer::executeSceneCommands(uint32_t passId, uint64_t version, const Camera& camera, const Light& light)
+	{
+		auto& sceneCommands = mSceneCommands[mImageIndex];
+		//Image may be acquired again before frame slot which drew it last time is waited.
+		//Commands aren't simultaneous use, so they can't be pending when executed or recorded again
+		if(sceneCommands.mFrame >= 0 && sceneCommands.mFrame != mCurrentFrame)
+		{
+			VK_CHECK(vkWaitForFences(mainDevice.logicalDevice, 1, &mDrawFences[sceneCommands.mFrame],
+				VK_TRUE, std::numeric_limits<uint64_t>::max()));
+		}
+		sceneCommands.mFrame = mCurrentFrame;
+
+		mRecordingStatistics.mSceneCommandsReused = sceneCommands.mVersion == version;
+		if(mRecordingStatistics.mSceneCommandsReused)
+		{
+			mRecordingStatistics = sceneCommands.mStatistics;
+			mRecordingStatistics.mSceneCommandsReused = true;
+		}
+		else
+		{
+			if(sceneCommands.mCommandBuffer == VK_NULL_HANDLE)
+			{
+				VkCommandBufferAllocateInfo allocInfo = {};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.commandPool = mGraphicsCommandPool.getCommandPool();
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				allocInfo.commandBufferCount = 1;
+				VK_CHECK(vkAllocateCommandBuffers(mainDevice.logicalDevice, &allocInfo, &sceneCommands.mCommandBuffer));
+			}
+
+			const auto& pass = mRenderGraph.getPass(passId);
+			VkCommandBufferInheritanceInfo inheritanceInfo = {};
+			inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			inheritanceInfo.renderPass = mRenderPasses[pass.mRenderPass].mRenderPass;
+			inheritanceInfo.subpass = pass.mSubpass;
+			inheritanceInfo.framebuffer = mFrameBuffers[mImageIndex].mFrameBuffers[pass.mRenderPass];
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
+			VK_CHECK(vkBeginCommandBuffer(sceneCommands.mCommandBuffer, &beginInfo));
+
+			//Secondary inherits no state, everything is bound again inside
+			VkCommandBuffer& commandBuffer = mGraphicsCommandBuffers[mImageIndex].mCommandBuffer;
+			std::swap(commandBuffer, sceneCommands.mCommandBuffer);
+			resetPushedConstants();
+			renderSubPass(passId, camera, light);
+			std::swap(commandBuffer, sceneCommands.mCommandBuffer);
+			resetPushedConstants();
+			VK_CHECK(vkEndCommandBuffer(sceneCommands.mCommandBuffer));
+
+			sceneCommands.mVersion = version;
+			sceneCommands.mStatistics = mRecordingStatistics;
+		}
+
+		vkCmdExecuteCommands(mGraphicsCommandBuffers[mImageIndex].mCommandBuffer, 1, &sceneCommands.mCommandBuffer);
+	}
+
+	void VulkanRenderer::createBarrier(VkBuffer buffer, VkPipelineBindPoint pipelineBindPoint)
+	{
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;   // Compute shader writes
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;    // Vertex shader reads
+		barrier.srcQueueFamilyIndex = mComputeQueueFamilyId;
+		barrier.dstQueueFamilyIndex = mGraphicsQueueFamilyId;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(
+			pipelineBindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? mComputeCommandBuffers[mImageIndex].mCommandBuffer
+				: mGraphicsCommandBuffers[mImageIndex].mCommandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+			0,
+			0, nullptr,
+			1, &barrier,
+			0, nullptr
+		);
+	}
+	
+	ShaderMetaDatum VulkanRenderer::getShaderMetaData(const std::string& shaderFileName)
+	{
+		ShaderMetaDatum result;
+
+		auto commonPushConstantsCallback =
+			[this](const Mesh::Ptr& mesh, const mat4& modelMatrix, const Camera& camera, const Light& light, VkPipelineLayout pipelineLayout, uint32_t instanceId)
+			{
+				if (mesh != nullptr)
+				{
+					pushConstants(mModelMatrixPCR, &modelMatrix[0], pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+					fillLightingPushConstant(mesh, modelMatrix, mLighting);
+					pushConstants(mLightingPCR, &mLighting, pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+				}
+			};
+
+		//Uber shader: textures, normal mapping and PBR are toggled by specialization constants
+		if(shaderFileName == "material" || shaderFileName == "colored")
+		{
+			ShaderMetaData md;
+
+			md.mVertexAttributes =
+			{
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos)},
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal)},
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tangent)},
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, tex)}
+			};
+			//Transform matrix columns, color and normal matrix columns
+			md.mInstanceAttributes =
+			{
+				{VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(MeshInstance, transform)},
+				{VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(MeshInstance, transform) + sizeof(vec4)},
+				{VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(MeshInstance, transform) + 2 * sizeof(vec4)},
+				{VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(MeshInstance, transform) + 3 * sizeof(vec4)},
+				{VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(MeshInstance, color)},
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshInstance, normalMatrix)},
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshInstance, normalMatrix) + sizeof(vec4)},
+				{VK_FORMAT_R32G32B32_SFLOAT, offsetof(MeshInstance, normalMatrix) + 2 * sizeof(vec4)}
+			};
+			md.mInstanceSize = sizeof(MeshInstance);
+			md.mPushConstantRanges = {mModelMatrixPCR, mLightingPCR};
+			md.mPushConstantsCallback = commonPushConstantsCallback;
+			md.mDepthTestEnabled = true;
+			md.mVertexSize = sizeof(Vertex);
+			md.mSubPassIndex = 0;
+			md.mHasVariants = shaderFileName == "material";
+			md.mDepthPrePass = true;
+
+			result.push_back(md);
+		}
+		else if(shaderFileName == "fog")
+		{
+			ShaderMetaData md;
+
+			md.mPushConstantRanges = {mNearFarPCR};
 			md.mPushConstantsCallback =
 				[this](const Mesh::Ptr& mesh, const mat4& modelMatrix, const Camera& camera,
 					const Light& light, VkPipelineLayout pipelineLayout, uint32_t instanceId)
@@ -2492,6 +4451,18 @@ namespace fre
 		else if(shaderFileName == "postProcess")
 		{
 			ShaderMetaData md;
+			md.mPushConstantRanges = {mRenderScalePCR};
+			md.mPushConstantsCallback =
+				[this](const Mesh::Ptr& mesh, const mat4& modelMatrix, const Camera& camera,
+					const Light& light, VkPipelineLayout pipelineLayout, uint32_t instanceId)
+				{
+					//Scene color is rendered to top left part of attachment, stretch it over the screen
+					const auto renderExtent = getRenderExtent();
+					const vec2 fullSize(mSwapChain.mSwapChainExtent.width, mSwapChain.mSwapChainExtent.height);
+					const vec2 renderSize(renderExtent.width, renderExtent.height);
+					const vec4 renderScale(renderSize / fullSize, (renderSize - 0.5f) / fullSize);
+					pushConstants(mRenderScalePCR, &renderScale, pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+				};
 			md.mDepthTestEnabled = false;
 			md.mVertexSize = 0;
 			md.mSubPassIndex = 1;
@@ -2519,15 +4490,18 @@ namespace fre
 		{
 			if(material.hasTextureTypes({aiTextureType_BASE_COLOR, aiTextureType_NORMALS, aiTextureType_METALNESS}))
 			{
-				shaderFileName = "pbr";
+				shaderFileName = "material";
+				material.mShaderVariant.mFeatures = SF_TEXTURED | SF_NORMAL_MAP | SF_PBR;
 			}
 			else if(material.hasTextureTypes({aiTextureType_DIFFUSE, aiTextureType_NORMALS}))
 			{
-				shaderFileName = "normalMap";
+				shaderFileName = "material";
+				material.mShaderVariant.mFeatures = SF_TEXTURED | SF_NORMAL_MAP;
 			}
 			else if(material.hasTextureTypes({aiTextureType_DIFFUSE}))
 			{
-				shaderFileName = "textured";
+				shaderFileName = "material";
+				material.mShaderVariant.mFeatures = SF_TEXTURED;
 			}
 			else
 			{
@@ -2539,7 +4513,29 @@ namespace fre
 		{
 			material.mShaderId = addShader(shaderFileName);
 		}
+
+		//Shaders find material textures in bindless table by index of material
+		auto getTextureInfoId = [&material](const std::vector<aiTextureType>& textureTypes)
+			{
+				for(const auto textureType : textureTypes)
+				{
+					const auto foundIt = material.mTextureIds.find(textureType);
+					if(foundIt != material.mTextureIds.end())
+					{
+						return foundIt->second;
+					}
+				}
+				return VulkanTextureManager::INVALID_BINDLESS_SLOT;
+			};
+		VulkanTextureManager::MaterialTextures textures;
+		textures.fill(VulkanTextureManager::INVALID_BINDLESS_SLOT);
+		textures[MT_BASE_COLOR] = getTextureInfoId({ aiTextureType_BASE_COLOR, aiTextureType_DIFFUSE });
+		textures[MT_NORMALS] = getTextureInfoId({ aiTextureType_NORMALS });
+		textures[MT_METALLIC_ROUGHNESS] = getTextureInfoId({ aiTextureType_METALNESS });
+		mTextureManager.setMaterialTextures(static_cast<uint32_t>(mMaterials.size()), textures);
+
 		mMaterials.push_back(material);
+		changeSceneVersion();
 	}
 
 	int VulkanRenderer::addShader(const std::string& shaderFileName)
@@ -2594,6 +4590,7 @@ namespace fre
 					{
 						Image image;
 						image.mFileName = path.C_Str();
+						image.mSRGB = textureType == aiTextureType_BASE_COLOR || textureType == aiTextureType_DIFFUSE;
 						auto textureInfoId = createTextureInfo(
 							VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_IMAGE_TILING_OPTIMAL,
 							VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
@@ -2607,11 +4604,16 @@ namespace fre
 			addMaterial(material);
 		}
 
-		//Load all meshes
+		//Load all meshes, keeping node hierarchy they are attached to
+		SceneGraph sceneGraph;
+		std::vector<uint32_t> meshNodes;
 		MeshModel::MeshList modelMeshes = MeshModel::loadNode(
-			scene->mRootNode, scene, mSceneBoundingBox, materialsOffset);
+			scene->mRootNode, scene, mSceneBoundingBox, materialsOffset, sceneGraph, meshNodes);
+
+		MeshModel::Ptr& meshModel = addMeshModel(modelMeshes);
+		meshModel->setSceneGraph(sceneGraph, meshNodes);
 
-		return addMeshModel(modelMeshes);
+		return meshModel;
 	}
 
 	void VulkanRenderer::requestRedraw()
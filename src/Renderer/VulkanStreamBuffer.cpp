@@ -0,0 +1,55 @@
+#include "Renderer/VulkanStreamBuffer.hpp"
+#include "Utilities.hpp"
+
+#include <cstring>
+
+namespace fre
+{
+	void VulkanStreamBuffer::create(const MainDevice& mainDevice, VkDeviceSize regionSize, uint32_t regionsCount,
+		VkBufferUsageFlags usage)
+	{
+		mRegionSize = alignedSize(static_cast<uint32_t>(regionSize), STREAM_BUFFER_ALIGNMENT);
+		//Nothing is uploaded yet
+		mVersions.assign(regionsCount, MAX(uint32_t));
+
+		fre::createBuffer(mainDevice, mRegionSize * regionsCount, usage,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			0,
+			&mBuffer, nullptr, &mMemory);
+		VK_CHECK(vkMapMemory(mainDevice.logicalDevice, mMemory, 0, VK_WHOLE_SIZE, 0, &mMappedData));
+
+		LOG_TRACE("Stream buffer created: region size {}, regions count {}", mRegionSize, regionsCount);
+	}
+
+	void VulkanStreamBuffer::destroy(VkDevice logicalDevice)
+	{
+		if(mBuffer != VK_NULL_HANDLE)
+		{
+			vkUnmapMemory(logicalDevice, mMemory);
+			vkDestroyBuffer(logicalDevice, mBuffer, nullptr);
+			vkFreeMemory(logicalDevice, mMemory, nullptr);
+		}
+		mBuffer = VK_NULL_HANDLE;
+		mMemory = VK_NULL_HANDLE;
+		mMappedData = nullptr;
+		mRegionSize = 0;
+		mVersions.clear();
+	}
+
+	void VulkanStreamBuffer::update(uint32_t region, const void* data, VkDeviceSize size, uint32_t version)
+	{
+		if(mVersions[region] != version)
+		{
+			memcpy(static_cast<uint8_t*>(mMappedData) + getOffset(region), data, size);
+			mVersions[region] = version;
+		}
+	}
+
+	void* VulkanStreamBuffer::getRegionData(uint32_t region)
+	{
+		//Content no longer matches any version
+		mVersions[region] = MAX(uint32_t);
+
+		return static_cast<uint8_t*>(mMappedData) + getOffset(region);
+	}
+}
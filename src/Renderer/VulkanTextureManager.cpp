@@ -1,14 +1,20 @@
+#include "Renderer/Mipmaps.hpp"
 #include "Renderer/VulkanBufferManager.hpp"
 #include "Renderer/VulkanImage.hpp"
 #include "Renderer/VulkanTexture.hpp"
 #include "Renderer/VulkanTextureManager.hpp"
 #include "Log.hpp"
 #include "Mutexes.hpp"
+#include "TextureContainer.hpp"
 #include "ThreadPool.hpp"
 #include "Utilities.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 
 using namespace glm;
 
@@ -16,6 +22,9 @@ namespace fre
 {
     std::mutex gImagesMutex;
 
+	//Level data uploaded for one residency update, bytes. Uploads wait for queue, so frame stalls stay short
+	const uint64_t STREAMING_LOAD_LIMIT = 32ull << 20;
+
 	void VulkanTextureManager::create(VkDevice logicalDevice)
 	{
 		LOG_INFO("Create texture manager");
@@ -25,6 +34,13 @@ namespace fre
 
 	void VulkanTextureManager::destroy(VkDevice logicalDevice)
 	{
+		//Residency update may still read texture infos
+		while(mResidencyUpdating)
+		{
+			std::this_thread::yield();
+		}
+		mStreamedLevels.clear();
+		destroyBindless(logicalDevice);
 		for (size_t i = 0; i < mTextures.size(); i++)
 		{
 			destroyTexture(logicalDevice, i);
@@ -80,7 +96,8 @@ namespace fre
 				ti.second->mLayout == layout &&
 				ti.second->mImage.mFileName == image.mFileName &&
 				ti.second->mImage.mFormat == image.mFormat &&
-				ti.second->mImage.mIsExternal == image.mIsExternal)
+				ti.second->mImage.mIsExternal == image.mIsExternal &&
+				ti.second->mImage.mSRGB == image.mSRGB)
 			{
 				result = ti.second->mId;
 				break;
@@ -122,53 +139,172 @@ namespace fre
 		int8_t transferQueueFamilyId,
 		int8_t graphicsQueueFamilyId,
 		const VkQueue queue,
-		const VkCommandPool commandPool,
+		VulkanOneTimeCommandPool& commandPool,
 		const VulkanTextureInfoPtr& info)
 	{
 		uint32_t id = mTextures.size();
+		//Image of info is written by thread pool until it is loaded, header read before loading is copied
+		VulkanTextureInfoPtr headerInfo;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(mLoadingImages.find(info->mId) != mLoadingImages.end())
+			{
+				headerInfo = std::make_shared<VulkanTextureInfo>(*info);
+			}
+		}
+		if(headerInfo != nullptr)
+		{
+			VulkanTexturePtr result = std::make_shared<VulkanTexture>();
+			result->mId = id;
+			const Image& image = headerInfo->mImage;
+			if(image.mFormat != VK_FORMAT_UNDEFINED && image.mDimension.x > 0 && image.mDimension.y > 0)
+			{
+				createTextureImage(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId, queue, commandPool, result,
+					headerInfo, true);
+			}
+			//Bindless slot is written once data is uploaded
+			mTextures[id] = result;
+			mReservedTextures[id] = { info->mId, image.mFormat, image.mDimension };
+
+			return id;
+		}
+
+		VulkanTexturePtr result = makeTexture(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId, queue, commandPool,
+			id, info);
+		mTextures[id] = result;
+		if(isBindless() && result->mImageView != VK_NULL_HANDLE)
+		{
+			writeBindlessTexture(mainDevice.logicalDevice, *info, *result);
+		}
+
+		return id;
+	}
+
+	VulkanTexturePtr VulkanTextureManager::makeTexture(
+		const MainDevice& mainDevice,
+		int8_t transferQueueFamilyId,
+		int8_t graphicsQueueFamilyId,
+		const VkQueue queue,
+		VulkanOneTimeCommandPool& commandPool,
+		uint32_t id,
+		const VulkanTextureInfoPtr& info)
+	{
 		VulkanTexturePtr result = std::make_shared<VulkanTexture>();
 		result->mId = id;
 
-		if(info->mImage.mDimension.x > 0 && info->mImage.mDimension.y > 0)
+		//Streamed texture starts with its tail levels, kept levels are copied from it later
+		VulkanTextureInfoPtr imageInfo = info;
+		std::vector<uint8_t> levelsData;
+		const bool streamed = isStreamed(*info);
+		if(streamed)
 		{
-			//Create image to hold final texture
-			if(info->mImage.mIsExternal)
+			const auto& levels = info->mImage.mLevels;
+			while(result->mFirstLevel + 1 < levels.size() &&
+				std::max(levels[result->mFirstLevel].mWidth, levels[result->mFirstLevel].mHeight) > STREAMING_TAIL_SIZE)
 			{
-				result->mImage = fre::createExternalImage(
-					mainDevice, info->mImage.mDimension.x, info->mImage.mDimension.y,
-					info->mImage.mFormat, info->mTiling,
-					VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, getDefaultMemHandleType(), &result->mImageMemory, result->mActualSize);
+				result->mFirstLevel++;
 			}
-			else
+			imageInfo = std::make_shared<VulkanTextureInfo>(*info);
+			imageInfo->mImage = getLevelsImage(info->mImage, result->mFirstLevel, levelsData);
+			imageInfo->mUsageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
+
+		if(imageInfo->mImage.mDimension.x > 0 && imageInfo->mImage.mDimension.y > 0)
+		{
+			createTextureImage(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId, queue, commandPool, result, imageInfo);
+		}
+
+		if(streamed)
+		{
+			StreamedTexture streamedTexture;
+			streamedTexture.mTextureId = id;
+			streamedTexture.mWidth = info->mImage.mLevels[0].mWidth;
+			streamedTexture.mHeight = info->mImage.mLevels[0].mHeight;
+			streamedTexture.mLevelsCount = static_cast<uint32_t>(info->mImage.mLevels.size());
+			std::vector<uint64_t> levelSizes;
+			for(const auto& level : info->mImage.mLevels)
+			{
+				levelSizes.push_back(level.mSize);
+			}
+			mStreamedTextures[info->mId] = streamedTexture;
 			{
-				result->mImage = fre::createImage(mainDevice, info->mImage.mDimension.x, info->mImage.mDimension.y,
-					info->mImage.mFormat, info->mTiling,
-					info->mUsageFlags,
-					info->mMemoryFlags,
-					&result->mImageMemory,
-					result->mActualSize);
+				std::lock_guard<std::mutex> lock(mStreamingMutex);
+				mResidency.addTexture(info->mId, levelSizes, result->mFirstLevel);
 			}
-			result->mImageView = createImageView(mainDevice.logicalDevice,
-				result->mImage, info->mImage.mFormat,
-				VK_IMAGE_ASPECT_COLOR_BIT);
+			//Finer levels are loaded again when requested
+			info->mImage.destroy();
+		}
 
-			//Is texture data passed?
-			if(info->mImage.mData != nullptr)
+		return result;
+	}
+
+	void VulkanTextureManager::createTextureImage(
+		const MainDevice& mainDevice,
+		int8_t transferQueueFamilyId,
+		int8_t graphicsQueueFamilyId,
+		const VkQueue queue,
+		VulkanOneTimeCommandPool& commandPool,
+		VulkanTexturePtr& texture,
+		const VulkanTextureInfoPtr& info,
+		bool reserve)
+	{
+		//Create image to hold final texture
+		if(info->mImage.mIsExternal)
+		{
+			texture->mImage = fre::createExternalImage(
+				mainDevice, info->mImage.mDimension.x, info->mImage.mDimension.y,
+				info->mImage.mFormat, info->mTiling,
+				VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, getDefaultMemHandleType(), &texture->mImageMemory, texture->mActualSize);
+		}
+		else
+		{
+			//Levels are written by transfer, blit reads previous level
+			VkImageUsageFlags usageFlags = info->mUsageFlags;
+			if(!info->mImage.mLevels.empty())
 			{
-				uploadData(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId,
-					queue, commandPool, result, info);
+				if(isBlockCompressedFormat(info->mImage.mFormat))
+				{
+					VkFormatProperties formatProperties;
+					vkGetPhysicalDeviceFormatProperties(mainDevice.physicalDevice, info->mImage.mFormat, &formatProperties);
+					if((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0)
+					{
+						throw std::runtime_error(formatString("Device can't sample format %u of texture %s",
+							info->mImage.mFormat, info->mImage.mFileName.c_str()));
+					}
+				}
+				texture->mMipLevels = static_cast<uint32_t>(info->mImage.mLevels.size());
+				usageFlags |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 			}
-			else
+			else if((reserve ? getLoadedMipmapsSource(mainDevice.physicalDevice, *info) :
+				getMipmapsSource(mainDevice.physicalDevice, *info)) != EMipmapsSource::None)
 			{
-				transitionImageLayout(mainDevice.logicalDevice, queue, commandPool, result->mImage, VK_IMAGE_ASPECT_COLOR_BIT,
-					VK_IMAGE_LAYOUT_UNDEFINED, info->mLayout);
+				texture->mMipLevels = getMipLevelsCount(info->mImage.mDimension.x, info->mImage.mDimension.y);
+				usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 			}
+			texture->mImage = fre::createImage(mainDevice, info->mImage.mDimension.x, info->mImage.mDimension.y,
+				info->mImage.mFormat, info->mTiling,
+				usageFlags,
+				info->mMemoryFlags,
+				&texture->mImageMemory,
+				texture->mActualSize,
+				texture->mMipLevels);
 		}
+		texture->mImageView = createImageView(mainDevice.logicalDevice,
+			texture->mImage, info->mImage.mFormat,
+			VK_IMAGE_ASPECT_COLOR_BIT, texture->mMipLevels);
 
-		mTextures[id] = result;
-
-		return id;
+		//Is texture data passed?
+		if(info->mImage.mData != nullptr)
+		{
+			uploadData(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId,
+				queue, commandPool, texture, info);
+		}
+		else
+		{
+			transitionImageLayout(mainDevice.logicalDevice, queue, commandPool, texture->mImage, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED, info->mLayout, texture->mMipLevels);
+		}
 	}
 
 	VulkanTexturePtr VulkanTextureManager::getTexture(const uint32_t id)
@@ -187,13 +323,30 @@ namespace fre
 	void VulkanTextureManager::loadImages(const LoadImageCallback& callback, ThreadPool& threadPool)
 	{
 		uint32_t cnt = mTextureInfos.size();
+		//Headers tell size and format of textures before images are decoded
+		const auto probeStart = std::chrono::steady_clock::now();
+		uint32_t probedCount = 0;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			for(uint32_t i = 1; i < cnt; i++)
+			{
+				Image& image = mTextureInfos[i]->mImage;
+				if(image.mData == nullptr && image.isFileNameValid())
+				{
+					probedCount += image.probeFile() ? 1 : 0;
+					mLoadingImages.insert(i);
+				}
+			}
+		}
+		const std::chrono::duration<double, std::milli> probeTime = std::chrono::steady_clock::now() - probeStart;
+		LOG_INFO("Image headers probed: {} of {} in {:.2f} ms", probedCount, cnt, probeTime.count());
+
 		for(uint32_t i = 0; i < cnt; i++)
 		{
 			//load default texture in main thread
 			if(i == 0)
 			{
-				auto& image = mTextureInfos[i]->mImage;
-				image.load();
+				loadImage(*mTextureInfos[i]);
 			}
 			else
 			{
@@ -201,11 +354,20 @@ namespace fre
 				(
 					[this, i, cnt, callback]
 					{
-						std::lock_guard<std::mutex> lock(mMutex);
-
-						auto& image = mTextureInfos[i]->mImage;
-						image.load();
+						VulkanTextureInfoPtr info;
+						VulkanTextureInfo loadedInfo;
+						{
+							std::lock_guard<std::mutex> lock(mMutex);
+							info = mTextureInfos[i];
+							loadedInfo = *info;
+						}
+						//Images are decoded and compressed in parallel, textures created meanwhile read info
+						loadImage(loadedInfo);
 
+						std::lock_guard<std::mutex> lock(mMutex);
+						info->mImage = loadedInfo.mImage;
+						mLoadingImages.erase(i);
+						mLoadedImages.push_back(i);
 						if(callback != nullptr)
 						{
 							callback(i, cnt);
@@ -222,43 +384,65 @@ namespace fre
 		int8_t transferQueueFamilyId,
 		int8_t graphicsQueueFamilyId,
 		const VkQueue queue,
-		const VkCommandPool commandPool,
+		VulkanOneTimeCommandPool& commandPool,
 		VulkanTexturePtr& texture,
 		const VulkanTextureInfoPtr& info)
 	{
+		const EMipmapsSource mipmapsSource = texture->mMipLevels > 1 && info->mImage.mData != nullptr ?
+			getMipmapsSource(mainDevice.physicalDevice, *info) : EMipmapsSource::None;
+		//All levels are uploaded at once when they are prebuilt or filtered on CPU
+		std::vector<MipLevel> levels = info->mImage.mLevels;
+		std::vector<uint8_t> levelsData;
+		if(mipmapsSource == EMipmapsSource::CPU)
+		{
+			levels = generateMipmaps(static_cast<const uint8_t*>(info->mImage.mData),
+				info->mImage.mDimension.x, info->mImage.mDimension.y,
+				info->mImage.mStride, info->mImage.mSRGB, levelsData);
+		}
+		const VkDeviceSize dataSize = levelsData.empty() ? info->mImage.mDataSize : levelsData.size();
+		const void* imageData = levelsData.empty() ? info->mImage.mData : levelsData.data();
+
 		//Create staging buffer to hold loaded data, ready to copy to device
 		VulkanBuffer imageStagingBuffer;
 		VkDeviceMemory imageStagingBufferMemory;
-		createBuffer(mainDevice, info->mImage.mDataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		createBuffer(mainDevice, dataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 			0,
 			&imageStagingBuffer.mBuffer, nullptr, &imageStagingBuffer.mBufferMemory);
 
 		//Copy image data to staging buffer
 		void* data;
-		VK_CHECK(vkMapMemory(mainDevice.logicalDevice, imageStagingBuffer.mBufferMemory, 0, info->mImage.mDataSize, 0, &data));
+		VK_CHECK(vkMapMemory(mainDevice.logicalDevice, imageStagingBuffer.mBufferMemory, 0, dataSize, 0, &data));
 		//Fill texture with zeoes if filename is not provided
-		if(info->mImage.mData != nullptr)
+		if(imageData != nullptr)
 		{
-			memcpy(data, info->mImage.mData, static_cast<size_t>(info->mImage.mDataSize));
+			memcpy(data, imageData, static_cast<size_t>(dataSize));
 		}
 		else
 		{
-			memset(data, 0, static_cast<size_t>(info->mImage.mDataSize));
+			memset(data, 0, static_cast<size_t>(dataSize));
 		}
 		vkUnmapMemory(mainDevice.logicalDevice, imageStagingBuffer.mBufferMemory);
 
 		//Copy data to image
 		//Transition image to be DST for copy operation
 		transitionImageLayout(mainDevice.logicalDevice, queue, commandPool, texture->mImage, VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, texture->mMipLevels);
 
 		copyImageBuffer(mainDevice.logicalDevice, transferQueueFamilyId, graphicsQueueFamilyId, queue, commandPool,
-			imageStagingBuffer.mBuffer, texture->mImage, info->mImage.mDimension.x, info->mImage.mDimension.y);
+			imageStagingBuffer.mBuffer, texture->mImage, info->mImage.mDimension.x, info->mImage.mDimension.y, levels);
 
-		//Transition image to be shader readable for shader usage
-		transitionImageLayout(mainDevice.logicalDevice, queue, commandPool, texture->mImage, VK_IMAGE_ASPECT_COLOR_BIT,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, /*VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL*/info->mLayout);
+		if(mipmapsSource == EMipmapsSource::Blit)
+		{
+			blitMipmaps(mainDevice.logicalDevice, queue, commandPool, texture->mImage,
+				info->mImage.mDimension.x, info->mImage.mDimension.y, texture->mMipLevels, info->mLayout);
+		}
+		else
+		{
+			//Transition image to be shader readable for shader usage
+			transitionImageLayout(mainDevice.logicalDevice, queue, commandPool, texture->mImage, VK_IMAGE_ASPECT_COLOR_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, /*VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL*/info->mLayout, texture->mMipLevels);
+		}
 
 		//Destroy staging buffers
 		vkDestroyBuffer(mainDevice.logicalDevice, imageStagingBuffer.mBuffer, nullptr);
@@ -267,26 +451,611 @@ namespace fre
 		info->mImage.destroy();
 	}
 
+	void VulkanTextureManager::uploadLoadedImages(
+		const MainDevice& mainDevice,
+		int8_t transferFamilyId,
+		int8_t graphicsFamilyId,
+		VkQueue queue,
+		VulkanOneTimeCommandPool& commandPool,
+		VulkanDeletionQueue& deletionQueue)
+	{
+		std::vector<uint32_t> loadedImages;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			loadedImages.swap(mLoadedImages);
+		}
+		if(mReservedTextures.empty())
+		{
+			return;
+		}
+
+		const std::set<uint32_t> loaded(loadedImages.begin(), loadedImages.end());
+		for(auto reserved = mReservedTextures.begin(); reserved != mReservedTextures.end();)
+		{
+			if(loaded.find(reserved->second.mTextureInfoId) == loaded.end())
+			{
+				++reserved;
+				continue;
+			}
+
+			const uint32_t textureId = reserved->first;
+			const VulkanTextureInfoPtr info = mTextureInfos[reserved->second.mTextureInfoId];
+			VulkanTexturePtr& texture = mTextures[textureId];
+			const Image& image = info->mImage;
+			uint32_t levelsCount = 1;
+			if(!image.mLevels.empty())
+			{
+				levelsCount = static_cast<uint32_t>(image.mLevels.size());
+			}
+			else if(getMipmapsSource(mainDevice.physicalDevice, *info) != EMipmapsSource::None)
+			{
+				levelsCount = getMipLevelsCount(image.mDimension.x, image.mDimension.y);
+			}
+
+			if(texture->mImage != VK_NULL_HANDLE && image.mFormat == reserved->second.mFormat &&
+				image.mDimension == reserved->second.mDimension && levelsCount == texture->mMipLevels && !isStreamed(*info))
+			{
+				//Nothing samples image before its slot is written
+				uploadData(mainDevice, transferFamilyId, graphicsFamilyId, queue, commandPool, texture, info);
+			}
+			else
+			{
+				//Format and levels of compressed or streamed image are known once it is processed, size of file without
+				//probed header is known once it is loaded
+				if(texture->mImage != VK_NULL_HANDLE)
+				{
+					releaseTexture(mainDevice.logicalDevice, textureId, deletionQueue);
+				}
+				texture = makeTexture(mainDevice, transferFamilyId, graphicsFamilyId, queue, commandPool, textureId, info);
+			}
+			if(isBindless() && texture->mImageView != VK_NULL_HANDLE)
+			{
+				writeBindlessTexture(mainDevice.logicalDevice, *info, *texture);
+			}
+			reserved = mReservedTextures.erase(reserved);
+		}
+	}
+
 	void VulkanTextureManager::updateTextureImage(
 		const MainDevice& mainDevice,
 		int8_t transferQueueFamilyId,
 		int8_t graphicsQueueFamilyId,
 		VkQueue queue,
-		VkCommandPool commandPool,
+		VulkanOneTimeCommandPool& commandPool,
+		VulkanDeletionQueue& deletionQueue,
 		const VulkanTextureInfoPtr& info)
 	{
-		if(mTextureInfos[info->mId]->mImage.mDimension != info->mImage.mDimension)
+		//Frames in flight may still sample old image, so data of any size goes to fresh image under the same id
+		//and old one is destroyed once these frames complete
+		VulkanTexturePtr& texture = mTextures[info->mId];
+		if(texture != nullptr && texture->mImage != VK_NULL_HANDLE)
+		{
+			releaseTexture(mainDevice.logicalDevice, info->mId, deletionQueue);
+		}
+		texture = makeTexture(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId, queue, commandPool, info->mId, info);
+		if(isBindless() && texture->mImageView != VK_NULL_HANDLE)
+		{
+			writeBindlessTexture(mainDevice.logicalDevice, *info, *texture);
+		}
+	}
+
+	VulkanTextureManager::EMipmapsSource VulkanTextureManager::getMipmapsSource(VkPhysicalDevice physicalDevice,
+		const VulkanTextureInfo& info)
+	{
+		if(info.mImage.mData == nullptr)
+		{
+			return EMipmapsSource::None;
+		}
+
+		return getLoadedMipmapsSource(physicalDevice, info);
+	}
+
+	VulkanTextureManager::EMipmapsSource VulkanTextureManager::getLoadedMipmapsSource(VkPhysicalDevice physicalDevice,
+		const VulkanTextureInfo& info)
+	{
+		const auto& image = info.mImage;
+		if(image.mIsExternal || !image.mLevels.empty() || info.mTiling != VK_IMAGE_TILING_OPTIMAL ||
+			(info.mUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) == 0 || (image.mDimension.x <= 1 && image.mDimension.y <= 1))
+		{
+			return EMipmapsSource::None;
+		}
+
+		const bool cpuFormat =
+			image.mFormat == VK_FORMAT_R8_UNORM ||
+			image.mFormat == VK_FORMAT_R8G8_UNORM ||
+			image.mFormat == VK_FORMAT_R8G8B8_UNORM ||
+			image.mFormat == VK_FORMAT_R8G8B8A8_UNORM;
+		//Blit would average sRGB values as they are stored
+		if(cpuFormat && image.mSRGB)
+		{
+			return EMipmapsSource::CPU;
+		}
+		if(isLinearBlitSupported(physicalDevice, image.mFormat))
+		{
+			return EMipmapsSource::Blit;
+		}
+
+		return cpuFormat ? EMipmapsSource::CPU : EMipmapsSource::None;
+	}
+
+	void VulkanTextureManager::loadImage(VulkanTextureInfo& info)
+	{
+		TextureProcessing processing;
+		processing.mCompression = mTextureCompression && mBlockCompressionSupported;
+		//Without cache chains are filtered at upload, blit is cheaper than CPU filter there. Streaming needs levels on CPU
+		processing.mMipmaps = (mTextureCache.isCreated() || mStreaming) && !info.mImage.mIsExternal &&
+			info.mTiling == VK_IMAGE_TILING_OPTIMAL && (info.mUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) != 0;
+		mTextureCache.loadImage(info.mImage, processing);
+	}
+
+	void VulkanTextureManager::setTextureStreaming(bool enabled, uint64_t budget)
+	{
+		mStreaming = enabled;
+		std::lock_guard<std::mutex> lock(mStreamingMutex);
+		mResidency.setBudget(budget);
+		mResidency.setLoadLimit(STREAMING_LOAD_LIMIT);
+	}
+
+	void VulkanTextureManager::requestTextureLevel(uint32_t textureInfoId, uint32_t level)
+	{
+		if(mStreamedTextures.find(textureInfoId) != mStreamedTextures.end())
+		{
+			mFrameRequests.push_back({ textureInfoId, level, mStreamingFrame });
+		}
+	}
+
+	void VulkanTextureManager::requestMaterialLevels(uint32_t materialId, float screenSize)
+	{
+		if(materialId >= mMaterialTextures.size())
+		{
+			return;
+		}
+
+		for(const uint32_t textureInfoId : mMaterialTextures[materialId])
+		{
+			const auto found = mStreamedTextures.find(textureInfoId);
+			if(found == mStreamedTextures.end())
+			{
+				continue;
+			}
+			//Level whose texels match pixels of screen size
+			const float size = static_cast<float>(std::max(found->second.mWidth, found->second.mHeight));
+			const uint32_t level = screenSize >= size ? 0 : static_cast<uint32_t>(std::log2(size / std::max(screenSize, 1.0f)));
+			mFrameRequests.push_back({ textureInfoId, level, mStreamingFrame });
+		}
+	}
+
+	void VulkanTextureManager::updateStreaming(
+		const MainDevice& mainDevice,
+		int8_t transferFamilyId,
+		int8_t graphicsFamilyId,
+		VkQueue queue,
+		VulkanOneTimeCommandPool& commandPool,
+		VulkanDeletionQueue& deletionQueue,
+		ThreadPool& threadPool)
+	{
+		if(!mStreaming)
+		{
+			return;
+		}
+
+		//Levels of finished update are taken before next one can add more
+		const bool updating = mResidencyUpdating;
+		std::vector<StreamedLevels> streamedLevels;
 		{
-			destroyTexture(mainDevice.logicalDevice, info->mId);
-			createTexture(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId, queue, commandPool, info);
+			std::lock_guard<std::mutex> lock(mStreamingMutex);
+			streamedLevels.swap(mStreamedLevels);
+			mStreamingRequests.insert(mStreamingRequests.end(), mFrameRequests.begin(), mFrameRequests.end());
+		}
+		mFrameRequests.clear();
+		for(auto& levels : streamedLevels)
+		{
+			applyStreamedLevels(mainDevice, transferFamilyId, graphicsFamilyId, queue, commandPool, deletionQueue, levels);
+		}
+
+		if(!updating)
+		{
+			mResidencyUpdating = true;
+			threadPool.enqueue([this, frame = mStreamingFrame]() { updateResidency(frame); });
+		}
+		mStreamingFrame++;
+	}
+
+	TextureStreamingStatistics VulkanTextureManager::getStreamingStatistics()
+	{
+		TextureStreamingStatistics result;
+		std::lock_guard<std::mutex> lock(mStreamingMutex);
+		result.mResidentSize = mResidency.getResidentSize();
+		result.mBudget = mResidency.getBudget();
+		result.mTexturesCount = mResidency.getTexturesCount();
+		result.mLoads = mStreamingLoads;
+		result.mEvictions = mStreamingEvictions;
+
+		return result;
+	}
+
+	bool VulkanTextureManager::isStreamed(const VulkanTextureInfo& info) const
+	{
+		//Descriptors written by app would keep sampling released images, bindless slots follow recreated ones
+		return mStreaming && isBindless() && !info.mImage.mIsExternal && info.mImage.mData != nullptr && info.mImage.mLevels.size() > 1 &&
+			info.mTiling == VK_IMAGE_TILING_OPTIMAL && (info.mUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) != 0;
+	}
+
+	Image VulkanTextureManager::getLevelsImage(const Image& image, uint32_t firstLevel, std::vector<uint8_t>& data)
+	{
+		Image result = image;
+		result.mMappedFile.reset();
+		result.mIsOwner = false;
+		result.mLevels.clear();
+		data.clear();
+		for(uint32_t i = firstLevel; i < image.mLevels.size(); i++)
+		{
+			MipLevel level = image.mLevels[i];
+			const auto* levelData = static_cast<const uint8_t*>(image.mData) + level.mOffset;
+			level.mOffset = data.size();
+			data.insert(data.end(), levelData, levelData + level.mSize);
+			result.mLevels.push_back(level);
+		}
+		result.mDimension = ivec2(result.mLevels[0].mWidth, result.mLevels[0].mHeight);
+		result.mData = data.data();
+		result.mDataSize = static_cast<uint32_t>(data.size());
+
+		return result;
+	}
+
+	void VulkanTextureManager::updateResidency(uint64_t frame)
+	{
+		std::vector<TextureResidencyChange> changes;
+		{
+			std::lock_guard<std::mutex> lock(mStreamingMutex);
+			for(const auto& request : mStreamingRequests)
+			{
+				mResidency.request(request.mTextureInfoId, request.mLevel, request.mFrame);
+			}
+			mStreamingRequests.clear();
+			changes = mResidency.update(frame);
+		}
+
+		std::vector<StreamedLevels> streamedLevels;
+		for(const auto& change : changes)
+		{
+			StreamedLevels levels;
+			levels.mChange = change;
+			if(change.mToLevel < change.mFromLevel)
+			{
+				VulkanTextureInfo info;
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					info = *mTextureInfos.at(change.mTexture);
+				}
+				//Image data was released once texture was created
+				info.mImage.mData = nullptr;
+				info.mImage.mDataSize = 0;
+				info.mImage.mLevels.clear();
+				info.mImage.mMappedFile.reset();
+				info.mImage.mIsOwner = false;
+				info.mImage.mIsTIFF = false;
+				info.mImage.mIsPNG = false;
+				try
+				{
+					loadImage(info);
+					if(info.mImage.mLevels.size() <= change.mFromLevel)
+					{
+						info.mImage.destroy();
+						throw std::runtime_error(formatString("Texture %s has %u levels instead of more than %u",
+							info.mImage.mFileName.c_str(), static_cast<uint32_t>(info.mImage.mLevels.size()), change.mFromLevel));
+					}
+					levels.mImage = getLevelsImage(info.mImage, change.mToLevel, levels.mData);
+					info.mImage.destroy();
+				}
+				catch(const std::runtime_error& e)
+				{
+					LOG_WARNING("Levels of texture {} aren't streamed: {}", change.mTexture, e.what());
+					std::lock_guard<std::mutex> lock(mStreamingMutex);
+					mResidency.revert(change);
+					continue;
+				}
+			}
+			streamedLevels.push_back(std::move(levels));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mStreamingMutex);
+			for(auto& levels : streamedLevels)
+			{
+				mStreamedLevels.push_back(std::move(levels));
+			}
+		}
+		mResidencyUpdating = false;
+	}
+
+	void VulkanTextureManager::applyStreamedLevels(
+		const MainDevice& mainDevice,
+		int8_t transferFamilyId,
+		int8_t graphicsFamilyId,
+		VkQueue queue,
+		VulkanOneTimeCommandPool& commandPool,
+		VulkanDeletionQueue& deletionQueue,
+		StreamedLevels& levels)
+	{
+		const auto& change = levels.mChange;
+		const auto found = mStreamedTextures.find(change.mTexture);
+		if(found == mStreamedTextures.end())
+		{
+			return;
+		}
+		const auto& streamedTexture = found->second;
+		const uint32_t textureId = streamedTexture.mTextureId;
+		const VulkanTexturePtr oldTexture = mTextures[textureId];
+		const VulkanTextureInfoPtr info = mTextureInfos[change.mTexture];
+		const bool load = change.mToLevel < change.mFromLevel;
+		//Eviction copies levels old image has
+		if(!load && change.mToLevel < oldTexture->mFirstLevel)
+		{
+			return;
+		}
+
+		VulkanTexturePtr texture = std::make_shared<VulkanTexture>();
+		texture->mId = textureId;
+		texture->mFirstLevel = change.mToLevel;
+		VulkanTextureInfoPtr imageInfo = std::make_shared<VulkanTextureInfo>(*info);
+		imageInfo->mUsageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		if(load)
+		{
+			//Pointer is set here, levels were moved since they were packed
+			imageInfo->mImage = levels.mImage;
+			imageInfo->mImage.mData = levels.mData.data();
+			createTextureImage(mainDevice, transferFamilyId, graphicsFamilyId, queue, commandPool, texture, imageInfo);
+		}
+		else
+		{
+			const uint32_t width = std::max(streamedTexture.mWidth >> change.mToLevel, 1u);
+			const uint32_t height = std::max(streamedTexture.mHeight >> change.mToLevel, 1u);
+			texture->mMipLevels = streamedTexture.mLevelsCount - change.mToLevel;
+			texture->mImage = createImage(mainDevice, width, height, info->mImage.mFormat, info->mTiling,
+				imageInfo->mUsageFlags | VK_IMAGE_USAGE_TRANSFER_DST_BIT, info->mMemoryFlags,
+				&texture->mImageMemory, texture->mActualSize, texture->mMipLevels);
+			texture->mImageView = createImageView(mainDevice.logicalDevice, texture->mImage, info->mImage.mFormat,
+				VK_IMAGE_ASPECT_COLOR_BIT, texture->mMipLevels);
+			copyImageLevels(mainDevice.logicalDevice, queue, commandPool, oldTexture->mImage,
+				change.mToLevel - oldTexture->mFirstLevel, texture->mImage, width, height, texture->mMipLevels, info->mLayout);
+		}
+
+		//Frames in flight may still sample old image
+		releaseTexture(mainDevice.logicalDevice, textureId, deletionQueue);
+		mTextures[textureId] = texture;
+		if(isBindless())
+		{
+			writeBindlessTexture(mainDevice.logicalDevice, *info, *texture);
+		}
+		if(load)
+		{
+			mStreamingLoads++;
 		}
 		else
 		{
-            uploadData(mainDevice, transferQueueFamilyId, graphicsQueueFamilyId,
-                queue, commandPool, mTextures[info->mId], info);
+			mStreamingEvictions++;
 		}
 	}
 
+	VulkanDescriptorSetLayoutInfo VulkanTextureManager::getBindlessLayoutInfo(uint32_t texturesCount, VkDescriptorBindingFlags texturesFlags)
+	{
+		VulkanDescriptorSetLayoutInfo result;
+		result.mDescriptorTypes = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+		result.mBindings = { 0, 1 };
+		result.mDescriptorCount = { texturesCount, 1 };
+		result.mStageFlags = { VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
+		result.mBindingFlags = { texturesFlags, 0 };
+
+		return result;
+	}
+
+	void VulkanTextureManager::createBindless(const MainDevice& mainDevice, VkDescriptorSetLayout layout,
+		uint32_t texturesCount, uint32_t materialsCount, uint32_t framesCount, const SamplerCallback& samplerCallback)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes =
+		{
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, texturesCount },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 }
+		};
+		VkDescriptorPoolCreateInfo poolCreateInfo = {};
+		poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolCreateInfo.maxSets = 1;
+		poolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolCreateInfo.pPoolSizes = poolSizes.data();
+		VK_CHECK(vkCreateDescriptorPool(mainDevice.logicalDevice, &poolCreateInfo, nullptr, &mBindlessPool));
+
+		VkDescriptorSetAllocateInfo setAllocInfo = {};
+		setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		setAllocInfo.descriptorPool = mBindlessPool;
+		setAllocInfo.descriptorSetCount = 1;
+		setAllocInfo.pSetLayouts = &layout;
+		VK_CHECK(vkAllocateDescriptorSets(mainDevice.logicalDevice, &setAllocInfo, &mBindlessSet));
+
+		//Descriptor covers regions of all frames, frame being recorded passes base of its region to shaders
+		mMaterialTableCount = materialsCount;
+		mMaterialTable.create(mainDevice, materialsCount * sizeof(MaterialTextures), framesCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		MaterialTextures noTextures;
+		noTextures.fill(INVALID_BINDLESS_SLOT);
+		mMaterialEntries.assign(materialsCount, noTextures);
+		VkDescriptorBufferInfo tableInfo = { mMaterialTable.mBuffer, 0, VK_WHOLE_SIZE };
+		VkWriteDescriptorSet tableWrite = {};
+		tableWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		tableWrite.dstSet = mBindlessSet;
+		tableWrite.dstBinding = 1;
+		tableWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		tableWrite.descriptorCount = 1;
+		tableWrite.pBufferInfo = &tableInfo;
+		vkUpdateDescriptorSets(mainDevice.logicalDevice, 1, &tableWrite, 0, nullptr);
+
+		mBindlessTexturesCount = texturesCount;
+		mBindlessSamplerCallback = samplerCallback;
+		mBindlessSlots.clear();
+		mFreeBindlessSlots.clear();
+		mUsedBindlessSlotsCount = 0;
+		for(const auto& [id, texture] : mTextures)
+		{
+			const auto info = getTextureInfo(id);
+			if(info != nullptr && texture->mImageView != VK_NULL_HANDLE && mReservedTextures.find(id) == mReservedTextures.end())
+			{
+				writeBindlessTexture(mainDevice.logicalDevice, *info, *texture);
+			}
+		}
+		for(uint32_t materialId = 0; materialId < mMaterialTableCount; materialId++)
+		{
+			writeMaterialEntry(materialId);
+		}
+
+		LOG_INFO("Bindless textures created: {} texture slots, {} materials", texturesCount, materialsCount);
+	}
+
+	void VulkanTextureManager::destroyBindless(VkDevice logicalDevice)
+	{
+		mMaterialTable.destroy(logicalDevice);
+		if(mBindlessPool != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorPool(logicalDevice, mBindlessPool, nullptr);
+		}
+		mBindlessPool = VK_NULL_HANDLE;
+		mBindlessSet = VK_NULL_HANDLE;
+		mBindlessSlots.clear();
+		mFreeBindlessSlots.clear();
+		mUsedBindlessSlotsCount = 0;
+		mMaterialEntries.clear();
+	}
+
+	void VulkanTextureManager::setMaterialTextures(uint32_t materialId, const MaterialTextures& textureInfoIds)
+	{
+		if(materialId >= mMaterialTextures.size())
+		{
+			MaterialTextures noTextures;
+			noTextures.fill(INVALID_BINDLESS_SLOT);
+			mMaterialTextures.resize(materialId + 1, noTextures);
+		}
+		mMaterialTextures[materialId] = textureInfoIds;
+		if(isBindless())
+		{
+			if(materialId >= mMaterialTableCount)
+			{
+				LOG_WARNING("Material {} doesn't fit bindless material table of {} materials", materialId, mMaterialTableCount);
+			}
+			writeMaterialEntry(materialId);
+		}
+	}
+
+	void VulkanTextureManager::updateMaterialTable(uint32_t frame)
+	{
+		if(!isBindless())
+		{
+			return;
+		}
+
+		mMaterialTable.update(frame, mMaterialEntries.data(), mMaterialEntries.size() * sizeof(MaterialTextures),
+			mMaterialEntriesVersion);
+	}
+
+	void VulkanTextureManager::writeBindlessTexture(VkDevice logicalDevice, const VulkanTextureInfo& info, const VulkanTexture& texture)
+	{
+		if((info.mUsageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) == 0)
+		{
+			return;
+		}
+
+		//Frames in flight may sample slot of previous image, so new image never overwrites it
+		uint32_t slot = INVALID_BINDLESS_SLOT;
+		if(!mFreeBindlessSlots.empty())
+		{
+			slot = mFreeBindlessSlots.back();
+			mFreeBindlessSlots.pop_back();
+		}
+		else if(mUsedBindlessSlotsCount < mBindlessTexturesCount)
+		{
+			slot = mUsedBindlessSlotsCount++;
+		}
+		else
+		{
+			LOG_WARNING("Texture {} doesn't fit {} bindless texture slots", info.mId, mBindlessTexturesCount);
+			return;
+		}
+
+		VkDescriptorImageInfo imageInfo = { mBindlessSamplerCallback(info), texture.mImageView, info.mLayout };
+		VkWriteDescriptorSet write = {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = mBindlessSet;
+		write.dstBinding = 0;
+		write.dstArrayElement = slot;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(logicalDevice, 1, &write, 0, nullptr);
+
+		//Materials start to use slot only after it is written
+		mBindlessSlots[info.mId] = slot;
+		writeMaterialEntries(info.mId);
+	}
+
+	void VulkanTextureManager::retireBindlessSlot(uint32_t textureInfoId, VulkanDeletionQueue* deletionQueue)
+	{
+		const auto found = mBindlessSlots.find(textureInfoId);
+		if(found == mBindlessSlots.end())
+		{
+			return;
+		}
+
+		const uint32_t slot = found->second;
+		mBindlessSlots.erase(found);
+		writeMaterialEntries(textureInfoId);
+		if(deletionQueue != nullptr)
+		{
+			deletionQueue->push([this, slot]()
+				{
+					mFreeBindlessSlots.push_back(slot);
+				});
+		}
+		else
+		{
+			mFreeBindlessSlots.push_back(slot);
+		}
+	}
+
+	void VulkanTextureManager::writeMaterialEntries(uint32_t textureInfoId)
+	{
+		for(uint32_t materialId = 0; materialId < mMaterialTextures.size(); materialId++)
+		{
+			const auto& textures = mMaterialTextures[materialId];
+			if(std::find(textures.begin(), textures.end(), textureInfoId) != textures.end())
+			{
+				writeMaterialEntry(materialId);
+			}
+		}
+	}
+
+	void VulkanTextureManager::writeMaterialEntry(uint32_t materialId)
+	{
+		if(materialId >= mMaterialTableCount)
+		{
+			return;
+		}
+
+		MaterialTextures entry;
+		entry.fill(INVALID_BINDLESS_SLOT);
+		if(materialId < mMaterialTextures.size())
+		{
+			for(uint32_t i = 0; i < entry.size(); i++)
+			{
+				const auto found = mBindlessSlots.find(mMaterialTextures[materialId][i]);
+				if(found != mBindlessSlots.end())
+				{
+					entry[i] = found->second;
+				}
+			}
+		}
+		//Regions read by frames in flight keep previous entry
+		mMaterialEntries[materialId] = entry;
+		mMaterialEntriesVersion++;
+	}
+
 	VkDeviceMemory VulkanTextureManager::getTextureMemory(uint32_t index)
 	{
 		VkDeviceMemory result = VK_NULL_HANDLE;
@@ -308,8 +1077,46 @@ namespace fre
 
 	void VulkanTextureManager::destroyTexture(VkDevice logicalDevice, uint32_t id)
 	{
+		mReservedTextures.erase(id);
+		for(auto streamed = mStreamedTextures.begin(); streamed != mStreamedTextures.end(); ++streamed)
+		{
+			if(streamed->second.mTextureId == id)
+			{
+				std::lock_guard<std::mutex> lock(mStreamingMutex);
+				mResidency.removeTexture(streamed->first);
+				mStreamedTextures.erase(streamed);
+				break;
+			}
+		}
+
+		//Materials stop sampling slot of destroyed texture
+		if(isBindless())
+		{
+			retireBindlessSlot(id, nullptr);
+		}
+
 		vkDestroyImageView(logicalDevice, mTextures[id]->mImageView, nullptr);
 		vkDestroyImage(logicalDevice, mTextures[id]->mImage, nullptr);
 		vkFreeMemory(logicalDevice, mTextures[id]->mImageMemory, nullptr);
 	}
+
+	void VulkanTextureManager::releaseTexture(VkDevice logicalDevice, uint32_t id, VulkanDeletionQueue& deletionQueue)
+	{
+		if(isBindless())
+		{
+			retireBindlessSlot(id, &deletionQueue);
+		}
+
+		VulkanTexture& texture = *mTextures[id];
+		deletionQueue.push([logicalDevice, imageView = texture.mImageView, image = texture.mImage, memory = texture.mImageMemory]()
+			{
+				vkDestroyImageView(logicalDevice, imageView, nullptr);
+				vkDestroyImage(logicalDevice, image, nullptr);
+				vkFreeMemory(logicalDevice, memory, nullptr);
+			});
+		//Texture is left in the list, so its handles mustn't be destroyed again
+		texture.mImageView = VK_NULL_HANDLE;
+		texture.mImage = VK_NULL_HANDLE;
+		texture.mImageMemory = VK_NULL_HANDLE;
+	}
 }
\ No newline at end of file
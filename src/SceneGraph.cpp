@@ -0,0 +1,197 @@
+#include "SceneGraph.hpp"
+
+#include "ThreadPool.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace glm;
+
+namespace fre
+{
+	//Subtrees smaller than this are not worth a task
+	static const uint32_t MIN_PARALLEL_CHUNK = 4096;
+
+	uint32_t SceneGraph::addNode(uint32_t parent, const mat4& localTransform)
+	{
+		const uint32_t node = getNodesCount();
+		if(parent != NO_PARENT && (parent >= node || mSubtreeEnds[parent] != node))
+		{
+			throw std::runtime_error(formatString("Scene node %u can't be parent of node %u, nodes must be added depth-first",
+				parent, node));
+		}
+		//Render objects hold transform per node
+		changeSceneVersion();
+
+		//Subtrees of all ancestors end with the new node
+		for(uint32_t ancestor = parent; ancestor != NO_PARENT; ancestor = mParents[ancestor])
+		{
+			mSubtreeEnds[ancestor]++;
+		}
+		mParents.push_back(parent);
+		mSubtreeEnds.push_back(node + 1);
+		mLocalTransforms.push_back(localTransform);
+		const bool parentDirty = parent != NO_PARENT && mDirtyNodes[parent] != 0;
+		mWorldTransforms.push_back(parent != NO_PARENT ? mWorldTransforms[parent] * localTransform : localTransform);
+		mDirtyNodes.push_back(parentDirty ? 1 : 0);
+
+		return node;
+	}
+
+	void SceneGraph::clear()
+	{
+		mParents.clear();
+		mSubtreeEnds.clear();
+		mLocalTransforms.clear();
+		mWorldTransforms.clear();
+		mDirtyNodes.clear();
+		mDirty = false;
+		mRanges.clear();
+		mSplitNodes.clear();
+		mPartitionNodesCount = 0;
+		changeSceneVersion();
+	}
+
+	void SceneGraph::setLocalTransform(uint32_t node, const mat4& transform)
+	{
+		mLocalTransforms[node] = transform;
+		mDirtyNodes[node] = 1;
+		mDirty = true;
+		changeTransformsVersion();
+	}
+
+	uint32_t SceneGraph::updateRange(uint32_t first, uint32_t end)
+	{
+		uint32_t result = 0;
+		uint32_t node = first;
+		while(node < end)
+		{
+			//Clean nodes are skipped by scanning flags only
+			node = static_cast<uint32_t>(std::find(mDirtyNodes.begin() + node, mDirtyNodes.begin() + end, 1) - mDirtyNodes.begin());
+			if(node >= end)
+			{
+				break;
+			}
+
+			//Whole subtree of dirty node is recomputed, parents always come first
+			const uint32_t subtreeEnd = mSubtreeEnds[node];
+			for(uint32_t i = node; i < subtreeEnd; i++)
+			{
+				const uint32_t parent = mParents[i];
+				mWorldTransforms[i] = parent != NO_PARENT ? mWorldTransforms[parent] * mLocalTransforms[i] : mLocalTransforms[i];
+			}
+			std::fill(mDirtyNodes.begin() + node, mDirtyNodes.begin() + subtreeEnd, 0);
+			result += subtreeEnd - node;
+			node = subtreeEnd;
+		}
+
+		return result;
+	}
+
+	void SceneGraph::partition(uint32_t first, uint32_t end, uint32_t chunkSize)
+	{
+		uint32_t node = first;
+		while(node < end)
+		{
+			const uint32_t subtreeEnd = mSubtreeEnds[node];
+			if(subtreeEnd - node > chunkSize)
+			{
+				//Children subtrees of large node follow it one after another
+				mSplitNodes.push_back(node);
+				partition(node + 1, subtreeEnd, chunkSize);
+			}
+			else if(!mRanges.empty() && mRanges.back().mEnd == node && subtreeEnd - mRanges.back().mFirst <= chunkSize)
+			{
+				mRanges.back().mEnd = subtreeEnd;
+			}
+			else
+			{
+				mRanges.push_back({ node, subtreeEnd });
+			}
+			node = subtreeEnd;
+		}
+	}
+
+	uint32_t SceneGraph::update(ThreadPool* threadPool)
+	{
+		if(!mDirty)
+		{
+			return 0;
+		}
+		mDirty = false;
+
+		const uint32_t nodesCount = getNodesCount();
+		const uint32_t threadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+		if(threadPool == nullptr || threadsCount == 1 || nodesCount < MIN_PARALLEL_CHUNK * 2)
+		{
+			return updateRange(0, nodesCount);
+		}
+
+		if(mPartitionNodesCount != nodesCount)
+		{
+			mRanges.clear();
+			mSplitNodes.clear();
+			partition(0, nodesCount, std::max(nodesCount / (threadsCount * 4), MIN_PARALLEL_CHUNK));
+			mPartitionNodesCount = nodesCount;
+		}
+
+		//Roots of large subtrees go first, dirty ones pass dirtiness to their children
+		uint32_t result = 0;
+		for(const uint32_t node : mSplitNodes)
+		{
+			if(mDirtyNodes[node] == 0)
+			{
+				continue;
+			}
+			const uint32_t parent = mParents[node];
+			mWorldTransforms[node] = parent != NO_PARENT ? mWorldTransforms[parent] * mLocalTransforms[node] : mLocalTransforms[node];
+			mDirtyNodes[node] = 0;
+			for(uint32_t child = node + 1; child < mSubtreeEnds[node]; child = mSubtreeEnds[child])
+			{
+				mDirtyNodes[child] = 1;
+			}
+			result++;
+		}
+
+		//Tasks which start after all ranges are taken return right away, so shared state outlives the call
+		struct UpdateJob
+		{
+			std::atomic<uint32_t> mNextRange{ 0 };
+			std::atomic<uint32_t> mUpdatedNodes{ 0 };
+			uint32_t mFinishedRanges = 0;
+			std::mutex mMutex;
+			std::condition_variable mFinished;
+		};
+		auto job = std::make_shared<UpdateJob>();
+		const uint32_t rangesCount = static_cast<uint32_t>(mRanges.size());
+		auto work = [this, job, rangesCount]()
+			{
+				for(uint32_t range = job->mNextRange++; range < rangesCount; range = job->mNextRange++)
+				{
+					job->mUpdatedNodes += updateRange(mRanges[range].mFirst, mRanges[range].mEnd);
+					std::unique_lock<std::mutex> lock(job->mMutex);
+					if(++job->mFinishedRanges == rangesCount)
+					{
+						job->mFinished.notify_one();
+					}
+				}
+			};
+		for(uint32_t i = 1; i < std::min(threadsCount, rangesCount); i++)
+		{
+			threadPool->enqueue(work);
+		}
+		work();
+		{
+			std::unique_lock<std::mutex> lock(job->mMutex);
+			job->mFinished.wait(lock, [&job, rangesCount]() { return job->mFinishedRanges == rangesCount; });
+		}
+
+		return result + job->mUpdatedNodes;
+	}
+}
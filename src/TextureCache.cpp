@@ -0,0 +1,372 @@
+#include "FileSystem/FileSystem.hpp"
+#include "FileSystem/MappedFile.hpp"
+#include "Renderer/BlockCompression.hpp"
+#include "Image.hpp"
+#include "Log.hpp"
+#include "TextureCache.hpp"
+#include "TextureContainer.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace fre
+{
+	//Files of older processing have other names and are evicted eventually
+	const uint32_t TEXTURE_CACHE_VERSION = 1;
+	const uint64_t HASH_PRIME_1 = 0x9E3779B185EBCA87ull;
+	const uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+	const size_t HASH_CHUNK_SIZE = 1 << 20;
+
+	static uint64_t rotateLeft(uint64_t value, uint32_t count)
+	{
+		return (value << count) | (value >> (64 - count));
+	}
+
+	//Random per process, so processes sharing cache directory never write the same temporary file. Thread ids
+	//are unique only inside process
+	static uint64_t getProcessTag()
+	{
+		static const uint64_t tag = []()
+			{
+				std::random_device device;
+				return (static_cast<uint64_t>(device()) << 32) | device();
+			}();
+		return tag;
+	}
+
+	//Word wise, source files are hashed on every load so it has to be cheap
+	static uint64_t hashData(uint64_t hash, const uint8_t* data, size_t size)
+	{
+		size_t i = 0;
+		for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(word));
+			hash = rotateLeft(hash ^ (word * HASH_PRIME_2), 31) * HASH_PRIME_1;
+		}
+		for(; i < size; i++)
+		{
+			hash = rotateLeft(hash ^ (data[i] * HASH_PRIME_2), 31) * HASH_PRIME_1;
+		}
+
+		return hash;
+	}
+
+	static uint64_t finalizeHash(uint64_t hash)
+	{
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDull;
+		hash ^= hash >> 33;
+		hash *= 0xC4CEB9FE1A85EC53ull;
+		hash ^= hash >> 33;
+
+		return hash;
+	}
+
+	static bool isProcessedFormat(VkFormat format)
+	{
+		return format == VK_FORMAT_R8_UNORM || format == VK_FORMAT_R8G8_UNORM || format == VK_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	void TextureCache::create(const std::string& directory, uint64_t sizeLimit)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mDirectory = directory;
+		mSizeLimit = sizeLimit;
+		mStatistics = TextureCacheStatistics();
+	}
+
+	void TextureCache::loadImage(Image& image, const TextureProcessing& processing)
+	{
+		if(!isCreated() || !image.isFileNameValid())
+		{
+			image.load();
+			processImage(image, processing);
+			return;
+		}
+
+		FS;
+		const uint64_t key = getKey(fs.find(image.mFileName), image, processing);
+		if(key == 0)
+		{
+			image.load();
+			processImage(image, processing);
+			return;
+		}
+
+		const std::string path = getPath(key);
+		if(loadFile(path, image))
+		{
+			return;
+		}
+
+		image.load();
+		processImage(image, processing);
+		storeFile(path, image);
+	}
+
+	TextureCacheStatistics TextureCache::getStatistics() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mStatistics;
+	}
+
+	void TextureCache::processImage(Image& image, const TextureProcessing& processing)
+	{
+		const bool chain = image.mDimension.x > 1 || image.mDimension.y > 1;
+		if(!isProcessedFormat(image.mFormat) || !image.mLevels.empty() || image.mData == nullptr ||
+			(!processing.mMipmaps && !processing.mCompression))
+		{
+			return;
+		}
+
+		const auto* data = static_cast<const uint8_t*>(image.mData);
+		TextureLevels texture;
+		texture.mWidth = image.mDimension.x;
+		texture.mHeight = image.mDimension.y;
+		if(processing.mCompression && (image.mSRGB || image.mStride <= 2))
+		{
+			texture.mFormat = chooseBlockCompressedFormat(data, static_cast<size_t>(texture.mWidth) * texture.mHeight, image.mStride);
+			//Images are processed by threads of thread pool one by one
+			texture.mLevels = compressImage(data, texture.mWidth, texture.mHeight, image.mStride, image.mSRGB,
+				texture.mFormat, 1, texture.mData);
+		}
+		else if(processing.mMipmaps && chain)
+		{
+			texture.mFormat = image.mFormat;
+			texture.mLevels = generateMipmaps(data, texture.mWidth, texture.mHeight, image.mStride, image.mSRGB, texture.mData);
+		}
+		else
+		{
+			return;
+		}
+
+		image.destroy();
+		image.create(texture);
+	}
+
+	uint64_t TextureCache::getKey(const std::string& fileName, const Image& image, const TextureProcessing& processing)
+	{
+		FILE* file = fopen(fileName.c_str(), "rb");
+		if(file == nullptr)
+		{
+			return 0;
+		}
+
+		std::vector<uint8_t> chunk(HASH_CHUNK_SIZE);
+		uint64_t hash = HASH_PRIME_1;
+		uint64_t size = 0;
+		size_t read = 0;
+		while((read = fread(chunk.data(), 1, chunk.size(), file)) > 0)
+		{
+			hash = hashData(hash, chunk.data(), read);
+			size += read;
+		}
+		const bool failed = ferror(file) != 0;
+		fclose(file);
+		if(failed)
+		{
+			return 0;
+		}
+
+		//Everything processed image depends on besides source bytes
+		const uint64_t options[] =
+		{
+			size,
+			image.mSRGB ? 1u : 0u,
+			processing.mMipmaps ? 1u : 0u,
+			processing.mCompression ? 1u : 0u,
+			TEXTURE_CACHE_VERSION
+		};
+		hash = finalizeHash(hashData(hash, reinterpret_cast<const uint8_t*>(options), sizeof(options)));
+
+		return hash == 0 ? 1 : hash;
+	}
+
+	std::string TextureCache::getPath(uint64_t key) const
+	{
+		return (std::filesystem::path(mDirectory) / formatString("%016llx.ktx2", static_cast<unsigned long long>(key))).string();
+	}
+
+	bool TextureCache::loadFile(const std::string& path, Image& image)
+	{
+		auto file = std::make_shared<MappedFile>();
+		TextureLevels texture;
+		bool loaded = file->open(path);
+		if(loaded)
+		{
+			try
+			{
+				texture = parseKTX2Header(file->getData(), file->getSize(), path);
+			}
+			catch(const std::runtime_error& e)
+			{
+				LOG_WARNING("Cached texture {} is ignored: {}", path, e.what());
+				loaded = false;
+			}
+		}
+		if(!loaded)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStatistics.mMisses++;
+			return false;
+		}
+
+		//Levels are stored smallest first, image data starts at the first one
+		size_t begin = std::numeric_limits<size_t>::max();
+		for(const auto& level : texture.mLevels)
+		{
+			begin = std::min(begin, level.mOffset);
+		}
+		for(auto& level : texture.mLevels)
+		{
+			level.mOffset -= begin;
+		}
+
+		image.mDimension = glm::ivec2(texture.mWidth, texture.mHeight);
+		image.mFormat = texture.mFormat;
+		//Single level is uploaded as loaded image, so mips are made at upload as without cache
+		if(texture.mLevels.size() > 1)
+		{
+			image.mLevels = texture.mLevels;
+		}
+		else
+		{
+			image.mLevels.clear();
+		}
+		image.mNumChannels = 0;
+		image.mIsTIFF = false;
+		image.mIsPNG = false;
+		image.mIsOwner = false;
+		image.mData = const_cast<uint8_t*>(file->getData() + begin);
+		image.mMappedFile = file;
+		image.calculateStrideAndDataSize();
+
+		std::error_code error;
+		std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStatistics.mHits++;
+
+		return true;
+	}
+
+	void TextureCache::storeFile(const std::string& path, const Image& image)
+	{
+		TextureLevels texture;
+		texture.mFormat = image.mFormat;
+		texture.mWidth = image.mDimension.x;
+		texture.mHeight = image.mDimension.y;
+		texture.mLevels = image.mLevels;
+		if(texture.mLevels.empty())
+		{
+			MipLevel level;
+			level.mWidth = texture.mWidth;
+			level.mHeight = texture.mHeight;
+			level.mSize = getLevelSize(texture.mFormat, texture.mWidth, texture.mHeight);
+			texture.mLevels.push_back(level);
+		}
+
+		//Formats containers can't hold, like RGB8, are processed on every load
+		const auto* data = static_cast<const uint8_t*>(image.mData);
+		if(getFormatBlockBytes(texture.mFormat) == 0 || data == nullptr)
+		{
+			return;
+		}
+		for(auto& level : texture.mLevels)
+		{
+			if(level.mSize != getLevelSize(texture.mFormat, level.mWidth, level.mHeight) || level.mOffset + level.mSize > image.mDataSize)
+			{
+				return;
+			}
+			const size_t offset = texture.mData.size();
+			texture.mData.insert(texture.mData.end(), data + level.mOffset, data + level.mOffset + level.mSize);
+			level.mOffset = offset;
+		}
+
+		//Other threads and processes never see partially written file
+		const std::string temporaryPath = formatString("%s.%016llx.%llu.tmp", path.c_str(),
+			static_cast<unsigned long long>(getProcessTag()),
+			static_cast<unsigned long long>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+		std::error_code error;
+		try
+		{
+			std::filesystem::create_directories(mDirectory, error);
+			saveKTX2(temporaryPath, texture);
+		}
+		catch(const std::runtime_error& e)
+		{
+			LOG_WARNING("Texture {} isn't cached: {}", image.mFileName, e.what());
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+		std::filesystem::rename(temporaryPath, path, error);
+		if(error)
+		{
+			//The same texture may be stored by other thread and mapped already
+			std::filesystem::remove(temporaryPath, error);
+		}
+
+		evict();
+	}
+
+	void TextureCache::evict()
+	{
+		struct Entry
+		{
+			std::filesystem::path mPath;
+			uint64_t mSize = 0;
+			std::filesystem::file_time_type mTime;
+		};
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		std::vector<Entry> entries;
+		uint64_t size = 0;
+		std::error_code error;
+		for(std::filesystem::directory_iterator it(mDirectory, error), end; !error && it != end; it.increment(error))
+		{
+			if(it->path().extension() != ".ktx2")
+			{
+				continue;
+			}
+			Entry entry;
+			entry.mPath = it->path();
+			std::error_code entryError;
+			entry.mSize = it->file_size(entryError);
+			entry.mTime = it->last_write_time(entryError);
+			if(!entryError)
+			{
+				size += entry.mSize;
+				entries.push_back(entry);
+			}
+		}
+
+		if(size > mSizeLimit)
+		{
+			std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.mTime < b.mTime; });
+			for(const auto& entry : entries)
+			{
+				if(size <= mSizeLimit)
+				{
+					break;
+				}
+				//Mapped files stay readable until unmapped
+				if(std::filesystem::remove(entry.mPath, error))
+				{
+					size -= entry.mSize;
+					mStatistics.mEvictions++;
+				}
+			}
+		}
+		mStatistics.mSize = size;
+	}
+}
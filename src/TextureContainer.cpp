@@ -0,0 +1,490 @@
+#include "TextureContainer.hpp"
+#include "Utilities.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace fre
+{
+	const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	//Identifier, header, index
+	const size_t KTX2_LEVEL_INDEX_OFFSET = 80;
+	const size_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+	//Data format descriptor models and channels of Khronos data format specification
+	const uint8_t KHR_DF_MODEL_RGBSDA = 1;
+	const uint8_t KHR_DF_MODEL_BC1A = 128;
+	const uint8_t KHR_DF_MODEL_BC3 = 130;
+	const uint8_t KHR_DF_MODEL_BC4 = 131;
+	const uint8_t KHR_DF_MODEL_BC5 = 132;
+	const uint8_t KHR_DF_MODEL_BC7 = 134;
+	const uint8_t KHR_DF_CHANNEL_ALPHA = 15;
+	const uint8_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+	const uint8_t KHR_DF_SAMPLE_DATATYPE_SIGNED = 0x40;
+	const uint8_t KHR_DF_SAMPLE_DATATYPE_FLOAT = 0x80;
+	const uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+	const uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+	const uint8_t KHR_DF_TRANSFER_SRGB = 2;
+
+	const size_t DDS_HEADER_OFFSET = 4;
+	const size_t DDS_DATA_OFFSET = DDS_HEADER_OFFSET + 124;
+	const size_t DDS_DX10_HEADER_SIZE = 20;
+	const uint32_t DDS_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDPF_RGB = 0x40;
+	const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+	const uint32_t DDSCAPS2_VOLUME = 0x200000;
+	const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+	static constexpr uint32_t makeFourCC(char a, char b, char c, char d)
+	{
+		return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) |
+			(static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+	}
+
+	template<typename T>
+	static T read(const uint8_t* file, size_t size, size_t offset, const std::string& name)
+	{
+		if(offset + sizeof(T) > size)
+		{
+			throw std::runtime_error(formatString("Texture file %s is truncated", name.c_str()));
+		}
+		T result;
+		memcpy(&result, &file[offset], sizeof(T));
+
+		return result;
+	}
+
+	template<typename T>
+	static T read(const std::vector<uint8_t>& file, size_t offset, const std::string& name)
+	{
+		return read<T>(file.data(), file.size(), offset, name);
+	}
+
+	template<typename T>
+	static void write(std::vector<uint8_t>& file, size_t offset, T value)
+	{
+		memcpy(&file[offset], &value, sizeof(T));
+	}
+
+	static void fillLevels(TextureLevels& texture, uint32_t levelsCount)
+	{
+		texture.mLevels.resize(levelsCount);
+		size_t offset = 0;
+		for(uint32_t level = 0; level < levelsCount; level++)
+		{
+			auto& mip = texture.mLevels[level];
+			mip.mWidth = std::max(texture.mWidth >> level, 1u);
+			mip.mHeight = std::max(texture.mHeight >> level, 1u);
+			mip.mOffset = offset;
+			mip.mSize = getLevelSize(texture.mFormat, mip.mWidth, mip.mHeight);
+			offset += mip.mSize;
+		}
+		texture.mData.resize(offset);
+	}
+
+	static void checkTexture(const TextureLevels& texture, uint32_t levelsCount, const std::string& name)
+	{
+		if(getFormatBlockBytes(texture.mFormat) == 0)
+		{
+			throw std::runtime_error(formatString("Texture file %s has unsupported format %u", name.c_str(), texture.mFormat));
+		}
+		if(texture.mWidth == 0 || texture.mHeight == 0 || levelsCount > getMipLevelsCount(texture.mWidth, texture.mHeight))
+		{
+			throw std::runtime_error(formatString("Texture file %s has invalid size %ux%u with %u levels",
+				name.c_str(), texture.mWidth, texture.mHeight, levelsCount));
+		}
+	}
+
+	//Data format descriptor with basic block of format, see Khronos data format specification
+	static std::vector<uint32_t> getDataFormatDescriptor(VkFormat format)
+	{
+		struct Sample
+		{
+			uint32_t mBitOffset;
+			uint32_t mBitLength;
+			uint8_t mChannelType;
+			uint32_t mUpper;
+			uint32_t mLower = 0;
+		};
+
+		uint8_t model = KHR_DF_MODEL_RGBSDA;
+		std::vector<Sample> samples;
+		const bool srgb =
+			format == VK_FORMAT_R8G8B8A8_SRGB ||
+			format == VK_FORMAT_BC1_RGB_SRGB_BLOCK ||
+			format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+			format == VK_FORMAT_BC3_SRGB_BLOCK ||
+			format == VK_FORMAT_BC7_SRGB_BLOCK;
+		//Alpha isn't sRGB encoded
+		const uint8_t alpha = KHR_DF_CHANNEL_ALPHA | (srgb ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0);
+		switch(format)
+		{
+		case VK_FORMAT_R8_UNORM:
+			samples = { { 0, 8, 0, 255 } };
+			break;
+		case VK_FORMAT_R8G8_UNORM:
+			samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 } };
+			break;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, alpha, 255 } };
+			break;
+		case VK_FORMAT_R16_UNORM:
+		case VK_FORMAT_R16_UINT:
+			samples = { { 0, 16, 0, 65535 } };
+			break;
+		case VK_FORMAT_R16_SFLOAT:
+			samples = { { 0, 16, KHR_DF_SAMPLE_DATATYPE_FLOAT | KHR_DF_SAMPLE_DATATYPE_SIGNED, 0x3C00, 0xBC00 } };
+			break;
+		case VK_FORMAT_R32_UINT:
+			samples = { { 0, 32, 0, 0xFFFFFFFF } };
+			break;
+		case VK_FORMAT_R32_SFLOAT:
+			samples = { { 0, 32, KHR_DF_SAMPLE_DATATYPE_FLOAT | KHR_DF_SAMPLE_DATATYPE_SIGNED, 0x3F800000, 0xBF800000 } };
+			break;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC1A;
+			samples = { { 0, 64, 0, 0xFFFFFFFF } };
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC1A;
+			samples = { { 0, 64, 1, 0xFFFFFFFF } };
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC3;
+			samples = { { 0, 64, alpha, 0xFFFFFFFF }, { 64, 64, 0, 0xFFFFFFFF } };
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			model = KHR_DF_MODEL_BC4;
+			samples = { { 0, 64, 0, 0xFFFFFFFF } };
+			break;
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+			model = KHR_DF_MODEL_BC5;
+			samples = { { 0, 64, 0, 0xFFFFFFFF }, { 64, 64, 1, 0xFFFFFFFF } };
+			break;
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			model = KHR_DF_MODEL_BC7;
+			samples = { { 0, 128, 0, 0xFFFFFFFF } };
+			break;
+		default:
+			break;
+		}
+
+		const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+		const uint32_t blockDimension = isBlockCompressedFormat(format) ? 3 | (3 << 8) : 0;
+		std::vector<uint32_t> result =
+		{
+			4 + blockSize,
+			//Khronos vendor, basic descriptor type
+			0,
+			2 | (blockSize << 16),
+			static_cast<uint32_t>(model | (KHR_DF_PRIMARIES_BT709 << 8) | ((srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16)),
+			blockDimension,
+			getFormatBlockBytes(format),
+			0
+		};
+		for(const auto& sample : samples)
+		{
+			result.push_back(sample.mBitOffset | ((sample.mBitLength - 1) << 16) | (static_cast<uint32_t>(sample.mChannelType) << 24));
+			result.push_back(0);
+			result.push_back(sample.mLower);
+			result.push_back(sample.mUpper);
+		}
+
+		return result;
+	}
+
+	static std::vector<uint8_t> readBinaryFile(const std::string& fileName)
+	{
+		std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+		if(!file.is_open())
+		{
+			throw std::runtime_error(formatString("Failed to open texture file %s", fileName.c_str()));
+		}
+		std::vector<uint8_t> result(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(result.data()), result.size());
+
+		return result;
+	}
+
+	uint32_t getFormatBlockBytes(VkFormat format)
+	{
+		switch(format)
+		{
+		case VK_FORMAT_R8_UNORM:
+			return 1;
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R16_UNORM:
+		case VK_FORMAT_R16_UINT:
+		case VK_FORMAT_R16_SFLOAT:
+			return 2;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_R32_UINT:
+		case VK_FORMAT_R32_SFLOAT:
+			return 4;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	bool isBlockCompressedFormat(VkFormat format)
+	{
+		return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+	}
+
+	size_t getLevelSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		const size_t blockBytes = getFormatBlockBytes(format);
+		if(isBlockCompressedFormat(format))
+		{
+			return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+		}
+
+		return static_cast<size_t>(width) * height * blockBytes;
+	}
+
+	TextureLevels parseKTX2Header(const uint8_t* file, size_t size, const std::string& name)
+	{
+		if(size < KTX2_LEVEL_INDEX_OFFSET || memcmp(file, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		{
+			throw std::runtime_error(formatString("%s is not a KTX2 file", name.c_str()));
+		}
+
+		TextureLevels result;
+		result.mFormat = static_cast<VkFormat>(read<uint32_t>(file, size, 12, name));
+		result.mWidth = read<uint32_t>(file, size, 20, name);
+		result.mHeight = read<uint32_t>(file, size, 24, name);
+		const uint32_t depth = read<uint32_t>(file, size, 28, name);
+		const uint32_t layersCount = read<uint32_t>(file, size, 32, name);
+		const uint32_t facesCount = read<uint32_t>(file, size, 36, name);
+		//0 asks loader to generate levels, only the first one is stored then
+		const uint32_t levelsCount = std::max(read<uint32_t>(file, size, 40, name), 1u);
+		const uint32_t supercompression = read<uint32_t>(file, size, 44, name);
+		if(depth > 1 || layersCount > 1 || facesCount != 1)
+		{
+			throw std::runtime_error(formatString("KTX2 file %s isn't a 2D texture: depth %u, layers %u, faces %u",
+				name.c_str(), depth, layersCount, facesCount));
+		}
+		if(supercompression != 0)
+		{
+			throw std::runtime_error(formatString("KTX2 file %s has unsupported supercompression scheme %u",
+				name.c_str(), supercompression));
+		}
+		checkTexture(result, levelsCount, name);
+
+		fillLevels(result, levelsCount);
+		result.mData.clear();
+		for(uint32_t level = 0; level < levelsCount; level++)
+		{
+			const size_t entry = KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+			const uint64_t offset = read<uint64_t>(file, size, entry, name);
+			const uint64_t length = read<uint64_t>(file, size, entry + 8, name);
+			auto& mip = result.mLevels[level];
+			if(length != mip.mSize || offset > size || length > size - offset)
+			{
+				throw std::runtime_error(formatString("KTX2 file %s has invalid level %u", name.c_str(), level));
+			}
+			mip.mOffset = static_cast<size_t>(offset);
+		}
+
+		return result;
+	}
+
+	TextureLevels parseKTX2(const std::vector<uint8_t>& file, const std::string& name)
+	{
+		TextureLevels result = parseKTX2Header(file.data(), file.size(), name);
+		size_t offset = 0;
+		for(auto& mip : result.mLevels)
+		{
+			result.mData.insert(result.mData.end(), file.begin() + mip.mOffset, file.begin() + mip.mOffset + mip.mSize);
+			mip.mOffset = offset;
+			offset += mip.mSize;
+		}
+
+		return result;
+	}
+
+	std::vector<uint8_t> serializeKTX2(const TextureLevels& texture)
+	{
+		const auto dataFormatDescriptor = getDataFormatDescriptor(texture.mFormat);
+		const uint32_t levelsCount = static_cast<uint32_t>(texture.mLevels.size());
+		const size_t dfdOffset = KTX2_LEVEL_INDEX_OFFSET + levelsCount * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+		const size_t dfdSize = dataFormatDescriptor.size() * sizeof(uint32_t);
+		//Levels are aligned to least common multiple of block size and 4
+		const size_t alignment = std::max<size_t>(getFormatBlockBytes(texture.mFormat), 4);
+
+		size_t fileSize = dfdOffset + dfdSize;
+		std::vector<size_t> offsets(levelsCount);
+		for(uint32_t level = levelsCount; level-- > 0;)
+		{
+			fileSize = (fileSize + alignment - 1) / alignment * alignment;
+			offsets[level] = fileSize;
+			fileSize += texture.mLevels[level].mSize;
+		}
+
+		std::vector<uint8_t> result(fileSize, 0);
+		memcpy(result.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+		write<uint32_t>(result, 12, texture.mFormat);
+		write<uint32_t>(result, 16, 1);
+		write<uint32_t>(result, 20, texture.mWidth);
+		write<uint32_t>(result, 24, texture.mHeight);
+		write<uint32_t>(result, 36, 1);
+		write<uint32_t>(result, 40, levelsCount);
+		write<uint32_t>(result, 48, static_cast<uint32_t>(dfdOffset));
+		write<uint32_t>(result, 52, static_cast<uint32_t>(dfdSize));
+		for(uint32_t level = 0; level < levelsCount; level++)
+		{
+			const auto& mip = texture.mLevels[level];
+			const size_t entry = KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+			write<uint64_t>(result, entry, offsets[level]);
+			write<uint64_t>(result, entry + 8, mip.mSize);
+			write<uint64_t>(result, entry + 16, mip.mSize);
+			memcpy(&result[offsets[level]], &texture.mData[mip.mOffset], mip.mSize);
+		}
+		memcpy(&result[dfdOffset], dataFormatDescriptor.data(), dfdSize);
+
+		return result;
+	}
+
+	TextureLevels parseDDS(const std::vector<uint8_t>& file, const std::string& name)
+	{
+		if(file.size() < DDS_DATA_OFFSET || read<uint32_t>(file, 0, name) != makeFourCC('D', 'D', 'S', ' '))
+		{
+			throw std::runtime_error(formatString("%s is not a DDS file", name.c_str()));
+		}
+
+		const size_t header = DDS_HEADER_OFFSET;
+		TextureLevels result;
+		const uint32_t flags = read<uint32_t>(file, header + 4, name);
+		result.mHeight = read<uint32_t>(file, header + 8, name);
+		result.mWidth = read<uint32_t>(file, header + 12, name);
+		const uint32_t levelsCount = (flags & DDS_MIPMAPCOUNT) != 0 ? std::max(read<uint32_t>(file, header + 24, name), 1u) : 1;
+		const uint32_t pixelFormatFlags = read<uint32_t>(file, header + 76, name);
+		const uint32_t fourCC = read<uint32_t>(file, header + 80, name);
+		const uint32_t caps2 = read<uint32_t>(file, header + 108, name);
+		if((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) != 0)
+		{
+			throw std::runtime_error(formatString("DDS file %s isn't a 2D texture", name.c_str()));
+		}
+
+		size_t dataOffset = DDS_DATA_OFFSET;
+		if((pixelFormatFlags & DDPF_FOURCC) != 0 && fourCC == makeFourCC('D', 'X', '1', '0'))
+		{
+			const uint32_t dxgiFormat = read<uint32_t>(file, DDS_DATA_OFFSET, name);
+			const uint32_t dimension = read<uint32_t>(file, DDS_DATA_OFFSET + 4, name);
+			const uint32_t arraySize = read<uint32_t>(file, DDS_DATA_OFFSET + 12, name);
+			if(dimension != DDS_DIMENSION_TEXTURE2D || arraySize > 1)
+			{
+				throw std::runtime_error(formatString("DDS file %s isn't a 2D texture", name.c_str()));
+			}
+			switch(dxgiFormat)
+			{
+			case 28: result.mFormat = VK_FORMAT_R8G8B8A8_UNORM; break;
+			case 29: result.mFormat = VK_FORMAT_R8G8B8A8_SRGB; break;
+			case 71: result.mFormat = VK_FORMAT_BC1_RGBA_UNORM_BLOCK; break;
+			case 72: result.mFormat = VK_FORMAT_BC1_RGBA_SRGB_BLOCK; break;
+			case 77: result.mFormat = VK_FORMAT_BC3_UNORM_BLOCK; break;
+			case 78: result.mFormat = VK_FORMAT_BC3_SRGB_BLOCK; break;
+			case 80: result.mFormat = VK_FORMAT_BC4_UNORM_BLOCK; break;
+			case 83: result.mFormat = VK_FORMAT_BC5_UNORM_BLOCK; break;
+			case 98: result.mFormat = VK_FORMAT_BC7_UNORM_BLOCK; break;
+			case 99: result.mFormat = VK_FORMAT_BC7_SRGB_BLOCK; break;
+			default:
+				throw std::runtime_error(formatString("DDS file %s has unsupported DXGI format %u", name.c_str(), dxgiFormat));
+			}
+			dataOffset += DDS_DX10_HEADER_SIZE;
+		}
+		else if((pixelFormatFlags & DDPF_FOURCC) != 0)
+		{
+			if(fourCC == makeFourCC('D', 'X', 'T', '1'))
+			{
+				result.mFormat = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			}
+			else if(fourCC == makeFourCC('D', 'X', 'T', '5'))
+			{
+				result.mFormat = VK_FORMAT_BC3_UNORM_BLOCK;
+			}
+			else if(fourCC == makeFourCC('A', 'T', 'I', '1') || fourCC == makeFourCC('B', 'C', '4', 'U'))
+			{
+				result.mFormat = VK_FORMAT_BC4_UNORM_BLOCK;
+			}
+			else if(fourCC == makeFourCC('A', 'T', 'I', '2') || fourCC == makeFourCC('B', 'C', '5', 'U'))
+			{
+				result.mFormat = VK_FORMAT_BC5_UNORM_BLOCK;
+			}
+			else
+			{
+				throw std::runtime_error(formatString("DDS file %s has unsupported four character code 0x%08X", name.c_str(), fourCC));
+			}
+		}
+		else if((pixelFormatFlags & DDPF_RGB) != 0 &&
+			read<uint32_t>(file, header + 84, name) == 32 &&
+			read<uint32_t>(file, header + 88, name) == 0x000000FF &&
+			read<uint32_t>(file, header + 92, name) == 0x0000FF00 &&
+			read<uint32_t>(file, header + 96, name) == 0x00FF0000)
+		{
+			result.mFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		}
+		else
+		{
+			throw std::runtime_error(formatString("DDS file %s has unsupported pixel format", name.c_str()));
+		}
+		checkTexture(result, levelsCount, name);
+
+		//Levels follow each other as they are packed
+		fillLevels(result, levelsCount);
+		if(dataOffset + result.mData.size() > file.size())
+		{
+			throw std::runtime_error(formatString("Texture file %s is truncated", name.c_str()));
+		}
+		memcpy(result.mData.data(), &file[dataOffset], result.mData.size());
+
+		return result;
+	}
+
+	TextureLevels loadKTX2(const std::string& fileName)
+	{
+		return parseKTX2(readBinaryFile(fileName), fileName);
+	}
+
+	void saveKTX2(const std::string& fileName, const TextureLevels& texture)
+	{
+		const auto data = serializeKTX2(texture);
+		std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+		if(!file.is_open())
+		{
+			throw std::runtime_error(formatString("Failed to open texture file %s for writing", fileName.c_str()));
+		}
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if(!file)
+		{
+			throw std::runtime_error(formatString("Failed to write texture file %s", fileName.c_str()));
+		}
+	}
+
+	TextureLevels loadDDS(const std::string& fileName)
+	{
+		return parseDDS(readBinaryFile(fileName), fileName);
+	}
+}
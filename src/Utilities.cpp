@@ -1,7 +1,9 @@
 #include "Engine.hpp"
 #include "Shader.hpp"
 #include "Utilities.hpp"
+#include "Renderer/VulkanFrameCommandPools.hpp"
 
+#include <atomic>
 #include <sstream>
 #include <iostream>
 #include <chrono>
@@ -124,53 +126,10 @@ namespace fre
 		LOG_TRACE("Vulkan buffer created: {}", (uint64_t)*buffer);
 	}
 
-    VkCommandBuffer beginCommandBuffer(VkDevice device, VkCommandPool commandPool)
-	{
-		//Command buffer to hold transfer command
-		VkCommandBuffer commandBuffer;
-
-		//Command Buffer details
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = commandPool;
-		allocInfo.commandBufferCount = 1;
-
-		//Allocate command buffer from pool
-		VK_CHECK(vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer));
-
-		//Information to begin the command buffer record
-		VkCommandBufferBeginInfo beginInfo = {};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;	//We're only using the command buffer once, so set up for one time submit
-
-		//Begin recording transfer commands
-		VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
-
-		return commandBuffer;
-	}
-
-    void endAndSubmitCommitBuffer(VkDevice device, VkCommandPool commandPool, VkQueue queue, VkCommandBuffer commandBuffer)
-	{
-		VK_CHECK(vkEndCommandBuffer(commandBuffer));
-
-		VkSubmitInfo submitInfo = {};
-		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-
-		//Submit transfer commands to transfer queue and wait until it finished
-		VK_CHECK(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE));
-		VK_CHECK(vkQueueWaitIdle(queue));
-
-		//Free temporary command buffer back to pool
-		vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-	}
-
-	void copyBuffer(VkDevice device, VkQueue transferQueue, VkCommandPool transferCommandPool,
+	void copyBuffer(VkDevice device, VkQueue transferQueue, VulkanOneTimeCommandPool& transferCommandPool,
 		VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize bufferSize)
 	{
-		VkCommandBuffer transferCommandBuffer = beginCommandBuffer(device, transferCommandPool);
+		VkCommandBuffer transferCommandBuffer = transferCommandPool.begin(device);
 
 		//Region of data to copy from and to
 		VkBufferCopy bufferCopyRegion = {};
@@ -181,7 +140,7 @@ namespace fre
 		//Command to copy srcBuffer to dstBuffer
 		vkCmdCopyBuffer(transferCommandBuffer, srcBuffer, dstBuffer, 1, &bufferCopyRegion);
 
-		endAndSubmitCommitBuffer(device, transferCommandPool, transferQueue, transferCommandBuffer);
+		transferCommandPool.endAndSubmit(device, transferQueue, transferCommandBuffer);
 	}
 
 	std::vector<VulkanQueueFamily> getQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
@@ -237,6 +196,35 @@ namespace fre
 		return vec2(result);
 	}
 
+	mat4 getNormalMatrix(const mat4& transform)
+	{
+		return mat4(transpose(inverse(mat3(transform))));
+	}
+
+	//Versions are shared by all renderers, change of another scene only gathers draws again
+	static std::atomic<uint64_t> gSceneVersion{ 1 };
+	static std::atomic<uint64_t> gTransformsVersion{ 1 };
+
+	uint64_t getSceneVersion()
+	{
+		return gSceneVersion;
+	}
+
+	void changeSceneVersion()
+	{
+		gSceneVersion++;
+	}
+
+	uint64_t getTransformsVersion()
+	{
+		return gTransformsVersion;
+	}
+
+	void changeTransformsVersion()
+	{
+		gTransformsVersion++;
+	}
+
 	ImVec2 operator + (const ImVec2& lhs, const ImVec2& rhs)
 	{
 		return ImVec2(lhs.x + rhs.x, lhs.y + rhs.y);